@@ -23,14 +23,20 @@ const int c_iDefaultScreenHeight = 720;
 
 const char *c_szDefaultPrimaryWindowTitle = "Multi Window Demo - Primary Window";
 
+const unsigned int c_uiMaxWindowCount = 16;			// size of the camera uniform buffer, in windows.
+const unsigned int c_uiCameraBlockBinding = 0;		// uniform buffer binding point for the Camera block.
+
 const char *c_szVertexShader = "#version 330\n"
 	"in vec4 Position;\n"
 	"in vec2 UV;\n"
 	"in vec4 Colour;\n"
 	"out vec2 vUV;\n"
 	"out vec4 vColour;\n"
-	"uniform mat4 Projection;\n"
-	"uniform mat4 View;\n"
+	"layout(std140) uniform Camera\n"
+	"{\n"
+		"mat4 Projection;\n"
+		"mat4 View;\n"
+	"};\n"
 	"uniform mat4 Model;\n"
 	"void main()\n"
 	"{\n" 
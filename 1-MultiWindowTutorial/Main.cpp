@@ -2,6 +2,7 @@
 #include "Constants.hpp"
 #include "GL\glew.h"
 #include "GLFW\glfw3.h"
+#include "ProgramCache.h"
 
 // Note the the following Includes do not need to be defined in order:
 #include <cstdio>
@@ -20,6 +21,7 @@ struct Window
 	unsigned int	m_uiHeight;
 	glm::mat4		m_m4Projection;
 	glm::mat4		m_m4ViewMatrix;
+	unsigned int	m_uiCameraOffset;	// where this windows CameraBlock lives in g_CameraUBO.
 
 	unsigned int	m_uiID;
 };
@@ -37,8 +39,18 @@ unsigned int g_VBO = 0;
 unsigned int g_IBO = 0;
 unsigned int g_Texture = 0;
 unsigned int g_Shader = 0;
+unsigned int g_CameraUBO = 0;					// one CameraBlock per window, shared by all contexts.
+unsigned int g_uiCameraBlockStride = 0;			// sizeof(CameraBlock) rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+GLint		 g_iModelUniform = -1;				// looked up once after linking, not every frame.
 glm::mat4	 g_ModelMatrix;
 
+// Per window camera data, matches the std140 layout of the Camera block in c_szVertexShader.
+struct CameraBlock
+{
+	glm::mat4 m_m4Projection;
+	glm::mat4 m_m4View;
+};
+
 struct Vertex
 {
 	glm::vec4 m_v4Position;
@@ -55,6 +67,7 @@ void GLFWErrorCallback(int a_iError, const char* a_szDiscription);
 void GLFWWindowSizeCallback(GLFWwindow* a_pWindow, int a_iWidth, int a_iHeight);
 GLEWContext* glewGetContext();   // This needs to be defined for GLEW MX to work, along with the GLEW_MX define in the perprocessor!
 void MakeContextCurrent(WindowHandle a_hWindowHandle);
+void UpdateCameraBlock(WindowHandle a_hWindowHandle);
 
 WindowHandle  CreateWindow(int a_iWidth, int a_iHeight, const std::string& a_szTitle, GLFWmonitor* a_pMonitor, WindowHandle a_hShare);
 
@@ -112,60 +125,39 @@ int Init()
 	
 	MakeContextCurrent(hPrimaryWindow);
 
-	// create shader:
-	GLint iSuccess = 0;
-	GLchar acLog[256];
-	GLuint vsHandle = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fsHandle = glCreateShader(GL_FRAGMENT_SHADER);
-
-	glShaderSource(vsHandle, 1, (const char**)&c_szVertexShader, 0);
-	glCompileShader(vsHandle);
-	glGetShaderiv(vsHandle, GL_COMPILE_STATUS, &iSuccess);
-	glGetShaderInfoLog(vsHandle, sizeof(acLog), 0, acLog);
-	if (iSuccess == GL_FALSE)
-	{
-		printf("Error: Failed to compile vertex shader!\n");
-		printf(acLog);
-		printf("\n");
-	}
-
-	glShaderSource(fsHandle, 1, (const char**)&c_szPixelShader, 0);
-	glCompileShader(fsHandle);
-	glGetShaderiv(fsHandle, GL_COMPILE_STATUS, &iSuccess);
-	glGetShaderInfoLog(fsHandle, sizeof(acLog), 0, acLog);
-	if (iSuccess == GL_FALSE)
-	{
-		printf("Error: Failed to compile fragment shader!\n");
-		printf(acLog);
-		printf("\n");
-	}
-
-	g_Shader = glCreateProgram();
-	glAttachShader(g_Shader, vsHandle);
-	glAttachShader(g_Shader, fsHandle);
-	glDeleteShader(vsHandle);
-	glDeleteShader(fsHandle);
-
-	// specify Vertex Attribs:
-	glBindAttribLocation(g_Shader, 0, "Position");
-	glBindAttribLocation(g_Shader, 1, "UV");
-	glBindAttribLocation(g_Shader, 2, "Colour");
-	glBindFragDataLocation(g_Shader, 0, "outColour");
-
-	glLinkProgram(g_Shader);
-	glGetProgramiv(g_Shader, GL_LINK_STATUS, &iSuccess);
-	glGetProgramInfoLog(g_Shader, sizeof(acLog), 0, acLog);
-	if (iSuccess == GL_FALSE)
+	// create shader, the linked program is cached on disk so later runs skip compiling it:
+	ProgramCache programCache;
+	g_Shader = programCache.CreateProgram(c_szVertexShader, c_szPixelShader, "", [](GLuint a_uiProgram)
 	{
-		printf("Error: failed to link Shader Program!\n");
-		printf(acLog);
-		printf("\n");
-	}
+		// specify Vertex Attribs:
+		glBindAttribLocation(a_uiProgram, 0, "Position");
+		glBindAttribLocation(a_uiProgram, 1, "UV");
+		glBindAttribLocation(a_uiProgram, 2, "Colour");
+		glBindFragDataLocation(a_uiProgram, 0, "outColour");
+	});
+	programCache.PrintReport();
+
+	// look up uniform locations once, now that the program is linked:
+	g_iModelUniform = glGetUniformLocation(g_Shader, "Model");
+	glUniformBlockBinding(g_Shader, glGetUniformBlockIndex(g_Shader, "Camera"), c_uiCameraBlockBinding);
 
 	glUseProgram(g_Shader);
 
 	CheckForGLErrors("Shader Setup Error");
 
+	// create the camera uniform buffer, each window gets its own aligned CameraBlock in it:
+	GLint iUBOAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &iUBOAlignment);
+	if (iUBOAlignment <= 0)
+		iUBOAlignment = 256;
+	g_uiCameraBlockStride = ((sizeof(CameraBlock) + iUBOAlignment - 1) / iUBOAlignment) * iUBOAlignment;
+
+	glGenBuffers(1, &g_CameraUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, g_CameraUBO);
+	glBufferData(GL_UNIFORM_BUFFER, g_uiCameraBlockStride * c_uiMaxWindowCount, nullptr, GL_DYNAMIC_DRAW);
+
+	CheckForGLErrors("Camera UBO Error");
+
 	// create and load a texture:
 	glm::vec4 *texData = new glm::vec4[256 * 256];
 	for (int i = 0; i < 256 * 256; i += 256)
@@ -262,6 +254,10 @@ int Init()
 		window->m_m4Projection = glm::perspective(45.0f, float(window->m_uiWidth)/float(window->m_uiHeight), 0.1f, 1000.0f);
 		window->m_m4ViewMatrix = glm::lookAt(glm::vec3(window->m_uiID * 8,8,8), glm::vec3(0,0,0), glm::vec3(0,1,0));
 
+		// and upload them to this windows slot in the camera UBO:
+		window->m_uiCameraOffset = (window->m_uiID % c_uiMaxWindowCount) * g_uiCameraBlockStride;
+		UpdateCameraBlock(window);
+
 		// set OpenGL Options:
 		glViewport(0, 0, window->m_uiWidth, window->m_uiHeight);
 		glClearColor(0.25f,0.25f,0.25f,1);
@@ -296,13 +292,9 @@ int MainLoop()
 
 			glUseProgram(g_Shader);
 
-			GLuint ProjectionID = glGetUniformLocation(g_Shader,"Projection");
-			GLuint ViewID = glGetUniformLocation(g_Shader,"View");
-			GLuint ModelID = glGetUniformLocation(g_Shader,"Model");
-
-			glUniformMatrix4fv(ProjectionID, 1, false, glm::value_ptr(window->m_m4Projection));
-			glUniformMatrix4fv(ViewID, 1, false, glm::value_ptr(window->m_m4ViewMatrix));
-			glUniformMatrix4fv(ModelID, 1, false, glm::value_ptr(g_ModelMatrix));
+			// projection and view come from this windows block in the camera UBO:
+			glBindBufferRange(GL_UNIFORM_BUFFER, c_uiCameraBlockBinding, g_CameraUBO, window->m_uiCameraOffset, sizeof(CameraBlock));
+			glUniformMatrix4fv(g_iModelUniform, 1, false, glm::value_ptr(g_ModelMatrix));
 
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture( GL_TEXTURE_2D, g_Texture );
@@ -347,22 +339,20 @@ void GLFWErrorCallback(int a_iError, const char* a_szDiscription)
 
 void GLFWWindowSizeCallback(GLFWwindow* a_pWindow, int a_iWidth, int a_iHeight)
 {
-	// find the window data corrosponding to a_pWindow;
-	WindowHandle window = nullptr;
-	for (auto& itr : g_lWindows)
+	// the window data corrosponding to a_pWindow was stored with it in CreateWindow(), no need to search for it:
+	WindowHandle window = (WindowHandle)glfwGetWindowUserPointer(a_pWindow);
+	if (window != nullptr)
 	{
-		if (itr->m_pWindow == a_pWindow)
-		{
-			window = itr;
-			window->m_uiWidth = a_iWidth;
-			window->m_uiHeight = a_iHeight;
-			window->m_m4Projection = glm::perspective(45.0f, float(a_iWidth)/float(a_iHeight), 0.1f, 1000.0f);
-		}
+		window->m_uiWidth = a_iWidth;
+		window->m_uiHeight = a_iHeight;
+		window->m_m4Projection = glm::perspective(45.0f, float(a_iWidth)/float(a_iHeight), 0.1f, 1000.0f);
 	}
 
 	WindowHandle previousContext = g_hCurrentContext;
 	MakeContextCurrent(window);
 	glViewport(0, 0, a_iWidth, a_iHeight);
+	if (window != nullptr)
+		UpdateCameraBlock(window);
 	MakeContextCurrent(previousContext);
 }
 
@@ -387,6 +377,7 @@ WindowHandle CreateWindow(int a_iWidth, int a_iHeight, const std::string& a_szTi
 	newWindow->m_uiID = g_uiWindowCounter++;		// set ID and Increment Counter!
 	newWindow->m_uiWidth = a_iWidth;
 	newWindow->m_uiHeight = a_iHeight;
+	newWindow->m_uiCameraOffset = 0;
 
 	// Create Window:
 	if (a_hShare != nullptr) // Check that the Window Handle passed in is valid.
@@ -429,7 +420,8 @@ WindowHandle CreateWindow(int a_iWidth, int a_iHeight, const std::string& a_szTi
 		return nullptr;
 	}
 	
-	// setup callbacks:
+	// setup callbacks, they find the window data through the user pointer:
+	glfwSetWindowUserPointer(newWindow->m_pWindow, newWindow);
 	// setup callback for window size changes:
 	glfwSetWindowSizeCallback(newWindow->m_pWindow, GLFWWindowSizeCallback);
 
@@ -442,6 +434,17 @@ WindowHandle CreateWindow(int a_iWidth, int a_iHeight, const std::string& a_szTi
 	return newWindow;
 }
 
+void UpdateCameraBlock(WindowHandle a_hWindowHandle)
+{
+	// the windows context must be current.
+	CameraBlock block;
+	block.m_m4Projection = a_hWindowHandle->m_m4Projection;
+	block.m_m4View = a_hWindowHandle->m_m4ViewMatrix;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, g_CameraUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, a_hWindowHandle->m_uiCameraOffset, sizeof(CameraBlock), &block);
+}
+
 void MakeContextCurrent(WindowHandle a_hWindowHandle)
 {
 	if (a_hWindowHandle != nullptr)
@@ -456,26 +459,26 @@ bool ShouldClose()
 	if (g_lWindows.empty())
 		return true;
 
-	std::list<WindowHandle> lToDelete;
-	for (const auto& window : g_lWindows)
+	// delete any windows that have been closed as we go, erase() hands back the next window so nothing is searched for twice:
+	auto itr = g_lWindows.begin();
+	while (itr != g_lWindows.end())
 	{
+		WindowHandle window = *itr;
 		if (glfwWindowShouldClose(window->m_pWindow))
 		{
-			lToDelete.push_back(window);
-		}
-	}
+			if (g_hCurrentContext == window)
+				g_hCurrentContext = nullptr;
 
-	if (!lToDelete.empty())
-	{
-		// we have windows to delete, Delete them:
-		for (auto& window : lToDelete)
-		{
 			delete window->m_pGLEWContext;
 			glfwDestroyWindow(window->m_pWindow);
 
 			delete window;
 
-			g_lWindows.remove(window);
+			itr = g_lWindows.erase(itr);
+		}
+		else
+		{
+			++itr;
 		}
 	}
 
@@ -0,0 +1,206 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "GLStateCache.h"
+#include "CommandList.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+
+static size_t AlignCommandSize(size_t a_uiBytes)
+{
+	return (a_uiBytes + c_uiCommandAlignment - 1) & ~(size_t)(c_uiCommandAlignment - 1);
+}
+
+
+CommandList::CommandList()
+	: m_vBuffer(c_uiDefaultCommandListBytes)
+	, m_uiSize(0)
+	, m_uiCommands(0)
+	, m_ullFrame(0)
+	, m_dSampleTime(0.0)
+	, m_dRecordStart(0.0)
+	, m_ullFramesRecorded(0)
+	, m_ullFramesReplayed(0)
+	, m_ullCommandsRecorded(0)
+	, m_ullBytesRecorded(0)
+	, m_uiGrows(0)
+	, m_dRecordSeconds(0.0)
+	, m_dReplaySeconds(0.0)
+{
+}
+
+
+void CommandList::Begin(unsigned long long a_ullFrame, double a_dSampleTime)
+{
+	m_dRecordStart = glfwGetTime();
+	m_uiSize = 0;
+	m_uiCommands = 0;
+	m_ullFrame = a_ullFrame;
+	m_dSampleTime = a_dSampleTime;
+}
+
+
+void CommandList::End()
+{
+	++m_ullFramesRecorded;
+	m_ullCommandsRecorded += m_uiCommands;
+	m_ullBytesRecorded += m_uiSize;
+	m_dRecordSeconds += glfwGetTime() - m_dRecordStart;
+}
+
+
+void* CommandList::Allocate(CommandTypes a_eType, size_t a_uiBytes, size_t a_uiExtra)
+{
+	size_t uiCommandSize = AlignCommandSize(sizeof(CommandHeader) + a_uiBytes + a_uiExtra);
+	if (m_uiSize + uiCommandSize > m_vBuffer.size())
+	{
+		// doubling, so a scene that grows only costs a few allocations before it fits again:
+		m_vBuffer.resize(std::max(m_vBuffer.size() * 2, m_uiSize + uiCommandSize));
+		++m_uiGrows;
+	}
+
+	CommandHeader* pHeader = (CommandHeader*)&m_vBuffer[m_uiSize];
+	pHeader->m_uiType = a_eType;
+	pHeader->m_uiSize = (unsigned int)uiCommandSize;
+	m_uiSize += uiCommandSize;
+	++m_uiCommands;
+	return pHeader + 1;
+}
+
+
+void CommandList::Viewport(GLint a_iX, GLint a_iY, GLsizei a_iWidth, GLsizei a_iHeight)
+{
+	ViewportCommand* pCommand = (ViewportCommand*)Allocate(CT_VIEWPORT, sizeof(ViewportCommand));
+	pCommand->m_iX = a_iX;
+	pCommand->m_iY = a_iY;
+	pCommand->m_iWidth = a_iWidth;
+	pCommand->m_iHeight = a_iHeight;
+}
+
+
+void CommandList::Clear(GLbitfield a_uiMask)
+{
+	ClearCommand* pCommand = (ClearCommand*)Allocate(CT_CLEAR, sizeof(ClearCommand));
+	pCommand->m_uiMask = a_uiMask;
+}
+
+
+void CommandList::BufferSubData(GLenum a_eTarget, GLuint a_uiBuffer, GLintptr a_iOffset, GLsizeiptr a_iSize, const void* a_pData)
+{
+	BufferCommand* pCommand = (BufferCommand*)Allocate(CT_BUFFER_SUB_DATA, sizeof(BufferCommand), (size_t)a_iSize);
+	pCommand->m_eTarget = a_eTarget;
+	pCommand->m_uiIndex = 0;
+	pCommand->m_uiBuffer = a_uiBuffer;
+	pCommand->m_iOffset = a_iOffset;
+	pCommand->m_iSize = a_iSize;
+	memcpy(pCommand + 1, a_pData, (size_t)a_iSize);
+}
+
+
+void CommandList::BindBufferRange(GLenum a_eTarget, GLuint a_uiIndex, GLuint a_uiBuffer, GLintptr a_iOffset, GLsizeiptr a_iSize)
+{
+	BufferCommand* pCommand = (BufferCommand*)Allocate(CT_BIND_BUFFER_RANGE, sizeof(BufferCommand));
+	pCommand->m_eTarget = a_eTarget;
+	pCommand->m_uiIndex = a_uiIndex;
+	pCommand->m_uiBuffer = a_uiBuffer;
+	pCommand->m_iOffset = a_iOffset;
+	pCommand->m_iSize = a_iSize;
+}
+
+
+void CommandList::Draw(ContextObjectID a_uiVertexArray, const DrawPacket& a_rPacket, const glm::mat4& a_m4Model, unsigned int a_uiLayer, float a_fDepth)
+{
+	DrawCommand* pCommand = (DrawCommand*)Allocate(CT_DRAW, sizeof(DrawCommand));
+	pCommand->m_Packet = a_rPacket;
+	pCommand->m_uiVertexArray = a_uiVertexArray;
+	pCommand->m_uiLayer = a_uiLayer;
+	pCommand->m_fDepth = a_fDepth;
+	pCommand->m_m4Model = a_m4Model;
+}
+
+
+void CommandList::Execute(GLStateCache& a_rState, RenderQueue& a_rQueue, ContextObjectRegistry& a_rObjects, unsigned int a_uiContextSlot)
+{
+	double dStart = glfwGetTime();
+
+	// draws are gathered into the render queue until the next command that is not a draw, which they have to come before:
+	bool bQueued = false;
+	for (size_t uiPos = 0; uiPos < m_uiSize; )
+	{
+		const CommandHeader* pHeader = (const CommandHeader*)&m_vBuffer[uiPos];
+		const void* pCommand = pHeader + 1;
+		uiPos += pHeader->m_uiSize;
+
+		if (pHeader->m_uiType == CT_DRAW)
+		{
+			const DrawCommand& draw = *(const DrawCommand*)pCommand;
+			if (!bQueued)
+			{
+				a_rQueue.Begin();
+				bQueued = true;
+			}
+
+			DrawPacket packet = draw.m_Packet;
+			packet.m_uiVertexArray = a_rObjects.Get(draw.m_uiVertexArray, a_uiContextSlot);
+			a_rQueue.Submit(RenderQueue::MakeSortKey(draw.m_uiLayer, packet.m_uiProgram, packet.m_uiVertexArray, packet.m_uiTexture, draw.m_fDepth),
+				packet, draw.m_m4Model);
+			continue;
+		}
+
+		if (bQueued)
+		{
+			a_rQueue.Execute(a_rState);
+			bQueued = false;
+		}
+
+		switch (pHeader->m_uiType)
+		{
+		case CT_VIEWPORT:
+		{
+			const ViewportCommand& viewport = *(const ViewportCommand*)pCommand;
+			a_rState.Viewport(viewport.m_iX, viewport.m_iY, viewport.m_iWidth, viewport.m_iHeight);
+			break;
+		}
+		case CT_CLEAR:
+			glClear(((const ClearCommand*)pCommand)->m_uiMask);
+			break;
+		case CT_BUFFER_SUB_DATA:
+		{
+			const BufferCommand& buffer = *(const BufferCommand*)pCommand;
+			a_rState.BindBuffer(buffer.m_eTarget, buffer.m_uiBuffer);
+			glBufferSubData(buffer.m_eTarget, buffer.m_iOffset, buffer.m_iSize, &buffer + 1);
+			break;
+		}
+		case CT_BIND_BUFFER_RANGE:
+		{
+			const BufferCommand& buffer = *(const BufferCommand*)pCommand;
+			a_rState.BindBufferRange(buffer.m_eTarget, buffer.m_uiIndex, buffer.m_uiBuffer, buffer.m_iOffset, buffer.m_iSize);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	if (bQueued)
+		a_rQueue.Execute(a_rState);
+
+	++m_ullFramesReplayed;
+	m_dReplaySeconds += glfwGetTime() - dStart;
+}
+
+
+void CommandList::PrintStats(unsigned int a_uiWindowID) const
+{
+	if (m_ullFramesRecorded == 0)
+		return;
+
+	printf("Window %u command list: %.1f commands and %.0f bytes per frame, %.3fms recording and %.3fms replaying, grew %u times\n", a_uiWindowID,
+		(double)m_ullCommandsRecorded / m_ullFramesRecorded, (double)m_ullBytesRecorded / m_ullFramesRecorded,
+		m_dRecordSeconds * 1000.0 / m_ullFramesRecorded, m_ullFramesReplayed > 0 ? m_dReplaySeconds * 1000.0 / m_ullFramesReplayed : 0.0, m_uiGrows);
+}
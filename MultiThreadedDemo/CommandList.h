@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////
+/// @file		CommandList.h
+/// @details	Deferred GL commands, recorded on any thread without a context
+///				and replayed later by the thread that owns one. Commands are
+///				small fixed layout records written back to back into one byte
+///				buffer that keeps its capacity between frames, so recording a
+///				frame allocates nothing once the buffer has grown to fit it.
+///				Anything that only exists per context (VAOs) is recorded by its
+///				ContextObjectID and looked up when the list is replayed, and
+///				draws go through the window's RenderQueue, so a run of draws
+///				between two state commands is still sorted by state.
+///				A list is written by one thread at a time and must not be
+///				replayed while it is being recorded.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _COMMANDLIST_H_
+#define _COMMANDLIST_H_
+
+#include "RenderQueue.h"
+#include "ContextObjectRegistry.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <cstddef>
+
+class GLStateCache;
+
+const unsigned int c_uiCommandAlignment = 8;				// every command starts on this many bytes.
+const unsigned int c_uiDefaultCommandListBytes = 4096;		// reserved up front, enough for a frame of the demo's scene.
+
+enum CommandTypes
+{
+	CT_VIEWPORT = 0,
+	CT_CLEAR,
+	CT_BUFFER_SUB_DATA,		// the data is copied into the list straight after the command.
+	CT_BIND_BUFFER_RANGE,
+	CT_DRAW,
+
+	CT_COUNT,
+};
+
+class CommandList
+{
+public:
+	CommandList();
+
+	/// Empties the list for a new frame. a_ullFrame and a_dSampleTime are those of the FrameSnapshot it is recorded from,
+	/// so the thread replaying it can measure the frame's latency.
+	void Begin(unsigned long long a_ullFrame, double a_dSampleTime);
+
+	/// Finishes recording, only the time it took is kept.
+	void End();
+
+	void Viewport(GLint a_iX, GLint a_iY, GLsizei a_iWidth, GLsizei a_iHeight);
+	void Clear(GLbitfield a_uiMask);
+	void BufferSubData(GLenum a_eTarget, GLuint a_uiBuffer, GLintptr a_iOffset, GLsizeiptr a_iSize, const void* a_pData);
+	void BindBufferRange(GLenum a_eTarget, GLuint a_uiIndex, GLuint a_uiBuffer, GLintptr a_iOffset, GLsizeiptr a_iSize);
+
+	/// a_rPacket's m_uiVertexArray is ignored, a_uiVertexArray is looked up in the replaying context's slot instead.
+	/// The sort key is made then too, from a_uiLayer and a_fDepth.
+	void Draw(ContextObjectID a_uiVertexArray, const DrawPacket& a_rPacket, const glm::mat4& a_m4Model, unsigned int a_uiLayer, float a_fDepth);
+
+	/// Makes every call in the order recorded. The context whose slot in a_rObjects is a_uiContextSlot must be current,
+	/// with a_rState and a_rQueue the ones that belong to it.
+	void Execute(GLStateCache& a_rState, RenderQueue& a_rQueue, ContextObjectRegistry& a_rObjects, unsigned int a_uiContextSlot);
+
+	unsigned long long GetFrame() const				{ return m_ullFrame; }
+	double GetSampleTime() const					{ return m_dSampleTime; }
+	unsigned int GetCommandCount() const			{ return m_uiCommands; }
+	size_t GetSize() const							{ return m_uiSize; }
+
+	/// Commands, bytes and recording and replay time per frame, and how often the buffer had to grow.
+	void PrintStats(unsigned int a_uiWindowID) const;
+
+private:
+	// every command starts with this, m_uiSize includes the header and any padding:
+	struct CommandHeader
+	{
+		unsigned int	m_uiType;
+		unsigned int	m_uiSize;
+	};
+
+	struct ViewportCommand
+	{
+		GLint			m_iX;
+		GLint			m_iY;
+		GLsizei			m_iWidth;
+		GLsizei			m_iHeight;
+	};
+
+	struct ClearCommand
+	{
+		GLbitfield		m_uiMask;
+	};
+
+	struct BufferCommand
+	{
+		GLenum			m_eTarget;
+		GLuint			m_uiIndex;			// CT_BIND_BUFFER_RANGE only.
+		GLuint			m_uiBuffer;
+		GLintptr		m_iOffset;
+		GLsizeiptr		m_iSize;
+	};
+
+	struct DrawCommand
+	{
+		DrawPacket		m_Packet;
+		ContextObjectID	m_uiVertexArray;
+		unsigned int	m_uiLayer;
+		float			m_fDepth;
+		glm::mat4		m_m4Model;
+	};
+
+	CommandList(const CommandList&);
+	CommandList& operator=(const CommandList&);
+
+	/// Room for a command and a_uiExtra bytes after it, returns where the command goes.
+	void* Allocate(CommandTypes a_eType, size_t a_uiBytes, size_t a_uiExtra = 0);
+
+	std::vector<unsigned char>	m_vBuffer;			// only ever grows, m_uiSize of it is in use.
+	size_t						m_uiSize;
+	unsigned int				m_uiCommands;
+	unsigned long long			m_ullFrame;
+	double						m_dSampleTime;
+	double						m_dRecordStart;
+
+	unsigned long long			m_ullFramesRecorded;
+	unsigned long long			m_ullFramesReplayed;
+	unsigned long long			m_ullCommandsRecorded;
+	unsigned long long			m_ullBytesRecorded;
+	unsigned int				m_uiGrows;			// times recording had to allocate.
+	double						m_dRecordSeconds;
+	double						m_dReplaySeconds;
+};
+
+#endif // _COMMANDLIST_H_
@@ -0,0 +1,163 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "ContextObjectRegistry.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <chrono>
+
+
+ContextObjectRegistry::ContextObjectRegistry()
+	: m_uiObjectCount(0)
+{
+	memset(m_auiNames, 0, sizeof(m_auiNames));
+
+	// hand out the low slots first:
+	for (unsigned int i = 0; i < c_uiMaxContextSlots; ++i)
+	{
+		m_vFreeSlots.push_back(c_uiMaxContextSlots - 1 - i);
+		m_abSlotOpen[i] = false;
+	}
+}
+
+
+ContextObjectID ContextObjectRegistry::Register(ContextObjectTypes a_eType, BuildFunc a_fBuild)
+{
+	if (m_uiObjectCount >= c_uiMaxContextObjects)
+	{
+		Log("Error: Only %u context objects can be registered!\n", c_uiMaxContextObjects);
+		return c_uiInvalidContextObject;
+	}
+
+	m_aDescriptions[m_uiObjectCount].m_eType = a_eType;
+	m_aDescriptions[m_uiObjectCount].m_fBuild = a_fBuild;
+	return m_uiObjectCount++;
+}
+
+
+unsigned int ContextObjectRegistry::OpenContext()
+{
+	std::lock_guard<std::mutex> lock(m_SlotLock);
+	if (m_vFreeSlots.empty())
+		return c_uiInvalidContextSlot;
+
+	unsigned int uiSlot = m_vFreeSlots.back();
+	m_vFreeSlots.pop_back();
+	m_abSlotOpen[uiSlot] = true;
+	return uiSlot;
+}
+
+
+void ContextObjectRegistry::CloseContext(unsigned int a_uiSlot)
+{
+	if (a_uiSlot >= c_uiMaxContextSlots)
+		return;
+
+	// the names belong to the context being closed, so this has to happen on it:
+	for (unsigned int i = 0; i < m_uiObjectCount; ++i)
+	{
+		GLuint& ruiName = m_auiNames[a_uiSlot][i];
+		if (ruiName == 0)
+			continue;
+
+		switch (m_aDescriptions[i].m_eType)
+		{
+		case COT_VERTEX_ARRAY:		glDeleteVertexArrays(1, &ruiName);		break;
+		case COT_FRAMEBUFFER:		glDeleteFramebuffers(1, &ruiName);		break;
+		case COT_PROGRAM_PIPELINE:	glDeleteProgramPipelines(1, &ruiName);	break;
+		case COT_QUERY:				glDeleteQueries(1, &ruiName);			break;
+		}
+		ruiName = 0;
+	}
+
+	std::lock_guard<std::mutex> lock(m_SlotLock);
+	if (m_abSlotOpen[a_uiSlot])
+	{
+		m_abSlotOpen[a_uiSlot] = false;
+		m_vFreeSlots.push_back(a_uiSlot);
+	}
+}
+
+
+GLuint ContextObjectRegistry::Build(ContextObjectID a_uiObject, unsigned int a_uiSlot)
+{
+	GLuint uiName = 0;
+	const Description& description = m_aDescriptions[a_uiObject];
+	switch (description.m_eType)
+	{
+	case COT_VERTEX_ARRAY:		glGenVertexArrays(1, &uiName);		break;
+	case COT_FRAMEBUFFER:		glGenFramebuffers(1, &uiName);		break;
+	case COT_PROGRAM_PIPELINE:	glGenProgramPipelines(1, &uiName);	break;
+	case COT_QUERY:				glGenQueries(1, &uiName);			break;
+	}
+
+	if (uiName == 0)
+	{
+		Log("Error: Could not create context object %u for context slot %u!\n", a_uiObject, a_uiSlot);
+		return 0;
+	}
+
+	if (description.m_fBuild)
+		description.m_fBuild(uiName);
+
+	m_auiNames[a_uiSlot][a_uiObject] = uiName;
+	return uiName;
+}
+
+
+ContextObjectLookupTimings BenchmarkContextObjectLookup(unsigned int a_uiContexts, unsigned int a_uiLookups)
+{
+	ContextObjectLookupTimings timings;
+	timings.m_uiContexts = a_uiContexts;
+	timings.m_dMapLookupNS = 0.0;
+	timings.m_dRegistryLookupNS = 0.0;
+	if (a_uiContexts == 0 || a_uiLookups == 0)
+		return timings;
+
+	// the registry is big, keep it off the stack:
+	ContextObjectRegistry* pRegistry = new ContextObjectRegistry();
+	ContextObjectID uiVAO = pRegistry->Register(COT_VERTEX_ARRAY, ContextObjectRegistry::BuildFunc());
+
+	// window IDs keep counting up as windows come and go, so the map's keys are spread out like they would be:
+	std::map<unsigned int, unsigned int> mVAOs;
+	std::vector<unsigned int> vWindowIDs;
+	std::vector<unsigned int> vSlots;
+	for (unsigned int i = 0; i < a_uiContexts && i < c_uiMaxContextSlots; ++i)
+	{
+		unsigned int uiSlot = pRegistry->OpenContext();
+		vSlots.push_back(uiSlot);
+		vWindowIDs.push_back(i * 3);
+		mVAOs[i * 3] = pRegistry->Get(uiVAO, uiSlot);
+	}
+	unsigned int uiContexts = (unsigned int)vSlots.size();
+	timings.m_uiContexts = uiContexts;
+
+	volatile GLuint uiSink = 0;
+
+	// old way, what DrawScene() used to do:
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < a_uiLookups; ++i)
+		uiSink = mVAOs[vWindowIDs[i % uiContexts]];
+	auto endTime = std::chrono::high_resolution_clock::now();
+	timings.m_dMapLookupNS = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / a_uiLookups;
+
+	// new way:
+	startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < a_uiLookups; ++i)
+		uiSink = pRegistry->Get(uiVAO, vSlots[i % uiContexts]);
+	endTime = std::chrono::high_resolution_clock::now();
+	timings.m_dRegistryLookupNS = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / a_uiLookups;
+
+	(void)uiSink;
+
+	for (auto uiSlot : vSlots)
+		pRegistry->CloseContext(uiSlot);
+	delete pRegistry;
+
+	return timings;
+}
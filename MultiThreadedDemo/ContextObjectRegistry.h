@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////
+/// @file		ContextObjectRegistry.h
+/// @details	Container objects (VAOs, FBOs and program pipelines) and query
+///				objects are not shared between contexts, so every context needs
+///				its own copy.
+///				The registry holds one shared description of each object and
+///				builds a context's copy the first time that context asks for it,
+///				so windows opened at any time get them. Every context has a slot
+///				and the copies live in a flat array indexed by slot and object,
+///				so a lookup is two array indexes instead of a map search.
+///				Describe objects with Register() before any render thread calls
+///				Get(). Get() for a slot may only be called by the thread that has
+///				that slot's context current.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _CONTEXTOBJECTREGISTRY_H_
+#define _CONTEXTOBJECTREGISTRY_H_
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+const unsigned int c_uiMaxContextSlots = 128;		// windows plus the loader, with room for windows opened later.
+const unsigned int c_uiMaxContextObjects = 16;		// described objects, every context may have one of each.
+const unsigned int c_uiInvalidContextSlot = 0xFFFFFFFF;
+
+typedef unsigned int ContextObjectID;
+const ContextObjectID c_uiInvalidContextObject = 0xFFFFFFFF;
+
+enum ContextObjectTypes
+{
+	COT_VERTEX_ARRAY = 0,
+	COT_FRAMEBUFFER,
+	COT_PROGRAM_PIPELINE,
+	COT_QUERY,
+};
+
+class ContextObjectRegistry
+{
+public:
+	/// Called with the context current and a freshly generated name, it must bind the object itself and set it up.
+	typedef std::function<void(GLuint a_uiName)> BuildFunc;
+
+	ContextObjectRegistry();
+
+	/// Describes an object every context can have a copy of. Not thread safe, register everything up front.
+	ContextObjectID Register(ContextObjectTypes a_eType, BuildFunc a_fBuild);
+
+	/// Gives a new context a slot, c_uiInvalidContextSlot if they are all in use.
+	unsigned int OpenContext();
+
+	/// Deletes the context's copies and frees its slot. The context must be current if it built anything.
+	void CloseContext(unsigned int a_uiSlot);
+
+	/// This context's copy of a_uiObject, built on first use.
+	GLuint Get(ContextObjectID a_uiObject, unsigned int a_uiSlot)
+	{
+		GLuint uiName = m_auiNames[a_uiSlot][a_uiObject];
+		return uiName != 0 ? uiName : Build(a_uiObject, a_uiSlot);
+	}
+
+	unsigned int GetObjectCount() const				{ return m_uiObjectCount; }
+
+private:
+	ContextObjectRegistry(const ContextObjectRegistry&);	// not copyable, we own GL objects.
+	ContextObjectRegistry& operator=(const ContextObjectRegistry&);
+
+	struct Description
+	{
+		ContextObjectTypes	m_eType;
+		BuildFunc			m_fBuild;
+	};
+
+	GLuint Build(ContextObjectID a_uiObject, unsigned int a_uiSlot);
+
+	Description					m_aDescriptions[c_uiMaxContextObjects];
+	unsigned int				m_uiObjectCount;
+
+	GLuint						m_auiNames[c_uiMaxContextSlots][c_uiMaxContextObjects];	// 0 until built.
+
+	std::mutex					m_SlotLock;			// guards the two below, windows open and close on any thread.
+	std::vector<unsigned int>	m_vFreeSlots;
+	bool						m_abSlotOpen[c_uiMaxContextSlots];
+};
+
+struct ContextObjectLookupTimings
+{
+	double			m_dMapLookupNS;			// per lookup cost of the old std::map<unsigned int, unsigned int> keyed by window ID.
+	double			m_dRegistryLookupNS;	// per lookup cost of ContextObjectRegistry::Get().
+	unsigned int	m_uiContexts;
+};
+
+/// Times a VAO lookup both ways, cycling through a_uiContexts contexts for a_uiLookups lookups.
+/// A context must be current, the registry's VAOs are all created on it.
+ContextObjectLookupTimings BenchmarkContextObjectLookup(unsigned int a_uiContexts, unsigned int a_uiLookups);
+
+#endif // _CONTEXTOBJECTREGISTRY_H_
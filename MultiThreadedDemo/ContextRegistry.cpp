@@ -0,0 +1,100 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ThreadingDemo.h"
+#include "ContextRegistry.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+THREAD_LOCAL WindowHandle	t_hCurrentContext = nullptr;
+THREAD_LOCAL GLEWContext*	t_pCurrentGLEWContext = nullptr;
+THREAD_LOCAL unsigned int	t_uiGLEWContextLookups = 0;
+
+
+ContextLookupTimings BenchmarkContextLookup(unsigned int a_uiThreads, unsigned int a_uiLookups)
+{
+	ContextLookupTimings timings;
+	timings.m_uiThreads = a_uiThreads;
+
+	// a dummy window so that both lookups have something real to dereference:
+	Window* pWindow = new Window();
+	pWindow->m_pGLEWContext = nullptr;
+
+	std::map<std::thread::id, WindowHandle> mContextMap;
+	std::mutex lock;
+	std::condition_variable start;
+	unsigned int uiRegistered = 0;
+	bool bGo = false;
+
+	std::vector<double> vMapNS(a_uiThreads, 0.0);
+	std::vector<double> vThreadLocalNS(a_uiThreads, 0.0);
+	std::vector<std::thread*> vThreads;
+
+	for (unsigned int i = 0; i < a_uiThreads; ++i)
+	{
+		vThreads.push_back(new std::thread([&, i] ()
+		{
+			// register with both, the map needs a lock here because registration inserts into the tree:
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				mContextMap[std::this_thread::get_id()] = pWindow;
+				SetCurrentContext(pWindow, pWindow->m_pGLEWContext);
+				++uiRegistered;
+				start.notify_all();
+				start.wait(guard, [&] () { return bGo; });
+			}
+
+			volatile GLEWContext* pSink = nullptr;
+
+			// old way, what glewGetContext() used to do:
+			auto startTime = std::chrono::high_resolution_clock::now();
+			for (unsigned int j = 0; j < a_uiLookups; ++j)
+			{
+				pSink = mContextMap[std::this_thread::get_id()]->m_pGLEWContext;
+			}
+			auto endTime = std::chrono::high_resolution_clock::now();
+			vMapNS[i] = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / a_uiLookups;
+
+			// new way:
+			startTime = std::chrono::high_resolution_clock::now();
+			for (unsigned int j = 0; j < a_uiLookups; ++j)
+			{
+				++t_uiGLEWContextLookups;
+				pSink = t_pCurrentGLEWContext;
+			}
+			endTime = std::chrono::high_resolution_clock::now();
+			vThreadLocalNS[i] = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / a_uiLookups;
+
+			(void)pSink;
+		}));
+	}
+
+	// release all the threads at once so the lookups are concurrent:
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		start.wait(guard, [&] () { return uiRegistered == a_uiThreads; });
+		bGo = true;
+		start.notify_all();
+	}
+
+	timings.m_dMapLookupNS = 0.0;
+	timings.m_dThreadLocalLookupNS = 0.0;
+	for (unsigned int i = 0; i < a_uiThreads; ++i)
+	{
+		vThreads[i]->join();
+		delete vThreads[i];
+
+		timings.m_dMapLookupNS += vMapNS[i] / a_uiThreads;
+		timings.m_dThreadLocalLookupNS += vThreadLocalNS[i] / a_uiThreads;
+	}
+
+	delete pWindow;
+
+	return timings;
+}
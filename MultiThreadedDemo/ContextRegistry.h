@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////
+/// @file		ContextRegistry.h
+/// @details	Thread local record of the context that is current on each thread.
+///				glewGetContext() is called for every GL entry point under GLEW MX,
+///				so the lookup must be O(1), lock free and safe from any thread.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _CONTEXTREGISTRY_H_
+#define _CONTEXTREGISTRY_H_
+
+// VS2013 does not support the C++11 thread_local keyword yet:
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL thread_local
+#endif
+
+struct Window;
+typedef Window* WindowHandle;
+typedef struct GLEWContextStruct GLEWContext;
+
+// GLEW MX calls this for every GL entry point, every file that makes GL calls needs to see it. Defined in ThreadingDemo.cpp.
+GLEWContext* glewGetContext();
+
+// Each thread only ever reads and writes its own copy of these, so no locking is required.
+extern THREAD_LOCAL WindowHandle	t_hCurrentContext;
+extern THREAD_LOCAL GLEWContext*	t_pCurrentGLEWContext;
+extern THREAD_LOCAL unsigned int	t_uiGLEWContextLookups;	// number of glewGetContext() calls made on this thread.
+
+inline WindowHandle GetCurrentContext()
+{
+	return t_hCurrentContext;
+}
+
+inline void SetCurrentContext(WindowHandle a_hWindowHandle, GLEWContext* a_pGLEWContext)
+{
+	t_hCurrentContext = a_hWindowHandle;
+	t_pCurrentGLEWContext = a_pGLEWContext;
+}
+
+struct ContextLookupTimings
+{
+	double			m_dMapLookupNS;			// per lookup cost of the old std::map<std::thread::id, WindowHandle> approach.
+	double			m_dThreadLocalLookupNS;	// per lookup cost of the thread local registry.
+	unsigned int	m_uiThreads;
+};
+
+/// Times both lookup strategies with a_uiThreads threads each doing a_uiLookups lookups at the same time.
+ContextLookupTimings BenchmarkContextLookup(unsigned int a_uiThreads, unsigned int a_uiLookups);
+
+#endif // _CONTEXTREGISTRY_H_
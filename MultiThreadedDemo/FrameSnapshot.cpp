@@ -0,0 +1,88 @@
+// Note that the following includes must be defined in order:
+#include "FrameSnapshot.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <thread>
+
+
+FrameSnapshotBuffer::FrameSnapshotBuffer()
+	: m_uiLatest(0)
+	, m_uiWriting(0)
+	, m_ullPublished(0)
+	, m_ullWriterWaits(0)
+{
+	// slot 0 is published from the start, so a reader before the first frame gets an empty one rather than nothing:
+	for (auto& slot : m_aSlots)
+	{
+		slot.m_Snapshot.m_ullFrame = 0;
+		slot.m_Snapshot.m_dSampleTime = 0.0;
+		slot.m_Snapshot.m_fTime = 0.0f;
+		slot.m_Snapshot.m_m4Model = glm::mat4();
+		slot.m_Snapshot.m_v3BoundsMin = glm::vec3(0);
+		slot.m_Snapshot.m_v3BoundsMax = glm::vec3(0);
+		slot.m_uiReaders = 0;
+	}
+}
+
+
+FrameSnapshot& FrameSnapshotBuffer::BeginWrite()
+{
+	// any slot but the latest that nobody has pinned. The latest only changes in Publish(), on this thread, so a reader can only
+	// pin a slot we pick here if it read m_uiLatest before it last changed, and then Acquire() sees the change and lets go:
+	unsigned int uiLatest = m_uiLatest.load();
+	bool bWaited = false;
+	while (true)
+	{
+		for (unsigned int i = 1; i < c_uiFrameSnapshotSlots; ++i)
+		{
+			unsigned int uiSlot = (uiLatest + i) % c_uiFrameSnapshotSlots;
+			if (m_aSlots[uiSlot].m_uiReaders.load() == 0)
+			{
+				m_uiWriting = uiSlot;
+				return m_aSlots[uiSlot].m_Snapshot;
+			}
+		}
+
+		// a reader is still on a frame two behind, it will be done with it soon:
+		if (!bWaited)
+		{
+			++m_ullWriterWaits;
+			bWaited = true;
+		}
+		std::this_thread::yield();
+	}
+}
+
+
+void FrameSnapshotBuffer::Publish()
+{
+	m_aSlots[m_uiWriting].m_Snapshot.m_ullFrame = ++m_ullPublished;
+	m_uiLatest.store(m_uiWriting);		// everything written to the slot is visible to whoever loads this.
+}
+
+
+const FrameSnapshot& FrameSnapshotBuffer::Acquire()
+{
+	// pin the latest, then check it is still the latest. If it is the writer cannot have picked it, if not try again:
+	while (true)
+	{
+		unsigned int uiSlot = m_uiLatest.load();
+		m_aSlots[uiSlot].m_uiReaders.fetch_add(1);
+		if (m_uiLatest.load() == uiSlot)
+			return m_aSlots[uiSlot].m_Snapshot;
+		m_aSlots[uiSlot].m_uiReaders.fetch_sub(1);
+	}
+}
+
+
+void FrameSnapshotBuffer::Release(const FrameSnapshot& a_rSnapshot)
+{
+	for (auto& slot : m_aSlots)
+	{
+		if (&slot.m_Snapshot == &a_rSnapshot)
+		{
+			slot.m_uiReaders.fetch_sub(1);
+			return;
+		}
+	}
+}
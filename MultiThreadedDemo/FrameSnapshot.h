@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////
+/// @file		FrameSnapshot.h
+/// @details	What the simulation hands the renderers each frame. The main
+///				thread fills in the snapshot of frame N+1 while the render
+///				threads draw from the published snapshot of frame N. Once N+1
+///				is done it is published by swapping one atomic index, and
+///				nothing ever takes a lock. Readers pin the snapshot they draw
+///				from, and the writer only reuses a slot that is neither the
+///				latest nor pinned. With three slots the writer always finds
+///				one free unless a reader is still on a frame two behind.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _FRAMESNAPSHOT_H_
+#define _FRAMESNAPSHOT_H_
+
+#include "glm/glm.hpp"
+#include <atomic>
+
+////////////////////////// Constants //////////////////////////////////
+const unsigned int c_uiFrameSnapshotSlots = 3;		// the one being written, the latest and the one before it.
+
+///////////////////////// Custom Data Types ///////////////////////////
+struct FrameSnapshot
+{
+	unsigned long long	m_ullFrame;				// 0 until the first frame is published.
+	double				m_dSampleTime;			// glfwGetTime() when the simulation sampled this frame, for the latency.
+	float				m_fTime;				// scene time, everything animated is driven by this.
+	glm::mat4			m_m4Model;				// the quad's spin.
+	glm::vec3			m_v3BoundsMin;			// bounds of the simulated scene (see SceneUpdate.h).
+	glm::vec3			m_v3BoundsMax;
+};
+
+class FrameSnapshotBuffer
+{
+public:
+	FrameSnapshotBuffer();
+
+	/// The writer's side, only ever one thread. Returns the slot to fill in for the next frame, waiting if every other slot is pinned.
+	FrameSnapshot& BeginWrite();
+
+	/// The slot BeginWrite() last returned, still the writer's until Publish().
+	FrameSnapshot& GetWriting()							{ return m_aSlots[m_uiWriting].m_Snapshot; }
+
+	/// Makes the slot from BeginWrite() the latest. Readers that already have a snapshot keep theirs.
+	void Publish();
+
+	/// Any thread. Pins and returns the latest published snapshot, it does not change until Release().
+	const FrameSnapshot& Acquire();
+	void Release(const FrameSnapshot& a_rSnapshot);
+
+	unsigned long long GetPublishedCount() const		{ return m_ullPublished; }
+	unsigned long long GetWriterWaits() const			{ return m_ullWriterWaits; }	// times BeginWrite() found every slot busy.
+
+private:
+	FrameSnapshotBuffer(const FrameSnapshotBuffer&);
+	FrameSnapshotBuffer& operator=(const FrameSnapshotBuffer&);
+
+	struct Slot
+	{
+		FrameSnapshot				m_Snapshot;
+		std::atomic<unsigned int>	m_uiReaders;
+	};
+
+	Slot						m_aSlots[c_uiFrameSnapshotSlots];
+	std::atomic<unsigned int>	m_uiLatest;			// index of the last published slot.
+	unsigned int				m_uiWriting;		// writer only.
+	unsigned long long			m_ullPublished;		// writer only.
+	unsigned long long			m_ullWriterWaits;	// writer only.
+};
+
+/// Pins the latest snapshot for as long as it is in scope.
+class ScopedFrameSnapshot
+{
+public:
+	explicit ScopedFrameSnapshot(FrameSnapshotBuffer& a_rBuffer) : m_rBuffer(a_rBuffer), m_rSnapshot(a_rBuffer.Acquire()) {}
+	~ScopedFrameSnapshot()								{ m_rBuffer.Release(m_rSnapshot); }
+
+	const FrameSnapshot& Get() const					{ return m_rSnapshot; }
+
+private:
+	ScopedFrameSnapshot(const ScopedFrameSnapshot&);
+	ScopedFrameSnapshot& operator=(const ScopedFrameSnapshot&);
+
+	FrameSnapshotBuffer&	m_rBuffer;
+	const FrameSnapshot&	m_rSnapshot;
+};
+
+#endif // _FRAMESNAPSHOT_H_
@@ -0,0 +1,286 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ThreadingDemo.h"
+#include "FrameTiming.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cmath>
+
+static const char* const c_aszTimerNames[FT_COUNT] = { "frame", "cpu", "swap", "lock", "fence", "present", "latency" };
+
+
+FrameHistogram::FrameHistogram()
+{
+	Reset();
+}
+
+
+void FrameHistogram::Record(double a_dSeconds)
+{
+	unsigned long long ullMicroseconds = a_dSeconds > 0.0 ? (unsigned long long)(a_dSeconds * 1000000.0) : 0;
+
+	// relaxed is fine, nothing else is published through these counters:
+	m_auiBuckets[BucketIndex(ullMicroseconds)].fetch_add(1, std::memory_order_relaxed);
+	m_ullCount.fetch_add(1, std::memory_order_relaxed);
+	m_ullSumUS.fetch_add(ullMicroseconds, std::memory_order_relaxed);
+
+	unsigned long long ullMax = m_ullMaxUS.load(std::memory_order_relaxed);
+	while (ullMicroseconds > ullMax && !m_ullMaxUS.compare_exchange_weak(ullMax, ullMicroseconds, std::memory_order_relaxed)) {}
+}
+
+
+void FrameHistogram::Reset()
+{
+	for (unsigned int i = 0; i < c_uiHistogramBuckets; ++i)
+		m_auiBuckets[i].store(0, std::memory_order_relaxed);
+	m_ullCount.store(0, std::memory_order_relaxed);
+	m_ullSumUS.store(0, std::memory_order_relaxed);
+	m_ullMaxUS.store(0, std::memory_order_relaxed);
+}
+
+
+unsigned long long FrameHistogram::GetCount() const
+{
+	return m_ullCount.load(std::memory_order_relaxed);
+}
+
+
+double FrameHistogram::GetPercentile(double a_dPercentile) const
+{
+	// sum the buckets rather than trusting m_ullCount, a Record() may be half way through on another thread:
+	unsigned long long aullCounts[c_uiHistogramBuckets];
+	unsigned long long ullTotal = 0;
+	for (unsigned int i = 0; i < c_uiHistogramBuckets; ++i)
+	{
+		aullCounts[i] = m_auiBuckets[i].load(std::memory_order_relaxed);
+		ullTotal += aullCounts[i];
+	}
+	if (ullTotal == 0)
+		return 0.0;
+
+	unsigned long long ullTarget = (unsigned long long)std::ceil(a_dPercentile / 100.0 * ullTotal);
+	if (ullTarget == 0)
+		ullTarget = 1;
+
+	unsigned long long ullSeen = 0;
+	for (unsigned int i = 0; i < c_uiHistogramBuckets; ++i)
+	{
+		ullSeen += aullCounts[i];
+		if (ullSeen >= ullTarget)
+		{
+			// don't report more than we have actually seen:
+			double dValue = BucketValue(i);
+			double dMax = GetMax();
+			return dValue < dMax ? dValue : dMax;
+		}
+	}
+
+	return GetMax();
+}
+
+
+double FrameHistogram::GetMean() const
+{
+	unsigned long long ullCount = m_ullCount.load(std::memory_order_relaxed);
+	return ullCount > 0 ? (double)m_ullSumUS.load(std::memory_order_relaxed) / ullCount / 1000000.0 : 0.0;
+}
+
+
+double FrameHistogram::GetMax() const
+{
+	return m_ullMaxUS.load(std::memory_order_relaxed) / 1000000.0;
+}
+
+
+unsigned int FrameHistogram::BucketIndex(unsigned long long a_ullMicroseconds)
+{
+	if (a_ullMicroseconds < c_uiHistogramSubBuckets)
+		return (unsigned int)a_ullMicroseconds;
+
+	unsigned int uiExponent = 0;
+	while ((a_ullMicroseconds >> (uiExponent + 1)) != 0)
+		++uiExponent;
+
+	// uiExponent is at least 3 here, the top 3 bits below the leading one pick the sub bucket:
+	unsigned int uiSubBucket = (unsigned int)(a_ullMicroseconds >> (uiExponent - 3)) & (c_uiHistogramSubBuckets - 1);
+	unsigned int uiBucket = (uiExponent - 2) * c_uiHistogramSubBuckets + uiSubBucket;
+	return uiBucket < c_uiHistogramBuckets ? uiBucket : c_uiHistogramBuckets - 1;
+}
+
+
+double FrameHistogram::BucketValue(unsigned int a_uiBucket)
+{
+	if (a_uiBucket < c_uiHistogramSubBuckets)
+		return (a_uiBucket + 0.5) / 1000000.0;
+
+	unsigned int uiExponent = a_uiBucket / c_uiHistogramSubBuckets + 2;
+	unsigned int uiSubBucket = a_uiBucket % c_uiHistogramSubBuckets;
+	double dWidth = (double)(1ull << (uiExponent - 3));
+	double dLow = (c_uiHistogramSubBuckets + uiSubBucket) * dWidth;
+	return (dLow + dWidth * 0.5) / 1000000.0;
+}
+
+
+FrameTimingData* CreateFrameTiming(unsigned int a_uiWindowID)
+{
+	FrameTimingData* pData = new FrameTimingData();
+	pData->m_dLastFrameEnd = 0.0;
+	pData->m_dLastReport = glfwGetTime();
+	pData->m_uiWindowID = a_uiWindowID;
+	pData->m_dLastSwapEnd = 0.0;
+	pData->m_ullPresents = 0;
+	pData->m_ullMissedIntervals = 0;
+	return pData;
+}
+
+
+void RecordFrameTime(WindowHandle a_hWindowHandle, FrameTimers a_eTimer, double a_dSeconds)
+{
+	FrameTimingData* pData = a_hWindowHandle->m_pFrameTiming;
+	if (pData == nullptr)
+		return;
+
+	pData->m_aRolling[a_eTimer].Record(a_dSeconds);
+	pData->m_aTotal[a_eTimer].Record(a_dSeconds);
+}
+
+
+unsigned int RecordPresent(WindowHandle a_hWindowHandle, double a_dQueued, double a_dSwapStart, double a_dSwapEnd, double a_dRefreshPeriod)
+{
+	FrameTimingData* pData = a_hWindowHandle->m_pFrameTiming;
+	if (pData == nullptr)
+		return 0;
+
+	RecordFrameTime(a_hWindowHandle, FT_SWAP, a_dSwapEnd - a_dSwapStart);
+	RecordFrameTime(a_hWindowHandle, FT_PRESENT, a_dSwapEnd - a_dQueued);
+
+	// how many vertical blanks since the last swap, to the nearest one, against how many the interval asked for:
+	unsigned int uiMissed = 0;
+	int iInterval = a_hWindowHandle->m_iSwapInterval;
+	if (iInterval > 0 && a_dRefreshPeriod > 0.0 && pData->m_dLastSwapEnd > 0.0)
+	{
+		int iBlanks = (int)floor((a_dSwapEnd - pData->m_dLastSwapEnd) / a_dRefreshPeriod + 0.5);
+		if (iBlanks > iInterval)
+			uiMissed = (unsigned int)(iBlanks - iInterval);
+	}
+
+	pData->m_dLastSwapEnd = a_dSwapEnd;
+	pData->m_ullPresents.fetch_add(1, std::memory_order_relaxed);
+	pData->m_ullMissedIntervals.fetch_add(uiMissed, std::memory_order_relaxed);
+	return uiMissed;
+}
+
+
+void EndFrameTiming(WindowHandle a_hWindowHandle)
+{
+	FrameTimingData* pData = a_hWindowHandle->m_pFrameTiming;
+	if (pData == nullptr)
+		return;
+
+	double dNow = glfwGetTime();
+	if (pData->m_dLastFrameEnd > 0.0)
+		RecordFrameTime(a_hWindowHandle, FT_FRAME, dNow - pData->m_dLastFrameEnd);
+	pData->m_dLastFrameEnd = dNow;
+
+	if (dNow - pData->m_dLastReport >= c_dFrameTimingReportInterval)
+	{
+		const FrameHistogram& frame = pData->m_aRolling[FT_FRAME];
+		double dFPS = frame.GetCount() / (dNow - pData->m_dLastReport);
+		// one message so lines from different render threads don't interleave, it is formatted on the logger's thread:
+		Log("Thread id: %s  Window: %u FPS = %i  frame ms p50 %.2f p95 %.2f p99 %.2f max %.2f  swap p99 %.2f\n",
+			GetLogThreadID(), pData->m_uiWindowID, (int)dFPS,
+			frame.GetPercentile(50) * 1000.0, frame.GetPercentile(95) * 1000.0, frame.GetPercentile(99) * 1000.0, frame.GetMax() * 1000.0,
+			pData->m_aRolling[FT_SWAP].GetPercentile(99) * 1000.0);
+
+		for (unsigned int i = 0; i < FT_COUNT; ++i)
+			pData->m_aRolling[i].Reset();
+		pData->m_dLastReport = dNow;
+	}
+}
+
+
+void PrintFrameTimings(const std::vector<WindowHandle>& a_vWindows)
+{
+	printf("\n%8s %8s %10s %10s %10s %10s %10s %10s\n", "Window", "Timer", "Count", "Mean ms", "p50 ms", "p95 ms", "p99 ms", "Max ms");
+	for (auto window : a_vWindows)
+	{
+		if (window->m_pFrameTiming == nullptr)
+			continue;
+
+		for (unsigned int i = 0; i < FT_COUNT; ++i)
+		{
+			const FrameHistogram& histogram = window->m_pFrameTiming->m_aTotal[i];
+			if (histogram.GetCount() == 0)
+				continue;
+			printf("%8u %8s %10llu %10.3f %10.3f %10.3f %10.3f %10.3f\n", window->m_uiID, c_aszTimerNames[i], histogram.GetCount(),
+				histogram.GetMean() * 1000.0, histogram.GetPercentile(50) * 1000.0, histogram.GetPercentile(95) * 1000.0,
+				histogram.GetPercentile(99) * 1000.0, histogram.GetMax() * 1000.0);
+		}
+	}
+
+	for (auto window : a_vWindows)
+	{
+		const FrameTimingData* pData = window->m_pFrameTiming;
+		if (pData != nullptr && pData->m_ullMissedIntervals > 0)
+			printf("Window %u missed %llu vertical blanks in %llu swaps with a swap interval of %i\n", window->m_uiID,
+				pData->m_ullMissedIntervals.load(), pData->m_ullPresents.load(), window->m_iSwapInterval);
+	}
+	printf("\n");
+}
+
+
+bool DumpFrameTimings(const std::vector<WindowHandle>& a_vWindows, const std::string& a_szFileName)
+{
+	FILE* pFile = fopen(a_szFileName.c_str(), "w");
+	if (pFile == nullptr)
+	{
+		Log("Error: Could not open %s to write frame timings!\n", a_szFileName.c_str());
+		return false;
+	}
+
+	bool bJSON = a_szFileName.size() >= 5 && a_szFileName.compare(a_szFileName.size() - 5, 5, ".json") == 0;
+	if (bJSON)
+		fprintf(pFile, "{\n  \"windows\": [");
+	else
+		fprintf(pFile, "window,timer,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+
+	bool bFirstWindow = true;
+	for (auto window : a_vWindows)
+	{
+		if (window->m_pFrameTiming == nullptr)
+			continue;
+
+		if (bJSON)
+			fprintf(pFile, "%s\n    { \"id\": %u, \"timers\": {", bFirstWindow ? "" : ",", window->m_uiID);
+		bFirstWindow = false;
+
+		for (unsigned int i = 0; i < FT_COUNT; ++i)
+		{
+			const FrameHistogram& histogram = window->m_pFrameTiming->m_aTotal[i];
+			double dMean = histogram.GetMean() * 1000.0;
+			double dP50 = histogram.GetPercentile(50) * 1000.0;
+			double dP95 = histogram.GetPercentile(95) * 1000.0;
+			double dP99 = histogram.GetPercentile(99) * 1000.0;
+			double dMax = histogram.GetMax() * 1000.0;
+
+			if (bJSON)
+				fprintf(pFile, "%s\n      \"%s\": { \"count\": %llu, \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p95_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f }",
+					i == 0 ? "" : ",", c_aszTimerNames[i], histogram.GetCount(), dMean, dP50, dP95, dP99, dMax);
+			else
+				fprintf(pFile, "%u,%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", window->m_uiID, c_aszTimerNames[i], histogram.GetCount(), dMean, dP50, dP95, dP99, dMax);
+		}
+
+		if (bJSON)
+			fprintf(pFile, "\n    } }");
+	}
+
+	if (bJSON)
+		fprintf(pFile, "\n  ]\n}\n");
+
+	fclose(pFile);
+	Log("Frame timings written to %s\n", a_szFileName.c_str());
+	return true;
+}
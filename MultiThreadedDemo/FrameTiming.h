@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////
+/// @file		FrameTiming.h
+/// @details	Per window frame timing, replaces the old FPSData/CalcFPS average.
+///				Times are kept in fixed size histograms of atomic counters so any
+///				thread can record into them or read percentiles without a lock.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _FRAMETIMING_H_
+#define _FRAMETIMING_H_
+
+#include <atomic>
+#include <vector>
+#include <string>
+
+struct Window;
+typedef Window* WindowHandle;
+
+////////////////////////// Constants //////////////////////////////////
+// buckets are log2 microseconds split into 8 linear steps, so each bucket is within 12.5% of its neighbour.
+// 200 buckets covers 0us to ~67 seconds.
+const unsigned int c_uiHistogramSubBuckets = 8;
+const unsigned int c_uiHistogramBuckets = 200;
+
+const double c_dFrameTimingReportInterval = 3.0;	// seconds between the rolling percentile print outs.
+
+///////////////////// Custom Data Types ///////////////////////////////
+enum FrameTimers
+{
+	FT_FRAME = 0,		// time between the end of one frame and the end of the next.
+	FT_CPU,				// time spent submitting GL calls, excluding the swap.
+	FT_SWAP,			// time blocked in glfwSwapBuffers().
+	FT_LOCK,			// time waiting for the other window's frame in the threaded loop.
+	FT_FENCE,			// time waiting on fence syncs.
+	FT_PRESENT,			// time from a frame being handed over for presenting to its swap returning.
+	FT_LATENCY,			// time from the simulation sampling a frame to it being handed to the swap, see FrameSnapshot.h.
+
+	FT_COUNT,
+};
+
+class FrameHistogram
+{
+public:
+	FrameHistogram();
+
+	void Record(double a_dSeconds);
+	void Reset();
+
+	unsigned long long GetCount() const;
+	double GetPercentile(double a_dPercentile) const;	// a_dPercentile is 0 - 100, result is in seconds.
+	double GetMean() const;
+	double GetMax() const;
+
+private:
+	static unsigned int BucketIndex(unsigned long long a_ullMicroseconds);
+	static double BucketValue(unsigned int a_uiBucket);		// the middle of the bucket in seconds.
+
+	std::atomic<unsigned int>		m_auiBuckets[c_uiHistogramBuckets];
+	std::atomic<unsigned long long>	m_ullCount;
+	std::atomic<unsigned long long>	m_ullSumUS;
+	std::atomic<unsigned long long>	m_ullMaxUS;
+};
+
+struct FrameTimingData
+{
+	FrameHistogram	m_aRolling[FT_COUNT];	// since the last report, cleared by EndFrameTiming().
+	FrameHistogram	m_aTotal[FT_COUNT];		// since the window was created.
+	double			m_dLastFrameEnd;		// only touched by the thread rendering the window.
+	double			m_dLastReport;
+	unsigned int	m_uiWindowID;
+
+	// swaps that came back later than the window's swap interval, see RecordPresent():
+	double							m_dLastSwapEnd;			// only touched by the thread presenting the window.
+	std::atomic<unsigned long long>	m_ullPresents;
+	std::atomic<unsigned long long>	m_ullMissedIntervals;
+};
+
+/////////////////////////// Functions /////////////////////////////////
+FrameTimingData* CreateFrameTiming(unsigned int a_uiWindowID);
+
+/// Adds a_dSeconds to both the rolling and total histogram for a_eTimer.
+void RecordFrameTime(WindowHandle a_hWindowHandle, FrameTimers a_eTimer, double a_dSeconds);
+
+/// Records a swap that was asked for at a_dQueued, started at a_dSwapStart and returned at a_dSwapEnd (FT_SWAP and FT_PRESENT).
+/// With a swap interval above 0, a swap returning more than the interval's worth of a_dRefreshPeriod after the last one
+/// counts every vertical blank it missed. Returns how many this swap missed.
+unsigned int RecordPresent(WindowHandle a_hWindowHandle, double a_dQueued, double a_dSwapStart, double a_dSwapEnd, double a_dRefreshPeriod);
+
+/// Call once at the end of each frame of a window, records FT_FRAME and prints the rolling percentiles every c_dFrameTimingReportInterval.
+void EndFrameTiming(WindowHandle a_hWindowHandle);
+
+/// Prints p50/p95/p99/max of every timer for every window.
+void PrintFrameTimings(const std::vector<WindowHandle>& a_vWindows);
+
+/// Writes the total histograms' percentiles for every window, as JSON if the file name ends in .json, otherwise CSV.
+bool DumpFrameTimings(const std::vector<WindowHandle>& a_vWindows, const std::string& a_szFileName);
+
+#endif // _FRAMETIMING_H_
@@ -0,0 +1,133 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "GLEWContextCache.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+
+// hints that change which context, and so which entry points, the driver hands out:
+static const int c_aiKeyAttribs[] =
+{
+	GLFW_CLIENT_API, GLFW_CONTEXT_VERSION_MAJOR, GLFW_CONTEXT_VERSION_MINOR, GLFW_CONTEXT_REVISION,
+	GLFW_OPENGL_FORWARD_COMPAT, GLFW_OPENGL_DEBUG_CONTEXT, GLFW_OPENGL_PROFILE, GLFW_CONTEXT_ROBUSTNESS,
+};
+
+// the pixel format, as far as GL 1.1 can tell us without GLEW:
+static const GLenum c_aeKeyBits[] = { GL_RED_BITS, GL_GREEN_BITS, GL_BLUE_BITS, GL_ALPHA_BITS, GL_DEPTH_BITS, GL_STENCIL_BITS };
+
+
+GLEWContextCache::GLEWContextCache()
+	: m_bEnabled(true)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+
+GLEWContextCache::~GLEWContextCache()
+{
+	Clear();
+}
+
+
+GLenum GLEWContextCache::InitContext(GLEWContext* a_pContext, GLFWwindow* a_pWindow)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	if (!m_bEnabled)
+	{
+		double dStart = glfwGetTime();
+		GLenum eResult = glewContextInit(a_pContext);
+		m_Stats.m_dInitSeconds += glfwGetTime() - dStart;
+		++m_Stats.m_uiMisses;
+		return eResult;
+	}
+
+	double dStart = glfwGetTime();
+	std::string szKey = GetKey(a_pWindow);
+	for (const auto& entry : m_vEntries)
+	{
+		if (entry.m_szKey == szKey)
+		{
+			*a_pContext = *entry.m_pContext;
+			m_Stats.m_dCopySeconds += glfwGetTime() - dStart;
+			++m_Stats.m_uiHits;
+			return GLEW_OK;
+		}
+	}
+	m_Stats.m_dCopySeconds += glfwGetTime() - dStart;
+
+	dStart = glfwGetTime();
+	GLenum eResult = glewContextInit(a_pContext);
+	m_Stats.m_dInitSeconds += glfwGetTime() - dStart;
+	++m_Stats.m_uiMisses;
+
+	// a context GLEW failed on is not worth remembering, the next one gets to try again:
+	if (eResult == GLEW_OK)
+	{
+		Entry entry;
+		entry.m_szKey = szKey;
+		entry.m_pContext = new GLEWContext(*a_pContext);
+		m_vEntries.push_back(entry);
+	}
+	return eResult;
+}
+
+
+void GLEWContextCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	for (auto& entry : m_vEntries)
+		delete entry.m_pContext;
+	m_vEntries.clear();
+}
+
+
+GLEWContextCacheStats GLEWContextCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Stats;
+}
+
+
+void GLEWContextCache::PrintReport() const
+{
+	GLEWContextCacheStats stats = GetStats();
+	if (!m_bEnabled)
+		Log("Status: GLEW context cache disabled, %u contexts initialised in %.2fms\n", stats.m_uiMisses, stats.m_dInitSeconds * 1000.0);
+	else
+		Log("Status: GLEW context cache %u hits, %u misses, %.2fms initialising and %.2fms copying\n",
+			stats.m_uiHits, stats.m_uiMisses, stats.m_dInitSeconds * 1000.0, stats.m_dCopySeconds * 1000.0);
+}
+
+
+std::string GLEWContextCache::GetKey(GLFWwindow* a_pWindow)
+{
+	// only GL 1.1 calls here, they are exported by the GL library itself and do not need GLEW:
+	std::string szKey;
+	const GLenum aeStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum eString : aeStrings)
+	{
+		const char* szValue = (const char*)glGetString(eString);
+		szKey += szValue != nullptr ? szValue : "";
+		szKey += '\n';
+	}
+
+	for (int iAttrib : c_aiKeyAttribs)
+		szKey += std::to_string(glfwGetWindowAttrib(a_pWindow, iAttrib)) + ",";
+
+	for (GLenum eBits : c_aeKeyBits)
+	{
+		GLint iBits = 0;
+		glGetIntegerv(eBits, &iBits);
+		szKey += std::to_string(iBits) + ",";
+	}
+
+	// a core profile has no *_BITS queries, don't leave its error for someone else to find:
+	glGetError();
+
+	return szKey;
+}
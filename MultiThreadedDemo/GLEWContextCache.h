@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////
+/// @file		GLEWContextCache.h
+/// @details	glewInit() looks up every entry point and extension GLEW knows
+///				of, thousands of them, for every context. Contexts made by the
+///				same driver with the same hints and pixel format get the same
+///				answers, so only the first of each kind is initialised and the
+///				rest are a copy of its GLEWContext. The key is the GL vendor,
+///				renderer and version strings, the GLFW context hints and the
+///				framebuffer's bit depths, all of which are readable before
+///				GLEW is.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _GLEWCONTEXTCACHE_H_
+#define _GLEWCONTEXTCACHE_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+struct GLEWContextCacheStats
+{
+	unsigned int	m_uiHits;			// contexts that were copied.
+	unsigned int	m_uiMisses;			// contexts that had to be initialised.
+	double			m_dInitSeconds;		// spent in glewContextInit().
+	double			m_dCopySeconds;		// spent working out the key and copying, hits and misses alike.
+};
+
+class GLEWContextCache
+{
+public:
+	GLEWContextCache();
+	~GLEWContextCache();
+
+	/// With the cache disabled every context runs glewInit(), for comparing start up times.
+	void SetEnabled(bool a_bEnabled)				{ m_bEnabled = a_bEnabled; }
+	bool IsEnabled() const							{ return m_bEnabled; }
+
+	/// Fills in a_pContext for a_pWindow, whose context must be current on this thread and a_pContext the one
+	/// glewGetContext() returns. Returns what glewInit() would.
+	GLenum InitContext(GLEWContext* a_pContext, GLFWwindow* a_pWindow);
+
+	/// Forgets every initialised context, so the next of each kind runs glewInit() again.
+	void Clear();
+
+	GLEWContextCacheStats GetStats() const;
+
+	/// One line of hits, misses and the time spent, for the end of start up.
+	void PrintReport() const;
+
+private:
+	// private and not defined, the cache owns its copies:
+	GLEWContextCache(const GLEWContextCache&);
+	GLEWContextCache& operator=(const GLEWContextCache&);
+
+	struct Entry
+	{
+		std::string		m_szKey;
+		GLEWContext*	m_pContext;
+	};
+
+	static std::string GetKey(GLFWwindow* a_pWindow);
+
+	bool				m_bEnabled;
+	std::vector<Entry>	m_vEntries;			// almost always one, a search is fine.
+	GLEWContextCacheStats m_Stats;
+	mutable std::mutex	m_Lock;				// windows are made on the main thread today, but nothing stops another.
+};
+
+#endif // _GLEWCONTEXTCACHE_H_
@@ -0,0 +1,314 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "GLStateCache.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+
+const GLuint c_uiUnknownName = 0xFFFFFFFF;	// never a real object name, so the first bind of anything goes to GL.
+
+const char * const c_aszGLStateCallNames[GSC_COUNT] =
+{
+	"glUseProgram",
+	"glBindVertexArray",
+	"glActiveTexture",
+	"glBindTexture",
+	"glBindBuffer(Range)",
+	"glEnable/glDisable",
+	"glViewport",
+	"glClearColor",
+};
+
+
+GLStateCache::GLStateCache(bool a_bEnabled)
+	: m_bEnabled(a_bEnabled)
+{
+	memset(m_aullMade, 0, sizeof(m_aullMade));
+	memset(m_aullSkipped, 0, sizeof(m_aullSkipped));
+	Invalidate();
+}
+
+
+void GLStateCache::UseProgram(GLuint a_uiProgram)
+{
+	if (!Changed(GSC_PROGRAM, m_uiProgram != a_uiProgram))
+		return;
+
+	m_uiProgram = a_uiProgram;
+	glUseProgram(a_uiProgram);
+}
+
+
+void GLStateCache::BindVertexArray(GLuint a_uiVertexArray)
+{
+	if (!Changed(GSC_VERTEX_ARRAY, m_uiVertexArray != a_uiVertexArray))
+		return;
+
+	m_uiVertexArray = a_uiVertexArray;
+	glBindVertexArray(a_uiVertexArray);
+}
+
+
+void GLStateCache::ActiveTexture(GLenum a_eUnit)
+{
+	GLuint uiUnit = a_eUnit - GL_TEXTURE0;
+	if (!Changed(GSC_ACTIVE_TEXTURE, m_uiActiveUnit != uiUnit))
+		return;
+
+	m_uiActiveUnit = uiUnit;
+	glActiveTexture(a_eUnit);
+}
+
+
+void GLStateCache::BindTexture(GLenum a_eTarget, GLuint a_uiTexture)
+{
+	int iTarget = GetTextureTarget(a_eTarget);
+	if (iTarget < 0 || m_uiActiveUnit >= c_uiGLStateTextureUnits)
+	{
+		// not something we track, it always goes through:
+		Changed(GSC_TEXTURE, true);
+		glBindTexture(a_eTarget, a_uiTexture);
+		return;
+	}
+
+	GLuint& ruiBound = m_auiTextures[m_uiActiveUnit][iTarget];
+	if (!Changed(GSC_TEXTURE, ruiBound != a_uiTexture))
+		return;
+
+	ruiBound = a_uiTexture;
+	glBindTexture(a_eTarget, a_uiTexture);
+}
+
+
+void GLStateCache::BindBuffer(GLenum a_eTarget, GLuint a_uiBuffer)
+{
+	int iTarget = GetBufferTarget(a_eTarget);
+	if (iTarget < 0)
+	{
+		Changed(GSC_BUFFER, true);
+		glBindBuffer(a_eTarget, a_uiBuffer);
+		return;
+	}
+
+	if (!Changed(GSC_BUFFER, m_auiBuffers[iTarget] != a_uiBuffer))
+		return;
+
+	m_auiBuffers[iTarget] = a_uiBuffer;
+	glBindBuffer(a_eTarget, a_uiBuffer);
+}
+
+
+void GLStateCache::BindBufferRange(GLenum a_eTarget, GLuint a_uiIndex, GLuint a_uiBuffer, GLintptr a_iOffset, GLsizeiptr a_iSize)
+{
+	if (a_eTarget != GL_UNIFORM_BUFFER || a_uiIndex >= c_uiGLStateUniformBindings)
+	{
+		// binding a range binds the generic target too:
+		Changed(GSC_BUFFER, true);
+		InvalidateBuffer(a_eTarget);
+		glBindBufferRange(a_eTarget, a_uiIndex, a_uiBuffer, a_iOffset, a_iSize);
+		return;
+	}
+
+	BufferRange& range = m_aUniformRanges[a_uiIndex];
+	bool bChanged = range.m_uiBuffer != a_uiBuffer || range.m_iOffset != a_iOffset || range.m_iSize != a_iSize || m_auiBuffers[BT_UNIFORM] != a_uiBuffer;
+	if (!Changed(GSC_BUFFER, bChanged))
+		return;
+
+	range.m_uiBuffer = a_uiBuffer;
+	range.m_iOffset = a_iOffset;
+	range.m_iSize = a_iSize;
+	m_auiBuffers[BT_UNIFORM] = a_uiBuffer;
+	glBindBufferRange(a_eTarget, a_uiIndex, a_uiBuffer, a_iOffset, a_iSize);
+}
+
+
+void GLStateCache::Enable(GLenum a_eCapability)
+{
+	SetCapability(a_eCapability, true);
+}
+
+
+void GLStateCache::Disable(GLenum a_eCapability)
+{
+	SetCapability(a_eCapability, false);
+}
+
+
+void GLStateCache::Viewport(GLint a_iX, GLint a_iY, GLsizei a_iWidth, GLsizei a_iHeight)
+{
+	bool bChanged = !m_bViewportKnown || m_aiViewport[0] != a_iX || m_aiViewport[1] != a_iY || m_aiViewport[2] != a_iWidth || m_aiViewport[3] != a_iHeight;
+	if (!Changed(GSC_VIEWPORT, bChanged))
+		return;
+
+	m_aiViewport[0] = a_iX;
+	m_aiViewport[1] = a_iY;
+	m_aiViewport[2] = a_iWidth;
+	m_aiViewport[3] = a_iHeight;
+	m_bViewportKnown = true;
+	glViewport(a_iX, a_iY, a_iWidth, a_iHeight);
+}
+
+
+void GLStateCache::ClearColour(GLfloat a_fRed, GLfloat a_fGreen, GLfloat a_fBlue, GLfloat a_fAlpha)
+{
+	bool bChanged = !m_bClearColourKnown || m_afClearColour[0] != a_fRed || m_afClearColour[1] != a_fGreen
+		|| m_afClearColour[2] != a_fBlue || m_afClearColour[3] != a_fAlpha;
+	if (!Changed(GSC_CLEAR_COLOUR, bChanged))
+		return;
+
+	m_afClearColour[0] = a_fRed;
+	m_afClearColour[1] = a_fGreen;
+	m_afClearColour[2] = a_fBlue;
+	m_afClearColour[3] = a_fAlpha;
+	m_bClearColourKnown = true;
+	glClearColor(a_fRed, a_fGreen, a_fBlue, a_fAlpha);
+}
+
+
+void GLStateCache::Invalidate()
+{
+	m_uiProgram = c_uiUnknownName;
+	m_uiVertexArray = c_uiUnknownName;
+	m_uiActiveUnit = c_uiUnknownName;
+	for (unsigned int i = 0; i < c_uiGLStateTextureUnits; ++i)
+	{
+		for (unsigned int j = 0; j < TT_COUNT; ++j)
+			m_auiTextures[i][j] = c_uiUnknownName;
+	}
+	for (unsigned int i = 0; i < BT_COUNT; ++i)
+		m_auiBuffers[i] = c_uiUnknownName;
+	for (unsigned int i = 0; i < c_uiGLStateUniformBindings; ++i)
+	{
+		m_aUniformRanges[i].m_uiBuffer = c_uiUnknownName;
+		m_aUniformRanges[i].m_iOffset = -1;
+		m_aUniformRanges[i].m_iSize = -1;
+	}
+	for (unsigned int i = 0; i < sizeof(m_aiCapabilities) / sizeof(m_aiCapabilities[0]); ++i)
+		m_aiCapabilities[i] = -1;
+	m_bViewportKnown = false;
+	m_bClearColourKnown = false;
+}
+
+
+void GLStateCache::InvalidateBuffer(GLenum a_eTarget)
+{
+	int iTarget = GetBufferTarget(a_eTarget);
+	if (iTarget >= 0)
+		m_auiBuffers[iTarget] = c_uiUnknownName;
+}
+
+
+void GLStateCache::InvalidateTexture(GLenum a_eTarget)
+{
+	int iTarget = GetTextureTarget(a_eTarget);
+	if (iTarget < 0)
+		return;
+	for (unsigned int i = 0; i < c_uiGLStateTextureUnits; ++i)
+		m_auiTextures[i][iTarget] = c_uiUnknownName;
+}
+
+
+unsigned long long GLStateCache::GetTotalCallsMade() const
+{
+	unsigned long long ullTotal = 0;
+	for (unsigned int i = 0; i < GSC_COUNT; ++i)
+		ullTotal += m_aullMade[i];
+	return ullTotal;
+}
+
+
+unsigned long long GLStateCache::GetTotalCallsSkipped() const
+{
+	unsigned long long ullTotal = 0;
+	for (unsigned int i = 0; i < GSC_COUNT; ++i)
+		ullTotal += m_aullSkipped[i];
+	return ullTotal;
+}
+
+
+void GLStateCache::PrintCounters(unsigned int a_uiWindowID) const
+{
+	unsigned long long ullMade = GetTotalCallsMade();
+	unsigned long long ullSkipped = GetTotalCallsSkipped();
+	unsigned long long ullTotal = ullMade + ullSkipped;
+	printf("Window %u state cache (%s): %llu of %llu state calls were redundant (%.1f%%)\n", a_uiWindowID, m_bEnabled ? "skipping them" : "disabled, made them anyway",
+		ullSkipped, ullTotal, ullTotal > 0 ? ullSkipped * 100.0 / ullTotal : 0.0);
+
+	for (unsigned int i = 0; i < GSC_COUNT; ++i)
+	{
+		if (m_aullMade[i] + m_aullSkipped[i] > 0)
+			printf("    %-22s %12llu made %12llu redundant\n", c_aszGLStateCallNames[i], m_aullMade[i], m_aullSkipped[i]);
+	}
+}
+
+
+int GLStateCache::GetTextureTarget(GLenum a_eTarget)
+{
+	switch (a_eTarget)
+	{
+	case GL_TEXTURE_2D:				return TT_2D;
+	case GL_TEXTURE_2D_ARRAY:		return TT_2D_ARRAY;
+	case GL_TEXTURE_CUBE_MAP:		return TT_CUBE_MAP;
+	default:						return -1;
+	}
+}
+
+
+int GLStateCache::GetBufferTarget(GLenum a_eTarget)
+{
+	switch (a_eTarget)
+	{
+	case GL_ARRAY_BUFFER:			return BT_ARRAY;
+	case GL_UNIFORM_BUFFER:			return BT_UNIFORM;
+	case GL_PIXEL_UNPACK_BUFFER:	return BT_PIXEL_UNPACK;
+	case GL_COPY_READ_BUFFER:		return BT_COPY_READ;
+	case GL_COPY_WRITE_BUFFER:		return BT_COPY_WRITE;
+	default:						return -1;
+	}
+}
+
+
+int GLStateCache::GetCapability(GLenum a_eCapability)
+{
+	switch (a_eCapability)
+	{
+	case GL_DEPTH_TEST:				return 0;
+	case GL_CULL_FACE:				return 1;
+	case GL_BLEND:					return 2;
+	case GL_SCISSOR_TEST:			return 3;
+	default:						return -1;
+	}
+}
+
+
+void GLStateCache::SetCapability(GLenum a_eCapability, bool a_bEnable)
+{
+	int iCapability = GetCapability(a_eCapability);
+	int iState = a_bEnable ? 1 : 0;
+	bool bChanged = iCapability < 0 || m_aiCapabilities[iCapability] != iState;
+	if (!Changed(GSC_ENABLE, bChanged))
+		return;
+
+	if (iCapability >= 0)
+		m_aiCapabilities[iCapability] = iState;
+
+	if (a_bEnable)
+		glEnable(a_eCapability);
+	else
+		glDisable(a_eCapability);
+}
+
+
+bool GLStateCache::Changed(GLStateCalls a_eCall, bool a_bChanged)
+{
+	if (a_bChanged)
+		++m_aullMade[a_eCall];
+	else
+		++m_aullSkipped[a_eCall];
+
+	// disabled, we still want the counts so the two can be compared:
+	return a_bChanged || !m_bEnabled;
+}
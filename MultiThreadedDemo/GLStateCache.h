@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////
+/// @file		GLStateCache.h
+/// @details	Shadow copy of the GL state a context has bound, so that binding
+///				what is already bound costs a compare instead of a driver call.
+///				GL state belongs to the context, not the thread, so every window
+///				owns one of these and it stays right whichever thread makes the
+///				window current. Only the thread the context is current on may use
+///				it, the same rule as the context itself.
+///				Anything that changes cached state without going through the cache
+///				(StreamBuffer, the loader) must call Invalidate() afterwards. Object
+///				names are not reference counted, so a deleted name must be unbound
+///				through the cache first or it may be skipped if the name is reused.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _GLSTATECACHE_H_
+#define _GLSTATECACHE_H_
+
+const unsigned int c_uiGLStateTextureUnits = 16;		// units above this are passed straight through.
+const unsigned int c_uiGLStateUniformBindings = 16;		// same for indexed uniform buffer binding points.
+
+enum GLStateCalls
+{
+	GSC_PROGRAM = 0,		// glUseProgram
+	GSC_VERTEX_ARRAY,		// glBindVertexArray
+	GSC_ACTIVE_TEXTURE,		// glActiveTexture
+	GSC_TEXTURE,			// glBindTexture
+	GSC_BUFFER,				// glBindBuffer and glBindBufferRange
+	GSC_ENABLE,				// glEnable and glDisable
+	GSC_VIEWPORT,			// glViewport
+	GSC_CLEAR_COLOUR,		// glClearColor
+
+	GSC_COUNT,
+};
+
+class GLStateCache
+{
+public:
+	/// Disabled the cache still counts what it would have skipped but makes every call, for comparing the two.
+	GLStateCache(bool a_bEnabled = true);
+
+	void UseProgram(GLuint a_uiProgram);
+	void BindVertexArray(GLuint a_uiVertexArray);
+	void ActiveTexture(GLenum a_eUnit);
+	void BindTexture(GLenum a_eTarget, GLuint a_uiTexture);		// on the active unit.
+	void BindBuffer(GLenum a_eTarget, GLuint a_uiBuffer);		// GL_ELEMENT_ARRAY_BUFFER belongs to the VAO, it is never cached.
+	void BindBufferRange(GLenum a_eTarget, GLuint a_uiIndex, GLuint a_uiBuffer, GLintptr a_iOffset, GLsizeiptr a_iSize);
+	void Enable(GLenum a_eCapability);
+	void Disable(GLenum a_eCapability);
+	void Viewport(GLint a_iX, GLint a_iY, GLsizei a_iWidth, GLsizei a_iHeight);
+	void ClearColour(GLfloat a_fRed, GLfloat a_fGreen, GLfloat a_fBlue, GLfloat a_fAlpha);
+
+	/// Forget everything, the next call of each kind goes to GL.
+	void Invalidate();
+	void InvalidateBuffer(GLenum a_eTarget);	// just one buffer target, after StreamBuffer has bound its own.
+	void InvalidateTexture(GLenum a_eTarget);	// one texture target on every unit, see SharedResourceView::m_bWaited.
+
+	bool IsEnabled() const										{ return m_bEnabled; }
+	unsigned long long GetCallsMade(GLStateCalls a_eCall) const		{ return m_aullMade[a_eCall]; }
+	unsigned long long GetCallsSkipped(GLStateCalls a_eCall) const	{ return m_aullSkipped[a_eCall]; }
+	unsigned long long GetTotalCallsMade() const;
+	unsigned long long GetTotalCallsSkipped() const;
+
+	/// One line per kind of call, with how many were made and how many were redundant.
+	void PrintCounters(unsigned int a_uiWindowID) const;
+
+private:
+	enum TextureTargets
+	{
+		TT_2D = 0,
+		TT_2D_ARRAY,
+		TT_CUBE_MAP,
+
+		TT_COUNT,
+	};
+
+	enum BufferTargets
+	{
+		BT_ARRAY = 0,
+		BT_UNIFORM,
+		BT_PIXEL_UNPACK,
+		BT_COPY_READ,
+		BT_COPY_WRITE,
+
+		BT_COUNT,
+	};
+
+	struct BufferRange
+	{
+		GLuint		m_uiBuffer;
+		GLintptr	m_iOffset;
+		GLsizeiptr	m_iSize;
+	};
+
+	static int GetTextureTarget(GLenum a_eTarget);
+	static int GetBufferTarget(GLenum a_eTarget);
+	static int GetCapability(GLenum a_eCapability);
+	void SetCapability(GLenum a_eCapability, bool a_bEnable);
+
+	// returns true if the call needs to be made, and counts it either way:
+	bool Changed(GLStateCalls a_eCall, bool a_bChanged);
+
+	bool				m_bEnabled;
+
+	GLuint				m_uiProgram;
+	GLuint				m_uiVertexArray;
+	GLuint				m_uiActiveUnit;
+	GLuint				m_auiTextures[c_uiGLStateTextureUnits][TT_COUNT];
+	GLuint				m_auiBuffers[BT_COUNT];
+	BufferRange			m_aUniformRanges[c_uiGLStateUniformBindings];
+	int					m_aiCapabilities[4];		// -1 unknown, 0 disabled, 1 enabled. See GetCapability().
+	GLint				m_aiViewport[4];
+	GLfloat				m_afClearColour[4];
+	bool				m_bViewportKnown;
+	bool				m_bClearColourKnown;
+
+	unsigned long long	m_aullMade[GSC_COUNT];
+	unsigned long long	m_aullSkipped[GSC_COUNT];
+};
+
+#endif // _GLSTATECACHE_H_
@@ -0,0 +1,298 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ThreadingDemo.h"
+#include "ContextRegistry.h"
+#include "GPUTimer.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+
+static const char* const c_aszScopeNames[GTS_COUNT] = { "clear", "draw", "swap" };
+
+// renderers whose timestamps are taken on the CPU, so they say nothing about a GPU:
+static const char* const c_aszSoftwareRenderers[] = { "llvmpipe", "softpipe", "Software", "SwiftShader", "GDI Generic", "Headless" };
+
+
+GPUTimer::GPUTimer(bool a_bAllowQueries)
+	: m_bAllowQueries(a_bAllowQueries)
+	, m_bChecked(false)
+	, m_bUseQueries(false)
+	, m_ullFrame(0)
+	, m_pCurrent(nullptr)
+	, m_uiTimelineNext(0)
+	, m_ullResolved(0)
+	, m_ullGPUResolved(0)
+	, m_ullDropped(0)
+{
+	memset(m_aSlots, 0, sizeof(m_aSlots));
+	for (unsigned int i = 0; i < GTS_COUNT; ++i)
+	{
+		m_adCPUTotal[i] = 0.0;
+		m_adGPUTotal[i] = 0.0;
+	}
+}
+
+
+GPUTimer::~GPUTimer()
+{
+	if (m_bUseQueries)
+		printf("Warning: GPUTimer was not destroyed!\n");
+}
+
+
+void GPUTimer::Destroy()
+{
+	if (!m_bUseQueries)
+		return;
+
+	// whatever is still in flight is never read:
+	for (auto& slot : m_aSlots)
+		glDeleteQueries(GTS_COUNT * 2, slot.m_auiQueries);
+	m_bUseQueries = false;
+}
+
+
+bool GPUTimer::QueriesSupported()
+{
+	// GL_TIMESTAMP is core from 3.3:
+	if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query)
+		return false;
+
+	const char* szRenderer = (const char*)glGetString(GL_RENDERER);
+	if (szRenderer == nullptr)
+		return false;
+	for (const char* szSoftware : c_aszSoftwareRenderers)
+	{
+		if (strstr(szRenderer, szSoftware) != nullptr)
+			return false;
+	}
+	return true;
+}
+
+
+const char* GPUTimer::GetScopeName(GPUTimerScopes a_eScope)
+{
+	return a_eScope < GTS_COUNT ? c_aszScopeNames[a_eScope] : "unknown";
+}
+
+
+void GPUTimer::BeginFrame()
+{
+	if (!m_bChecked)
+	{
+		m_bChecked = true;
+		m_bUseQueries = m_bAllowQueries && QueriesSupported();
+		if (m_bUseQueries)
+		{
+			for (auto& slot : m_aSlots)
+				glGenQueries(GTS_COUNT * 2, slot.m_auiQueries);
+		}
+	}
+
+	// the slot was last used c_uiGPUTimerLatency frames ago, its results should have long been ready:
+	Slot& slot = m_aSlots[m_ullFrame % c_uiGPUTimerLatency];
+	if (slot.m_bPending)
+		Resolve(slot);
+
+	slot.m_Frame.m_ullFrame = m_ullFrame++;
+	slot.m_Frame.m_bGPUTimes = m_bUseQueries;
+	slot.m_Frame.m_uiScopes = 0;
+	slot.m_uiLastQuery = 0;
+	m_pCurrent = &slot;
+}
+
+
+void GPUTimer::BeginScope(GPUTimerScopes a_eScope)
+{
+	if (m_pCurrent == nullptr)
+		return;
+
+	if (m_bUseQueries)
+	{
+		m_pCurrent->m_uiLastQuery = m_pCurrent->m_auiQueries[a_eScope * 2];
+		glQueryCounter(m_pCurrent->m_uiLastQuery, GL_TIMESTAMP);
+	}
+	m_pCurrent->m_Frame.m_adCPUStart[a_eScope] = glfwGetTime();
+}
+
+
+void GPUTimer::EndScope(GPUTimerScopes a_eScope)
+{
+	if (m_pCurrent == nullptr)
+		return;
+
+	GPUTimerFrame& frame = m_pCurrent->m_Frame;
+	frame.m_adCPUSeconds[a_eScope] = glfwGetTime() - frame.m_adCPUStart[a_eScope];
+	frame.m_uiScopes |= 1 << a_eScope;
+
+	if (m_bUseQueries)
+	{
+		m_pCurrent->m_uiLastQuery = m_pCurrent->m_auiQueries[a_eScope * 2 + 1];
+		glQueryCounter(m_pCurrent->m_uiLastQuery, GL_TIMESTAMP);
+	}
+}
+
+
+void GPUTimer::EndFrame()
+{
+	if (m_pCurrent == nullptr)
+		return;
+
+	// CPU times are known now, GPU times once the slot comes round again:
+	if (m_bUseQueries && m_pCurrent->m_uiLastQuery != 0)
+		m_pCurrent->m_bPending = true;
+	else if (m_pCurrent->m_Frame.m_uiScopes != 0)
+		AddToTimeline(m_pCurrent->m_Frame);
+	m_pCurrent = nullptr;
+}
+
+
+void GPUTimer::Resolve(Slot& a_rSlot)
+{
+	a_rSlot.m_bPending = false;
+
+	// timestamps complete in order, so if the last is ready every one before it is. If not, drop the frame rather than wait:
+	GLuint64 ullAvailable = 0;
+	glGetQueryObjectui64v(a_rSlot.m_uiLastQuery, GL_QUERY_RESULT_AVAILABLE, &ullAvailable);
+	if (ullAvailable == 0)
+	{
+		++m_ullDropped;
+		return;
+	}
+
+	GPUTimerFrame& frame = a_rSlot.m_Frame;
+	GLuint64 ullFirst = 0;
+	for (unsigned int i = 0; i < GTS_COUNT; ++i)
+	{
+		frame.m_adGPUStart[i] = 0.0;
+		frame.m_adGPUSeconds[i] = 0.0;
+		if ((frame.m_uiScopes & (1 << i)) == 0)
+			continue;
+
+		GLuint64 ullStart = 0;
+		GLuint64 ullEnd = 0;
+		glGetQueryObjectui64v(a_rSlot.m_auiQueries[i * 2], GL_QUERY_RESULT, &ullStart);
+		glGetQueryObjectui64v(a_rSlot.m_auiQueries[i * 2 + 1], GL_QUERY_RESULT, &ullEnd);
+		if (ullFirst == 0)
+			ullFirst = ullStart;
+
+		frame.m_adGPUStart[i] = (ullStart - ullFirst) * 1e-9;
+		frame.m_adGPUSeconds[i] = ullEnd > ullStart ? (ullEnd - ullStart) * 1e-9 : 0.0;
+	}
+
+	AddToTimeline(frame);
+}
+
+
+void GPUTimer::AddToTimeline(const GPUTimerFrame& a_rFrame)
+{
+	if (m_vTimeline.size() < c_uiGPUTimelineFrames)
+	{
+		m_vTimeline.push_back(a_rFrame);
+	}
+	else
+	{
+		m_vTimeline[m_uiTimelineNext] = a_rFrame;
+		m_uiTimelineNext = (m_uiTimelineNext + 1) % c_uiGPUTimelineFrames;
+	}
+
+	++m_ullResolved;
+	if (a_rFrame.m_bGPUTimes)
+		++m_ullGPUResolved;
+	for (unsigned int i = 0; i < GTS_COUNT; ++i)
+	{
+		if ((a_rFrame.m_uiScopes & (1 << i)) == 0)
+			continue;
+		m_adCPUTotal[i] += a_rFrame.m_adCPUSeconds[i];
+		if (a_rFrame.m_bGPUTimes)
+			m_adGPUTotal[i] += a_rFrame.m_adGPUSeconds[i];
+	}
+}
+
+
+void GPUTimer::GetTimeline(std::vector<GPUTimerFrame>& a_rvFrames) const
+{
+	a_rvFrames.clear();
+	a_rvFrames.insert(a_rvFrames.end(), m_vTimeline.begin() + m_uiTimelineNext, m_vTimeline.end());
+	a_rvFrames.insert(a_rvFrames.end(), m_vTimeline.begin(), m_vTimeline.begin() + m_uiTimelineNext);
+}
+
+
+double GPUTimer::GetMeanCPUSeconds(GPUTimerScopes a_eScope) const
+{
+	return m_ullResolved > 0 ? m_adCPUTotal[a_eScope] / m_ullResolved : 0.0;
+}
+
+
+double GPUTimer::GetMeanGPUSeconds(GPUTimerScopes a_eScope) const
+{
+	return m_ullGPUResolved > 0 ? m_adGPUTotal[a_eScope] / m_ullGPUResolved : 0.0;
+}
+
+
+void PrintGPUTimers(const std::vector<WindowHandle>& a_vWindows)
+{
+	printf("\n%8s %8s %10s %10s %10s %10s\n", "Window", "Scope", "Frames", "CPU ms", "GPU ms", "Dropped");
+	for (auto window : a_vWindows)
+	{
+		const GPUTimer* pTimer = window->m_pGPUTimer;
+		if (pTimer == nullptr || pTimer->GetResolvedFrames() == 0)
+			continue;
+
+		for (unsigned int i = 0; i < GTS_COUNT; ++i)
+		{
+			GPUTimerScopes eScope = (GPUTimerScopes)i;
+			if (pTimer->UsesQueries())
+				printf("%8u %8s %10llu %10.3f %10.3f %10llu\n", window->m_uiID, GPUTimer::GetScopeName(eScope), pTimer->GetResolvedFrames(),
+					pTimer->GetMeanCPUSeconds(eScope) * 1000.0, pTimer->GetMeanGPUSeconds(eScope) * 1000.0, pTimer->GetDroppedFrames());
+			else
+				printf("%8u %8s %10llu %10.3f %10s %10s\n", window->m_uiID, GPUTimer::GetScopeName(eScope), pTimer->GetResolvedFrames(),
+					pTimer->GetMeanCPUSeconds(eScope) * 1000.0, "cpu only", "");
+		}
+	}
+	printf("\n");
+}
+
+
+bool DumpGPUTimeline(const std::vector<WindowHandle>& a_vWindows, const std::string& a_szFileName)
+{
+	FILE* pFile = fopen(a_szFileName.c_str(), "w");
+	if (pFile == nullptr)
+	{
+		printf("Error: Could not open %s to write the GPU timeline!\n", a_szFileName.c_str());
+		return false;
+	}
+
+	// GPU columns are empty for frames that only have CPU times:
+	fprintf(pFile, "window,frame,scope,cpu_start_ms,cpu_ms,gpu_start_ms,gpu_ms\n");
+
+	std::vector<GPUTimerFrame> vFrames;
+	for (auto window : a_vWindows)
+	{
+		if (window->m_pGPUTimer == nullptr)
+			continue;
+
+		window->m_pGPUTimer->GetTimeline(vFrames);
+		for (const auto& frame : vFrames)
+		{
+			for (unsigned int i = 0; i < GTS_COUNT; ++i)
+			{
+				if ((frame.m_uiScopes & (1 << i)) == 0)
+					continue;
+
+				fprintf(pFile, "%u,%llu,%s,%.3f,%.3f,", window->m_uiID, frame.m_ullFrame, c_aszScopeNames[i],
+					frame.m_adCPUStart[i] * 1000.0, frame.m_adCPUSeconds[i] * 1000.0);
+				if (frame.m_bGPUTimes)
+					fprintf(pFile, "%.3f,%.3f\n", frame.m_adGPUStart[i] * 1000.0, frame.m_adGPUSeconds[i] * 1000.0);
+				else
+					fprintf(pFile, ",\n");
+			}
+		}
+	}
+
+	fclose(pFile);
+	printf("Status: Wrote the GPU timeline to %s\n", a_szFileName.c_str());
+	return true;
+}
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////
+/// @file		GPUTimer.h
+/// @details	Per window timing of the passes of a frame (clear, draw, swap)
+///				on both the CPU and the GPU, to tell submitting a frame apart
+///				from executing it. Each scope writes a GL_TIMESTAMP query at
+///				its start and end. The queries sit in a ring of
+///				c_uiGPUTimerLatency frames and are only read when their slot
+///				comes round again, so reading them never waits on the GPU.
+///				Results that are still not ready are dropped, not waited for.
+///				Without timer queries, or on a software or the headless GL,
+///				only CPU timestamps are taken. Resolved frames go into a
+///				timeline that can be written out with DumpGPUTimeline().
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _GPUTIMER_H_
+#define _GPUTIMER_H_
+
+#include <vector>
+#include <string>
+
+struct Window;
+typedef Window* WindowHandle;
+
+////////////////////////// Constants //////////////////////////////////
+const unsigned int c_uiGPUTimerLatency = 4;			// frames between issuing a frame's queries and reading them.
+const unsigned int c_uiGPUTimelineFrames = 1024;	// resolved frames kept per window, the oldest are overwritten.
+
+///////////////////// Custom Data Types ///////////////////////////////
+enum GPUTimerScopes
+{
+	GTS_CLEAR = 0,
+	GTS_DRAW,
+	GTS_SWAP,
+
+	GTS_COUNT,
+};
+
+struct GPUTimerFrame
+{
+	unsigned long long	m_ullFrame;
+	bool				m_bGPUTimes;						// false if only the CPU times are valid.
+	double				m_adCPUStart[GTS_COUNT];			// glfwGetTime(), seconds.
+	double				m_adCPUSeconds[GTS_COUNT];
+	double				m_adGPUStart[GTS_COUNT];			// seconds after the frame's first timestamp, the GPU has its own clock.
+	double				m_adGPUSeconds[GTS_COUNT];
+	unsigned int		m_uiScopes;							// a bit per GPUTimerScopes that was timed this frame.
+};
+
+class GPUTimer
+{
+public:
+	/// a_bAllowQueries false always uses CPU timestamps (-cputimers).
+	explicit GPUTimer(bool a_bAllowQueries);
+	~GPUTimer();	// Destroy() must have been called with the window's context current.
+
+	void Destroy();
+
+	/// The window's context must be current for all of these, and stay on the same thread from BeginFrame() to EndFrame().
+	/// BeginFrame() reads back the frame issued c_uiGPUTimerLatency frames ago, if its results are ready.
+	void BeginFrame();
+	void BeginScope(GPUTimerScopes a_eScope);
+	void EndScope(GPUTimerScopes a_eScope);
+	void EndFrame();
+
+	bool UsesQueries() const						{ return m_bUseQueries; }
+	unsigned long long GetResolvedFrames() const	{ return m_ullResolved; }
+	unsigned long long GetDroppedFrames() const		{ return m_ullDropped; }	// results not ready when their slot came round.
+
+	/// The resolved frames, oldest first.
+	void GetTimeline(std::vector<GPUTimerFrame>& a_rvFrames) const;
+
+	/// Mean over every resolved frame, in seconds.
+	double GetMeanCPUSeconds(GPUTimerScopes a_eScope) const;
+	double GetMeanGPUSeconds(GPUTimerScopes a_eScope) const;
+
+	static const char* GetScopeName(GPUTimerScopes a_eScope);
+
+	/// Whether the current context has usable timer queries. Software renderers and the headless GL report them but their
+	/// timestamps are not GPU time, so they use CPU timestamps instead.
+	static bool QueriesSupported();
+
+private:
+	GPUTimer(const GPUTimer&);
+	GPUTimer& operator=(const GPUTimer&);
+
+	struct Slot
+	{
+		GPUTimerFrame	m_Frame;
+		GLuint			m_auiQueries[GTS_COUNT * 2];		// start and end of each scope.
+		bool			m_bPending;							// issued and not read back yet.
+		GLuint			m_uiLastQuery;						// the last timestamp issued, once it is ready they all are.
+	};
+
+	void Resolve(Slot& a_rSlot);
+	void AddToTimeline(const GPUTimerFrame& a_rFrame);
+
+	bool					m_bAllowQueries;
+	bool					m_bChecked;						// queries are checked for on the first frame, with a context current.
+	bool					m_bUseQueries;
+	Slot					m_aSlots[c_uiGPUTimerLatency];
+	unsigned long long		m_ullFrame;
+	Slot*					m_pCurrent;						// between BeginFrame() and EndFrame().
+
+	std::vector<GPUTimerFrame>	m_vTimeline;				// a ring once it is full, m_uiTimelineNext is the oldest.
+	unsigned int				m_uiTimelineNext;
+	unsigned long long			m_ullResolved;
+	unsigned long long			m_ullGPUResolved;
+	unsigned long long			m_ullDropped;
+	double						m_adCPUTotal[GTS_COUNT];
+	double						m_adGPUTotal[GTS_COUNT];
+};
+
+/// Times a scope of the current frame for as long as it is in scope.
+class ScopedGPUTimer
+{
+public:
+	ScopedGPUTimer(GPUTimer& a_rTimer, GPUTimerScopes a_eScope) : m_rTimer(a_rTimer), m_eScope(a_eScope)	{ m_rTimer.BeginScope(m_eScope); }
+	~ScopedGPUTimer()																						{ m_rTimer.EndScope(m_eScope); }
+
+private:
+	ScopedGPUTimer(const ScopedGPUTimer&);
+	ScopedGPUTimer& operator=(const ScopedGPUTimer&);
+
+	GPUTimer&		m_rTimer;
+	GPUTimerScopes	m_eScope;
+};
+
+/////////////////////////// Functions /////////////////////////////////
+/// Prints the mean CPU and GPU time of each scope for every window.
+void PrintGPUTimers(const std::vector<WindowHandle>& a_vWindows);
+
+/// Writes every window's timeline to a_szFileName as CSV, one row per scope per frame. Returns false if the file could not be opened.
+bool DumpGPUTimeline(const std::vector<WindowHandle>& a_vWindows, const std::string& a_szFileName);
+
+#endif // _GPUTIMER_H_
@@ -0,0 +1,1766 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "HeadlessGL.h"
+
+#ifdef HEADLESS_GL
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+/////////////////////// Recorded Calls ////////////////////////////////
+// OpenGL 1.1 entry points, these are linked directly rather than going through GLEW:
+#define HEADLESS_GL11_FUNCTIONS(X) \
+	X(Clear, HCK_OTHER) \
+	X(ClearColor, HCK_STATE) \
+	X(Viewport, HCK_STATE) \
+	X(Enable, HCK_STATE) \
+	X(Disable, HCK_STATE) \
+	X(IsEnabled, HCK_QUERY) \
+	X(GetIntegerv, HCK_QUERY) \
+	X(GetError, HCK_QUERY) \
+	X(GetString, HCK_QUERY) \
+	X(BindTexture, HCK_STATE) \
+	X(GenTextures, HCK_OTHER) \
+	X(DeleteTextures, HCK_OTHER) \
+	X(TexImage2D, HCK_UPLOAD) \
+	X(TexSubImage2D, HCK_UPLOAD) \
+	X(TexParameterf, HCK_STATE) \
+	X(TexParameteri, HCK_STATE) \
+	X(PixelStorei, HCK_STATE) \
+	X(DrawElements, HCK_DRAW) \
+	X(Flush, HCK_SYNC) \
+	X(Finish, HCK_SYNC)
+
+// Entry points that GLEW MX loads into its function table:
+#define HEADLESS_GLEW_FUNCTIONS(X) \
+	X(ActiveTexture, PFNGLACTIVETEXTUREPROC, HCK_STATE) \
+	X(AttachShader, PFNGLATTACHSHADERPROC, HCK_OTHER) \
+	X(BeginQuery, PFNGLBEGINQUERYPROC, HCK_OTHER) \
+	X(BindAttribLocation, PFNGLBINDATTRIBLOCATIONPROC, HCK_OTHER) \
+	X(BindBuffer, PFNGLBINDBUFFERPROC, HCK_STATE) \
+	X(BindBufferRange, PFNGLBINDBUFFERRANGEPROC, HCK_STATE) \
+	X(BindFragDataLocation, PFNGLBINDFRAGDATALOCATIONPROC, HCK_OTHER) \
+	X(BindFramebuffer, PFNGLBINDFRAMEBUFFERPROC, HCK_STATE) \
+	X(BindVertexArray, PFNGLBINDVERTEXARRAYPROC, HCK_STATE) \
+	X(BlitFramebuffer, PFNGLBLITFRAMEBUFFERPROC, HCK_DRAW) \
+	X(BufferData, PFNGLBUFFERDATAPROC, HCK_UPLOAD) \
+	X(BufferStorage, PFNGLBUFFERSTORAGEPROC, HCK_OTHER) \
+	X(BufferSubData, PFNGLBUFFERSUBDATAPROC, HCK_UPLOAD) \
+	X(CheckFramebufferStatus, PFNGLCHECKFRAMEBUFFERSTATUSPROC, HCK_QUERY) \
+	X(ClientWaitSync, PFNGLCLIENTWAITSYNCPROC, HCK_SYNC) \
+	X(CompileShader, PFNGLCOMPILESHADERPROC, HCK_OTHER) \
+	X(CreateProgram, PFNGLCREATEPROGRAMPROC, HCK_OTHER) \
+	X(CreateShader, PFNGLCREATESHADERPROC, HCK_OTHER) \
+	X(DebugMessageCallback, PFNGLDEBUGMESSAGECALLBACKPROC, HCK_OTHER) \
+	X(DebugMessageControl, PFNGLDEBUGMESSAGECONTROLPROC, HCK_OTHER) \
+	X(DeleteBuffers, PFNGLDELETEBUFFERSPROC, HCK_OTHER) \
+	X(DeleteFramebuffers, PFNGLDELETEFRAMEBUFFERSPROC, HCK_OTHER) \
+	X(DeleteProgram, PFNGLDELETEPROGRAMPROC, HCK_OTHER) \
+	X(DeleteProgramPipelines, PFNGLDELETEPROGRAMPIPELINESPROC, HCK_OTHER) \
+	X(DeleteQueries, PFNGLDELETEQUERIESPROC, HCK_OTHER) \
+	X(DeleteShader, PFNGLDELETESHADERPROC, HCK_OTHER) \
+	X(DeleteSync, PFNGLDELETESYNCPROC, HCK_SYNC) \
+	X(DeleteVertexArrays, PFNGLDELETEVERTEXARRAYSPROC, HCK_OTHER) \
+	X(DrawElementsInstanced, PFNGLDRAWELEMENTSINSTANCEDPROC, HCK_DRAW) \
+	X(DrawElementsInstancedBaseInstance, PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC, HCK_DRAW) \
+	X(EnableVertexAttribArray, PFNGLENABLEVERTEXATTRIBARRAYPROC, HCK_STATE) \
+	X(EndQuery, PFNGLENDQUERYPROC, HCK_OTHER) \
+	X(FenceSync, PFNGLFENCESYNCPROC, HCK_SYNC) \
+	X(FramebufferTexture, PFNGLFRAMEBUFFERTEXTUREPROC, HCK_STATE) \
+	X(FramebufferTextureLayer, PFNGLFRAMEBUFFERTEXTURELAYERPROC, HCK_STATE) \
+	X(GenBuffers, PFNGLGENBUFFERSPROC, HCK_OTHER) \
+	X(GenFramebuffers, PFNGLGENFRAMEBUFFERSPROC, HCK_OTHER) \
+	X(GenProgramPipelines, PFNGLGENPROGRAMPIPELINESPROC, HCK_OTHER) \
+	X(GenQueries, PFNGLGENQUERIESPROC, HCK_OTHER) \
+	X(GenVertexArrays, PFNGLGENVERTEXARRAYSPROC, HCK_OTHER) \
+	X(GetActiveAttrib, PFNGLGETACTIVEATTRIBPROC, HCK_QUERY) \
+	X(GetActiveUniform, PFNGLGETACTIVEUNIFORMPROC, HCK_QUERY) \
+	X(GetActiveUniformBlockName, PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC, HCK_QUERY) \
+	X(GetActiveUniformBlockiv, PFNGLGETACTIVEUNIFORMBLOCKIVPROC, HCK_QUERY) \
+	X(GetAttribLocation, PFNGLGETATTRIBLOCATIONPROC, HCK_QUERY) \
+	X(GetProgramBinary, PFNGLGETPROGRAMBINARYPROC, HCK_QUERY) \
+	X(GetProgramInfoLog, PFNGLGETPROGRAMINFOLOGPROC, HCK_QUERY) \
+	X(GetProgramiv, PFNGLGETPROGRAMIVPROC, HCK_QUERY) \
+	X(GetQueryObjectui64v, PFNGLGETQUERYOBJECTUI64VPROC, HCK_QUERY) \
+	X(GetShaderInfoLog, PFNGLGETSHADERINFOLOGPROC, HCK_QUERY) \
+	X(GetShaderiv, PFNGLGETSHADERIVPROC, HCK_QUERY) \
+	X(GetUniformBlockIndex, PFNGLGETUNIFORMBLOCKINDEXPROC, HCK_QUERY) \
+	X(GetUniformLocation, PFNGLGETUNIFORMLOCATIONPROC, HCK_QUERY) \
+	X(LinkProgram, PFNGLLINKPROGRAMPROC, HCK_OTHER) \
+	X(MapBufferRange, PFNGLMAPBUFFERRANGEPROC, HCK_SYNC) \
+	X(ProgramBinary, PFNGLPROGRAMBINARYPROC, HCK_OTHER) \
+	X(ProgramParameteri, PFNGLPROGRAMPARAMETERIPROC, HCK_OTHER) \
+	X(QueryCounter, PFNGLQUERYCOUNTERPROC, HCK_QUERY) \
+	X(ShaderSource, PFNGLSHADERSOURCEPROC, HCK_OTHER) \
+	X(TexImage3D, PFNGLTEXIMAGE3DPROC, HCK_UPLOAD) \
+	X(Uniform1i, PFNGLUNIFORM1IPROC, HCK_UPLOAD) \
+	X(UniformBlockBinding, PFNGLUNIFORMBLOCKBINDINGPROC, HCK_OTHER) \
+	X(UniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC, HCK_UPLOAD) \
+	X(UnmapBuffer, PFNGLUNMAPBUFFERPROC, HCK_SYNC) \
+	X(UseProgram, PFNGLUSEPROGRAMPROC, HCK_STATE) \
+	X(VertexAttribDivisor, PFNGLVERTEXATTRIBDIVISORPROC, HCK_STATE) \
+	X(VertexAttribPointer, PFNGLVERTEXATTRIBPOINTERPROC, HCK_STATE) \
+	X(WaitSync, PFNGLWAITSYNCPROC, HCK_SYNC)
+
+enum HeadlessCalls
+{
+#define HEADLESS_GL11_ENUM(name, kind) HC_##name,
+#define HEADLESS_GLEW_ENUM(name, type, kind) HC_##name,
+	HEADLESS_GL11_FUNCTIONS(HEADLESS_GL11_ENUM)
+	HEADLESS_GLEW_FUNCTIONS(HEADLESS_GLEW_ENUM)
+#undef HEADLESS_GL11_ENUM
+#undef HEADLESS_GLEW_ENUM
+	HC_SwapBuffers,
+
+	HC_COUNT,
+};
+
+static const HeadlessCallKinds c_aeCallKinds[HC_COUNT] =
+{
+#define HEADLESS_GL11_KIND(name, kind) kind,
+#define HEADLESS_GLEW_KIND(name, type, kind) kind,
+	HEADLESS_GL11_FUNCTIONS(HEADLESS_GL11_KIND)
+	HEADLESS_GLEW_FUNCTIONS(HEADLESS_GLEW_KIND)
+#undef HEADLESS_GL11_KIND
+#undef HEADLESS_GLEW_KIND
+	HCK_OTHER,
+};
+
+static const char* const c_aszCallNames[HC_COUNT] =
+{
+#define HEADLESS_GL11_NAME(name, kind) "gl" #name,
+#define HEADLESS_GLEW_NAME(name, type, kind) "gl" #name,
+	HEADLESS_GL11_FUNCTIONS(HEADLESS_GL11_NAME)
+	HEADLESS_GLEW_FUNCTIONS(HEADLESS_GLEW_NAME)
+#undef HEADLESS_GL11_NAME
+#undef HEADLESS_GLEW_NAME
+	"glfwSwapBuffers",
+};
+
+// outside of Win32 GLEW MX keeps the function pointers as globals instead of in the GLEWContext:
+#ifndef _WIN32
+extern "C" {
+#define HEADLESS_GLEW_POINTER(name, type, kind) type __glew##name = nullptr;
+	HEADLESS_GLEW_FUNCTIONS(HEADLESS_GLEW_POINTER)
+#undef HEADLESS_GLEW_POINTER
+}
+#endif
+
+// glew.h leaves GLAPIENTRY empty once it is done with it, but the declarations it made are still __stdcall on Win32:
+#ifdef _WIN32
+#define HEADLESS_APIENTRY __stdcall
+#else
+#define HEADLESS_APIENTRY
+#endif
+
+const unsigned int c_uiTraceCapacity = 1 << 16;		// calls kept per window when tracing.
+const unsigned int c_uiMaxTextureUnits = 32;
+const unsigned int c_uiReportWindowRows = 24;		// windows listed one per row in the report, the rest are summed into one.
+
+struct CallRecord
+{
+	unsigned long long	m_ullTimeNS;
+	unsigned int		m_uiCall;
+};
+
+struct HeadlessFence
+{
+	unsigned long long	m_ullSignalTimeNS;
+};
+
+////////////////////////// Headless Window ////////////////////////////
+// GLFW only ever hands out pointers to this, so we are free to define it.
+struct GLFWwindow
+{
+	std::string					m_szTitle;
+	int							m_iWidth;
+	int							m_iHeight;
+	int							m_iSwapInterval;
+	bool						m_bShouldClose;
+	bool						m_bDestroyed;
+	void*						m_pUserPointer;
+	GLFWwindowsizefun			m_fSizeCallback;
+	GLFWkeyfun					m_fKeyCallback;
+	std::atomic<std::thread::id> m_CurrentThread;	// thread the context is current on.
+	double						m_dCreateTime;
+
+	HeadlessStats				m_Stats;
+	unsigned long long			m_aullCallCounts[HC_COUNT];
+	std::vector<CallRecord>		m_vTrace;
+	unsigned long long			m_ullTraced;
+
+	// shadow state, only used to spot redundant calls:
+	GLuint						m_uiProgram;
+	GLuint						m_uiVertexArray;
+	GLenum						m_eActiveTexture;
+	GLuint						m_auiTextures[c_uiMaxTextureUnits];
+	GLuint						m_uiArrayBuffer;
+	GLuint						m_uiElementBuffer;
+	GLuint						m_uiUniformBuffer;
+	GLuint						m_uiPixelUnpackBuffer;
+	GLint						m_aiViewport[4];
+	GLclampf					m_afClearColour[4];
+	bool						m_bDepthTest;
+	bool						m_bCullFace;
+	bool						m_bBlend;
+	GLuint						m_uiActiveQuery;		// between glBeginQuery() and glEndQuery(), otherwise 0.
+};
+
+// there is only ever the one pretend display, at HEADLESS_GL_REFRESH_HZ:
+struct GLFWmonitor
+{
+	GLFWvidmode					m_VideoMode;
+};
+
+////////////////////////// Backend State //////////////////////////////
+THREAD_LOCAL GLFWwindow* t_pHeadlessCurrent = nullptr;
+GLFWmonitor					g_HeadlessMonitor;
+
+std::mutex					g_HeadlessWindowLock;
+std::list<GLFWwindow*>		g_lHeadlessWindows;		// every window ever created, for the report.
+
+// buffers only get real memory once they are mapped, so mapped writes have somewhere to go:
+struct HeadlessBufferStore
+{
+	GLsizeiptr					m_iSize;
+	std::vector<unsigned char>	m_vMemory;
+};
+std::mutex									g_HeadlessBufferLock;
+std::map<GLuint, HeadlessBufferStore>		g_mHeadlessBuffers;
+
+// program binaries are a fixed blob, any other binary is rejected the way a driver rejects an out of date one:
+const GLenum								c_eHeadlessProgramBinaryFormat = 0x48424E31;	// "HBN1"
+const char									c_acHeadlessProgramBinary[] = "headless program binary v2";	// followed by the program's reflection.
+std::mutex									g_HeadlessProgramLock;
+std::set<GLuint>							g_sHeadlessRejectedPrograms;	// programs whose last glProgramBinary() failed.
+
+// nothing is compiled, but linking reads the attached shaders' declarations so programs can still be reflected:
+struct HeadlessShader
+{
+	GLenum						m_eType;
+	std::string					m_szSource;
+	bool						m_bDeleted;		// glDeleteShader() was called while it was still attached.
+};
+
+struct HeadlessProgram
+{
+	std::vector<GLuint>				m_vShaders;				// attached.
+	std::map<std::string, GLint>	m_mBoundAttributes;		// from glBindAttribLocation(), used at the next link.
+	std::vector<std::string>		m_vUniforms;			// outside blocks, the location of each is its index.
+	std::vector<std::string>		m_vAttributes;			// the vertex shader's inputs.
+	std::vector<GLint>				m_viAttributeLocations;
+	std::vector<std::string>		m_vUniformBlocks;		// the index of each is its position.
+};
+std::map<GLuint, HeadlessShader>			g_mHeadlessShaders;		// guarded by g_HeadlessProgramLock, like the programs.
+std::map<GLuint, HeadlessProgram>			g_mHeadlessPrograms;
+
+// there is no GPU to time, a timer query measures how long the calls between its begin and end took to record:
+struct HeadlessQuery
+{
+	unsigned long long			m_ullBeginNS;
+	unsigned long long			m_ullEndNS;
+};
+std::mutex									g_HeadlessQueryLock;
+std::map<GLuint, HeadlessQuery>				g_mHeadlessQueries;
+std::atomic<GLuint>			g_uiHeadlessNextName(1);
+GLFWerrorfun				g_fHeadlessErrorCallback = nullptr;
+std::chrono::steady_clock::time_point g_HeadlessStartTime;
+bool						g_bHeadlessInitialised = false;
+
+// config, see HeadlessGL.h:
+double						g_dHeadlessRefreshHz = 60.0;
+int							g_iHeadlessSwapInterval = 1;
+double						g_dHeadlessRunTime = 30.0;
+unsigned long long			g_ullHeadlessGPULatencyNS = 0;
+unsigned long long			g_ullHeadlessCallCostNS = 0;
+unsigned long long			g_ullHeadlessLinkCostNS = 0;
+unsigned long long			g_ullHeadlessGLEWInitCostNS = 0;
+std::string					g_szHeadlessTraceFile;
+
+
+static unsigned long long NowNS()
+{
+	return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_HeadlessStartTime).count();
+}
+
+
+static void SleepUntilNS(unsigned long long a_ullTimeNS)
+{
+	std::this_thread::sleep_until(g_HeadlessStartTime + std::chrono::nanoseconds(a_ullTimeNS));
+}
+
+
+static double EnvDouble(const char* a_szName, double a_dDefault)
+{
+	const char* szValue = getenv(a_szName);
+	return szValue != nullptr ? atof(szValue) : a_dDefault;
+}
+
+
+static void Record(HeadlessCalls a_eCall)
+{
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow == nullptr)
+		return;		// no context current, a real driver would ignore the call too.
+
+	++pWindow->m_aullCallCounts[a_eCall];
+	++pWindow->m_Stats.m_aullCalls[c_aeCallKinds[a_eCall]];
+
+	if (!pWindow->m_vTrace.empty())
+	{
+		CallRecord& record = pWindow->m_vTrace[pWindow->m_ullTraced++ % c_uiTraceCapacity];
+		record.m_ullTimeNS = NowNS();
+		record.m_uiCall = a_eCall;
+	}
+
+	if (g_ullHeadlessCallCostNS != 0)
+	{
+		// burn the CPU time a driver would have used:
+		unsigned long long ullEnd = NowNS() + g_ullHeadlessCallCostNS;
+		while (NowNS() < ullEnd) {}
+	}
+}
+
+
+// counts a_bRedundant against the current context, returns a_bRedundant.
+static bool Redundant(bool a_bRedundant)
+{
+	if (a_bRedundant && t_pHeadlessCurrent != nullptr)
+		++t_pHeadlessCurrent->m_Stats.m_ullRedundantStateCalls;
+	return a_bRedundant;
+}
+
+
+static void Uploaded(GLsizeiptr a_iBytes)
+{
+	if (t_pHeadlessCurrent != nullptr && a_iBytes > 0)
+		t_pHeadlessCurrent->m_Stats.m_ullBytesUploaded += (unsigned long long)a_iBytes;
+}
+
+
+static void GenNames(GLsizei a_iCount, GLuint* a_puiNames)
+{
+	for (GLsizei i = 0; i < a_iCount; ++i)
+		a_puiNames[i] = g_uiHeadlessNextName++;
+}
+
+
+static void WriteLog(GLsizei a_iBufSize, GLsizei* a_piLength, GLchar* a_szLog)
+{
+	if (a_piLength != nullptr)
+		*a_piLength = 0;
+	if (a_szLog != nullptr && a_iBufSize > 0)
+		a_szLog[0] = '\0';
+}
+
+
+static void WriteName(const std::string& a_szName, GLsizei a_iBufSize, GLsizei* a_piLength, GLchar* a_szBuffer)
+{
+	if (a_szBuffer == nullptr || a_iBufSize <= 0)
+	{
+		WriteLog(a_iBufSize, a_piLength, a_szBuffer);
+		return;
+	}
+
+	GLsizei iLength = std::min((GLsizei)a_szName.size(), a_iBufSize - 1);
+	memcpy(a_szBuffer, a_szName.c_str(), iLength);
+	a_szBuffer[iLength] = '\0';
+	if (a_piLength != nullptr)
+		*a_piLength = iLength;
+}
+
+
+// words and the punctuation between them, enough for the declarations at the top of the demo's shaders:
+static std::vector<std::string> TokeniseShader(const std::string& a_szSource)
+{
+	std::vector<std::string> vTokens;
+	std::string szToken;
+	for (char c : a_szSource)
+	{
+		bool bSpace = isspace((unsigned char)c) != 0;
+		if (bSpace || c == ';' || c == '{' || c == '}' || c == '(' || c == ')')
+		{
+			if (!szToken.empty())
+				vTokens.push_back(szToken);
+			szToken.clear();
+			if (!bSpace)
+				vTokens.push_back(std::string(1, c));
+		}
+		else
+			szToken += c;
+	}
+	if (!szToken.empty())
+		vTokens.push_back(szToken);
+	return vTokens;
+}
+
+
+static void AddName(std::vector<std::string>& a_rvNames, std::string a_szName)
+{
+	// GL names arrays by their first element:
+	size_t uiBracket = a_szName.find('[');
+	if (uiBracket != std::string::npos)
+		a_szName = a_szName.substr(0, uiBracket) + "[0]";
+	if (std::find(a_rvNames.begin(), a_rvNames.end(), a_szName) == a_rvNames.end())
+		a_rvNames.push_back(a_szName);
+}
+
+
+// every declaration counts as active, a real compiler would drop the unused ones:
+static void ReflectShader(const HeadlessShader& a_rShader, HeadlessProgram& a_rProgram)
+{
+	std::vector<std::string> vTokens = TokeniseShader(a_rShader.m_szSource);
+	int iDepth = 0;
+	for (size_t i = 0; i < vTokens.size(); ++i)
+	{
+		if (vTokens[i] == "{")
+			++iDepth;
+		else if (vTokens[i] == "}")
+			--iDepth;
+		else if (iDepth == 0 && i + 2 < vTokens.size() && vTokens[i] == "uniform" && vTokens[i + 2] == "{")
+			AddName(a_rProgram.m_vUniformBlocks, vTokens[i + 1]);
+		else if (iDepth == 0 && i + 3 < vTokens.size() && vTokens[i + 3] == ";")
+		{
+			if (vTokens[i] == "uniform")
+				AddName(a_rProgram.m_vUniforms, vTokens[i + 2]);
+			else if (vTokens[i] == "in" && a_rShader.m_eType == GL_VERTEX_SHADER)
+				AddName(a_rProgram.m_vAttributes, vTokens[i + 2]);
+		}
+	}
+}
+
+
+// the binary is c_acHeadlessProgramBinary and a line for each uniform, attribute and block:
+static std::string SaveHeadlessProgram(const HeadlessProgram& a_rProgram)
+{
+	std::string szBinary(c_acHeadlessProgramBinary, sizeof(c_acHeadlessProgramBinary));
+	for (auto& szName : a_rProgram.m_vUniforms)
+		szBinary += "u " + szName + "\n";
+	for (size_t i = 0; i < a_rProgram.m_vAttributes.size(); ++i)
+		szBinary += "a " + std::to_string(a_rProgram.m_viAttributeLocations[i]) + " " + a_rProgram.m_vAttributes[i] + "\n";
+	for (auto& szName : a_rProgram.m_vUniformBlocks)
+		szBinary += "b " + szName + "\n";
+	return szBinary;
+}
+
+
+static bool LoadHeadlessProgram(const GLvoid* a_pBinary, GLsizei a_iLength, HeadlessProgram& a_rProgram)
+{
+	if (a_pBinary == nullptr || a_iLength < (GLsizei)sizeof(c_acHeadlessProgramBinary)
+		|| memcmp(a_pBinary, c_acHeadlessProgramBinary, sizeof(c_acHeadlessProgramBinary)) != 0)
+		return false;
+
+	std::string szLines((const char*)a_pBinary + sizeof(c_acHeadlessProgramBinary), a_iLength - sizeof(c_acHeadlessProgramBinary));
+	HeadlessProgram program;
+	size_t uiStart = 0;
+	while (uiStart < szLines.size())
+	{
+		size_t uiEnd = szLines.find('\n', uiStart);
+		if (uiEnd == std::string::npos || uiEnd < uiStart + 3 || szLines[uiStart + 1] != ' ')
+			return false;
+
+		std::string szName = szLines.substr(uiStart + 2, uiEnd - uiStart - 2);
+		switch (szLines[uiStart])
+		{
+		case 'u':	program.m_vUniforms.push_back(szName); break;
+		case 'b':	program.m_vUniformBlocks.push_back(szName); break;
+		case 'a':
+		{
+			char* szAfter = nullptr;
+			long lLocation = strtol(szName.c_str(), &szAfter, 10);
+			if (*szAfter != ' ')
+				return false;
+			program.m_viAttributeLocations.push_back((GLint)lLocation);
+			program.m_vAttributes.push_back(szAfter + 1);
+			break;
+		}
+		default:	return false;
+		}
+		uiStart = uiEnd + 1;
+	}
+
+	// it keeps what is attached, only what linking made is replaced:
+	a_rProgram.m_vUniforms.swap(program.m_vUniforms);
+	a_rProgram.m_vAttributes.swap(program.m_vAttributes);
+	a_rProgram.m_viAttributeLocations.swap(program.m_viAttributeLocations);
+	a_rProgram.m_vUniformBlocks.swap(program.m_vUniformBlocks);
+	return true;
+}
+
+
+// g_HeadlessProgramLock must be held, an unknown program reflects as empty:
+static const HeadlessProgram& FindProgram(GLuint a_uiProgram)
+{
+	static const HeadlessProgram s_EmptyProgram;
+	auto itr = g_mHeadlessPrograms.find(a_uiProgram);
+	return itr != g_mHeadlessPrograms.end() ? itr->second : s_EmptyProgram;
+}
+
+
+// g_HeadlessProgramLock must be held:
+static bool IsShaderAttached(GLuint a_uiShader)
+{
+	for (auto& itr : g_mHeadlessPrograms)
+	{
+		if (std::find(itr.second.m_vShaders.begin(), itr.second.m_vShaders.end(), a_uiShader) != itr.second.m_vShaders.end())
+			return true;
+	}
+	return false;
+}
+
+
+static GLint LongestName(const std::vector<std::string>& a_rvNames)
+{
+	size_t uiLongest = 0;
+	for (auto& szName : a_rvNames)
+		uiLongest = std::max(uiLongest, szName.size());
+	return a_rvNames.empty() ? 0 : (GLint)uiLongest + 1;	// with the terminating 0, like GL.
+}
+
+
+////////////////////////// OpenGL 1.1 /////////////////////////////////
+extern "C" {
+
+void HEADLESS_APIENTRY glClear(GLbitfield /* mask */)
+{
+	Record(HC_Clear);
+}
+
+void HEADLESS_APIENTRY glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+	Record(HC_ClearColor);
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow == nullptr)
+		return;
+	GLclampf* afColour = pWindow->m_afClearColour;
+	if (!Redundant(afColour[0] == red && afColour[1] == green && afColour[2] == blue && afColour[3] == alpha))
+	{
+		afColour[0] = red; afColour[1] = green; afColour[2] = blue; afColour[3] = alpha;
+	}
+}
+
+void HEADLESS_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	Record(HC_Viewport);
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow == nullptr)
+		return;
+	GLint* aiViewport = pWindow->m_aiViewport;
+	if (!Redundant(aiViewport[0] == x && aiViewport[1] == y && aiViewport[2] == width && aiViewport[3] == height))
+	{
+		aiViewport[0] = x; aiViewport[1] = y; aiViewport[2] = width; aiViewport[3] = height;
+	}
+}
+
+static bool* CapabilityShadow(GLenum a_eCap)
+{
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow == nullptr)
+		return nullptr;
+	switch (a_eCap)
+	{
+	case GL_DEPTH_TEST:	return &pWindow->m_bDepthTest;
+	case GL_CULL_FACE:	return &pWindow->m_bCullFace;
+	case GL_BLEND:		return &pWindow->m_bBlend;
+	default:			return nullptr;
+	}
+}
+
+void HEADLESS_APIENTRY glEnable(GLenum cap)
+{
+	Record(HC_Enable);
+	bool* pbShadow = CapabilityShadow(cap);
+	if (pbShadow != nullptr && !Redundant(*pbShadow))
+		*pbShadow = true;
+}
+
+void HEADLESS_APIENTRY glDisable(GLenum cap)
+{
+	Record(HC_Disable);
+	bool* pbShadow = CapabilityShadow(cap);
+	if (pbShadow != nullptr && !Redundant(!*pbShadow))
+		*pbShadow = false;
+}
+
+GLboolean HEADLESS_APIENTRY glIsEnabled(GLenum cap)
+{
+	Record(HC_IsEnabled);
+	bool* pbShadow = CapabilityShadow(cap);
+	return (pbShadow != nullptr && *pbShadow) ? GL_TRUE : GL_FALSE;
+}
+
+void HEADLESS_APIENTRY glGetIntegerv(GLenum pname, GLint* params)
+{
+	Record(HC_GetIntegerv);
+	if (params == nullptr)
+		return;
+	switch (pname)
+	{
+	case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:	*params = 256; break;
+	case GL_MAX_TEXTURE_IMAGE_UNITS:			*params = (GLint)c_uiMaxTextureUnits; break;
+	case GL_MAX_TEXTURE_SIZE:					*params = 16384; break;
+	case GL_MAX_UNIFORM_BUFFER_BINDINGS:		*params = 84; break;
+	case GL_NUM_PROGRAM_BINARY_FORMATS:			*params = 1; break;
+	case GL_MAJOR_VERSION:						*params = 4; break;
+	case GL_MINOR_VERSION:						*params = 4; break;
+	default:									*params = 0; break;
+	}
+}
+
+GLenum HEADLESS_APIENTRY glGetError(void)
+{
+	Record(HC_GetError);
+	return GL_NO_ERROR;
+}
+
+const GLubyte* HEADLESS_APIENTRY glGetString(GLenum name)
+{
+	Record(HC_GetString);
+	switch (name)
+	{
+	case GL_VENDOR:						return (const GLubyte*)"GLFW3 Tutorials";
+	case GL_RENDERER:					return (const GLubyte*)"Headless Recording GL";
+	case GL_VERSION:					return (const GLubyte*)"4.4.0 Headless";
+	case GL_SHADING_LANGUAGE_VERSION:	return (const GLubyte*)"4.40 Headless";
+	default:							return (const GLubyte*)"";
+	}
+}
+
+void HEADLESS_APIENTRY glBindTexture(GLenum /* target */, GLuint texture)
+{
+	Record(HC_BindTexture);
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow == nullptr)
+		return;
+	GLuint& ruiBound = pWindow->m_auiTextures[(pWindow->m_eActiveTexture - GL_TEXTURE0) % c_uiMaxTextureUnits];
+	if (!Redundant(ruiBound == texture))
+		ruiBound = texture;
+}
+
+void HEADLESS_APIENTRY glGenTextures(GLsizei n, GLuint* textures)
+{
+	Record(HC_GenTextures);
+	GenNames(n, textures);
+}
+
+void HEADLESS_APIENTRY glDeleteTextures(GLsizei /* n */, const GLuint* /* textures */)
+{
+	Record(HC_DeleteTextures);
+}
+
+static GLsizeiptr TexelSize(GLenum a_eFormat, GLenum a_eType)
+{
+	GLsizeiptr iComponents = 4;
+	switch (a_eFormat)
+	{
+	case GL_RED:	iComponents = 1; break;
+	case GL_RG:		iComponents = 2; break;
+	case GL_RGB:
+	case GL_BGR:	iComponents = 3; break;
+	default:		break;
+	}
+
+	switch (a_eType)
+	{
+	case GL_FLOAT:							return iComponents * 4;
+	case GL_HALF_FLOAT:						return iComponents * 2;
+	case GL_UNSIGNED_INT_2_10_10_10_REV:	return 4;
+	default:								return iComponents;
+	}
+}
+
+void HEADLESS_APIENTRY glTexImage2D(GLenum /* target */, GLint /* level */, GLint /* internalformat */, GLsizei width, GLsizei height, GLint /* border */, GLenum format, GLenum type, const GLvoid* pixels)
+{
+	Record(HC_TexImage2D);
+	if (pixels != nullptr)
+		Uploaded(width * height * TexelSize(format, type));
+}
+
+void HEADLESS_APIENTRY glTexSubImage2D(GLenum /* target */, GLint /* level */, GLint /* xoffset */, GLint /* yoffset */, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* /* pixels */)
+{
+	Record(HC_TexSubImage2D);
+	Uploaded(width * height * TexelSize(format, type));
+}
+
+void HEADLESS_APIENTRY glTexParameterf(GLenum /* target */, GLenum /* pname */, GLfloat /* param */)
+{
+	Record(HC_TexParameterf);
+}
+
+void HEADLESS_APIENTRY glTexParameteri(GLenum /* target */, GLenum /* pname */, GLint /* param */)
+{
+	Record(HC_TexParameteri);
+}
+
+void HEADLESS_APIENTRY glPixelStorei(GLenum /* pname */, GLint /* param */)
+{
+	Record(HC_PixelStorei);
+}
+
+void HEADLESS_APIENTRY glDrawElements(GLenum /* mode */, GLsizei count, GLenum /* type */, const GLvoid* /* indices */)
+{
+	Record(HC_DrawElements);
+	if (t_pHeadlessCurrent != nullptr)
+		t_pHeadlessCurrent->m_Stats.m_ullIndicesDrawn += count;
+}
+
+void HEADLESS_APIENTRY glFlush(void)
+{
+	Record(HC_Flush);
+}
+
+void HEADLESS_APIENTRY glFinish(void)
+{
+	Record(HC_Finish);
+}
+
+} // extern "C"
+
+/////////////////////// GLEW loaded functions /////////////////////////
+static void HEADLESS_APIENTRY hglActiveTexture(GLenum texture)
+{
+	Record(HC_ActiveTexture);
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow != nullptr && !Redundant(pWindow->m_eActiveTexture == texture))
+		pWindow->m_eActiveTexture = texture;
+}
+
+static void HEADLESS_APIENTRY hglAttachShader(GLuint program, GLuint shader)
+{
+	Record(HC_AttachShader);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	g_mHeadlessPrograms[program].m_vShaders.push_back(shader);
+}
+
+static void HEADLESS_APIENTRY hglBeginQuery(GLenum, GLuint id)
+{
+	Record(HC_BeginQuery);
+	if (t_pHeadlessCurrent == nullptr)
+		return;
+	t_pHeadlessCurrent->m_uiActiveQuery = id;
+
+	std::lock_guard<std::mutex> lock(g_HeadlessQueryLock);
+	HeadlessQuery& query = g_mHeadlessQueries[id];
+	query.m_ullBeginNS = NowNS();
+	query.m_ullEndNS = query.m_ullBeginNS;
+}
+
+static void HEADLESS_APIENTRY hglEndQuery(GLenum)
+{
+	Record(HC_EndQuery);
+	if (t_pHeadlessCurrent == nullptr || t_pHeadlessCurrent->m_uiActiveQuery == 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_HeadlessQueryLock);
+	g_mHeadlessQueries[t_pHeadlessCurrent->m_uiActiveQuery].m_ullEndNS = NowNS();
+	t_pHeadlessCurrent->m_uiActiveQuery = 0;
+}
+
+static void HEADLESS_APIENTRY hglGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+{
+	Record(HC_GetQueryObjectui64v);
+	if (params == nullptr)
+		return;
+	if (pname == GL_QUERY_RESULT_AVAILABLE)
+	{
+		*params = GL_TRUE;
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(g_HeadlessQueryLock);
+	auto itr = g_mHeadlessQueries.find(id);
+	*params = itr != g_mHeadlessQueries.end() ? itr->second.m_ullEndNS - itr->second.m_ullBeginNS : 0;
+}
+
+static void HEADLESS_APIENTRY hglQueryCounter(GLuint id, GLenum /* target */)
+{
+	// a timestamp is when the call was recorded, read back as a time elapsed since 0:
+	Record(HC_QueryCounter);
+	std::lock_guard<std::mutex> lock(g_HeadlessQueryLock);
+	HeadlessQuery& query = g_mHeadlessQueries[id];
+	query.m_ullBeginNS = 0;
+	query.m_ullEndNS = NowNS();
+}
+
+static void HEADLESS_APIENTRY hglGenQueries(GLsizei n, GLuint* ids)
+{
+	Record(HC_GenQueries);
+	GenNames(n, ids);
+}
+
+static void HEADLESS_APIENTRY hglDeleteQueries(GLsizei n, const GLuint* ids)
+{
+	Record(HC_DeleteQueries);
+	std::lock_guard<std::mutex> lock(g_HeadlessQueryLock);
+	for (GLsizei i = 0; i < n; ++i)
+		g_mHeadlessQueries.erase(ids[i]);
+}
+
+static void HEADLESS_APIENTRY hglBindFramebuffer(GLenum, GLuint)						{ Record(HC_BindFramebuffer); }
+static void HEADLESS_APIENTRY hglBlitFramebuffer(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum) { Record(HC_BlitFramebuffer); }
+static void HEADLESS_APIENTRY hglFramebufferTexture(GLenum, GLenum, GLuint, GLint)		{ Record(HC_FramebufferTexture); }
+static void HEADLESS_APIENTRY hglFramebufferTextureLayer(GLenum, GLenum, GLuint, GLint, GLint) { Record(HC_FramebufferTextureLayer); }
+
+static GLenum HEADLESS_APIENTRY hglCheckFramebufferStatus(GLenum)
+{
+	Record(HC_CheckFramebufferStatus);
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void HEADLESS_APIENTRY hglTexImage3D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLint, GLenum format, GLenum type, const GLvoid* pixels)
+{
+	Record(HC_TexImage3D);
+	if (pixels != nullptr)
+		Uploaded(width * height * depth * TexelSize(format, type));
+}
+static void HEADLESS_APIENTRY hglBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+	Record(HC_BindAttribLocation);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	g_mHeadlessPrograms[program].m_mBoundAttributes[name] = (GLint)index;
+}
+
+static void HEADLESS_APIENTRY hglBindFragDataLocation(GLuint, GLuint, const GLchar*) { Record(HC_BindFragDataLocation); }
+
+static GLuint* BufferShadow(GLenum a_eTarget)
+{
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow == nullptr)
+		return nullptr;
+	switch (a_eTarget)
+	{
+	case GL_ARRAY_BUFFER:			return &pWindow->m_uiArrayBuffer;
+	case GL_ELEMENT_ARRAY_BUFFER:	return &pWindow->m_uiElementBuffer;
+	case GL_UNIFORM_BUFFER:			return &pWindow->m_uiUniformBuffer;
+	case GL_PIXEL_UNPACK_BUFFER:	return &pWindow->m_uiPixelUnpackBuffer;
+	default:						return nullptr;
+	}
+}
+
+static void HEADLESS_APIENTRY hglBindBuffer(GLenum target, GLuint buffer)
+{
+	Record(HC_BindBuffer);
+	GLuint* puiShadow = BufferShadow(target);
+	if (puiShadow != nullptr && !Redundant(*puiShadow == buffer))
+		*puiShadow = buffer;
+}
+
+static void HEADLESS_APIENTRY hglBindBufferRange(GLenum, GLuint, GLuint, GLintptr, GLsizeiptr)	{ Record(HC_BindBufferRange); }
+
+static void HEADLESS_APIENTRY hglBindVertexArray(GLuint array)
+{
+	Record(HC_BindVertexArray);
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow != nullptr && !Redundant(pWindow->m_uiVertexArray == array))
+		pWindow->m_uiVertexArray = array;
+}
+
+static void SetBufferSize(GLenum a_eTarget, GLsizeiptr a_iSize, bool a_bAllocate)
+{
+	GLuint* puiBuffer = BufferShadow(a_eTarget);
+	if (puiBuffer == nullptr || *puiBuffer == 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_HeadlessBufferLock);
+	HeadlessBufferStore& store = g_mHeadlessBuffers[*puiBuffer];
+	store.m_iSize = a_iSize;
+	store.m_vMemory.clear();
+	if (a_bAllocate)
+		store.m_vMemory.resize(a_iSize);
+}
+
+static void HEADLESS_APIENTRY hglBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum)
+{
+	Record(HC_BufferData);
+	if (data != nullptr)
+		Uploaded(size);
+	SetBufferSize(target, size, false);
+}
+
+static void HEADLESS_APIENTRY hglBufferStorage(GLenum target, GLsizeiptr size, const GLvoid* data, GLbitfield flags)
+{
+	Record(HC_BufferStorage);
+	if (data != nullptr)
+		Uploaded(size);
+	SetBufferSize(target, size, (flags & GL_MAP_PERSISTENT_BIT) != 0);
+}
+
+static GLvoid* HEADLESS_APIENTRY hglMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	Record(HC_MapBufferRange);
+	GLuint* puiBuffer = BufferShadow(target);
+	if (puiBuffer == nullptr || *puiBuffer == 0)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(g_HeadlessBufferLock);
+	auto itr = g_mHeadlessBuffers.find(*puiBuffer);
+	if (itr == g_mHeadlessBuffers.end() || offset + length > itr->second.m_iSize)
+		return nullptr;
+	if (itr->second.m_vMemory.empty())
+		itr->second.m_vMemory.resize(itr->second.m_iSize);
+	if ((access & GL_MAP_WRITE_BIT) != 0 && (access & GL_MAP_PERSISTENT_BIT) == 0)
+		Uploaded(length);
+	return itr->second.m_vMemory.data() + offset;
+}
+
+static GLboolean HEADLESS_APIENTRY hglUnmapBuffer(GLenum)
+{
+	Record(HC_UnmapBuffer);
+	return GL_TRUE;
+}
+
+static void HEADLESS_APIENTRY hglBufferSubData(GLenum, GLintptr, GLsizeiptr size, const GLvoid*)
+{
+	Record(HC_BufferSubData);
+	Uploaded(size);
+}
+
+static GLenum HEADLESS_APIENTRY hglClientWaitSync(GLsync sync, GLbitfield, GLuint64 timeout)
+{
+	Record(HC_ClientWaitSync);
+	HeadlessFence* pFence = (HeadlessFence*)sync;
+	if (pFence == nullptr)
+		return GL_WAIT_FAILED;
+
+	unsigned long long ullNow = NowNS();
+	if (ullNow >= pFence->m_ullSignalTimeNS)
+		return GL_ALREADY_SIGNALED;
+	if (timeout == 0)
+		return GL_TIMEOUT_EXPIRED;
+
+	// wait for the simulated GPU:
+	unsigned long long ullWaitUntil = pFence->m_ullSignalTimeNS;
+	if (timeout != GL_TIMEOUT_IGNORED && ullNow + timeout < ullWaitUntil)
+		ullWaitUntil = ullNow + timeout;
+	SleepUntilNS(ullWaitUntil);
+	if (t_pHeadlessCurrent != nullptr)
+		t_pHeadlessCurrent->m_Stats.m_dFenceBlockedSeconds += (NowNS() - ullNow) * 1e-9;
+
+	return NowNS() >= pFence->m_ullSignalTimeNS ? GL_CONDITION_SATISFIED : GL_TIMEOUT_EXPIRED;
+}
+
+static void HEADLESS_APIENTRY hglCompileShader(GLuint)	{ Record(HC_CompileShader); }
+
+static GLuint HEADLESS_APIENTRY hglCreateProgram(void)
+{
+	Record(HC_CreateProgram);
+	return g_uiHeadlessNextName++;
+}
+
+static GLuint HEADLESS_APIENTRY hglCreateShader(GLenum type)
+{
+	Record(HC_CreateShader);
+	GLuint uiShader = g_uiHeadlessNextName++;
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	HeadlessShader& rShader = g_mHeadlessShaders[uiShader];
+	rShader.m_eType = type;
+	rShader.m_bDeleted = false;
+	return uiShader;
+}
+
+static void HEADLESS_APIENTRY hglDebugMessageCallback(GLDEBUGPROC, const GLvoid*)	{ Record(HC_DebugMessageCallback); }
+static void HEADLESS_APIENTRY hglDebugMessageControl(GLenum, GLenum, GLenum, GLsizei, const GLuint*, GLboolean) { Record(HC_DebugMessageControl); }
+static void HEADLESS_APIENTRY hglDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	Record(HC_DeleteBuffers);
+	std::lock_guard<std::mutex> lock(g_HeadlessBufferLock);
+	for (GLsizei i = 0; i < n; ++i)
+		g_mHeadlessBuffers.erase(buffers[i]);
+}
+static void HEADLESS_APIENTRY hglDeleteFramebuffers(GLsizei, const GLuint*)		{ Record(HC_DeleteFramebuffers); }
+static void HEADLESS_APIENTRY hglDeleteProgram(GLuint program)
+{
+	Record(HC_DeleteProgram);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	auto itr = g_mHeadlessPrograms.find(program);
+	if (itr != g_mHeadlessPrograms.end())
+	{
+		std::vector<GLuint> vShaders;
+		vShaders.swap(itr->second.m_vShaders);
+		g_mHeadlessPrograms.erase(itr);
+		for (GLuint uiShader : vShaders)
+		{
+			auto shader = g_mHeadlessShaders.find(uiShader);
+			if (shader != g_mHeadlessShaders.end() && shader->second.m_bDeleted && !IsShaderAttached(uiShader))
+				g_mHeadlessShaders.erase(shader);
+		}
+	}
+	g_sHeadlessRejectedPrograms.erase(program);
+}
+
+static void HEADLESS_APIENTRY hglDeleteProgramPipelines(GLsizei, const GLuint*)	{ Record(HC_DeleteProgramPipelines); }
+
+static void HEADLESS_APIENTRY hglDeleteShader(GLuint shader)
+{
+	// like GL, a shader that is still attached lives on until its last program is deleted:
+	Record(HC_DeleteShader);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	if (IsShaderAttached(shader))
+		g_mHeadlessShaders[shader].m_bDeleted = true;
+	else
+		g_mHeadlessShaders.erase(shader);
+}
+
+static void HEADLESS_APIENTRY hglDeleteSync(GLsync sync)
+{
+	Record(HC_DeleteSync);
+	delete (HeadlessFence*)sync;
+}
+
+static void HEADLESS_APIENTRY hglDeleteVertexArrays(GLsizei, const GLuint*)		{ Record(HC_DeleteVertexArrays); }
+static void HEADLESS_APIENTRY hglDrawElementsInstanced(GLenum, GLsizei count, GLenum, const GLvoid*, GLsizei primcount)
+{
+	Record(HC_DrawElementsInstanced);
+	if (t_pHeadlessCurrent != nullptr)
+		t_pHeadlessCurrent->m_Stats.m_ullIndicesDrawn += (unsigned long long)count * primcount;
+}
+
+static void HEADLESS_APIENTRY hglDrawElementsInstancedBaseInstance(GLenum, GLsizei count, GLenum, const GLvoid*, GLsizei primcount, GLuint)
+{
+	Record(HC_DrawElementsInstancedBaseInstance);
+	if (t_pHeadlessCurrent != nullptr)
+		t_pHeadlessCurrent->m_Stats.m_ullIndicesDrawn += (unsigned long long)count * primcount;
+}
+
+static void HEADLESS_APIENTRY hglEnableVertexAttribArray(GLuint)					{ Record(HC_EnableVertexAttribArray); }
+
+static GLsync HEADLESS_APIENTRY hglFenceSync(GLenum, GLbitfield)
+{
+	Record(HC_FenceSync);
+	HeadlessFence* pFence = new HeadlessFence();
+	pFence->m_ullSignalTimeNS = NowNS() + g_ullHeadlessGPULatencyNS;
+	return (GLsync)pFence;
+}
+
+static void HEADLESS_APIENTRY hglGenBuffers(GLsizei n, GLuint* buffers)
+{
+	Record(HC_GenBuffers);
+	GenNames(n, buffers);
+}
+
+static void HEADLESS_APIENTRY hglGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+	Record(HC_GenFramebuffers);
+	GenNames(n, framebuffers);
+}
+
+static void HEADLESS_APIENTRY hglGenProgramPipelines(GLsizei n, GLuint* pipelines)
+{
+	Record(HC_GenProgramPipelines);
+	GenNames(n, pipelines);
+}
+
+static void HEADLESS_APIENTRY hglGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+	Record(HC_GenVertexArrays);
+	GenNames(n, arrays);
+}
+
+// what linking found in the shaders, the types are left out since nothing here draws with them:
+static void HEADLESS_APIENTRY hglGetActiveAttrib(GLuint program, GLuint index, GLsizei maxLength, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	Record(HC_GetActiveAttrib);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	const HeadlessProgram& rProgram = FindProgram(program);
+	WriteName(index < rProgram.m_vAttributes.size() ? rProgram.m_vAttributes[index] : "", maxLength, length, name);
+	if (size != nullptr)
+		*size = 1;
+	if (type != nullptr)
+		*type = 0;
+}
+
+static void HEADLESS_APIENTRY hglGetActiveUniform(GLuint program, GLuint index, GLsizei maxLength, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	Record(HC_GetActiveUniform);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	const HeadlessProgram& rProgram = FindProgram(program);
+	WriteName(index < rProgram.m_vUniforms.size() ? rProgram.m_vUniforms[index] : "", maxLength, length, name);
+	if (size != nullptr)
+		*size = 1;
+	if (type != nullptr)
+		*type = 0;
+}
+
+static void HEADLESS_APIENTRY hglGetActiveUniformBlockName(GLuint program, GLuint uniformBlockIndex, GLsizei bufSize, GLsizei* length, GLchar* uniformBlockName)
+{
+	Record(HC_GetActiveUniformBlockName);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	const HeadlessProgram& rProgram = FindProgram(program);
+	WriteName(uniformBlockIndex < rProgram.m_vUniformBlocks.size() ? rProgram.m_vUniformBlocks[uniformBlockIndex] : "", bufSize, length, uniformBlockName);
+}
+
+static void HEADLESS_APIENTRY hglGetActiveUniformBlockiv(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params)
+{
+	Record(HC_GetActiveUniformBlockiv);
+	if (params == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	const HeadlessProgram& rProgram = FindProgram(program);
+	if (pname == GL_UNIFORM_BLOCK_NAME_LENGTH && uniformBlockIndex < rProgram.m_vUniformBlocks.size())
+		*params = (GLint)rProgram.m_vUniformBlocks[uniformBlockIndex].size() + 1;
+	else
+		*params = 0;
+}
+
+static GLint HEADLESS_APIENTRY hglGetAttribLocation(GLuint program, const GLchar* name)
+{
+	Record(HC_GetAttribLocation);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	const HeadlessProgram& rProgram = FindProgram(program);
+	auto itr = std::find(rProgram.m_vAttributes.begin(), rProgram.m_vAttributes.end(), name);
+	return itr != rProgram.m_vAttributes.end() ? rProgram.m_viAttributeLocations[itr - rProgram.m_vAttributes.begin()] : -1;
+}
+
+static void HEADLESS_APIENTRY hglGetProgramInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+	Record(HC_GetProgramInfoLog);
+	WriteLog(bufSize, length, infoLog);
+}
+
+static void HEADLESS_APIENTRY hglGetProgramiv(GLuint program, GLenum pname, GLint* param)
+{
+	Record(HC_GetProgramiv);
+	if (param == nullptr)
+		return;
+
+	switch (pname)
+	{
+	case GL_LINK_STATUS:
+	{
+		std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+		*param = g_sHeadlessRejectedPrograms.count(program) == 0 ? GL_TRUE : GL_FALSE;
+		break;
+	}
+	case GL_VALIDATE_STATUS:		*param = GL_TRUE; break;
+	case GL_PROGRAM_BINARY_LENGTH:
+	{
+		std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+		*param = (GLint)SaveHeadlessProgram(FindProgram(program)).size();
+		break;
+	}
+	case GL_ACTIVE_UNIFORMS:
+	case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+	case GL_ACTIVE_ATTRIBUTES:
+	case GL_ACTIVE_ATTRIBUTE_MAX_LENGTH:
+	case GL_ACTIVE_UNIFORM_BLOCKS:
+	{
+		std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+		const HeadlessProgram& rProgram = FindProgram(program);
+		if (pname == GL_ACTIVE_UNIFORMS)
+			*param = (GLint)rProgram.m_vUniforms.size();
+		else if (pname == GL_ACTIVE_UNIFORM_MAX_LENGTH)
+			*param = LongestName(rProgram.m_vUniforms);
+		else if (pname == GL_ACTIVE_ATTRIBUTES)
+			*param = (GLint)rProgram.m_vAttributes.size();
+		else if (pname == GL_ACTIVE_ATTRIBUTE_MAX_LENGTH)
+			*param = LongestName(rProgram.m_vAttributes);
+		else
+			*param = (GLint)rProgram.m_vUniformBlocks.size();
+		break;
+	}
+	default:						*param = 0; break;
+	}
+}
+
+static void HEADLESS_APIENTRY hglGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, GLvoid* binary)
+{
+	Record(HC_GetProgramBinary);
+	std::string szBinary;
+	{
+		std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+		szBinary = SaveHeadlessProgram(FindProgram(program));
+	}
+
+	GLsizei iLength = bufSize < (GLsizei)szBinary.size() ? 0 : (GLsizei)szBinary.size();
+	if (binary != nullptr && iLength > 0)
+		memcpy(binary, szBinary.data(), iLength);
+	if (length != nullptr)
+		*length = iLength;
+	if (binaryFormat != nullptr)
+		*binaryFormat = c_eHeadlessProgramBinaryFormat;
+}
+
+static void HEADLESS_APIENTRY hglProgramBinary(GLuint program, GLenum binaryFormat, const GLvoid* binary, GLsizei length)
+{
+	// only accept what hglGetProgramBinary() hands out, like a driver would after an update:
+	Record(HC_ProgramBinary);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	bool bValid = binaryFormat == c_eHeadlessProgramBinaryFormat && LoadHeadlessProgram(binary, length, g_mHeadlessPrograms[program]);
+	if (bValid)
+		g_sHeadlessRejectedPrograms.erase(program);
+	else
+		g_sHeadlessRejectedPrograms.insert(program);
+}
+
+static void HEADLESS_APIENTRY hglProgramParameteri(GLuint, GLenum, GLint)				{ Record(HC_ProgramParameteri); }
+
+static void HEADLESS_APIENTRY hglGetShaderInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+	Record(HC_GetShaderInfoLog);
+	WriteLog(bufSize, length, infoLog);
+}
+
+static void HEADLESS_APIENTRY hglGetShaderiv(GLuint, GLenum pname, GLint* param)
+{
+	Record(HC_GetShaderiv);
+	if (param != nullptr)
+		*param = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static GLuint HEADLESS_APIENTRY hglGetUniformBlockIndex(GLuint program, const GLchar* uniformBlockName)
+{
+	Record(HC_GetUniformBlockIndex);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	const HeadlessProgram& rProgram = FindProgram(program);
+	auto itr = std::find(rProgram.m_vUniformBlocks.begin(), rProgram.m_vUniformBlocks.end(), uniformBlockName);
+	return itr != rProgram.m_vUniformBlocks.end() ? (GLuint)(itr - rProgram.m_vUniformBlocks.begin()) : GL_INVALID_INDEX;
+}
+
+static GLint HEADLESS_APIENTRY hglGetUniformLocation(GLuint program, const GLchar* name)
+{
+	Record(HC_GetUniformLocation);
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	const HeadlessProgram& rProgram = FindProgram(program);
+	auto itr = std::find(rProgram.m_vUniforms.begin(), rProgram.m_vUniforms.end(), name);
+	return itr != rProgram.m_vUniforms.end() ? (GLint)(itr - rProgram.m_vUniforms.begin()) : -1;
+}
+
+static void HEADLESS_APIENTRY hglLinkProgram(GLuint program)
+{
+	Record(HC_LinkProgram);
+	{
+		std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+		g_sHeadlessRejectedPrograms.erase(program);
+
+		HeadlessProgram& rProgram = g_mHeadlessPrograms[program];
+		rProgram.m_vUniforms.clear();
+		rProgram.m_vAttributes.clear();
+		rProgram.m_viAttributeLocations.clear();
+		rProgram.m_vUniformBlocks.clear();
+		for (GLuint uiShader : rProgram.m_vShaders)
+		{
+			auto itr = g_mHeadlessShaders.find(uiShader);
+			if (itr != g_mHeadlessShaders.end())
+				ReflectShader(itr->second, rProgram);
+		}
+
+		// bound attributes keep their location, the rest are numbered in the order they were declared:
+		for (size_t i = 0; i < rProgram.m_vAttributes.size(); ++i)
+		{
+			auto itr = rProgram.m_mBoundAttributes.find(rProgram.m_vAttributes[i]);
+			rProgram.m_viAttributeLocations.push_back(itr != rProgram.m_mBoundAttributes.end() ? itr->second : (GLint)i);
+		}
+	}
+
+	// compiling and linking is where a real driver spends its time at start up:
+	if (g_ullHeadlessLinkCostNS != 0)
+		SleepUntilNS(NowNS() + g_ullHeadlessLinkCostNS);
+}
+static void HEADLESS_APIENTRY hglShaderSource(GLuint shader, GLsizei count, const GLchar** string, const GLint* length)
+{
+	Record(HC_ShaderSource);
+	std::string szSource;
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (length != nullptr && length[i] >= 0)
+			szSource.append(string[i], length[i]);
+		else
+			szSource.append(string[i]);
+	}
+
+	std::lock_guard<std::mutex> lock(g_HeadlessProgramLock);
+	g_mHeadlessShaders[shader].m_szSource.swap(szSource);
+}
+static void HEADLESS_APIENTRY hglUniform1i(GLint, GLint)									{ Record(HC_Uniform1i); }
+static void HEADLESS_APIENTRY hglUniformBlockBinding(GLuint, GLuint, GLuint)				{ Record(HC_UniformBlockBinding); }
+
+static void HEADLESS_APIENTRY hglUniformMatrix4fv(GLint, GLsizei count, GLboolean, const GLfloat*)
+{
+	Record(HC_UniformMatrix4fv);
+	Uploaded(count * 16 * sizeof(GLfloat));
+}
+
+static void HEADLESS_APIENTRY hglUseProgram(GLuint program)
+{
+	Record(HC_UseProgram);
+	GLFWwindow* pWindow = t_pHeadlessCurrent;
+	if (pWindow != nullptr && !Redundant(pWindow->m_uiProgram == program))
+		pWindow->m_uiProgram = program;
+}
+
+static void HEADLESS_APIENTRY hglVertexAttribDivisor(GLuint, GLuint)					{ Record(HC_VertexAttribDivisor); }
+static void HEADLESS_APIENTRY hglVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const GLvoid*) { Record(HC_VertexAttribPointer); }
+static void HEADLESS_APIENTRY hglWaitSync(GLsync, GLbitfield, GLuint64)					{ Record(HC_WaitSync); }
+
+////////////////////////////// GLEW ///////////////////////////////////
+extern "C" {
+
+GLenum HEADLESS_APIENTRY glewContextInit(GLEWContext* ctx)
+{
+	if (ctx == nullptr)
+		return GLEW_ERROR_NO_GL_VERSION;
+
+	// we claim 4.4 core but no extensions:
+	ctx->__GLEW_VERSION_1_1 = GL_TRUE;
+	ctx->__GLEW_VERSION_1_2 = GL_TRUE;
+	ctx->__GLEW_VERSION_1_3 = GL_TRUE;
+	ctx->__GLEW_VERSION_1_4 = GL_TRUE;
+	ctx->__GLEW_VERSION_1_5 = GL_TRUE;
+	ctx->__GLEW_VERSION_2_0 = GL_TRUE;
+	ctx->__GLEW_VERSION_2_1 = GL_TRUE;
+	ctx->__GLEW_VERSION_3_0 = GL_TRUE;
+	ctx->__GLEW_VERSION_3_1 = GL_TRUE;
+	ctx->__GLEW_VERSION_3_2 = GL_TRUE;
+	ctx->__GLEW_VERSION_3_3 = GL_TRUE;
+	ctx->__GLEW_VERSION_4_0 = GL_TRUE;
+	ctx->__GLEW_VERSION_4_1 = GL_TRUE;
+	ctx->__GLEW_VERSION_4_2 = GL_TRUE;
+	ctx->__GLEW_VERSION_4_3 = GL_TRUE;
+	ctx->__GLEW_VERSION_4_4 = GL_TRUE;
+
+#ifdef _WIN32
+#define HEADLESS_GLEW_BIND(name, type, kind) ctx->__glew##name = hgl##name;
+#else
+#define HEADLESS_GLEW_BIND(name, type, kind) __glew##name = hgl##name;
+#endif
+	HEADLESS_GLEW_FUNCTIONS(HEADLESS_GLEW_BIND)
+#undef HEADLESS_GLEW_BIND
+
+	// a real GLEW asks the driver for a few thousand entry points here:
+	if (g_ullHeadlessGLEWInitCostNS != 0)
+		SleepUntilNS(NowNS() + g_ullHeadlessGLEWInitCostNS);
+
+	return GLEW_OK;
+}
+
+GLboolean HEADLESS_APIENTRY glewContextIsSupported(const GLEWContext* /* ctx */, const char* /* name */)
+{
+	return GL_FALSE;
+}
+
+GLboolean HEADLESS_APIENTRY glewGetExtension(const char* /* name */)
+{
+	return GL_FALSE;
+}
+
+const GLubyte* HEADLESS_APIENTRY glewGetErrorString(GLenum error)
+{
+	return (const GLubyte*)(error == GLEW_OK ? "No error" : "Headless GLEW error");
+}
+
+const GLubyte* HEADLESS_APIENTRY glewGetString(GLenum name)
+{
+	return (const GLubyte*)(name == GLEW_VERSION ? "1.10.0 (headless)" : "");
+}
+
+} // extern "C"
+
+////////////////////////////// GLFW ///////////////////////////////////
+extern "C" {
+
+int glfwInit(void)
+{
+	if (g_bHeadlessInitialised)
+		return GL_TRUE;
+
+	g_HeadlessStartTime = std::chrono::steady_clock::now();
+	g_dHeadlessRefreshHz = EnvDouble("HEADLESS_GL_REFRESH_HZ", 60.0);
+	if (g_dHeadlessRefreshHz <= 0.0)
+		g_dHeadlessRefreshHz = 60.0;
+	g_iHeadlessSwapInterval = (int)EnvDouble("HEADLESS_GL_SWAP_INTERVAL", 1.0);
+	g_dHeadlessRunTime = EnvDouble("HEADLESS_GL_RUN_TIME", 30.0);
+	g_ullHeadlessGPULatencyNS = (unsigned long long)(EnvDouble("HEADLESS_GL_GPU_LATENCY_US", 0.0) * 1000.0);
+	g_ullHeadlessCallCostNS = (unsigned long long)EnvDouble("HEADLESS_GL_CALL_COST_NS", 0.0);
+	g_ullHeadlessLinkCostNS = (unsigned long long)(EnvDouble("HEADLESS_GL_LINK_COST_US", 0.0) * 1000.0);
+	g_ullHeadlessGLEWInitCostNS = (unsigned long long)(EnvDouble("HEADLESS_GL_GLEW_INIT_COST_US", 0.0) * 1000.0);
+	const char* szTrace = getenv("HEADLESS_GL_TRACE");
+	g_szHeadlessTraceFile = szTrace != nullptr ? szTrace : "";
+
+	printf("Status: Headless GL backend, %.1f Hz, swap interval %i, run time %.1fs\n", g_dHeadlessRefreshHz, g_iHeadlessSwapInterval, g_dHeadlessRunTime);
+
+	g_bHeadlessInitialised = true;
+	return GL_TRUE;
+}
+
+void glfwTerminate(void)
+{
+	if (!g_bHeadlessInitialised)
+		return;
+
+	HeadlessPrintReport();
+
+	std::lock_guard<std::mutex> lock(g_HeadlessWindowLock);
+
+	if (!g_szHeadlessTraceFile.empty())
+	{
+		FILE* pFile = fopen(g_szHeadlessTraceFile.c_str(), "w");
+		if (pFile != nullptr)
+		{
+			fprintf(pFile, "window,call,time_ns\n");
+			for (auto window : g_lHeadlessWindows)
+			{
+				unsigned long long ullFirst = window->m_ullTraced > c_uiTraceCapacity ? window->m_ullTraced - c_uiTraceCapacity : 0;
+				for (unsigned long long i = ullFirst; i < window->m_ullTraced; ++i)
+				{
+					const CallRecord& record = window->m_vTrace[i % c_uiTraceCapacity];
+					fprintf(pFile, "\"%s\",%s,%llu\n", window->m_szTitle.c_str(), c_aszCallNames[record.m_uiCall], record.m_ullTimeNS);
+				}
+			}
+			fclose(pFile);
+			printf("Status: Headless call trace written to %s\n", g_szHeadlessTraceFile.c_str());
+		}
+	}
+
+	for (auto window : g_lHeadlessWindows)
+		delete window;
+	g_lHeadlessWindows.clear();
+
+	std::lock_guard<std::mutex> bufferLock(g_HeadlessBufferLock);
+	g_mHeadlessBuffers.clear();
+	std::lock_guard<std::mutex> programLock(g_HeadlessProgramLock);
+	g_sHeadlessRejectedPrograms.clear();
+
+	g_bHeadlessInitialised = false;
+}
+
+const char* glfwGetVersionString(void)
+{
+	return "3.0.0 Headless";
+}
+
+GLFWerrorfun glfwSetErrorCallback(GLFWerrorfun cbfun)
+{
+	GLFWerrorfun fPrevious = g_fHeadlessErrorCallback;
+	g_fHeadlessErrorCallback = cbfun;
+	return fPrevious;
+}
+
+void glfwDefaultWindowHints(void)
+{
+}
+
+void glfwWindowHint(int /* target */, int /* hint */)
+{
+	// nothing is ever shown, so there is nothing to hint at.
+}
+
+GLFWwindow* glfwCreateWindow(int width, int height, const char* title, GLFWmonitor* /* monitor */, GLFWwindow* /* share */)
+{
+	GLFWwindow* pWindow = new GLFWwindow();
+	pWindow->m_szTitle = title != nullptr ? title : "";
+	pWindow->m_iWidth = width;
+	pWindow->m_iHeight = height;
+	pWindow->m_iSwapInterval = g_iHeadlessSwapInterval;
+	pWindow->m_bShouldClose = false;
+	pWindow->m_bDestroyed = false;
+	pWindow->m_pUserPointer = nullptr;
+	pWindow->m_fSizeCallback = nullptr;
+	pWindow->m_fKeyCallback = nullptr;
+	pWindow->m_CurrentThread = std::thread::id();
+	pWindow->m_dCreateTime = NowNS() * 1e-9;
+	memset(&pWindow->m_Stats, 0, sizeof(HeadlessStats));
+	memset(pWindow->m_aullCallCounts, 0, sizeof(pWindow->m_aullCallCounts));
+	pWindow->m_ullTraced = 0;
+	if (!g_szHeadlessTraceFile.empty())
+		pWindow->m_vTrace.resize(c_uiTraceCapacity);
+
+	pWindow->m_uiProgram = 0;
+	pWindow->m_uiVertexArray = 0;
+	pWindow->m_eActiveTexture = GL_TEXTURE0;
+	memset(pWindow->m_auiTextures, 0, sizeof(pWindow->m_auiTextures));
+	pWindow->m_uiArrayBuffer = 0;
+	pWindow->m_uiElementBuffer = 0;
+	pWindow->m_uiUniformBuffer = 0;
+	pWindow->m_uiPixelUnpackBuffer = 0;
+	pWindow->m_aiViewport[0] = 0;
+	pWindow->m_aiViewport[1] = 0;
+	pWindow->m_aiViewport[2] = width;
+	pWindow->m_aiViewport[3] = height;
+	memset(pWindow->m_afClearColour, 0, sizeof(pWindow->m_afClearColour));
+	pWindow->m_bDepthTest = false;
+	pWindow->m_bCullFace = false;
+	pWindow->m_bBlend = false;
+	pWindow->m_uiActiveQuery = 0;
+
+	std::lock_guard<std::mutex> lock(g_HeadlessWindowLock);
+	g_lHeadlessWindows.push_back(pWindow);
+
+	return pWindow;
+}
+
+void glfwDestroyWindow(GLFWwindow* window)
+{
+	// keep it around for the report, it is deleted in glfwTerminate().
+	if (window == nullptr)
+		return;
+	if (t_pHeadlessCurrent == window)
+		t_pHeadlessCurrent = nullptr;
+	window->m_bDestroyed = true;
+	window->m_CurrentThread = std::thread::id();
+}
+
+int glfwWindowShouldClose(GLFWwindow* window)
+{
+	if (window->m_bShouldClose)
+		return GL_TRUE;
+	return (g_dHeadlessRunTime > 0.0 && NowNS() * 1e-9 >= g_dHeadlessRunTime) ? GL_TRUE : GL_FALSE;
+}
+
+void glfwSetWindowShouldClose(GLFWwindow* window, int value)
+{
+	window->m_bShouldClose = value != 0;
+}
+
+void glfwGetWindowSize(GLFWwindow* window, int* width, int* height)
+{
+	if (width != nullptr)
+		*width = window->m_iWidth;
+	if (height != nullptr)
+		*height = window->m_iHeight;
+}
+
+void glfwSetWindowSize(GLFWwindow* window, int width, int height)
+{
+	// there is no window manager to say no, so the size callback always follows straight away:
+	window->m_iWidth = width;
+	window->m_iHeight = height;
+	if (window->m_fSizeCallback != nullptr)
+		window->m_fSizeCallback(window, width, height);
+}
+
+void glfwSetWindowUserPointer(GLFWwindow* window, void* pointer)
+{
+	window->m_pUserPointer = pointer;
+}
+
+void* glfwGetWindowUserPointer(GLFWwindow* window)
+{
+	return window->m_pUserPointer;
+}
+
+void glfwShowWindow(GLFWwindow* /* window */)
+{
+	// nothing is ever on screen.
+}
+
+void glfwHideWindow(GLFWwindow* /* window */)
+{
+}
+
+GLFWwindowsizefun glfwSetWindowSizeCallback(GLFWwindow* window, GLFWwindowsizefun cbfun)
+{
+	GLFWwindowsizefun fPrevious = window->m_fSizeCallback;
+	window->m_fSizeCallback = cbfun;
+	return fPrevious;
+}
+
+GLFWkeyfun glfwSetKeyCallback(GLFWwindow* window, GLFWkeyfun cbfun)
+{
+	// there are no keys to press, but keep it so the callback can be swapped like the real one:
+	GLFWkeyfun fPrevious = window->m_fKeyCallback;
+	window->m_fKeyCallback = cbfun;
+	return fPrevious;
+}
+
+int glfwGetWindowAttrib(GLFWwindow* /* window */, int attrib)
+{
+	switch (attrib)
+	{
+	case GLFW_CONTEXT_VERSION_MAJOR:	return 4;
+	case GLFW_CONTEXT_VERSION_MINOR:	return 4;
+	case GLFW_CONTEXT_REVISION:			return 0;
+	case GLFW_VISIBLE:					return 0;
+	default:							return 0;
+	}
+}
+
+void glfwPollEvents(void)
+{
+	// there is never any input.
+}
+
+GLFWmonitor* glfwGetPrimaryMonitor(void)
+{
+	return &g_HeadlessMonitor;
+}
+
+const GLFWvidmode* glfwGetVideoMode(GLFWmonitor* monitor)
+{
+	monitor->m_VideoMode.width = 1920;
+	monitor->m_VideoMode.height = 1080;
+	monitor->m_VideoMode.redBits = 8;
+	monitor->m_VideoMode.greenBits = 8;
+	monitor->m_VideoMode.blueBits = 8;
+	monitor->m_VideoMode.refreshRate = (int)(g_dHeadlessRefreshHz + 0.5);
+	return &monitor->m_VideoMode;
+}
+
+double glfwGetTime(void)
+{
+	return NowNS() * 1e-9;
+}
+
+void glfwMakeContextCurrent(GLFWwindow* window)
+{
+	std::thread::id thisThread = std::this_thread::get_id();
+
+	if (t_pHeadlessCurrent != nullptr && t_pHeadlessCurrent != window)
+		t_pHeadlessCurrent->m_CurrentThread = std::thread::id();
+
+	if (window != nullptr)
+	{
+		// a context can only be current on one thread at a time, a real driver would fail or crash here:
+		std::thread::id previous = window->m_CurrentThread.exchange(thisThread);
+		if (previous != std::thread::id() && previous != thisThread)
+		{
+			++window->m_Stats.m_ullContextConflicts;
+			if (g_fHeadlessErrorCallback != nullptr)
+				g_fHeadlessErrorCallback(GLFW_PLATFORM_ERROR, "Headless: context made current while current on another thread");
+		}
+	}
+
+	t_pHeadlessCurrent = window;
+}
+
+GLFWwindow* glfwGetCurrentContext(void)
+{
+	return t_pHeadlessCurrent;
+}
+
+void glfwSwapBuffers(GLFWwindow* window)
+{
+	GLFWwindow* pPrevious = t_pHeadlessCurrent;
+	t_pHeadlessCurrent = window;
+	Record(HC_SwapBuffers);
+	t_pHeadlessCurrent = pPrevious;
+
+	unsigned long long ullStart = NowNS();
+	if (window->m_iSwapInterval > 0)
+	{
+		// block until the requested vertical blank of our pretend display:
+		unsigned long long ullPeriod = (unsigned long long)(1e9 / g_dHeadlessRefreshHz);
+		unsigned long long ullVBlank = (ullStart / ullPeriod + window->m_iSwapInterval) * ullPeriod;
+		SleepUntilNS(ullVBlank);
+	}
+
+	double dBlocked = (NowNS() - ullStart) * 1e-9;
+	window->m_Stats.m_dSwapBlockedSeconds += dBlocked;
+	if (dBlocked > window->m_Stats.m_dMaxSwapBlockedSeconds)
+		window->m_Stats.m_dMaxSwapBlockedSeconds = dBlocked;
+	++window->m_Stats.m_ullFrames;
+}
+
+void glfwSwapInterval(int interval)
+{
+	if (t_pHeadlessCurrent != nullptr)
+		t_pHeadlessCurrent->m_iSwapInterval = interval;
+}
+
+int glfwExtensionSupported(const char* /* extension */)
+{
+	return GL_FALSE;
+}
+
+GLFWglproc glfwGetProcAddress(const char* /* procname */)
+{
+	return nullptr;
+}
+
+} // extern "C"
+
+////////////////////////// Reporting //////////////////////////////////
+bool HeadlessGetStats(GLFWwindow* a_pWindow, HeadlessStats& a_rStats)
+{
+	if (a_pWindow == nullptr)
+		return false;
+	a_rStats = a_pWindow->m_Stats;
+	return true;
+}
+
+
+void HeadlessPrintReport()
+{
+	std::lock_guard<std::mutex> lock(g_HeadlessWindowLock);
+
+	double dNow = NowNS() * 1e-9;
+	printf("\n---------------------headless-gl-report---------------\n");
+	printf("Run time %.2fs, %.1f Hz display, %u windows\n", dNow, g_dHeadlessRefreshHz, (unsigned int)g_lHeadlessWindows.size());
+	printf("%-36s %8s %8s %10s %10s %10s %8s %10s %10s %10s %10s\n", "Window", "Frames", "FPS", "Calls", "State", "Redundant", "Draws", "Upload KB", "Swap avg", "Swap max", "Conflicts");
+
+	HeadlessStats total;
+	memset(&total, 0, sizeof(total));
+	HeadlessStats rest;			// everything past c_uiReportWindowRows.
+	memset(&rest, 0, sizeof(rest));
+	unsigned int uiRow = 0;
+	for (auto window : g_lHeadlessWindows)
+	{
+		const HeadlessStats& stats = window->m_Stats;
+		unsigned long long ullCalls = 0;
+		for (int i = 0; i < HCK_COUNT; ++i)
+		{
+			ullCalls += stats.m_aullCalls[i];
+			total.m_aullCalls[i] += stats.m_aullCalls[i];
+		}
+		total.m_ullRedundantStateCalls += stats.m_ullRedundantStateCalls;
+		total.m_ullFrames += stats.m_ullFrames;
+		total.m_ullBytesUploaded += stats.m_ullBytesUploaded;
+		total.m_ullContextConflicts += stats.m_ullContextConflicts;
+
+		if (uiRow++ >= c_uiReportWindowRows)
+		{
+			for (int i = 0; i < HCK_COUNT; ++i)
+				rest.m_aullCalls[i] += stats.m_aullCalls[i];
+			rest.m_ullRedundantStateCalls += stats.m_ullRedundantStateCalls;
+			rest.m_ullFrames += stats.m_ullFrames;
+			rest.m_ullBytesUploaded += stats.m_ullBytesUploaded;
+			rest.m_ullContextConflicts += stats.m_ullContextConflicts;
+			continue;
+		}
+
+		double dLifeTime = dNow - window->m_dCreateTime;
+		double dSwapAvgMS = stats.m_ullFrames > 0 ? stats.m_dSwapBlockedSeconds * 1000.0 / stats.m_ullFrames : 0.0;
+		printf("%-36.36s %8llu %8.1f %10llu %10llu %10llu %8llu %10.1f %8.2fms %8.2fms %10llu\n", window->m_szTitle.c_str(),
+			stats.m_ullFrames, dLifeTime > 0.0 ? stats.m_ullFrames / dLifeTime : 0.0, ullCalls,
+			stats.m_aullCalls[HCK_STATE], stats.m_ullRedundantStateCalls, stats.m_aullCalls[HCK_DRAW],
+			stats.m_ullBytesUploaded / 1024.0, dSwapAvgMS, stats.m_dMaxSwapBlockedSeconds * 1000.0, stats.m_ullContextConflicts);
+	}
+
+	if (uiRow > c_uiReportWindowRows)
+	{
+		unsigned long long ullRestCalls = 0;
+		for (int i = 0; i < HCK_COUNT; ++i)
+			ullRestCalls += rest.m_aullCalls[i];
+		std::string szRest = "(" + std::to_string(uiRow - c_uiReportWindowRows) + " more windows)";
+		printf("%-36.36s %8llu %8s %10llu %10llu %10llu %8llu %10.1f %10s %10s %10llu\n", szRest.c_str(), rest.m_ullFrames, "", ullRestCalls,
+			rest.m_aullCalls[HCK_STATE], rest.m_ullRedundantStateCalls, rest.m_aullCalls[HCK_DRAW], rest.m_ullBytesUploaded / 1024.0, "", "", rest.m_ullContextConflicts);
+	}
+
+	unsigned long long ullTotalCalls = 0;
+	for (int i = 0; i < HCK_COUNT; ++i)
+		ullTotalCalls += total.m_aullCalls[i];
+	printf("Total: %llu frames, %llu calls (%llu state, %llu redundant, %llu draws, %llu uploads, %llu syncs, %llu queries), %llu context conflicts\n",
+		total.m_ullFrames, ullTotalCalls, total.m_aullCalls[HCK_STATE], total.m_ullRedundantStateCalls, total.m_aullCalls[HCK_DRAW],
+		total.m_aullCalls[HCK_UPLOAD], total.m_aullCalls[HCK_SYNC], total.m_aullCalls[HCK_QUERY], total.m_ullContextConflicts);
+	if (total.m_ullFrames > 0)
+		printf("Per frame: %.1f calls, %.1f state changes, %.2f draws\n", (double)ullTotalCalls / total.m_ullFrames,
+			(double)total.m_aullCalls[HCK_STATE] / total.m_ullFrames, (double)total.m_aullCalls[HCK_DRAW] / total.m_ullFrames);
+	printf("---------------------headless-gl-report-end-----------\n\n");
+}
+
+#endif // HEADLESS_GL
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////
+/// @file		HeadlessGL.h
+/// @details	A recording stand in for OpenGL, GLEW MX and GLFW, so the render
+///				loops can be run and compared on machines without a GPU.
+///				Nothing is compiled, but linking reads the uniforms, vertex
+///				inputs and uniform blocks the attached shaders declare, so
+///				programs can still be reflected.
+///				Build with HEADLESS_GL defined and do not link glfw3, opengl32,
+///				glu32 or glew32mxs (see the Headless configuration).
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _HEADLESSGL_H_
+#define _HEADLESSGL_H_
+
+#ifdef HEADLESS_GL
+
+// The backend reads these environment variables in glfwInit():
+//	HEADLESS_GL_REFRESH_HZ		simulated display refresh rate, default 60.
+//	HEADLESS_GL_SWAP_INTERVAL	swap interval for new windows, default 1 (vsync on). The demo's -swapinterval overrides it.
+//	HEADLESS_GL_RUN_TIME		seconds until every window reports it should close, default 30, 0 = never.
+//	HEADLESS_GL_GPU_LATENCY_US	how long after creation a fence signals, default 0.
+//	HEADLESS_GL_CALL_COST_NS	simulated driver CPU cost of every GL call, default 0.
+//	HEADLESS_GL_LINK_COST_US	simulated time glLinkProgram() takes to compile and link, default 0.
+//	HEADLESS_GL_GLEW_INIT_COST_US	simulated time glewContextInit() takes to look up every entry point, default 0.
+//	HEADLESS_GL_TRACE			file to write every recorded call to (CSV) in glfwTerminate().
+
+enum HeadlessCallKinds
+{
+	HCK_STATE = 0,		// binds, enables, viewport, program changes etc.
+	HCK_DRAW,
+	HCK_UPLOAD,			// buffer and texture data.
+	HCK_SYNC,			// fences and flushes.
+	HCK_QUERY,			// glGet*.
+	HCK_OTHER,			// object creation, shader compilation, etc.
+
+	HCK_COUNT,
+};
+
+struct HeadlessStats
+{
+	unsigned long long	m_aullCalls[HCK_COUNT];
+	unsigned long long	m_ullRedundantStateCalls;	// state calls that set what was already set.
+	unsigned long long	m_ullIndicesDrawn;
+	unsigned long long	m_ullBytesUploaded;
+	unsigned long long	m_ullFrames;				// glfwSwapBuffers() calls.
+	double				m_dSwapBlockedSeconds;		// total simulated vsync wait.
+	double				m_dMaxSwapBlockedSeconds;
+	double				m_dFenceBlockedSeconds;		// total time glClientWaitSync() waited on the simulated GPU.
+	unsigned long long	m_ullContextConflicts;		// times the context was made current while current on another thread.
+};
+
+/// Copies the stats recorded so far for a_pWindow. Returns false if the window is unknown.
+bool HeadlessGetStats(GLFWwindow* a_pWindow, HeadlessStats& a_rStats);
+
+/// Prints a summary for every window, this is also done by glfwTerminate().
+void HeadlessPrintReport();
+
+#endif // HEADLESS_GL
+
+#endif // _HEADLESSGL_H_
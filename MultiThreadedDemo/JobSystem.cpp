@@ -0,0 +1,317 @@
+// Note that the following includes must be defined in order:
+#include "ContextRegistry.h"
+#include "JobSystem.h"
+#include "ThreadPlacement.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <chrono>
+#include <string>
+
+const unsigned int c_uiIdleSpins = 64;				// failed searches before a worker goes to sleep.
+const unsigned int c_uiNotAWorker = 0xFFFFFFFF;
+
+struct Job
+{
+	JobSystem::JobFunc		m_fWork;
+	JobHandle				m_hParent;
+	std::atomic<int>		m_iUnfinished;		// 1 for the job itself plus one per unfinished child.
+	std::atomic<int>		m_iDependencies;	// unfinished prerequisites, plus 1 until the job is submitted.
+
+	std::mutex				m_Lock;				// guards the two below.
+	std::vector<JobHandle>	m_vDependents;		// jobs waiting on this one.
+	bool					m_bFinished;
+};
+
+// which worker of which job system this thread is, so jobs it queues go on its own deque:
+THREAD_LOCAL JobSystem*		t_pJobSystem = nullptr;
+THREAD_LOCAL unsigned int	t_uiJobWorker = c_uiNotAWorker;
+
+
+JobSystem::JobSystem()
+	: m_uiQueuedJobs(0)
+	, m_bQuit(false)
+	, m_ullJobsRun(0)
+	, m_ullJobsStolen(0)
+{
+	// the shared queue exists even with no workers, the caller just runs everything itself in Wait():
+	m_vQueues.push_back(new WorkerQueue());
+}
+
+
+JobSystem::~JobSystem()
+{
+	Stop();
+	for (auto queue : m_vQueues)
+		delete queue;
+}
+
+
+void JobSystem::Start(unsigned int a_uiWorkers)
+{
+	Stop();
+
+	// worker queues go in front of the shared queue, which stays last:
+	WorkerQueue* pShared = m_vQueues.back();
+	m_vQueues.clear();
+	for (unsigned int i = 0; i < a_uiWorkers; ++i)
+		m_vQueues.push_back(new WorkerQueue());
+	m_vQueues.push_back(pShared);
+
+	m_bQuit = false;
+	for (unsigned int i = 0; i < a_uiWorkers; ++i)
+		m_vWorkers.push_back(new std::thread(&JobSystem::WorkerLoop, this, i));
+}
+
+
+void JobSystem::Stop()
+{
+	if (m_vWorkers.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepLock);
+		m_bQuit = true;
+	}
+	m_WakeUp.notify_all();
+
+	for (auto worker : m_vWorkers)
+	{
+		worker->join();
+		delete worker;
+	}
+	m_vWorkers.clear();
+
+	// anything left on a worker queue moves to the shared queue so a later Wait() can still run it:
+	WorkerQueue* pShared = m_vQueues.back();
+	for (unsigned int i = 0; i + 1 < m_vQueues.size(); ++i)
+	{
+		pShared->m_dJobs.insert(pShared->m_dJobs.end(), m_vQueues[i]->m_dJobs.begin(), m_vQueues[i]->m_dJobs.end());
+		delete m_vQueues[i];
+	}
+	m_vQueues.clear();
+	m_vQueues.push_back(pShared);
+}
+
+
+unsigned int JobSystem::GetDefaultWorkerCount()
+{
+	unsigned int uiHardwareThreads = std::thread::hardware_concurrency();
+	return uiHardwareThreads > 1 ? uiHardwareThreads - 1 : 0;
+}
+
+
+JobHandle JobSystem::CreateJob(JobFunc a_fWork, const JobHandle& a_hParent)
+{
+	JobHandle hJob = std::make_shared<Job>();
+	hJob->m_fWork = a_fWork;
+	hJob->m_hParent = a_hParent;
+	hJob->m_iUnfinished = 1;
+	hJob->m_iDependencies = 1;
+	hJob->m_bFinished = false;
+
+	if (a_hParent)
+		a_hParent->m_iUnfinished.fetch_add(1);
+
+	return hJob;
+}
+
+
+void JobSystem::AddDependency(const JobHandle& a_hJob, const JobHandle& a_hPrerequisite)
+{
+	std::lock_guard<std::mutex> lock(a_hPrerequisite->m_Lock);
+	if (a_hPrerequisite->m_bFinished)
+		return;
+
+	a_hJob->m_iDependencies.fetch_add(1);
+	a_hPrerequisite->m_vDependents.push_back(a_hJob);
+}
+
+
+void JobSystem::Submit(const JobHandle& a_hJob)
+{
+	if (a_hJob->m_iDependencies.fetch_sub(1) == 1)
+		Enqueue(a_hJob);
+}
+
+
+void JobSystem::Wait(const JobHandle& a_hJob)
+{
+	while (!IsFinished(a_hJob))
+	{
+		if (!RunOneJob())
+			std::this_thread::yield();
+	}
+}
+
+
+bool JobSystem::IsFinished(const JobHandle& a_hJob) const
+{
+	return a_hJob->m_iUnfinished.load() == 0;
+}
+
+
+JobHandle JobSystem::ParallelForAsync(unsigned int a_uiCount, RangeFunc a_fWork, unsigned int a_uiGrainSize)
+{
+	if (a_uiGrainSize == 0)
+		a_uiGrainSize = 1;
+
+	JobHandle hRoot = CreateJob(JobFunc());
+	for (unsigned int uiBegin = 0; uiBegin < a_uiCount; uiBegin += a_uiGrainSize)
+	{
+		unsigned int uiEnd = a_uiCount - uiBegin > a_uiGrainSize ? uiBegin + a_uiGrainSize : a_uiCount;
+		Submit(CreateJob([a_fWork, uiBegin, uiEnd]() { a_fWork(uiBegin, uiEnd); }, hRoot));
+	}
+	Submit(hRoot);
+
+	return hRoot;
+}
+
+
+void JobSystem::ParallelFor(unsigned int a_uiCount, RangeFunc a_fWork, unsigned int a_uiGrainSize)
+{
+	Wait(ParallelForAsync(a_uiCount, a_fWork, a_uiGrainSize));
+}
+
+
+void JobSystem::WorkerLoop(unsigned int a_uiWorker)
+{
+	t_pJobSystem = this;
+	t_uiJobWorker = a_uiWorker;
+	PlaceThread(TR_JOB, ("Job worker " + std::to_string(a_uiWorker)).c_str());
+
+	unsigned int uiIdle = 0;
+	while (!m_bQuit)
+	{
+		if (RunOneJob())
+		{
+			SampleThreadPlacement();
+			uiIdle = 0;
+			continue;
+		}
+
+		if (++uiIdle < c_uiIdleSpins)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// nothing to do for a while, sleep until something is queued. The timeout covers a wake up
+		// that lands between our last search and the wait:
+		std::unique_lock<std::mutex> lock(m_SleepLock);
+		m_WakeUp.wait_for(lock, std::chrono::milliseconds(1), [this]() { return m_bQuit || m_uiQueuedJobs > 0; });
+		uiIdle = 0;
+	}
+
+	t_pJobSystem = nullptr;
+	t_uiJobWorker = c_uiNotAWorker;
+}
+
+
+void JobSystem::Enqueue(const JobHandle& a_hJob)
+{
+	// workers keep their own jobs (and the children they spawn) local, everyone else shares a queue:
+	bool bWorker = t_pJobSystem == this && t_uiJobWorker < m_vQueues.size() - 1;
+	WorkerQueue* pQueue = bWorker ? m_vQueues[t_uiJobWorker] : m_vQueues.back();
+	{
+		std::lock_guard<std::mutex> lock(pQueue->m_Lock);
+		pQueue->m_dJobs.push_back(a_hJob);
+	}
+
+	m_uiQueuedJobs.fetch_add(1);
+	m_WakeUp.notify_one();
+}
+
+
+bool JobSystem::RunOneJob()
+{
+	JobHandle hJob = FindJob();
+	if (!hJob)
+		return false;
+
+	Execute(hJob);
+	return true;
+}
+
+
+JobHandle JobSystem::FindJob()
+{
+	JobHandle hJob;
+	if (m_uiQueuedJobs == 0)
+		return hJob;
+
+	unsigned int uiQueues = (unsigned int)m_vQueues.size();
+	bool bWorker = t_pJobSystem == this && t_uiJobWorker < uiQueues - 1;
+
+	// newest first from our own deque, it is the most likely to still be in cache:
+	if (bWorker)
+	{
+		WorkerQueue* pOwn = m_vQueues[t_uiJobWorker];
+		std::lock_guard<std::mutex> lock(pOwn->m_Lock);
+		if (!pOwn->m_dJobs.empty())
+		{
+			hJob = pOwn->m_dJobs.back();
+			pOwn->m_dJobs.pop_back();
+		}
+	}
+
+	// then the oldest from everyone else, starting with the shared queue and then the worker after us so
+	// thieves spread out rather than all hitting worker 0:
+	unsigned int uiWorkers = uiQueues - 1;
+	unsigned int uiStart = bWorker ? t_uiJobWorker + 1 : 0;
+	for (unsigned int i = 0; !hJob && i <= uiWorkers; ++i)
+	{
+		unsigned int uiQueue = i == 0 ? uiWorkers : (uiStart + i - 1) % uiWorkers;
+		if (bWorker && uiQueue == t_uiJobWorker)
+			continue;
+
+		WorkerQueue* pVictim = m_vQueues[uiQueue];
+		std::lock_guard<std::mutex> lock(pVictim->m_Lock);
+		if (!pVictim->m_dJobs.empty())
+		{
+			hJob = pVictim->m_dJobs.front();
+			pVictim->m_dJobs.pop_front();
+			if (uiQueue != uiWorkers)
+				m_ullJobsStolen.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (hJob)
+		m_uiQueuedJobs.fetch_sub(1);
+
+	return hJob;
+}
+
+
+void JobSystem::Execute(const JobHandle& a_hJob)
+{
+	if (a_hJob->m_fWork)
+		a_hJob->m_fWork();
+
+	m_ullJobsRun.fetch_add(1, std::memory_order_relaxed);
+	Finish(a_hJob.get());
+}
+
+
+void JobSystem::Finish(Job* a_pJob)
+{
+	if (a_pJob->m_iUnfinished.fetch_sub(1) != 1)
+		return;
+
+	// this job and all its children are done, release anything that was waiting on it:
+	std::vector<JobHandle> vDependents;
+	{
+		std::lock_guard<std::mutex> lock(a_pJob->m_Lock);
+		a_pJob->m_bFinished = true;
+		vDependents.swap(a_pJob->m_vDependents);
+	}
+
+	for (auto& dependent : vDependents)
+		Submit(dependent);
+
+	// the parent can only finish after us, and dropping our reference lets it go once nothing else holds it:
+	JobHandle hParent;
+	hParent.swap(a_pJob->m_hParent);
+	if (hParent)
+		Finish(hParent.get());
+}
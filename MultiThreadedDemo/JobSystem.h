@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////
+/// @file		JobSystem.h
+/// @details	A work stealing job system for the per frame game work.
+///				Every worker owns a deque, it pushes and pops its own jobs at the
+///				back while idle workers steal from the front of the others.
+///				Threads that are not workers (main, render threads) push into a
+///				shared queue and help run jobs while they wait on one.
+///				Jobs can have a parent (the parent finishes when all of its
+///				children have) and dependencies (a job only runs after the jobs
+///				it depends on have finished), which is enough to build graphs.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _JOBSYSTEM_H_
+#define _JOBSYSTEM_H_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+struct Job;
+typedef std::shared_ptr<Job> JobHandle;
+
+const unsigned int c_uiDefaultJobGrainSize = 256;	// items per job for ParallelFor().
+
+class JobSystem
+{
+public:
+	typedef std::function<void()> JobFunc;
+	typedef std::function<void(unsigned int a_uiBegin, unsigned int a_uiEnd)> RangeFunc;
+
+	JobSystem();
+	~JobSystem();
+
+	/// Starts a_uiWorkers worker threads. With 0 every job runs on whichever thread waits for it.
+	void Start(unsigned int a_uiWorkers);
+	void Stop();	// not safe while jobs are still being submitted.
+	bool IsRunning() const								{ return !m_vWorkers.empty(); }
+	unsigned int GetWorkerCount() const					{ return (unsigned int)m_vWorkers.size(); }
+
+	/// Creates a job that will not run until it is submitted. If a_hParent is given the parent will not finish until this job has.
+	JobHandle CreateJob(JobFunc a_fWork, const JobHandle& a_hParent = JobHandle());
+
+	/// a_hJob will not run until a_hPrerequisite has finished. Must be called before a_hJob is submitted.
+	void AddDependency(const JobHandle& a_hJob, const JobHandle& a_hPrerequisite);
+
+	/// Queues the job, it runs as soon as all of its dependencies have finished.
+	void Submit(const JobHandle& a_hJob);
+
+	/// Runs other jobs until a_hJob (and all of its children) has finished.
+	void Wait(const JobHandle& a_hJob);
+	bool IsFinished(const JobHandle& a_hJob) const;
+
+	/// Splits [0, a_uiCount) into jobs of a_uiGrainSize items. The returned job finishes when they all have.
+	JobHandle ParallelForAsync(unsigned int a_uiCount, RangeFunc a_fWork, unsigned int a_uiGrainSize = c_uiDefaultJobGrainSize);
+	void ParallelFor(unsigned int a_uiCount, RangeFunc a_fWork, unsigned int a_uiGrainSize = c_uiDefaultJobGrainSize);
+
+	/// One less than the number of hardware threads, the thread that waits makes up the last one.
+	static unsigned int GetDefaultWorkerCount();
+
+	unsigned long long GetJobsRun() const				{ return m_ullJobsRun; }
+	unsigned long long GetJobsStolen() const			{ return m_ullJobsStolen; }
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex				m_Lock;
+		std::deque<JobHandle>	m_dJobs;
+	};
+
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+
+	void WorkerLoop(unsigned int a_uiWorker);
+	void Enqueue(const JobHandle& a_hJob);
+	bool RunOneJob();
+	JobHandle FindJob();
+	void Execute(const JobHandle& a_hJob);
+	void Finish(Job* a_pJob);
+
+	std::vector<std::thread*>		m_vWorkers;
+	std::vector<WorkerQueue*>		m_vQueues;			// one per worker plus the shared queue at the end.
+
+	std::mutex						m_SleepLock;
+	std::condition_variable			m_WakeUp;
+	std::atomic<unsigned int>		m_uiQueuedJobs;		// jobs sitting in any queue, sleeping workers wake when this goes up.
+	std::atomic_bool				m_bQuit;
+
+	std::atomic<unsigned long long>	m_ullJobsRun;
+	std::atomic<unsigned long long>	m_ullJobsStolen;
+};
+
+#endif // _JOBSYSTEM_H_
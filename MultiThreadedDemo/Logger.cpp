@@ -0,0 +1,684 @@
+// Note that the following includes must be defined in order:
+#include "ContextRegistry.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+#include <cstdarg>
+#include <cstddef>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+///////////////////// Custom Data Types ///////////////////////////////
+enum LogArgTypes
+{
+	LAT_SIGNED = 0,
+	LAT_UNSIGNED,
+	LAT_CHAR,
+	LAT_DOUBLE,
+	LAT_STRING,			// c_ullLogStringOffset bits of offset into m_acStrings, then the length.
+	LAT_POINTER,
+	LAT_NONE,			// %n, prints nothing.
+};
+
+enum LogLengths
+{
+	LLM_NONE = 0,
+	LLM_SHORT,			// h and hh, promoted to int anyway.
+	LLM_LONG,			// l
+	LLM_LONG_LONG,		// ll, I64 and j
+	LLM_SIZE,			// z and t
+	LLM_LONG_DOUBLE,	// L
+};
+
+// one % conversion of a format:
+struct LogSpec
+{
+	char		m_acFlags[8];
+	int			m_iWidth;				// -1 if none.
+	int			m_iPrecision;			// -1 if none.
+	bool		m_bWidthArg;			// * width, it is the argument before the value.
+	bool		m_bPrecisionArg;
+	LogLengths	m_eLength;
+	char		m_cConversion;			// '\0' if the format ended mid conversion.
+};
+
+// what is queued for a message, the arguments are packed but nothing is formatted:
+struct LogRecord
+{
+	const char*			m_szFormat;
+	unsigned char		m_ucArgCount;
+	unsigned char		m_aucArgTypes[c_uiMaxLogArgs];
+	unsigned short		m_usStringBytes;
+	unsigned long long	m_aullArgs[c_uiMaxLogArgs];		// the bits of each argument.
+	char				m_acStrings[c_uiLogStringBytes];
+};
+
+const unsigned long long c_ullLogStringOffset = 16;		// bits of a string argument holding its offset.
+const unsigned long long c_ullLogStringCut = 1ull << 63;	// set on a string argument that did not fit.
+
+class Logger
+{
+public:
+	Logger();
+	~Logger();
+
+	void Start();
+	void Stop();
+	bool IsRunning() const				{ return m_bRunning.load(std::memory_order_acquire); }
+
+	/// Waits until everything queued before the call has been written.
+	void Flush();
+
+	/// Queues the message, or prints it straight away if the flush thread is not running.
+	void Write(const char* a_szFormat, va_list a_Args);
+
+	/// False if a_eSource and a_uiID have used up this second's messages.
+	bool Admit(LogSources a_eSource, unsigned int a_uiID);
+
+private:
+	Logger(const Logger&);
+	Logger& operator=(const Logger&);
+
+	struct Cell
+	{
+		std::atomic<size_t>		m_uiSequence;		// its index when free, index + 1 once written, the next lap's index once read.
+		LogRecord				m_Record;
+	};
+
+	struct RateSlot
+	{
+		std::atomic<long long>		m_llSecond;		// the second m_uiCount is for.
+		std::atomic<unsigned int>	m_uiCount;
+		std::atomic<unsigned int>	m_uiSuppressed;
+		std::atomic<unsigned int>	m_uiLastSource;	// of the last message suppressed, for the report.
+		std::atomic<unsigned int>	m_uiLastID;
+	};
+
+	void FlushLoop();
+	void Drain(std::string& a_rszText);
+
+	Cell						m_aCells[c_uiLogRingSize];
+	std::atomic<size_t>			m_uiEnqueuePos;
+	size_t						m_uiDequeuePos;			// flush thread only.
+
+	RateSlot					m_aRateSlots[c_uiLogRateSlots];
+
+	std::atomic_bool			m_bRunning;
+	std::thread*				m_pThread;
+	std::mutex					m_Lock;
+	std::condition_variable		m_Wake;
+	std::condition_variable		m_Flushed;				// a batch was written.
+	bool						m_bQuit;
+	bool						m_bFlushRequested;		// wakes the flush thread before its interval is up.
+	size_t						m_uiFlushedPos;			// every message before this has been written, guarded by m_Lock.
+
+	std::atomic<unsigned long long>	m_ullWritten;
+	std::atomic<unsigned long long>	m_ullDropped;		// the ring was full.
+	std::atomic<unsigned long long>	m_ullRateLimited;
+};
+
+static Logger g_Logger;
+static THREAD_LOCAL char t_acLogThreadID[32];
+
+static const char* const c_aszLogSourceNames[LS_COUNT] = { "GL debug", "GLFW", "stream buffer" };
+
+
+static const char* ParseSpec(const char* a_szSpec, LogSpec& a_rSpec)
+{
+	// a_szSpec is just past the %:
+	const char* p = a_szSpec;
+	unsigned int uiFlags = 0;
+	while (*p != '\0' && strchr("-+ #0", *p) != nullptr)
+	{
+		if (uiFlags < sizeof(a_rSpec.m_acFlags) - 1)
+			a_rSpec.m_acFlags[uiFlags++] = *p;
+		++p;
+	}
+	a_rSpec.m_acFlags[uiFlags] = '\0';
+
+	a_rSpec.m_iWidth = -1;
+	a_rSpec.m_bWidthArg = *p == '*';
+	if (a_rSpec.m_bWidthArg)
+		++p;
+	for (; *p >= '0' && *p <= '9'; ++p)
+		a_rSpec.m_iWidth = (a_rSpec.m_iWidth < 0 ? 0 : a_rSpec.m_iWidth * 10) + (*p - '0');
+
+	a_rSpec.m_iPrecision = -1;
+	a_rSpec.m_bPrecisionArg = false;
+	if (*p == '.')
+	{
+		++p;
+		a_rSpec.m_iPrecision = 0;
+		a_rSpec.m_bPrecisionArg = *p == '*';
+		if (a_rSpec.m_bPrecisionArg)
+			++p;
+		for (; *p >= '0' && *p <= '9'; ++p)
+			a_rSpec.m_iPrecision = a_rSpec.m_iPrecision * 10 + (*p - '0');
+	}
+
+	a_rSpec.m_eLength = LLM_NONE;
+	if (*p == 'h')
+	{
+		a_rSpec.m_eLength = LLM_SHORT;
+		p += p[1] == 'h' ? 2 : 1;
+	}
+	else if (*p == 'l')
+	{
+		a_rSpec.m_eLength = p[1] == 'l' ? LLM_LONG_LONG : LLM_LONG;
+		p += p[1] == 'l' ? 2 : 1;
+	}
+	else if (*p == 'j')
+	{
+		a_rSpec.m_eLength = LLM_LONG_LONG;
+		++p;
+	}
+	else if (*p == 'I' && p[1] == '6' && p[2] == '4')
+	{
+		a_rSpec.m_eLength = LLM_LONG_LONG;
+		p += 3;
+	}
+	else if (*p == 'z' || *p == 't')
+	{
+		a_rSpec.m_eLength = LLM_SIZE;
+		++p;
+	}
+	else if (*p == 'L')
+	{
+		a_rSpec.m_eLength = LLM_LONG_DOUBLE;
+		++p;
+	}
+
+	a_rSpec.m_cConversion = *p;
+	return *p != '\0' ? p + 1 : p;
+}
+
+
+static void PackRecord(LogRecord& a_rRecord, const char* a_szFormat, va_list a_Args)
+{
+	a_rRecord.m_szFormat = a_szFormat;
+	a_rRecord.m_ucArgCount = 0;
+	a_rRecord.m_usStringBytes = 0;
+
+	// walks the format the way FormatRecord() will, so each argument is read with the type it was passed as:
+	LogSpec spec;
+	for (const char* p = strchr(a_szFormat, '%'); p != nullptr; p = strchr(p, '%'))
+	{
+		p = ParseSpec(p + 1, spec);
+		if (spec.m_cConversion == '%' || spec.m_cConversion == '\0')
+			continue;
+
+		unsigned int uiArgs = (spec.m_bWidthArg ? 1 : 0) + (spec.m_bPrecisionArg ? 1 : 0) + 1;
+		if (a_rRecord.m_ucArgCount + uiArgs > c_uiMaxLogArgs)
+			break;
+
+		for (unsigned int i = 1; i < uiArgs; ++i)
+		{
+			a_rRecord.m_aucArgTypes[a_rRecord.m_ucArgCount] = LAT_SIGNED;
+			a_rRecord.m_aullArgs[a_rRecord.m_ucArgCount++] = (unsigned long long)(long long)va_arg(a_Args, int);
+		}
+
+		unsigned char& rucType = a_rRecord.m_aucArgTypes[a_rRecord.m_ucArgCount];
+		unsigned long long& rullArg = a_rRecord.m_aullArgs[a_rRecord.m_ucArgCount++];
+		switch (spec.m_cConversion)
+		{
+		case 'd':
+		case 'i':
+			rucType = LAT_SIGNED;
+			switch (spec.m_eLength)
+			{
+			case LLM_LONG:			rullArg = (unsigned long long)(long long)va_arg(a_Args, long); break;
+			case LLM_LONG_LONG:		rullArg = (unsigned long long)va_arg(a_Args, long long); break;
+			case LLM_SIZE:			rullArg = (unsigned long long)(long long)va_arg(a_Args, ptrdiff_t); break;
+			default:				rullArg = (unsigned long long)(long long)va_arg(a_Args, int); break;
+			}
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			rucType = LAT_UNSIGNED;
+			switch (spec.m_eLength)
+			{
+			case LLM_LONG:			rullArg = va_arg(a_Args, unsigned long); break;
+			case LLM_LONG_LONG:		rullArg = va_arg(a_Args, unsigned long long); break;
+			case LLM_SIZE:			rullArg = va_arg(a_Args, size_t); break;
+			default:				rullArg = va_arg(a_Args, unsigned int); break;
+			}
+			break;
+		case 'c':
+			rucType = LAT_CHAR;
+			rullArg = (unsigned long long)va_arg(a_Args, int);
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+		{
+			rucType = LAT_DOUBLE;
+			double dValue = spec.m_eLength == LLM_LONG_DOUBLE ? (double)va_arg(a_Args, long double) : va_arg(a_Args, double);
+			memcpy(&rullArg, &dValue, sizeof(double));
+			break;
+		}
+		case 's':
+		{
+			// the only thing copied, the string may be gone by the time it is printed:
+			rucType = LAT_STRING;
+			const char* szValue = va_arg(a_Args, const char*);
+			if (szValue == nullptr)
+				szValue = "(null)";
+			size_t uiLength = strlen(szValue);
+			size_t uiRoom = c_uiLogStringBytes - a_rRecord.m_usStringBytes;
+			size_t uiCopied = uiLength < uiRoom ? uiLength : uiRoom;
+			memcpy(a_rRecord.m_acStrings + a_rRecord.m_usStringBytes, szValue, uiCopied);
+			rullArg = (unsigned long long)a_rRecord.m_usStringBytes | (unsigned long long)uiCopied << c_ullLogStringOffset;
+			if (uiCopied < uiLength)
+				rullArg |= c_ullLogStringCut;
+			a_rRecord.m_usStringBytes = (unsigned short)(a_rRecord.m_usStringBytes + uiCopied);
+			break;
+		}
+		case 'p':
+			rucType = LAT_POINTER;
+			rullArg = (unsigned long long)(size_t)va_arg(a_Args, void*);
+			break;
+		case 'n':
+			rucType = LAT_NONE;
+			va_arg(a_Args, int*);
+			break;
+		default:
+			// not a conversion printf knows, nothing was passed for it:
+			rucType = LAT_NONE;
+			break;
+		}
+	}
+}
+
+
+static void AppendSpecPrefix(std::string& a_rszSpec, const LogSpec& a_rSpec)
+{
+	// widths past these would only be a mistake, and the formatting buffer must hold the result:
+	a_rszSpec = "%";
+	a_rszSpec += a_rSpec.m_acFlags;
+	if (a_rSpec.m_iWidth >= 0)
+		a_rszSpec += std::to_string(a_rSpec.m_iWidth < 128 ? a_rSpec.m_iWidth : 128);
+	if (a_rSpec.m_iPrecision >= 0)
+		a_rszSpec += "." + std::to_string(a_rSpec.m_iPrecision < 64 ? a_rSpec.m_iPrecision : 64);
+}
+
+
+static void FormatRecord(const LogRecord& a_rRecord, std::string& a_rszText)
+{
+	char acBuffer[512];
+	std::string szSpec;
+	unsigned int uiArg = 0;
+
+	const char* p = a_rRecord.m_szFormat;
+	while (*p != '\0')
+	{
+		const char* szPercent = strchr(p, '%');
+		if (szPercent == nullptr)
+		{
+			a_rszText += p;
+			break;
+		}
+		a_rszText.append(p, szPercent - p);
+
+		LogSpec spec;
+		p = ParseSpec(szPercent + 1, spec);
+		if (spec.m_cConversion == '%')
+		{
+			a_rszText += '%';
+			continue;
+		}
+		if (spec.m_cConversion == '\0')
+			break;
+
+		// * widths and precisions come first, a negative width means left aligned:
+		if (spec.m_bWidthArg && uiArg < a_rRecord.m_ucArgCount)
+		{
+			long long llWidth = (long long)a_rRecord.m_aullArgs[uiArg++];
+			size_t uiFlags = strlen(spec.m_acFlags);
+			if (llWidth < 0 && strchr(spec.m_acFlags, '-') == nullptr && uiFlags < sizeof(spec.m_acFlags) - 1)
+			{
+				spec.m_acFlags[uiFlags] = '-';
+				spec.m_acFlags[uiFlags + 1] = '\0';
+			}
+			if (llWidth < 0)
+				llWidth = -llWidth;
+			spec.m_iWidth = (int)llWidth;
+		}
+		if (spec.m_bPrecisionArg && uiArg < a_rRecord.m_ucArgCount)
+			spec.m_iPrecision = (int)(long long)a_rRecord.m_aullArgs[uiArg++];
+
+		if (uiArg >= a_rRecord.m_ucArgCount)
+		{
+			a_rszText += '?';
+			continue;
+		}
+
+		unsigned long long ullArg = a_rRecord.m_aullArgs[uiArg];
+		AppendSpecPrefix(szSpec, spec);
+		switch (a_rRecord.m_aucArgTypes[uiArg++])
+		{
+		case LAT_SIGNED:
+			szSpec += std::string("ll") + spec.m_cConversion;
+			sprintf(acBuffer, szSpec.c_str(), (long long)ullArg);
+			a_rszText += acBuffer;
+			break;
+		case LAT_UNSIGNED:
+			szSpec += std::string("ll") + spec.m_cConversion;
+			sprintf(acBuffer, szSpec.c_str(), ullArg);
+			a_rszText += acBuffer;
+			break;
+		case LAT_CHAR:
+			szSpec += 'c';
+			sprintf(acBuffer, szSpec.c_str(), (int)ullArg);
+			a_rszText += acBuffer;
+			break;
+		case LAT_DOUBLE:
+		{
+			double dValue;
+			memcpy(&dValue, &ullArg, sizeof(double));
+			szSpec += spec.m_cConversion;
+			sprintf(acBuffer, szSpec.c_str(), dValue);
+			a_rszText += acBuffer;
+			break;
+		}
+		case LAT_STRING:
+		{
+			// padded by hand, the string can be longer than any buffer:
+			size_t uiOffset = (size_t)(ullArg & 0xFFFF);
+			size_t uiLength = (size_t)((ullArg & ~c_ullLogStringCut) >> c_ullLogStringOffset);
+			if (spec.m_iPrecision >= 0 && (size_t)spec.m_iPrecision < uiLength)
+				uiLength = spec.m_iPrecision;
+			size_t uiPadding = spec.m_iWidth > 0 && (size_t)spec.m_iWidth > uiLength ? spec.m_iWidth - uiLength : 0;
+			bool bLeft = strchr(spec.m_acFlags, '-') != nullptr;
+			if (!bLeft)
+				a_rszText.append(uiPadding, ' ');
+			a_rszText.append(a_rRecord.m_acStrings + uiOffset, uiLength);
+			if ((ullArg & c_ullLogStringCut) != 0)
+				a_rszText += "...";
+			if (bLeft)
+				a_rszText.append(uiPadding, ' ');
+			break;
+		}
+		case LAT_POINTER:
+			szSpec += 'p';
+			sprintf(acBuffer, szSpec.c_str(), (void*)(size_t)ullArg);
+			a_rszText += acBuffer;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+
+Logger::Logger()
+	: m_uiEnqueuePos(0)
+	, m_uiDequeuePos(0)
+	, m_bRunning(false)
+	, m_pThread(nullptr)
+	, m_bQuit(false)
+	, m_bFlushRequested(false)
+	, m_uiFlushedPos(0)
+	, m_ullWritten(0)
+	, m_ullDropped(0)
+	, m_ullRateLimited(0)
+{
+	for (size_t i = 0; i < c_uiLogRingSize; ++i)
+		m_aCells[i].m_uiSequence = i;
+
+	for (auto& slot : m_aRateSlots)
+	{
+		slot.m_llSecond = -1;
+		slot.m_uiCount = 0;
+		slot.m_uiSuppressed = 0;
+		slot.m_uiLastSource = 0;
+		slot.m_uiLastID = 0;
+	}
+}
+
+
+Logger::~Logger()
+{
+	Stop();
+}
+
+
+void Logger::Start()
+{
+	if (m_pThread != nullptr)
+		return;
+
+	m_bQuit = false;
+	m_pThread = new std::thread(&Logger::FlushLoop, this);
+	m_bRunning.store(true, std::memory_order_release);
+}
+
+
+void Logger::Stop()
+{
+	if (m_pThread == nullptr)
+		return;
+
+	// new messages print straight away from here on, the flush thread writes what is already queued before it exits:
+	m_bRunning.store(false, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_bQuit = true;
+		m_Wake.notify_all();
+	}
+	m_pThread->join();
+	delete m_pThread;
+	m_pThread = nullptr;
+
+	// anything a thread queued just as we stopped:
+	std::string szText;
+	Drain(szText);
+	fputs(szText.c_str(), stdout);
+
+	printf("Status: Logged %llu messages, %llu were rate limited and %llu dropped because the log was full\n",
+		m_ullWritten.load(), m_ullRateLimited.load(), m_ullDropped.load());
+}
+
+
+void Logger::Flush()
+{
+	if (IsRunning())
+	{
+		size_t uiTarget = m_uiEnqueuePos.load(std::memory_order_acquire);
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_bFlushRequested = true;
+		m_Wake.notify_all();
+		m_Flushed.wait(lock, [this, uiTarget] () { return m_bQuit || (ptrdiff_t)(m_uiFlushedPos - uiTarget) >= 0; });
+	}
+	fflush(stdout);
+}
+
+
+bool Logger::Admit(LogSources a_eSource, unsigned int a_uiID)
+{
+	unsigned int uiHash = (a_uiID ^ ((unsigned int)a_eSource << 24)) * 2654435761u;
+	RateSlot& slot = m_aRateSlots[(uiHash >> 16) % c_uiLogRateSlots];
+
+	// whoever moves the slot on to a new second reports what the last one suppressed:
+	long long llSecond = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	long long llSlotSecond = slot.m_llSecond.load(std::memory_order_relaxed);
+	if (llSlotSecond != llSecond && slot.m_llSecond.compare_exchange_strong(llSlotSecond, llSecond))
+	{
+		slot.m_uiCount.store(0, std::memory_order_relaxed);
+		unsigned int uiSuppressed = slot.m_uiSuppressed.exchange(0);
+		if (uiSuppressed > 0)
+		{
+			unsigned int uiSource = slot.m_uiLastSource.load(std::memory_order_relaxed);
+			Log("Warning: %u %s messages like ID %u were rate limited\n", uiSuppressed,
+				c_aszLogSourceNames[uiSource < LS_COUNT ? uiSource : 0], slot.m_uiLastID.load(std::memory_order_relaxed));
+		}
+	}
+
+	if (slot.m_uiCount.fetch_add(1, std::memory_order_relaxed) < c_uiLogRateLimit)
+		return true;
+
+	slot.m_uiLastSource.store((unsigned int)a_eSource, std::memory_order_relaxed);
+	slot.m_uiLastID.store(a_uiID, std::memory_order_relaxed);
+	slot.m_uiSuppressed.fetch_add(1, std::memory_order_relaxed);
+	m_ullRateLimited.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+
+void Logger::Write(const char* a_szFormat, va_list a_Args)
+{
+	if (!IsRunning())
+	{
+		LogRecord record;
+		PackRecord(record, a_szFormat, a_Args);
+		std::string szText;
+		FormatRecord(record, szText);
+		fputs(szText.c_str(), stdout);
+		return;
+	}
+
+	// claim the next cell, unless the flush thread has not read it from the last lap yet (see FlushLoop()):
+	size_t uiPos = m_uiEnqueuePos.load(std::memory_order_relaxed);
+	Cell* pCell = nullptr;
+	while (true)
+	{
+		pCell = &m_aCells[uiPos & (c_uiLogRingSize - 1)];
+		size_t uiSequence = pCell->m_uiSequence.load(std::memory_order_acquire);
+		if (uiSequence == uiPos)
+		{
+			if (m_uiEnqueuePos.compare_exchange_weak(uiPos, uiPos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (uiSequence < uiPos)
+		{
+			m_ullDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			uiPos = m_uiEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	PackRecord(pCell->m_Record, a_szFormat, a_Args);
+	pCell->m_uiSequence.store(uiPos + 1, std::memory_order_release);
+}
+
+
+void Logger::Drain(std::string& a_rszText)
+{
+	// cells are read in order, so one still being written holds up the ones after it until the next batch:
+	while (true)
+	{
+		Cell& cell = m_aCells[m_uiDequeuePos & (c_uiLogRingSize - 1)];
+		if (cell.m_uiSequence.load(std::memory_order_acquire) != m_uiDequeuePos + 1)
+			break;
+
+		FormatRecord(cell.m_Record, a_rszText);
+		cell.m_uiSequence.store(m_uiDequeuePos + c_uiLogRingSize, std::memory_order_release);
+		++m_uiDequeuePos;
+		m_ullWritten.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+void Logger::FlushLoop()
+{
+	std::string szText;
+	bool bQuit = false;
+	while (!bQuit)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Lock);
+			m_Wake.wait_for(lock, std::chrono::milliseconds(c_uiLogFlushInterval), [this] () { return m_bQuit || m_bFlushRequested; });
+			m_bFlushRequested = false;
+			bQuit = m_bQuit;
+		}
+
+		// one write per batch, however many messages are in it:
+		Drain(szText);
+		if (!szText.empty())
+		{
+			fwrite(szText.data(), 1, szText.size(), stdout);
+			fflush(stdout);
+			szText.clear();
+		}
+
+		// a cell still being written holds up the ones after it, so FlushLog() may have to wait for another batch:
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_uiFlushedPos = m_uiDequeuePos;
+		}
+		m_Flushed.notify_all();
+	}
+}
+
+
+void StartLogger()
+{
+	g_Logger.Start();
+}
+
+
+void StopLogger()
+{
+	g_Logger.Stop();
+}
+
+
+void FlushLog()
+{
+	g_Logger.Flush();
+}
+
+
+bool IsLoggerRunning()
+{
+	return g_Logger.IsRunning();
+}
+
+
+void Log(const char* a_szFormat, ...)
+{
+	va_list args;
+	va_start(args, a_szFormat);
+	g_Logger.Write(a_szFormat, args);
+	va_end(args);
+}
+
+
+void LogRateLimited(LogSources a_eSource, unsigned int a_uiID, const char* a_szFormat, ...)
+{
+	if (!g_Logger.Admit(a_eSource, a_uiID))
+		return;
+
+	va_list args;
+	va_start(args, a_szFormat);
+	g_Logger.Write(a_szFormat, args);
+	va_end(args);
+}
+
+
+const char* GetLogThreadID()
+{
+	if (t_acLogThreadID[0] == '\0')
+	{
+		std::ostringstream threadID;
+		threadID << std::this_thread::get_id();
+		strncpy(t_acLogThreadID, threadID.str().c_str(), sizeof(t_acLogThreadID) - 1);
+	}
+	return t_acLogThreadID;
+}
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////
+/// @file		Logger.h
+/// @details	Console output that never makes the thread logging it wait on
+///				the console. Log() takes a printf() format but only packs its
+///				arguments into a fixed size binary record (%s strings are
+///				copied, nothing is formatted) and claims a cell of a lock free
+///				ring for it. A flush thread formats whatever has been queued
+///				every few milliseconds and writes it out in one go. If the ring
+///				is full the message is dropped and counted, not waited for.
+///				LogRateLimited() also lets through at most c_uiLogRateLimit
+///				messages a second for each ID, so a burst of GL debug messages
+///				from a render thread costs next to nothing.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _LOGGER_H_
+#define _LOGGER_H_
+
+////////////////////////// Constants //////////////////////////////////
+const unsigned int c_uiLogRingSize = 2048;			// records, a power of two. About 1MB.
+const unsigned int c_uiMaxLogArgs = 8;				// arguments of one message, any past this print as ?.
+const unsigned int c_uiLogStringBytes = 400;		// the %s arguments of one message share this, longer ones are cut short.
+const unsigned int c_uiLogFlushInterval = 5;		// ms the flush thread sleeps between batches.
+const unsigned int c_uiLogRateSlots = 256;			// IDs that hash to the same slot share its limit.
+const unsigned int c_uiLogRateLimit = 10;			// messages a second for each rate limited ID, the rest are counted and dropped.
+
+///////////////////// Custom Data Types ///////////////////////////////
+enum LogSources
+{
+	LS_GL_DEBUG = 0,		// the ID is the GL debug message ID.
+	LS_GLFW,				// the GLFW error code.
+	LS_STREAM_BUFFER,		// the buffer's GL name.
+
+	LS_COUNT,
+};
+
+/////////////////////////// Functions /////////////////////////////////
+/// Starts the flush thread. Until then, and after StopLogger(), Log() formats and prints straight away.
+void StartLogger();
+
+/// Writes everything still queued and joins the flush thread, then prints how many messages were rate limited or dropped.
+/// Messages logged by other threads while it runs may be printed out of order.
+void StopLogger();
+
+/// Waits until everything logged before the call has been written, so output printed straight to the console after it
+/// comes after it too. The benchmarks call it before printing their tables.
+void FlushLog();
+
+bool IsLoggerRunning();
+
+/// Like printf(). The format is not copied, so it must outlive the logger, which a string literal does.
+/// * widths and precisions are supported, %n is ignored.
+void Log(const char* a_szFormat, ...);
+
+/// Log(), but only c_uiLogRateLimit messages a second get through for each source and ID.
+void LogRateLimited(LogSources a_eSource, unsigned int a_uiID, const char* a_szFormat, ...);
+
+/// std::this_thread::get_id() as text, worked out once per thread.
+const char* GetLogThreadID();
+
+#endif // _LOGGER_H_
@@ -0,0 +1,141 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "GLStateCache.h"
+#include "MultiViewTarget.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+
+
+MultiViewTarget::MultiViewTarget()
+	: m_pRegistry(nullptr)
+	, m_uiDrawFramebuffer(c_uiInvalidContextObject)
+	, m_uiReadFramebuffer(c_uiInvalidContextObject)
+	, m_uiColourTexture(0)
+	, m_uiDepthTexture(0)
+	, m_iWidth(0)
+	, m_iHeight(0)
+	, m_uiViews(0)
+	, m_bChecked(false)
+	, m_PassFence(0)
+{
+}
+
+
+MultiViewTarget::~MultiViewTarget()
+{
+	if (m_uiColourTexture != 0)
+		printf("Warning: MultiViewTarget %u was not destroyed!\n", m_uiColourTexture);
+}
+
+
+void MultiViewTarget::RegisterFramebuffers(ContextObjectRegistry& a_rRegistry)
+{
+	// the attachments change whenever the target is recreated, so they are made in BeginPass() and Present() instead:
+	m_pRegistry = &a_rRegistry;
+	m_uiDrawFramebuffer = a_rRegistry.Register(COT_FRAMEBUFFER, ContextObjectRegistry::BuildFunc());
+	m_uiReadFramebuffer = a_rRegistry.Register(COT_FRAMEBUFFER, ContextObjectRegistry::BuildFunc());
+}
+
+
+bool MultiViewTarget::Create(GLStateCache& a_rState, GLsizei a_iWidth, GLsizei a_iHeight, unsigned int a_uiViews)
+{
+	if (m_uiColourTexture != 0 || m_pRegistry == nullptr || a_iWidth <= 0 || a_iHeight <= 0 || a_uiViews == 0)
+		return false;
+
+	m_iWidth = a_iWidth;
+	m_iHeight = a_iHeight;
+	m_uiViews = a_uiViews;
+	m_bChecked = false;
+
+	// one layer per view, blits scale them so they need filtering but never mipmaps:
+	glGenTextures(1, &m_uiColourTexture);
+	a_rState.BindTexture(GL_TEXTURE_2D_ARRAY, m_uiColourTexture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, a_iWidth, a_iHeight, a_uiViews, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glGenTextures(1, &m_uiDepthTexture);
+	a_rState.BindTexture(GL_TEXTURE_2D_ARRAY, m_uiDepthTexture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, a_iWidth, a_iHeight, a_uiViews, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	a_rState.BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return true;
+}
+
+
+void MultiViewTarget::Destroy(GLStateCache& a_rState)
+{
+	if (m_PassFence != 0)
+	{
+		glDeleteSync(m_PassFence);
+		m_PassFence = 0;
+	}
+
+	if (m_uiColourTexture == 0)
+		return;
+
+	// the framebuffers that still have them attached let go when they are next attached to, or deleted:
+	a_rState.BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glDeleteTextures(1, &m_uiColourTexture);
+	glDeleteTextures(1, &m_uiDepthTexture);
+	m_uiColourTexture = 0;
+	m_uiDepthTexture = 0;
+	m_uiViews = 0;
+}
+
+
+void MultiViewTarget::BeginPass(GLStateCache& a_rState, unsigned int a_uiSlot)
+{
+	// attaching a whole array makes the framebuffer layered, gl_Layer then picks the layer each triangle goes to:
+	GLuint uiFramebuffer = m_pRegistry->Get(m_uiDrawFramebuffer, a_uiSlot);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, uiFramebuffer);
+	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_uiColourTexture, 0);
+	glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_uiDepthTexture, 0);
+
+	if (!m_bChecked)
+	{
+		GLenum eStatus = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+		if (eStatus != GL_FRAMEBUFFER_COMPLETE)
+			Log("Error: Multi-view framebuffer is incomplete (0x%x)!\n", eStatus);
+		m_bChecked = true;
+	}
+
+	// a layered clear clears every layer:
+	a_rState.Viewport(0, 0, m_iWidth, m_iHeight);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+
+void MultiViewTarget::EndPass()
+{
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+	// every Present() of the last pass has been issued by now, GL keeps the fence alive until their waits are done:
+	if (m_PassFence != 0)
+		glDeleteSync(m_PassFence);
+	m_PassFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();		// the other contexts can only wait on a fence that has reached the GPU.
+}
+
+
+void MultiViewTarget::Present(unsigned int a_uiSlot, unsigned int a_uiLayer, GLsizei a_iWidth, GLsizei a_iHeight)
+{
+	if (m_uiColourTexture == 0 || a_uiLayer >= m_uiViews)
+		return;
+
+	if (m_PassFence != 0)
+		glWaitSync(m_PassFence, 0, GL_TIMEOUT_IGNORED);
+
+	// attaching again after the fence is also what makes the pass visible to this context. Nothing else reads from a
+	// framebuffer, so it is left bound for reading and the blit goes to the back buffer, which is always bound for drawing:
+	GLuint uiFramebuffer = m_pRegistry->Get(m_uiReadFramebuffer, a_uiSlot);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, uiFramebuffer);
+	glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_uiColourTexture, 0, a_uiLayer);
+	glBlitFramebuffer(0, 0, m_iWidth, m_iHeight, 0, 0, a_iWidth, a_iHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+}
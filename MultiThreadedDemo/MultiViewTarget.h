@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////
+/// @file		MultiViewTarget.h
+/// @details	A colour and depth texture array with one layer per view, so the
+///				views of every window can be drawn in a single pass. One context
+///				draws the pass, a geometry shader copies each triangle into every
+///				layer through gl_Layer, and each window's context then only blits
+///				its own layer to its back buffer. The textures are shared, the
+///				framebuffers are not, so each context gets its own through the
+///				ContextObjectRegistry. The pass is fenced and every blit waits on
+///				the fence on the GPU, the CPU never blocks.
+///				Layers are a fixed size and are scaled to fit each window.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _MULTIVIEWTARGET_H_
+#define _MULTIVIEWTARGET_H_
+
+#include "ContextObjectRegistry.h"
+
+class GLStateCache;
+
+class MultiViewTarget
+{
+public:
+	MultiViewTarget();
+	~MultiViewTarget();		// Destroy() must have been called with a context current.
+
+	/// Registers the draw and read framebuffers every context builds on first use. Call before any render thread starts.
+	void RegisterFramebuffers(ContextObjectRegistry& a_rRegistry);
+
+	/// Creates the texture arrays, a context must be current. a_uiViews layers of a_iWidth by a_iHeight.
+	bool Create(GLStateCache& a_rState, GLsizei a_iWidth, GLsizei a_iHeight, unsigned int a_uiViews);
+	void Destroy(GLStateCache& a_rState);
+
+	/// Binds every layer for drawing, sets the viewport to the layer size and clears them all.
+	/// a_uiSlot is the context slot of the context drawing the pass.
+	void BeginPass(GLStateCache& a_rState, unsigned int a_uiSlot);
+
+	/// Goes back to the default framebuffer and fences the pass for Present(). The caller restores the viewport.
+	void EndPass();
+
+	/// Blits a_uiLayer to the current context's back buffer, scaled to a_iWidth by a_iHeight. Waits on the pass on the GPU.
+	/// Leaves the context's read framebuffer bound.
+	void Present(unsigned int a_uiSlot, unsigned int a_uiLayer, GLsizei a_iWidth, GLsizei a_iHeight);
+
+	bool IsCreated() const						{ return m_uiColourTexture != 0; }
+	unsigned int GetViewCount() const			{ return m_uiViews; }
+
+private:
+	MultiViewTarget(const MultiViewTarget&);			// not copyable, we own GL objects.
+	MultiViewTarget& operator=(const MultiViewTarget&);
+
+	ContextObjectRegistry*	m_pRegistry;
+	ContextObjectID			m_uiDrawFramebuffer;	// every layer attached, only the context drawing the pass uses it.
+	ContextObjectID			m_uiReadFramebuffer;	// one layer attached, every presenting context has one.
+
+	GLuint					m_uiColourTexture;
+	GLuint					m_uiDepthTexture;
+	GLsizei					m_iWidth;
+	GLsizei					m_iHeight;
+	unsigned int			m_uiViews;
+	bool					m_bChecked;				// framebuffer completeness is checked on the first pass only.
+
+	GLsync					m_PassFence;			// after the last pass, 0 before the first.
+};
+
+#endif // _MULTIVIEWTARGET_H_
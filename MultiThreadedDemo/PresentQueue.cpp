@@ -0,0 +1,163 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ThreadingDemo.h"
+#include "ContextRegistry.h"
+#include "FrameTiming.h"
+#include "PresentQueue.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+
+void MakeContextCurrent(WindowHandle a_hWindowHandle);	// defined in ThreadingDemo.cpp
+
+
+PresentQueue::PresentQueue()
+	: m_dRefreshPeriod(0.0)
+{
+}
+
+
+PresentQueue::~PresentQueue()
+{
+	Stop();
+}
+
+
+void PresentQueue::Start(const std::vector<WindowHandle>& a_vWindows, double a_dRefreshPeriod)
+{
+	if (IsRunning() || a_vWindows.empty())
+		return;
+
+	m_dRefreshPeriod = a_dRefreshPeriod;
+	m_vThreadsBySlot.assign(c_uiMaxWindowCount, nullptr);
+
+	// the threads sit and wait for their first Present() before touching the context:
+	for (auto window : a_vWindows)
+	{
+		PresentThread* thread = new PresentThread();
+		thread->m_hWindow = window;
+		thread->m_bQueued = false;
+		thread->m_bQuit = false;
+		thread->m_dQueuedTime = 0.0;
+		thread->m_pThread = new std::thread(&PresentQueue::ThreadLoop, this, thread);
+
+		m_vThreads.push_back(thread);
+		m_vThreadsBySlot[window->m_uiSlot] = thread;
+	}
+
+	Log("Present queue started %u present threads\n", (unsigned int)m_vThreads.size());
+}
+
+
+void PresentQueue::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	// each thread finishes the swap it has queued, if any, before it sees the quit:
+	for (auto thread : m_vThreads)
+	{
+		std::lock_guard<std::mutex> lock(thread->m_Lock);
+		thread->m_bQuit = true;
+		thread->m_Wake.notify_all();
+	}
+
+	for (auto thread : m_vThreads)
+	{
+		thread->m_pThread->join();
+		delete thread->m_pThread;
+		delete thread;
+	}
+	m_vThreads.clear();
+	m_vThreadsBySlot.clear();
+
+	Log("Present queue stopped\n");
+}
+
+
+double PresentQueue::Acquire(WindowHandle a_hWindow)
+{
+	double dWaited = 0.0;
+	PresentThread* pThread = Find(a_hWindow);
+	if (pThread != nullptr)
+	{
+		std::unique_lock<std::mutex> lock(pThread->m_Lock);
+		if (pThread->m_bQueued)
+		{
+			double dStart = glfwGetTime();
+			pThread->m_Wake.wait(lock, [pThread] () { return !pThread->m_bQueued; });
+			dWaited = glfwGetTime() - dStart;
+		}
+	}
+
+	MakeContextCurrent(a_hWindow);
+	return dWaited;
+}
+
+
+void PresentQueue::Present(WindowHandle a_hWindow)
+{
+	PresentThread* pThread = Find(a_hWindow);
+	if (pThread == nullptr)
+	{
+		double dStart = glfwGetTime();
+		glfwSwapBuffers(a_hWindow->m_pWindow);
+		RecordPresent(a_hWindow, dStart, dStart, glfwGetTime(), m_dRefreshPeriod);
+		return;
+	}
+
+	// a context can only be current on one thread, so let go of it before the present thread takes it.
+	// Releasing it flushes it too, so the swap follows everything we drew:
+	glfwMakeContextCurrent(nullptr);
+	SetCurrentContext(nullptr, nullptr);
+
+	std::lock_guard<std::mutex> lock(pThread->m_Lock);
+	pThread->m_bQueued = true;
+	pThread->m_dQueuedTime = glfwGetTime();
+	pThread->m_Wake.notify_all();
+}
+
+
+PresentQueue::PresentThread* PresentQueue::Find(WindowHandle a_hWindow) const
+{
+	if (a_hWindow->m_uiSlot >= m_vThreadsBySlot.size())
+		return nullptr;
+
+	PresentThread* pThread = m_vThreadsBySlot[a_hWindow->m_uiSlot];
+	return pThread != nullptr && pThread->m_hWindow == a_hWindow ? pThread : nullptr;
+}
+
+
+void PresentQueue::ThreadLoop(PresentThread* a_pThread)
+{
+	WindowHandle hWindow = a_pThread->m_hWindow;
+
+	while (true)
+	{
+		double dQueued = 0.0;
+		{
+			std::unique_lock<std::mutex> lock(a_pThread->m_Lock);
+			a_pThread->m_Wake.wait(lock, [a_pThread] () { return a_pThread->m_bQueued || a_pThread->m_bQuit; });
+			if (!a_pThread->m_bQueued)
+				break;
+			dQueued = a_pThread->m_dQueuedTime;
+		}
+
+		// the drawing thread has given the context up and cannot take it back until we say so:
+		MakeContextCurrent(hWindow);
+		double dSwapStart = glfwGetTime();
+		glfwSwapBuffers(hWindow->m_pWindow);
+		double dSwapEnd = glfwGetTime();
+		glfwMakeContextCurrent(nullptr);
+		SetCurrentContext(nullptr, nullptr);
+
+		RecordPresent(hWindow, dQueued, dSwapStart, dSwapEnd, m_dRefreshPeriod);
+
+		{
+			std::lock_guard<std::mutex> lock(a_pThread->m_Lock);
+			a_pThread->m_bQueued = false;
+			a_pThread->m_Wake.notify_all();
+		}
+	}
+}
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////
+/// @file		PresentQueue.h
+/// @details	Gives every window its own present thread, so a thread drawing
+///				windows one after another does not wait for each window's
+///				swap in turn. The drawing thread acquires a window's context,
+///				draws it and hands it to the window's present thread, which
+///				makes the context current, swaps and gives it back. With vsync
+///				on, the swaps of all the windows wait for the same vertical
+///				blank instead of one blank each.
+///				Only one thread may draw through the queue, and only between
+///				Start() and Stop().
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _PRESENTQUEUE_H_
+#define _PRESENTQUEUE_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct Window;
+typedef Window* WindowHandle;
+
+class PresentQueue
+{
+public:
+	PresentQueue();
+	~PresentQueue();
+
+	/// Starts a present thread for each window. a_dRefreshPeriod is the display's refresh period in seconds,
+	/// used to count missed vertical blanks (see RecordPresent() in FrameTiming.h).
+	void Start(const std::vector<WindowHandle>& a_vWindows, double a_dRefreshPeriod);
+
+	/// Waits for the queued swaps and joins the present threads. None of the windows' contexts are current anywhere afterwards.
+	void Stop();
+
+	/// Waits for the window's last swap to finish and makes its context current on the calling thread.
+	/// Returns the time spent waiting in seconds. Windows opened after Start() are just made current.
+	double Acquire(WindowHandle a_hWindow);
+
+	/// Gives up the window's context and queues its swap on its present thread. Windows opened after Start() are swapped here.
+	void Present(WindowHandle a_hWindow);
+
+	bool IsRunning() const					{ return !m_vThreads.empty(); }
+	unsigned int GetThreadCount() const		{ return (unsigned int)m_vThreads.size(); }
+
+private:
+	PresentQueue(const PresentQueue&);				// not copyable, we own threads.
+	PresentQueue& operator=(const PresentQueue&);
+
+	struct PresentThread
+	{
+		std::thread*			m_pThread;
+		WindowHandle			m_hWindow;
+
+		std::mutex				m_Lock;			// guards the three below.
+		std::condition_variable	m_Wake;			// both ways, a swap has been queued or it has finished.
+		bool					m_bQueued;		// a swap is waiting or in progress, the present thread owns the context.
+		bool					m_bQuit;
+		double					m_dQueuedTime;
+	};
+
+	void ThreadLoop(PresentThread* a_pThread);
+	PresentThread* Find(WindowHandle a_hWindow) const;
+
+	std::vector<PresentThread*>		m_vThreads;
+	std::vector<PresentThread*>		m_vThreadsBySlot;		// by Window::m_uiSlot, nullptr for windows without one.
+	double							m_dRefreshPeriod;
+};
+
+#endif // _PRESENTQUEUE_H_
@@ -0,0 +1,346 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ProgramCache.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+#include <cstdarg>
+#include <vector>
+#include <algorithm>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+GLEWContext* glewGetContext();	// GLEW MX needs this for every GL call, each demo defines it.
+
+const unsigned int c_uiProgramBinaryMagic = 0x43504C47;	// "GLPC"
+const unsigned int c_uiProgramBinaryVersion = 1;
+
+// written in front of every binary:
+struct ProgramBinaryHeader
+{
+	unsigned int		m_uiMagic;
+	unsigned int		m_uiVersion;
+	unsigned long long	m_ullKey;
+	unsigned int		m_uiFormat;
+	unsigned int		m_uiLength;
+	double				m_dBuildSeconds;	// so a later hit knows how much time it saved.
+};
+
+
+// the default, so the cache needs nothing but this file:
+static void PrintMessage(const char* a_szFormat, ...)
+{
+	va_list args;
+	va_start(args, a_szFormat);
+	vprintf(a_szFormat, args);
+	va_end(args);
+}
+
+
+ProgramCache::ProgramCache(const std::string& a_szDirectory)
+	: m_szDirectory(a_szDirectory)
+	, m_bEnabled(true)
+	, m_fMessage(&PrintMessage)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+
+void ProgramCache::SetMessageFunc(MessageFunc a_fMessage)
+{
+	m_fMessage = a_fMessage != nullptr ? a_fMessage : &PrintMessage;
+}
+
+
+GLuint ProgramCache::CreateProgram(const char* a_szVertexShader, const char* a_szPixelShader, const std::string& a_szDefines, PreLinkFunc a_fPreLink)
+{
+	return CreateProgram(a_szVertexShader, nullptr, a_szPixelShader, a_szDefines, a_fPreLink);
+}
+
+
+GLuint ProgramCache::CreateProgram(const char* a_szVertexShader, const char* a_szGeometryShader, const char* a_szPixelShader, const std::string& a_szDefines, PreLinkFunc a_fPreLink)
+{
+	std::string szVertexShader = AddDefines(a_szVertexShader, a_szDefines);
+	std::string szGeometryShader = a_szGeometryShader != nullptr ? AddDefines(a_szGeometryShader, a_szDefines) : "";
+	std::string szPixelShader = AddDefines(a_szPixelShader, a_szDefines);
+	bool bUseCache = m_bEnabled && IsSupported();
+
+	// the key, a binary is only any good for the exact same source on the exact same driver:
+	unsigned long long ullKey = 14695981039346656037ull;	// FNV-1a offset basis.
+	ullKey = Hash(ullKey, szVertexShader.c_str());
+	if (!szGeometryShader.empty())
+		ullKey = Hash(ullKey, szGeometryShader.c_str());	// only when there is one, so the keys of the other programs stay the same.
+	ullKey = Hash(ullKey, szPixelShader.c_str());
+	ullKey = Hash(ullKey, (const char*)glGetString(GL_VENDOR));
+	ullKey = Hash(ullKey, (const char*)glGetString(GL_RENDERER));
+	ullKey = Hash(ullKey, (const char*)glGetString(GL_VERSION));
+
+	if (bUseCache)
+	{
+		double dStart = glfwGetTime();
+		double dBuildSeconds = 0.0;
+		GLuint uiProgram = Load(ullKey, dBuildSeconds);
+		if (uiProgram != 0)
+		{
+			double dLoadSeconds = glfwGetTime() - dStart;
+			++m_Stats.m_uiHits;
+			m_Stats.m_dLoadSeconds += dLoadSeconds;
+			// dBuildSeconds is what this key took to build when it was stored, a load that took longer saved nothing:
+			m_Stats.m_dSavedSeconds += std::max(dBuildSeconds - dLoadSeconds, 0.0);
+			return uiProgram;
+		}
+	}
+
+	double dStart = glfwGetTime();
+	GLuint uiProgram = Build(szVertexShader, szGeometryShader, szPixelShader, a_fPreLink, bUseCache);
+	double dBuildSeconds = glfwGetTime() - dStart;
+	m_Stats.m_dBuildSeconds += dBuildSeconds;
+
+	if (bUseCache && uiProgram != 0)
+		Save(ullKey, uiProgram, dBuildSeconds);
+
+	return uiProgram;
+}
+
+
+void ProgramCache::PrintReport() const
+{
+	if (!m_bEnabled)
+		m_fMessage("Status: Program cache disabled, %.2fms compiling and linking\n", m_Stats.m_dBuildSeconds * 1000.0);
+	else if (!IsSupported())
+		m_fMessage("Status: Program cache not supported by this driver, %.2fms compiling and linking\n", m_Stats.m_dBuildSeconds * 1000.0);
+	else
+		m_fMessage("Status: Program cache %u hits, %u misses, %u stale, %.2fms loading, %.2fms compiling and linking, %.2fms saved\n",
+			m_Stats.m_uiHits, m_Stats.m_uiMisses, m_Stats.m_uiStale, m_Stats.m_dLoadSeconds * 1000.0, m_Stats.m_dBuildSeconds * 1000.0,
+			m_Stats.m_dSavedSeconds * 1000.0);
+}
+
+
+bool ProgramCache::IsSupported() const
+{
+	// some drivers expose the extension but support no formats, there is no point saving anything then:
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+		return false;
+
+	GLint iFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &iFormats);
+	return iFormats > 0;
+}
+
+
+std::string ProgramCache::GetPath(unsigned long long a_ullKey) const
+{
+	char acName[32];
+	sprintf(acName, "/%016llx.bin", a_ullKey);
+	return m_szDirectory + acName;
+}
+
+
+GLuint ProgramCache::Build(const std::string& a_szVertexShader, const std::string& a_szGeometryShader, const std::string& a_szPixelShader, PreLinkFunc a_fPreLink, bool a_bRetrievable)
+{
+	GLint iSuccess = 0;
+	GLchar acLog[256];
+	GLuint vsHandle = glCreateShader(GL_VERTEX_SHADER);
+	GLuint gsHandle = 0;
+	GLuint fsHandle = glCreateShader(GL_FRAGMENT_SHADER);
+
+	const char* szVertexShader = a_szVertexShader.c_str();
+	glShaderSource(vsHandle, 1, (const char**)&szVertexShader, 0);
+	glCompileShader(vsHandle);
+	glGetShaderiv(vsHandle, GL_COMPILE_STATUS, &iSuccess);
+	glGetShaderInfoLog(vsHandle, sizeof(acLog), 0, acLog);
+	if (iSuccess == GL_FALSE)
+	{
+		m_fMessage("Error: Failed to compile vertex shader!\n");
+		m_fMessage("%s", acLog);
+		m_fMessage("\n");
+	}
+
+	if (!a_szGeometryShader.empty())
+	{
+		gsHandle = glCreateShader(GL_GEOMETRY_SHADER);
+		const char* szGeometryShader = a_szGeometryShader.c_str();
+		glShaderSource(gsHandle, 1, (const char**)&szGeometryShader, 0);
+		glCompileShader(gsHandle);
+		glGetShaderiv(gsHandle, GL_COMPILE_STATUS, &iSuccess);
+		glGetShaderInfoLog(gsHandle, sizeof(acLog), 0, acLog);
+		if (iSuccess == GL_FALSE)
+		{
+			m_fMessage("Error: Failed to compile geometry shader!\n");
+			m_fMessage("%s", acLog);
+			m_fMessage("\n");
+		}
+	}
+
+	const char* szPixelShader = a_szPixelShader.c_str();
+	glShaderSource(fsHandle, 1, (const char**)&szPixelShader, 0);
+	glCompileShader(fsHandle);
+	glGetShaderiv(fsHandle, GL_COMPILE_STATUS, &iSuccess);
+	glGetShaderInfoLog(fsHandle, sizeof(acLog), 0, acLog);
+	if (iSuccess == GL_FALSE)
+	{
+		m_fMessage("Error: Failed to compile fragment shader!\n");
+		m_fMessage("%s", acLog);
+		m_fMessage("\n");
+	}
+
+	GLuint uiProgram = glCreateProgram();
+	glAttachShader(uiProgram, vsHandle);
+	if (gsHandle != 0)
+		glAttachShader(uiProgram, gsHandle);
+	glAttachShader(uiProgram, fsHandle);
+	glDeleteShader(vsHandle);
+	if (gsHandle != 0)
+		glDeleteShader(gsHandle);
+	glDeleteShader(fsHandle);
+
+	if (a_fPreLink)
+		a_fPreLink(uiProgram);
+
+	// ask the driver to keep the binary around so Save() can fetch it:
+	if (a_bRetrievable)
+		glProgramParameteri(uiProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	glLinkProgram(uiProgram);
+	glGetProgramiv(uiProgram, GL_LINK_STATUS, &iSuccess);
+	glGetProgramInfoLog(uiProgram, sizeof(acLog), 0, acLog);
+	if (iSuccess == GL_FALSE)
+	{
+		m_fMessage("Error: failed to link Shader Program!\n");
+		m_fMessage("%s", acLog);
+		m_fMessage("\n");
+	}
+
+	return uiProgram;
+}
+
+
+GLuint ProgramCache::Load(unsigned long long a_ullKey, double& a_rdBuildSeconds)
+{
+	std::string szPath = GetPath(a_ullKey);
+	FILE* pFile = fopen(szPath.c_str(), "rb");
+	if (pFile == nullptr)
+	{
+		++m_Stats.m_uiMisses;
+		return 0;
+	}
+
+	ProgramBinaryHeader header;
+	std::vector<unsigned char> vBinary;
+	bool bValid = fread(&header, sizeof(header), 1, pFile) == 1 && header.m_uiMagic == c_uiProgramBinaryMagic
+		&& header.m_uiVersion == c_uiProgramBinaryVersion && header.m_ullKey == a_ullKey && header.m_uiLength > 0;
+	if (bValid)
+	{
+		vBinary.resize(header.m_uiLength);
+		bValid = fread(vBinary.data(), 1, vBinary.size(), pFile) == vBinary.size();
+	}
+	fclose(pFile);
+
+	GLuint uiProgram = 0;
+	if (bValid)
+	{
+		uiProgram = glCreateProgram();
+		glProgramBinary(uiProgram, header.m_uiFormat, vBinary.data(), (GLsizei)vBinary.size());
+
+		// a driver update or a different GPU makes the binary useless, it just fails to link:
+		GLint iSuccess = GL_FALSE;
+		glGetProgramiv(uiProgram, GL_LINK_STATUS, &iSuccess);
+		if (iSuccess == GL_FALSE)
+		{
+			glDeleteProgram(uiProgram);
+			uiProgram = 0;
+		}
+	}
+
+	if (uiProgram == 0)
+	{
+		m_fMessage("Warning: Program binary %s is stale, rebuilding it\n", szPath.c_str());
+		++m_Stats.m_uiStale;
+		return 0;
+	}
+
+	a_rdBuildSeconds = header.m_dBuildSeconds;
+	return uiProgram;
+}
+
+
+void ProgramCache::Save(unsigned long long a_ullKey, GLuint a_uiProgram, double a_dBuildSeconds)
+{
+	GLint iLength = 0;
+	glGetProgramiv(a_uiProgram, GL_PROGRAM_BINARY_LENGTH, &iLength);
+	if (iLength <= 0)
+		return;
+
+	std::vector<unsigned char> vBinary(iLength);
+	GLenum eFormat = 0;
+	GLsizei iWritten = 0;
+	glGetProgramBinary(a_uiProgram, iLength, &iWritten, &eFormat, vBinary.data());
+	if (iWritten <= 0)
+		return;
+
+#ifdef _WIN32
+	_mkdir(m_szDirectory.c_str());
+#else
+	mkdir(m_szDirectory.c_str(), 0755);
+#endif
+
+	std::string szPath = GetPath(a_ullKey);
+	FILE* pFile = fopen(szPath.c_str(), "wb");
+	if (pFile == nullptr)
+	{
+		m_fMessage("Warning: Could not write program binary %s\n", szPath.c_str());
+		return;
+	}
+
+	ProgramBinaryHeader header;
+	memset(&header, 0, sizeof(header));
+	header.m_uiMagic = c_uiProgramBinaryMagic;
+	header.m_uiVersion = c_uiProgramBinaryVersion;
+	header.m_ullKey = a_ullKey;
+	header.m_uiFormat = eFormat;
+	header.m_uiLength = (unsigned int)iWritten;
+	header.m_dBuildSeconds = a_dBuildSeconds;
+	fwrite(&header, sizeof(header), 1, pFile);
+	fwrite(vBinary.data(), 1, iWritten, pFile);
+	fclose(pFile);
+}
+
+
+unsigned long long ProgramCache::Hash(unsigned long long a_ullHash, const char* a_szText)
+{
+	// FNV-1a, the terminating 0 is hashed too so "ab" + "c" and "a" + "bc" differ:
+	if (a_szText == nullptr)
+		a_szText = "";
+	do
+	{
+		a_ullHash ^= (unsigned char)*a_szText;
+		a_ullHash *= 1099511628211ull;
+	} while (*a_szText++ != 0);
+	return a_ullHash;
+}
+
+
+std::string ProgramCache::AddDefines(const char* a_szSource, const std::string& a_szDefines)
+{
+	std::string szSource = a_szSource;
+	if (a_szDefines.empty())
+		return szSource;
+
+	// #version has to stay the first line:
+	size_t iInsert = 0;
+	if (szSource.compare(0, 8, "#version") == 0)
+	{
+		iInsert = szSource.find('\n');
+		iInsert = iInsert == std::string::npos ? szSource.size() : iInsert + 1;
+	}
+
+	std::string szDefines = a_szDefines;
+	if (szDefines[szDefines.size() - 1] != '\n')
+		szDefines += '\n';
+	return szSource.insert(iInsert, szDefines);
+}
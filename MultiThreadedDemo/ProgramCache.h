@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////
+/// @file		ProgramCache.h
+/// @details	On disk cache of linked shader program binaries, so a program is
+///				only compiled from source the first time it is seen on a driver.
+///				Binaries are keyed by a hash of the sources, the defines and the
+///				GL vendor/renderer/version strings, so changing any of them gets a
+///				new entry. A binary the driver rejects is treated as stale and the
+///				program is rebuilt from source and stored again.
+///				It only needs GLEW and a current context. The tutorial keeps its
+///				own copy, so it builds without the demo's sources.
+///				Its status lines, warnings and build logs go to printf() unless
+///				the demo hands it its own logger with SetMessageFunc().
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _PROGRAMCACHE_H_
+#define _PROGRAMCACHE_H_
+
+#include <string>
+#include <functional>
+
+const char * const c_szDefaultProgramCacheDirectory = "ShaderCache";
+
+struct ProgramCacheStats
+{
+	unsigned int	m_uiHits;
+	unsigned int	m_uiMisses;			// no binary on disk for the key.
+	unsigned int	m_uiStale;			// a binary was on disk but the driver rejected it.
+	double			m_dLoadSeconds;		// spent loading binaries that were used.
+	double			m_dBuildSeconds;	// spent compiling and linking from source.
+	double			m_dSavedSeconds;	// what each loaded program took to build when it was stored, less the time to load it, never below 0.
+};
+
+class ProgramCache
+{
+public:
+	/// Called after the shaders are attached and before linking, to bind attribute and frag data locations.
+	/// It must always do the same thing for the same sources, it is not part of the key.
+	typedef std::function<void(GLuint a_uiProgram)> PreLinkFunc;
+
+	/// Takes a printf() format, the format must be a string literal.
+	typedef void (*MessageFunc)(const char* a_szFormat, ...);
+
+	ProgramCache(const std::string& a_szDirectory = c_szDefaultProgramCacheDirectory);
+
+	/// With the cache disabled every program is built from source, for comparing start up times.
+	void SetEnabled(bool a_bEnabled)				{ m_bEnabled = a_bEnabled; }
+
+	/// Where the report, warnings and build logs go, nullptr goes back to printf().
+	void SetMessageFunc(MessageFunc a_fMessage);
+
+	/// Returns a linked program, loaded from disk if possible. A context must be current.
+	/// a_szDefines is inserted after the #version line of every shader.
+	GLuint CreateProgram(const char* a_szVertexShader, const char* a_szPixelShader, const std::string& a_szDefines, PreLinkFunc a_fPreLink);
+
+	/// The same with a geometry shader between the two, a_szGeometryShader may be nullptr.
+	GLuint CreateProgram(const char* a_szVertexShader, const char* a_szGeometryShader, const char* a_szPixelShader, const std::string& a_szDefines, PreLinkFunc a_fPreLink);
+
+	const ProgramCacheStats& GetStats() const		{ return m_Stats; }
+
+	/// One line of hits, misses and the time saved, for the end of start up.
+	void PrintReport() const;
+
+private:
+	bool IsSupported() const;
+	std::string GetPath(unsigned long long a_ullKey) const;
+	GLuint Build(const std::string& a_szVertexShader, const std::string& a_szGeometryShader, const std::string& a_szPixelShader, PreLinkFunc a_fPreLink, bool a_bRetrievable);
+	GLuint Load(unsigned long long a_ullKey, double& a_rdBuildSeconds);
+	void Save(unsigned long long a_ullKey, GLuint a_uiProgram, double a_dBuildSeconds);
+
+	static unsigned long long Hash(unsigned long long a_ullHash, const char* a_szText);
+	static std::string AddDefines(const char* a_szSource, const std::string& a_szDefines);
+
+	std::string			m_szDirectory;
+	bool				m_bEnabled;
+	MessageFunc			m_fMessage;
+	ProgramCacheStats	m_Stats;
+};
+
+#endif // _PROGRAMCACHE_H_
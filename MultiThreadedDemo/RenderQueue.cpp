@@ -0,0 +1,154 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "GLStateCache.h"
+#include "RenderQueue.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+#include "glm/ext.hpp"
+
+const unsigned int c_uiRadixBits = 8;
+const unsigned int c_uiRadixBuckets = 1 << c_uiRadixBits;
+const unsigned int c_uiRadixPasses = 64 / c_uiRadixBits;
+
+
+RenderQueue::RenderQueue()
+	: m_ullFrames(0)
+	, m_ullDraws(0)
+	, m_ullStateChanges(0)
+	, m_dSortSeconds(0.0)
+	, m_dFirstFrameTime(0.0)
+	, m_dLastFrameTime(0.0)
+{
+}
+
+
+unsigned long long RenderQueue::MakeSortKey(unsigned int a_uiLayer, GLuint a_uiProgram, GLuint a_uiVertexArray, GLuint a_uiTexture, float a_fDepth)
+{
+	const unsigned long long ullNameMask = (1ull << c_uiSortKeyNameBits) - 1;
+	const unsigned long long ullDepthMax = (1ull << c_uiSortKeyDepthBits) - 1;
+
+	if (a_fDepth < 0.0f)
+		a_fDepth = 0.0f;
+	else if (a_fDepth > 1.0f)
+		a_fDepth = 1.0f;
+
+	unsigned long long ullKey = a_uiLayer & ((1ull << c_uiSortKeyLayerBits) - 1);
+	ullKey = (ullKey << c_uiSortKeyNameBits) | (a_uiProgram & ullNameMask);
+	ullKey = (ullKey << c_uiSortKeyNameBits) | (a_uiVertexArray & ullNameMask);
+	ullKey = (ullKey << c_uiSortKeyNameBits) | (a_uiTexture & ullNameMask);
+	ullKey = (ullKey << c_uiSortKeyDepthBits) | (unsigned long long)(a_fDepth * ullDepthMax);
+	return ullKey;
+}
+
+
+void RenderQueue::Begin()
+{
+	// clear() keeps the capacity, after the first few frames nothing is allocated:
+	m_vPackets.clear();
+	m_vTransforms.clear();
+	m_vEntries.clear();
+}
+
+
+void RenderQueue::Submit(unsigned long long a_ullSortKey, const DrawPacket& a_rPacket, const glm::mat4& a_m4Model)
+{
+	SortEntry entry;
+	entry.m_ullKey = a_ullSortKey;
+	entry.m_uiPacket = (unsigned int)m_vPackets.size();
+	m_vEntries.push_back(entry);
+
+	m_vPackets.push_back(a_rPacket);
+	m_vPackets.back().m_uiTransform = (unsigned int)m_vTransforms.size();
+	m_vTransforms.push_back(a_m4Model);
+}
+
+
+void RenderQueue::Execute(GLStateCache& a_rState)
+{
+	double dStart = glfwGetTime();
+	if (m_ullFrames == 0)
+		m_dFirstFrameTime = dStart;
+
+	Sort();
+	m_dSortSeconds += glfwGetTime() - dStart;
+
+	unsigned long long ullMadeBefore = a_rState.GetTotalCallsMade();
+	for (const auto& entry : m_vEntries)
+	{
+		const DrawPacket& packet = m_vPackets[entry.m_uiPacket];
+
+		a_rState.UseProgram(packet.m_uiProgram);
+		a_rState.BindVertexArray(packet.m_uiVertexArray);
+		a_rState.ActiveTexture(GL_TEXTURE0);
+		a_rState.BindTexture(GL_TEXTURE_2D, packet.m_uiTexture);
+
+		glUniformMatrix4fv(packet.m_iModelUniform, 1, false, glm::value_ptr(m_vTransforms[packet.m_uiTransform]));
+
+		if (packet.m_iInstanceCount == 0)
+			glDrawElements(GL_TRIANGLES, packet.m_iIndexCount, GL_UNSIGNED_INT, 0);
+		else if (packet.m_uiFirstInstance == 0)
+			glDrawElementsInstanced(GL_TRIANGLES, packet.m_iIndexCount, GL_UNSIGNED_INT, 0, packet.m_iInstanceCount);
+		else
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, packet.m_iIndexCount, GL_UNSIGNED_INT, 0, packet.m_iInstanceCount, packet.m_uiFirstInstance);
+	}
+
+	m_ullStateChanges += a_rState.GetTotalCallsMade() - ullMadeBefore;
+	m_ullDraws += m_vEntries.size();
+	++m_ullFrames;
+	m_dLastFrameTime = glfwGetTime();
+}
+
+
+void RenderQueue::PrintStats(unsigned int a_uiWindowID) const
+{
+	if (m_ullFrames == 0)
+		return;
+
+	double dSeconds = m_dLastFrameTime - m_dFirstFrameTime;
+	printf("Window %u render queue: %.0f draws/sec, %.1f draws, %.1f state changes and %.3fms sorting per frame\n", a_uiWindowID,
+		dSeconds > 0.0 ? m_ullDraws / dSeconds : 0.0, (double)m_ullDraws / m_ullFrames, (double)m_ullStateChanges / m_ullFrames,
+		m_dSortSeconds * 1000.0 / m_ullFrames);
+}
+
+
+void RenderQueue::Sort()
+{
+	// LSD radix sort, one histogram pass for all eight bytes then one scatter per byte. Bytes every key
+	// shares (the layer, and usually the program and VAO) are skipped, so most frames only sort the depth:
+	unsigned int uiCount = (unsigned int)m_vEntries.size();
+	if (uiCount < 2)
+		return;
+
+	unsigned int auiHistogram[c_uiRadixPasses][c_uiRadixBuckets];
+	memset(auiHistogram, 0, sizeof(auiHistogram));
+	for (const auto& entry : m_vEntries)
+	{
+		for (unsigned int uiPass = 0; uiPass < c_uiRadixPasses; ++uiPass)
+			++auiHistogram[uiPass][(entry.m_ullKey >> (uiPass * c_uiRadixBits)) & (c_uiRadixBuckets - 1)];
+	}
+
+	m_vScratch.resize(uiCount);
+	for (unsigned int uiPass = 0; uiPass < c_uiRadixPasses; ++uiPass)
+	{
+		unsigned int uiShift = uiPass * c_uiRadixBits;
+		unsigned int* puiBuckets = auiHistogram[uiPass];
+		if (puiBuckets[(m_vEntries[0].m_ullKey >> uiShift) & (c_uiRadixBuckets - 1)] == uiCount)
+			continue;
+
+		unsigned int uiOffset = 0;
+		for (unsigned int i = 0; i < c_uiRadixBuckets; ++i)
+		{
+			unsigned int uiBucketSize = puiBuckets[i];
+			puiBuckets[i] = uiOffset;
+			uiOffset += uiBucketSize;
+		}
+
+		for (const auto& entry : m_vEntries)
+			m_vScratch[puiBuckets[(entry.m_ullKey >> uiShift) & (c_uiRadixBuckets - 1)]++] = entry;
+		m_vEntries.swap(m_vScratch);
+	}
+}
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////
+/// @file		RenderQueue.h
+/// @details	Decouples issuing draws from executing them. Scene code pushes
+///				small DrawPackets, each with a 64 bit sort key, and the queue
+///				radix sorts them and executes them in key order when the window
+///				is rendered. The key puts the most expensive state change in the
+///				highest bits (layer, then program, VAO, texture and finally
+///				depth), so sorting groups draws that share state together and
+///				the GLStateCache can skip the binds in between.
+///				One queue per window, only used by the thread rendering it.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _RENDERQUEUE_H_
+#define _RENDERQUEUE_H_
+
+#include "glm/glm.hpp"
+#include <vector>
+
+class GLStateCache;
+
+// Sort key layout, from the top bit down:
+// | layer 4 | program 12 | VAO 12 | texture 12 | depth 24 |
+// Names are truncated to 12 bits, two objects that share the bits only sort next to each other, the packet
+// still binds the right one.
+const unsigned int c_uiSortKeyLayerBits = 4;
+const unsigned int c_uiSortKeyNameBits = 12;
+const unsigned int c_uiSortKeyDepthBits = 24;
+
+struct DrawPacket
+{
+	GLuint			m_uiProgram;
+	GLuint			m_uiVertexArray;
+	GLuint			m_uiTexture;		// GL_TEXTURE_2D on unit 0, 0 for none.
+	GLint			m_iModelUniform;	// set from the matrix given to Submit(), GL ignores -1 as usual.
+	unsigned int	m_uiTransform;		// index of the model matrix given to Submit().
+	GLsizei			m_iIndexCount;		// GL_UNSIGNED_INT triangles from the VAO's index buffer.
+	GLuint			m_uiFirstInstance;	// instance range, a count of 0 is a plain glDrawElements().
+	GLsizei			m_iInstanceCount;
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	/// Builds a sort key, a_fDepth is 0 (near) to 1 (far) and is drawn front to back within the same state.
+	static unsigned long long MakeSortKey(unsigned int a_uiLayer, GLuint a_uiProgram, GLuint a_uiVertexArray, GLuint a_uiTexture, float a_fDepth);
+
+	/// Empties the queue for a new frame.
+	void Begin();
+
+	/// Queues a draw. The model matrix is copied, m_uiTransform is filled in by the queue.
+	void Submit(unsigned long long a_ullSortKey, const DrawPacket& a_rPacket, const glm::mat4& a_m4Model);
+
+	/// Sorts and draws everything submitted since Begin(), binding state through a_rState.
+	/// The window's context must be current and anything not in a packet (camera UBO etc.) already bound.
+	void Execute(GLStateCache& a_rState);
+
+	unsigned int GetPacketCount() const				{ return (unsigned int)m_vPackets.size(); }
+
+	/// Draws per second since the first frame and state changes, draws and sort time per frame.
+	void PrintStats(unsigned int a_uiWindowID) const;
+
+private:
+	struct SortEntry
+	{
+		unsigned long long	m_ullKey;
+		unsigned int		m_uiPacket;
+	};
+
+	void Sort();
+
+	std::vector<DrawPacket>		m_vPackets;
+	std::vector<glm::mat4>		m_vTransforms;
+	std::vector<SortEntry>		m_vEntries;
+	std::vector<SortEntry>		m_vScratch;			// radix sort ping pongs between these two.
+
+	unsigned long long			m_ullFrames;
+	unsigned long long			m_ullDraws;
+	unsigned long long			m_ullStateChanges;	// binds the state cache could not skip.
+	double						m_dSortSeconds;
+	double						m_dFirstFrameTime;
+	double						m_dLastFrameTime;
+};
+
+#endif // _RENDERQUEUE_H_
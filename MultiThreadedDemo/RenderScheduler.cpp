@@ -0,0 +1,198 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ThreadingDemo.h"
+#include "RenderScheduler.h"
+#include "ContextRegistry.h"
+#include "FrameTiming.h"
+#include "ThreadPlacement.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <string>
+
+void MakeContextCurrent(WindowHandle a_hWindowHandle);	// defined in ThreadingDemo.cpp
+
+// how long a render thread will wait for the GPU to finish a windows previous frame (in nanoseconds).
+const GLuint64 c_ullFrameFenceTimeout = 100000000;	// 100ms
+
+
+RenderScheduler::RenderScheduler()
+	: m_InitFence(0)
+	, m_bQuit(false)
+	, m_ullFramesRendered(0)
+{
+}
+
+
+RenderScheduler::~RenderScheduler()
+{
+	Stop();
+}
+
+
+void RenderScheduler::Start(const std::vector<WindowHandle>& a_vWindows, unsigned int a_uiThreadCount, RenderFunc a_fRender, GLsync a_InitFence)
+{
+	if (IsRunning() || a_vWindows.empty())
+		return;
+
+	if (a_uiThreadCount == 0)
+		a_uiThreadCount = std::thread::hardware_concurrency();
+	if (a_uiThreadCount == 0)
+		a_uiThreadCount = 1;
+	if (a_uiThreadCount > a_vWindows.size())
+		a_uiThreadCount = (unsigned int)a_vWindows.size();
+
+	m_fRender = a_fRender;
+	m_InitFence = a_InitFence;
+	m_bQuit = false;
+	m_ullFramesRendered = 0;
+	m_ThreadsStarted.Reset(a_uiThreadCount);
+	m_FrameStart.Reset(a_uiThreadCount + 1);
+	m_FrameDone.Reset(a_uiThreadCount + 1);
+
+	// hand out the windows round robin:
+	for (unsigned int i = 0; i < a_uiThreadCount; ++i)
+	{
+		RenderThread* thread = new RenderThread();
+		thread->m_uiIndex = i;
+		thread->m_pThread = nullptr;
+		m_vThreads.push_back(thread);
+	}
+
+	unsigned int uiWindow = 0;
+	for (auto window : a_vWindows)
+	{
+		m_vThreads[uiWindow++ % a_uiThreadCount]->m_vWindows.push_back(window);
+	}
+
+	// a context can only be current on one thread, so give them all up before the render threads need them:
+	glfwMakeContextCurrent(nullptr);
+
+	// the threads will sit and wait for the first RenderFrame() before touching any GL:
+	for (auto thread : m_vThreads)
+	{
+		thread->m_pThread = new std::thread(&RenderScheduler::ThreadLoop, this, thread);
+	}
+	m_ThreadsStarted.Wait();
+
+	Log("Render scheduler started %u threads for %u windows\n", a_uiThreadCount, (unsigned int)a_vWindows.size());
+}
+
+
+void RenderScheduler::RenderFrame()
+{
+	if (!IsRunning())
+		return;
+
+	m_FrameStart.ArriveAndWait();
+	m_FrameDone.ArriveAndWait();
+}
+
+
+void RenderScheduler::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	// the threads are all waiting at the start of a frame, they see m_bQuit once they are let go:
+	m_bQuit = true;
+	m_FrameStart.ArriveAndWait();
+
+	for (auto thread : m_vThreads)
+	{
+		thread->m_pThread->join();
+		delete thread->m_pThread;
+		delete thread;
+	}
+	m_vThreads.clear();
+
+	Log("Render scheduler stopped\n");
+}
+
+
+std::vector<std::thread::id> RenderScheduler::GetThreadIDs() const
+{
+	std::vector<std::thread::id> vIDs;
+	for (auto thread : m_vThreads)
+	{
+		vIDs.push_back(thread->m_pThread->get_id());
+	}
+	return vIDs;
+}
+
+
+SyncStats RenderScheduler::GetSyncStats() const
+{
+	SyncStats stats = m_FrameStart.GetStats();
+	AddSyncStats(stats, m_FrameDone.GetStats());
+	return stats;
+}
+
+
+void RenderScheduler::ResetSyncStats()
+{
+	m_FrameStart.ResetStats();
+	m_FrameDone.ResetStats();
+}
+
+
+void RenderScheduler::ThreadLoop(RenderThread* a_pThread)
+{
+	Log("Starting Render Thread: %s with %u windows\n", GetLogThreadID(), (unsigned int)a_pThread->m_vWindows.size());
+
+	PlaceThread(TR_RENDER, ("Render " + std::to_string(a_pThread->m_uiIndex)).c_str());
+	m_ThreadsStarted.CountDown();
+	bool bFirstFrame = true;
+
+	while (true)
+	{
+		// wait for the main thread to kick off the next frame:
+		m_FrameStart.ArriveAndWait();
+		if (m_bQuit)
+			break;
+
+		for (auto window : a_pThread->m_vWindows)
+		{
+			MakeContextCurrent(window);
+
+			if (bFirstFrame && m_InitFence != 0)
+			{
+				// make sure the shared resources created on the main thread are visible to this context:
+				glWaitSync(m_InitFence, 0, GL_TIMEOUT_IGNORED);
+			}
+
+			if (window->m_FrameFence != 0)
+			{
+				// don't let the CPU get more then a frame ahead of the GPU for this window, the other windows are not affected.
+				double dWaitStart = glfwGetTime();
+				glClientWaitSync(window->m_FrameFence, GL_SYNC_FLUSH_COMMANDS_BIT, c_ullFrameFenceTimeout);
+				RecordFrameTime(window, FT_FENCE, glfwGetTime() - dWaitStart);
+				glDeleteSync(window->m_FrameFence);
+			}
+
+			m_fRender(window);
+			window->m_FrameFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);	// setup our fence sync for the next frame of this window.
+			++m_ullFramesRendered;
+		}
+		bFirstFrame = false;
+		SampleThreadPlacement();
+
+		// let the main thread know we are done:
+		m_FrameDone.ArriveAndWait();
+	}
+
+	// cleanup our fences and give up our contexts so that they can be used elsewhere:
+	for (auto window : a_pThread->m_vWindows)
+	{
+		if (window->m_FrameFence != 0)
+		{
+			MakeContextCurrent(window);
+			glDeleteSync(window->m_FrameFence);
+			window->m_FrameFence = 0;
+		}
+	}
+	glfwMakeContextCurrent(nullptr);
+
+	Log("Exiting Render Thread: %s\n", GetLogThreadID());
+}
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////
+/// @file		RenderScheduler.h
+/// @details	A pool of render threads that draws any number of windows.
+///				Each window is owned by exactly one render thread, its context
+///				stays current on that thread, and windows are synchronised
+///				with per window fences rather than a global render lock.
+///				Frames are kicked off and collected with two FrameBarriers, so a
+///				render thread that finishes early spins briefly and then parks
+///				until the next frame, see SyncPrimitives.h.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _RENDERSCHEDULER_H_
+#define _RENDERSCHEDULER_H_
+
+#include "SyncPrimitives.h"
+#include <vector>
+#include <thread>
+#include <functional>
+#include <atomic>
+
+struct Window;
+typedef Window* WindowHandle;
+
+class RenderScheduler
+{
+public:
+	typedef std::function<void(WindowHandle)> RenderFunc;
+
+	RenderScheduler();
+	~RenderScheduler();
+
+	/// Spins up a_uiThreadCount render threads (0 = one per hardware thread, never more
+	/// than there are windows) and hands each window to one of them round robin. Returns once they have all started.
+	/// The calling thread must own no context when this returns, the render threads take them.
+	/// a_InitFence is a fence inserted after all shared resources were created, every render
+	/// thread makes its contexts wait on it once before their first frame.
+	void Start(const std::vector<WindowHandle>& a_vWindows, unsigned int a_uiThreadCount, RenderFunc a_fRender, GLsync a_InitFence);
+
+	/// Renders one frame on every window and blocks until all render threads are done.
+	void RenderFrame();
+
+	/// Joins all render threads, each thread releases its contexts before exiting.
+	void Stop();
+
+	bool IsRunning() const { return !m_vThreads.empty(); }
+	unsigned int GetThreadCount() const { return (unsigned int)m_vThreads.size(); }
+	std::vector<std::thread::id> GetThreadIDs() const;
+	GLsync GetInitFence() const { return m_InitFence; }
+
+	/// total number of window frames rendered since Start().
+	unsigned long long GetFramesRendered() const { return m_ullFramesRendered; }
+
+	/// both barriers together, kept across Stop() and Start().
+	SyncStats GetSyncStats() const;
+	void ResetSyncStats();
+
+private:
+	struct RenderThread
+	{
+		unsigned int				m_uiIndex;		// its placement is by name, so a restarted thread N goes back where thread N was.
+		std::thread*				m_pThread;
+		std::vector<WindowHandle>	m_vWindows;
+	};
+
+	void ThreadLoop(RenderThread* a_pThread);
+
+	std::vector<RenderThread*>		m_vThreads;
+	RenderFunc						m_fRender;
+	GLsync							m_InitFence;
+
+	// frame kick off / completion, the render threads and the thread calling RenderFrame() all arrive at both:
+	StartLatch						m_ThreadsStarted;
+	FrameBarrier					m_FrameStart;
+	FrameBarrier					m_FrameDone;
+	std::atomic_bool				m_bQuit;		// set before the last arrival at m_FrameStart.
+
+	std::atomic<unsigned long long>	m_ullFramesRendered;
+};
+
+#endif // _RENDERSCHEDULER_H_
@@ -0,0 +1,284 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ThreadingDemo.h"
+#include "ContextRegistry.h"
+#include "ResourceLoader.h"
+#include "ThreadPlacement.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstring>
+
+void MakeContextCurrent(WindowHandle a_hWindowHandle);	// defined in ThreadingDemo.cpp
+
+
+ResourceLoader::ResourceLoader()
+	: m_hWindow(nullptr)
+	, m_pJobSystem(nullptr)
+	, m_pThread(nullptr)
+	, m_bQuit(false)
+	, m_uiPending(0)
+	, m_uiUnpackBuffer(0)
+	, m_iUnpackBufferSize(0)
+{
+}
+
+
+ResourceLoader::~ResourceLoader()
+{
+	if (m_pThread != nullptr)
+		printf("Warning: ResourceLoader was not stopped!\n");
+}
+
+
+bool ResourceLoader::Start(WindowHandle a_hLoaderWindow, JobSystem* a_pJobSystem)
+{
+	if (m_pThread != nullptr || a_hLoaderWindow == nullptr)
+		return false;
+
+	m_hWindow = a_hLoaderWindow;
+	m_pJobSystem = a_pJobSystem;
+	m_bQuit = false;
+	m_pThread = new std::thread(&ResourceLoader::UploadLoop, this);
+	return true;
+}
+
+
+void ResourceLoader::Stop()
+{
+	if (m_pThread == nullptr)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_QueueLock);
+		m_bQuit = true;
+	}
+	m_QueueChanged.notify_all();
+
+	m_pThread->join();
+	delete m_pThread;
+	m_pThread = nullptr;
+}
+
+
+ResourceHandle ResourceLoader::LoadTexture2D(const std::string& a_szName, GLsizei a_iWidth, GLsizei a_iHeight, GLint a_iInternalFormat,
+	GLenum a_eFormat, GLenum a_eType, GenerateFunc a_fGenerate)
+{
+	RequestHandle hRequest = std::make_shared<UploadRequest>();
+	hRequest->m_fGenerate = a_fGenerate;
+	hRequest->m_iWidth = a_iWidth;
+	hRequest->m_iHeight = a_iHeight;
+	hRequest->m_iInternalFormat = a_iInternalFormat;
+	hRequest->m_eFormat = a_eFormat;
+	hRequest->m_eType = a_eType;
+	return Queue(RT_TEXTURE_2D, a_szName, hRequest);
+}
+
+
+ResourceHandle ResourceLoader::LoadBuffer(const std::string& a_szName, GenerateFunc a_fGenerate)
+{
+	RequestHandle hRequest = std::make_shared<UploadRequest>();
+	hRequest->m_fGenerate = a_fGenerate;
+	hRequest->m_iWidth = 0;
+	hRequest->m_iHeight = 0;
+	hRequest->m_iInternalFormat = 0;
+	hRequest->m_eFormat = 0;
+	hRequest->m_eType = 0;
+	return Queue(RT_BUFFER, a_szName, hRequest);
+}
+
+
+bool ResourceLoader::IsReady(const ResourceHandle& a_hResource)
+{
+	if (!a_hResource)
+		return false;
+	if (a_hResource->m_bReady)
+		return true;
+	if (!a_hResource->m_bUploaded)
+		return false;
+
+	// a zero timeout only asks, it never waits:
+	GLenum eResult = glClientWaitSync(a_hResource->m_Fence, 0, 0);
+	if (eResult == GL_ALREADY_SIGNALED || eResult == GL_CONDITION_SATISFIED)
+	{
+		a_hResource->m_bReady = true;
+		return true;
+	}
+
+	return false;
+}
+
+
+void ResourceLoader::WaitUntilReady(const ResourceHandle& a_hResource)
+{
+	if (!a_hResource)
+		return;
+
+	while (!a_hResource->m_bUploaded)
+	{
+		if (m_pThread == nullptr)
+			return;	// nothing will ever upload it.
+		std::this_thread::yield();
+	}
+
+	while (!IsReady(a_hResource))
+		glClientWaitSync(a_hResource->m_Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);	// 1ms at a time.
+}
+
+
+ResourceHandle ResourceLoader::Queue(ResourceTypes a_eType, const std::string& a_szName, RequestHandle a_hRequest)
+{
+	ResourceHandle hResource = std::make_shared<LoadedResource>();
+	hResource->m_eType = a_eType;
+	hResource->m_szName = a_szName;
+	hResource->m_uiName = 0;
+	hResource->m_Fence = 0;
+	hResource->m_bUploaded = false;
+	hResource->m_bReady = false;
+	hResource->m_dRequestTime = glfwGetTime();
+	a_hRequest->m_hResource = hResource;
+
+	{
+		std::lock_guard<std::mutex> lock(m_ResourceLock);
+		m_vResources.push_back(hResource);
+	}
+
+	// start generating the data straight away, the loader thread picks it up when it gets to this request:
+	if (m_pJobSystem != nullptr)
+	{
+		UploadRequest* pRequest = a_hRequest.get();
+		a_hRequest->m_hGenerateJob = m_pJobSystem->CreateJob([pRequest] () { pRequest->m_fGenerate(pRequest->m_vData); });
+		m_pJobSystem->Submit(a_hRequest->m_hGenerateJob);
+	}
+
+	++m_uiPending;
+	{
+		std::lock_guard<std::mutex> lock(m_QueueLock);
+		m_dRequests.push_back(a_hRequest);
+	}
+	m_QueueChanged.notify_one();
+
+	return hResource;
+}
+
+
+void ResourceLoader::UploadLoop()
+{
+	Log("Starting Loader Thread: %s\n", GetLogThreadID());
+	PlaceThread(TR_LOADER, "Loader");
+	MakeContextCurrent(m_hWindow);
+
+	while (true)
+	{
+		RequestHandle hRequest;
+		{
+			std::unique_lock<std::mutex> lock(m_QueueLock);
+			m_QueueChanged.wait(lock, [this] () { return m_bQuit || !m_dRequests.empty(); });
+			if (m_bQuit)
+				break;
+			hRequest = m_dRequests.front();
+			m_dRequests.pop_front();
+		}
+
+		// help out with the generation rather than sit idle, or do it all ourselves without a job system:
+		if (hRequest->m_hGenerateJob)
+			m_pJobSystem->Wait(hRequest->m_hGenerateJob);
+		else
+			hRequest->m_fGenerate(hRequest->m_vData);
+
+		Upload(*hRequest);
+		--m_uiPending;
+		SampleThreadPlacement();
+	}
+
+	// the render threads have stopped looking at these by now:
+	{
+		std::lock_guard<std::mutex> lock(m_ResourceLock);
+		for (auto& resource : m_vResources)
+		{
+			if (resource->m_Fence != 0)
+				glDeleteSync(resource->m_Fence);
+			resource->m_Fence = 0;
+		}
+	}
+
+	if (m_uiUnpackBuffer != 0)
+		glDeleteBuffers(1, &m_uiUnpackBuffer);
+	m_uiUnpackBuffer = 0;
+	m_iUnpackBufferSize = 0;
+
+	glfwMakeContextCurrent(nullptr);
+
+	Log("Exiting Loader Thread: %s\n", GetLogThreadID());
+}
+
+
+void ResourceLoader::Upload(UploadRequest& a_rRequest)
+{
+	LoadedResource& resource = *a_rRequest.m_hResource;
+	GLsizeiptr iSize = (GLsizeiptr)a_rRequest.m_vData.size();
+
+	if (resource.m_eType == RT_TEXTURE_2D)
+	{
+		// copy the texels into the unpack buffer, the driver can then copy them to the texture without stalling us:
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uiUnpackBuffer);
+		if (m_uiUnpackBuffer == 0 || iSize > m_iUnpackBufferSize)
+		{
+			if (m_uiUnpackBuffer == 0)
+			{
+				glGenBuffers(1, &m_uiUnpackBuffer);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uiUnpackBuffer);
+			}
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, iSize, nullptr, GL_STREAM_DRAW);
+			m_iUnpackBufferSize = iSize;
+		}
+
+		// invalidating lets the driver hand us fresh memory if the last upload is still in flight:
+		void* pMapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, iSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (pMapped != nullptr)
+		{
+			memcpy(pMapped, a_rRequest.m_vData.data(), iSize);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+		else
+		{
+			// with an unpack buffer bound the texel pointer below would be read as an offset into it:
+			Log("Error: Could not map the unpack buffer for %s, uploading from client memory!\n", resource.m_szName.c_str());
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		glGenTextures(1, &resource.m_uiName);
+		glBindTexture(GL_TEXTURE_2D, resource.m_uiName);
+		glTexImage2D(GL_TEXTURE_2D, 0, a_rRequest.m_iInternalFormat, a_rRequest.m_iWidth, a_rRequest.m_iHeight, 0,
+			a_rRequest.m_eFormat, a_rRequest.m_eType, pMapped != nullptr ? 0 : a_rRequest.m_vData.data());
+
+		// specify default filtering and wrapping
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else
+	{
+		// buffers are not tied to a target, GL_ARRAY_BUFFER is fine for index data too and needs no VAO bound:
+		glGenBuffers(1, &resource.m_uiName);
+		glBindBuffer(GL_ARRAY_BUFFER, resource.m_uiName);
+		glBufferData(GL_ARRAY_BUFFER, iSize, a_rRequest.m_vData.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// the flush makes sure the fence reaches the GPU, otherwise the other contexts could poll it forever:
+	resource.m_Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	resource.m_bUploaded = true;
+
+	Log("Status: Loaded %s (%u bytes) on the loader thread, %.2fms after it was requested\n", resource.m_szName.c_str(),
+		(unsigned int)iSize, (glfwGetTime() - resource.m_dRequestTime) * 1000.0);
+
+	// the CPU copy is not needed any more:
+	std::vector<unsigned char>().swap(a_rRequest.m_vData);
+}
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////
+/// @file		ResourceLoader.h
+/// @details	Loads textures and buffers without stalling the main or render threads.
+///				Each request is generated on the job system, then uploaded on the
+///				loader thread, which owns a hidden window whose context shares with
+///				all the others. Textures go through a pixel unpack buffer. Every
+///				upload is followed by a fence, and other threads poll it with a
+///				zero timeout through IsReady(), so a frame never waits on a load.
+///				It just draws without the resource until it is ready.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _RESOURCELOADER_H_
+#define _RESOURCELOADER_H_
+
+#include "JobSystem.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+struct Window;
+typedef Window* WindowHandle;
+
+const char * const c_szLoaderWindowTitle = "Threading Demo - Loader";
+
+///////////////////// Custom Data Types ///////////////////////////////
+enum ResourceTypes
+{
+	RT_TEXTURE_2D = 0,
+	RT_BUFFER,
+};
+
+struct LoadedResource
+{
+	ResourceTypes		m_eType;
+	std::string			m_szName;
+	GLuint				m_uiName;		// the texture or buffer, only use it once IsReady() says so.
+	GLsync				m_Fence;		// placed after the upload, deleted by ResourceLoader::Stop().
+	std::atomic_bool	m_bUploaded;	// set by the loader thread once m_uiName and m_Fence are valid.
+	std::atomic_bool	m_bReady;		// set by the first thread to see m_Fence signalled.
+	double				m_dRequestTime;
+};
+typedef std::shared_ptr<LoadedResource> ResourceHandle;
+
+class ResourceLoader
+{
+public:
+	/// Fills the vector with the resource's data, runs on a job system worker.
+	typedef std::function<void(std::vector<unsigned char>& a_rvData)> GenerateFunc;
+
+	ResourceLoader();
+	~ResourceLoader();
+
+	/// Starts the loader thread, which takes a_hLoaderWindow's context. The window must share with every
+	/// window that will use the resources and must not be current anywhere else.
+	/// Without a job system the loader thread generates everything itself.
+	bool Start(WindowHandle a_hLoaderWindow, JobSystem* a_pJobSystem);
+
+	/// Drops anything not yet uploaded, deletes the fences and joins the loader thread.
+	/// No other thread may be calling IsReady() on any of our resources.
+	void Stop();
+
+	/// Queues a 2D texture, a_fGenerate must produce a_iWidth * a_iHeight texels of a_eFormat/a_eType.
+	ResourceHandle LoadTexture2D(const std::string& a_szName, GLsizei a_iWidth, GLsizei a_iHeight, GLint a_iInternalFormat,
+		GLenum a_eFormat, GLenum a_eType, GenerateFunc a_fGenerate);
+
+	/// Queues a static buffer object, it can be bound to any target once it is ready.
+	ResourceHandle LoadBuffer(const std::string& a_szName, GenerateFunc a_fGenerate);
+
+	/// Never blocks. True once the resource has been uploaded and the GPU has passed its fence.
+	/// A context that shares with the loader's must be current, and the resource must be bound after
+	/// this returns true for its contents to be visible in that context.
+	static bool IsReady(const ResourceHandle& a_hResource);
+
+	/// Needs no context, for threads recording commands. True once some thread has seen IsReady() return true.
+	static bool IsKnownReady(const ResourceHandle& a_hResource)	{ return a_hResource && a_hResource->m_bReady; }
+
+	/// Blocks until the resource is ready, for benchmarks that must not time a half loaded scene.
+	void WaitUntilReady(const ResourceHandle& a_hResource);
+
+	unsigned int GetPendingCount() const			{ return m_uiPending; }
+
+private:
+	struct UploadRequest
+	{
+		ResourceHandle				m_hResource;
+		GenerateFunc				m_fGenerate;
+		JobHandle					m_hGenerateJob;		// null when the loader thread generates it itself.
+		std::vector<unsigned char>	m_vData;
+		GLsizei						m_iWidth;
+		GLsizei						m_iHeight;
+		GLint						m_iInternalFormat;
+		GLenum						m_eFormat;
+		GLenum						m_eType;
+	};
+	typedef std::shared_ptr<UploadRequest> RequestHandle;
+
+	ResourceLoader(const ResourceLoader&);
+	ResourceLoader& operator=(const ResourceLoader&);
+
+	ResourceHandle Queue(ResourceTypes a_eType, const std::string& a_szName, RequestHandle a_hRequest);
+	void UploadLoop();
+	void Upload(UploadRequest& a_rRequest);
+
+	WindowHandle					m_hWindow;
+	JobSystem*						m_pJobSystem;
+	std::thread*					m_pThread;
+
+	std::mutex						m_QueueLock;
+	std::condition_variable			m_QueueChanged;
+	std::deque<RequestHandle>		m_dRequests;
+	bool							m_bQuit;
+	std::atomic<unsigned int>		m_uiPending;
+
+	std::mutex						m_ResourceLock;
+	std::vector<ResourceHandle>		m_vResources;		// everything ever queued, so Stop() can free the fences.
+
+	// only touched on the loader thread:
+	GLuint							m_uiUnpackBuffer;
+	GLsizeiptr						m_iUnpackBufferSize;
+};
+
+#endif // _RESOURCELOADER_H_
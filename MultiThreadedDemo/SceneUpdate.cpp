@@ -0,0 +1,83 @@
+// Note that the following includes must be defined in order:
+#include "SceneUpdate.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cmath>
+#include <cstdlib>
+#include "glm/ext.hpp"
+
+
+void CreateSimulatedScene(SimulatedScene& a_rScene, unsigned int a_uiObjectCount)
+{
+	a_rScene.m_vObjects.resize(a_uiObjectCount);
+	a_rScene.m_vModelMatrices.resize(a_uiObjectCount);
+
+	unsigned int uiChunks = (a_uiObjectCount + c_uiSceneUpdateGrainSize - 1) / c_uiSceneUpdateGrainSize;
+	a_rScene.m_vChunkMin.resize(uiChunks);
+	a_rScene.m_vChunkMax.resize(uiChunks);
+	a_rScene.m_v3BoundsMin = glm::vec3(0);
+	a_rScene.m_v3BoundsMax = glm::vec3(0);
+
+	// the same scene every run, so timings can be compared:
+	srand(1);
+	for (auto& object : a_rScene.m_vObjects)
+	{
+		object.m_v3Position = glm::vec3(rand() % 2001 - 1000, rand() % 2001 - 1000, rand() % 2001 - 1000) * 0.01f;
+		object.m_v3Axis = glm::normalize(glm::vec3(rand() % 100 + 1, rand() % 100 + 1, rand() % 100 + 1));
+		object.m_fSpeed = (float)(rand() % 90 + 10);
+		object.m_fScale = (rand() % 100 + 1) * 0.002f;
+	}
+}
+
+
+JobHandle StartSceneUpdate(JobSystem& a_rJobSystem, SimulatedScene& a_rScene, float a_fTime)
+{
+	SimulatedScene* pScene = &a_rScene;
+
+	// each job rebuilds a run of model matrices and the bounds of that run:
+	JobHandle hUpdate = a_rJobSystem.ParallelForAsync((unsigned int)a_rScene.m_vObjects.size(), [pScene, a_fTime] (unsigned int a_uiBegin, unsigned int a_uiEnd)
+	{
+		glm::vec3 v3Min(1e30f);
+		glm::vec3 v3Max(-1e30f);
+		glm::mat4 identity;
+
+		for (unsigned int i = a_uiBegin; i < a_uiEnd; ++i)
+		{
+			const SceneObject& object = pScene->m_vObjects[i];
+			glm::vec3 v3Position = object.m_v3Position;
+			v3Position.y += sinf(a_fTime + i * 0.37f) * 0.5f;
+
+			glm::mat4 m4Model = glm::translate(identity, v3Position);
+			m4Model = glm::rotate(m4Model, a_fTime * object.m_fSpeed, object.m_v3Axis);
+			m4Model = glm::scale(m4Model, glm::vec3(object.m_fScale));
+			pScene->m_vModelMatrices[i] = m4Model;
+
+			// the quad is 4 units across, so its corners are at most 2 * sqrt(2) from the centre:
+			glm::vec3 v3Extent(object.m_fScale * 2.83f);
+			v3Min = glm::min(v3Min, v3Position - v3Extent);
+			v3Max = glm::max(v3Max, v3Position + v3Extent);
+		}
+
+		unsigned int uiChunk = a_uiBegin / c_uiSceneUpdateGrainSize;
+		pScene->m_vChunkMin[uiChunk] = v3Min;
+		pScene->m_vChunkMax[uiChunk] = v3Max;
+	}, c_uiSceneUpdateGrainSize);
+
+	// and once they have all finished, merge the chunk bounds:
+	JobHandle hBounds = a_rJobSystem.CreateJob([pScene] ()
+	{
+		glm::vec3 v3Min(1e30f);
+		glm::vec3 v3Max(-1e30f);
+		for (size_t i = 0; i < pScene->m_vChunkMin.size(); ++i)
+		{
+			v3Min = glm::min(v3Min, pScene->m_vChunkMin[i]);
+			v3Max = glm::max(v3Max, pScene->m_vChunkMax[i]);
+		}
+		pScene->m_v3BoundsMin = v3Min;
+		pScene->m_v3BoundsMax = v3Max;
+	});
+	a_rJobSystem.AddDependency(hBounds, hUpdate);
+	a_rJobSystem.Submit(hBounds);
+
+	return hBounds;
+}
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////
+/// @file		SceneUpdate.h
+/// @details	The per frame game work, replaces the sleep() the loops used to
+///				pretend to be busy with. Every frame each object's model matrix is
+///				rebuilt in parallel on the job system, then a job that depends on
+///				that merges the per chunk bounds into the bounds of the scene.
+///				The update is started before the windows are drawn and waited on
+///				after, so it runs alongside rendering.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _SCENEUPDATE_H_
+#define _SCENEUPDATE_H_
+
+#include "glm/glm.hpp"
+#include "JobSystem.h"
+#include <vector>
+
+////////////////////////// Constants //////////////////////////////////
+const unsigned int c_uiDefaultSceneObjectCount = 20000;		// -objects N
+const unsigned int c_uiSceneUpdateGrainSize = 256;			// objects per job.
+
+///////////////////// Custom Data Types ///////////////////////////////
+struct SceneObject
+{
+	glm::vec3	m_v3Position;
+	glm::vec3	m_v3Axis;		// spins around this.
+	float		m_fSpeed;		// degrees per second.
+	float		m_fScale;
+};
+
+struct SimulatedScene
+{
+	std::vector<SceneObject>	m_vObjects;
+	std::vector<glm::mat4>		m_vModelMatrices;	// written by StartSceneUpdate(), one per object.
+	std::vector<glm::vec3>		m_vChunkMin;		// bounds of each update job's objects.
+	std::vector<glm::vec3>		m_vChunkMax;
+	glm::vec3					m_v3BoundsMin;		// bounds of the whole scene, valid once the update has finished.
+	glm::vec3					m_v3BoundsMax;
+};
+
+/////////////////////////// Functions /////////////////////////////////
+void CreateSimulatedScene(SimulatedScene& a_rScene, unsigned int a_uiObjectCount);
+
+/// Queues this frames update of a_rScene, the returned job finishes once the matrices and bounds are done.
+/// a_rScene must not be touched until then.
+JobHandle StartSceneUpdate(JobSystem& a_rJobSystem, SimulatedScene& a_rScene, float a_fTime);
+
+#endif // _SCENEUPDATE_H_
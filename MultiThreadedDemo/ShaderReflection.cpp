@@ -0,0 +1,104 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "ContextRegistry.h"
+#include "ShaderReflection.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <vector>
+
+
+// strips the "[0]" that GL puts on the end of array names, so arrays can be looked up by their plain name.
+static std::string StripArraySuffix(const char* a_szName)
+{
+	std::string szName(a_szName);
+	size_t uiBracket = szName.find('[');
+	if (uiBracket != std::string::npos)
+		szName.resize(uiBracket);
+	return szName;
+}
+
+
+void ReflectProgram(GLuint a_uiProgram, ProgramReflection& a_rReflection)
+{
+	a_rReflection.m_uiProgram = a_uiProgram;
+	a_rReflection.m_mUniforms.clear();
+	a_rReflection.m_mAttributes.clear();
+	a_rReflection.m_mUniformBlocks.clear();
+
+	GLint iCount = 0;
+	GLint iMaxLength = 0;
+	GLint iSize = 0;
+	GLenum eType = 0;
+
+	// uniforms:
+	glGetProgramiv(a_uiProgram, GL_ACTIVE_UNIFORMS, &iCount);
+	glGetProgramiv(a_uiProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &iMaxLength);
+	std::vector<GLchar> vName(iMaxLength + 1);
+	for (GLint i = 0; i < iCount; ++i)
+	{
+		glGetActiveUniform(a_uiProgram, i, (GLsizei)vName.size(), nullptr, &iSize, &eType, vName.data());
+		GLint iLocation = glGetUniformLocation(a_uiProgram, vName.data());
+		if (iLocation != -1)
+			a_rReflection.m_mUniforms[StripArraySuffix(vName.data())] = iLocation;
+	}
+
+	// attributes:
+	glGetProgramiv(a_uiProgram, GL_ACTIVE_ATTRIBUTES, &iCount);
+	glGetProgramiv(a_uiProgram, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &iMaxLength);
+	vName.resize(iMaxLength + 1);
+	for (GLint i = 0; i < iCount; ++i)
+	{
+		glGetActiveAttrib(a_uiProgram, i, (GLsizei)vName.size(), nullptr, &iSize, &eType, vName.data());
+		GLint iLocation = glGetAttribLocation(a_uiProgram, vName.data());
+		if (iLocation != -1)
+			a_rReflection.m_mAttributes[StripArraySuffix(vName.data())] = iLocation;
+	}
+
+	// uniform blocks:
+	glGetProgramiv(a_uiProgram, GL_ACTIVE_UNIFORM_BLOCKS, &iCount);
+	for (GLint i = 0; i < iCount; ++i)
+	{
+		GLint iNameLength = 0;
+		glGetActiveUniformBlockiv(a_uiProgram, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &iNameLength);
+		vName.resize(iNameLength + 1);
+		glGetActiveUniformBlockName(a_uiProgram, i, (GLsizei)vName.size(), nullptr, vName.data());
+		a_rReflection.m_mUniformBlocks[vName.data()] = (GLuint)i;
+	}
+}
+
+
+GLint ProgramReflection::GetUniformLocation(const std::string& a_szName) const
+{
+	auto itr = m_mUniforms.find(a_szName);
+	return itr != m_mUniforms.end() ? itr->second : -1;
+}
+
+
+GLint ProgramReflection::GetAttribLocation(const std::string& a_szName) const
+{
+	auto itr = m_mAttributes.find(a_szName);
+	return itr != m_mAttributes.end() ? itr->second : -1;
+}
+
+
+GLuint ProgramReflection::GetUniformBlockIndex(const std::string& a_szName) const
+{
+	auto itr = m_mUniformBlocks.find(a_szName);
+	return itr != m_mUniformBlocks.end() ? itr->second : GL_INVALID_INDEX;
+}
+
+
+void PrintProgramReflection(const ProgramReflection& a_rReflection)
+{
+	Log("Status: Program %u has %u uniforms, %u attributes and %u uniform blocks\n", a_rReflection.m_uiProgram,
+		(unsigned int)a_rReflection.m_mUniforms.size(), (unsigned int)a_rReflection.m_mAttributes.size(), (unsigned int)a_rReflection.m_mUniformBlocks.size());
+
+	for (auto& itr : a_rReflection.m_mUniforms)
+		Log("    uniform %s = %i\n", itr.first.c_str(), itr.second);
+	for (auto& itr : a_rReflection.m_mAttributes)
+		Log("    attribute %s = %i\n", itr.first.c_str(), itr.second);
+	for (auto& itr : a_rReflection.m_mUniformBlocks)
+		Log("    block %s = %u\n", itr.first.c_str(), itr.second);
+}
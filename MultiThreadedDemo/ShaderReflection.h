@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////
+/// @file		ShaderReflection.h
+/// @details	Resolves every active uniform, attribute and uniform block of a
+///				linked program once, so that nothing in the render loop has to
+///				look a location up by name.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _SHADERREFLECTION_H_
+#define _SHADERREFLECTION_H_
+
+#include <map>
+#include <string>
+
+struct ProgramReflection
+{
+	GLuint							m_uiProgram;
+	std::map<std::string, GLint>	m_mUniforms;		// uniforms in the default block only, block members have no location.
+	std::map<std::string, GLint>	m_mAttributes;
+	std::map<std::string, GLuint>	m_mUniformBlocks;
+
+	// These are for load time only, cache the result rather than calling them every frame.
+	GLint GetUniformLocation(const std::string& a_szName) const;		// returns -1 if not found.
+	GLint GetAttribLocation(const std::string& a_szName) const;		// returns -1 if not found.
+	GLuint GetUniformBlockIndex(const std::string& a_szName) const;	// returns GL_INVALID_INDEX if not found.
+};
+
+/// Fills in a_rReflection for a_uiProgram, which must already be linked.
+void ReflectProgram(GLuint a_uiProgram, ProgramReflection& a_rReflection);
+
+/// Prints what was found, handy when a location comes back as -1.
+void PrintProgramReflection(const ProgramReflection& a_rReflection);
+
+#endif // _SHADERREFLECTION_H_
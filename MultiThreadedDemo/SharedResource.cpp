@@ -0,0 +1,296 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "GLStateCache.h"
+#include "SharedResource.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstring>
+#include <algorithm>
+
+
+SharedResource::SharedResource()
+	: m_eTarget(0)
+	, m_iSize(0)
+	, m_iWidth(0)
+	, m_iHeight(0)
+	, m_iInternalFormat(0)
+	, m_eFormat(0)
+	, m_eType(0)
+	, m_uiLatest(0)
+	, m_ullVersion(0)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+
+SharedResource::~SharedResource()
+{
+}
+
+
+bool SharedResource::CreateBuffer(GLStateCache& a_rState, GLsizeiptr a_iSize, const void* a_pData, unsigned int a_uiCopies)
+{
+	m_iSize = a_iSize;
+	return Create(a_rState, GL_ARRAY_BUFFER, a_pData, a_uiCopies);
+}
+
+
+bool SharedResource::CreateTexture2D(GLStateCache& a_rState, GLsizei a_iWidth, GLsizei a_iHeight, GLint a_iInternalFormat, GLenum a_eFormat, GLenum a_eType,
+	const void* a_pData, unsigned int a_uiCopies)
+{
+	m_iWidth = a_iWidth;
+	m_iHeight = a_iHeight;
+	m_iInternalFormat = a_iInternalFormat;
+	m_eFormat = a_eFormat;
+	m_eType = a_eType;
+	return Create(a_rState, GL_TEXTURE_2D, a_pData, a_uiCopies);
+}
+
+
+bool SharedResource::Create(GLStateCache& a_rState, GLenum a_eTarget, const void* a_pData, unsigned int a_uiCopies)
+{
+	if (IsCreated() || a_uiCopies == 0)
+		return false;
+
+	m_eTarget = a_eTarget;
+	m_vCopies.resize(a_uiCopies);
+	for (auto& copy : m_vCopies)
+	{
+		memset(&copy, 0, sizeof(copy));
+
+		// buffers are not tied to a target, GL_ARRAY_BUFFER is fine whatever they are used as:
+		if (m_eTarget == GL_TEXTURE_2D)
+		{
+			glGenTextures(1, &copy.m_uiName);
+			a_rState.BindTexture(GL_TEXTURE_2D, copy.m_uiName);
+			glTexImage2D(GL_TEXTURE_2D, 0, m_iInternalFormat, m_iWidth, m_iHeight, 0, m_eFormat, m_eType, nullptr);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		}
+		else
+		{
+			glGenBuffers(1, &copy.m_uiName);
+			a_rState.BindBuffer(GL_ARRAY_BUFFER, copy.m_uiName);
+			glBufferData(GL_ARRAY_BUFFER, m_iSize, nullptr, GL_DYNAMIC_DRAW);
+		}
+	}
+
+	// the first version goes in the first copy, the rest are written as updates come in:
+	m_uiLatest = 0;
+	m_ullVersion = 1;
+	Write(a_rState, m_vCopies[0], a_pData);
+	m_vCopies[0].m_ullVersion = m_ullVersion;
+	return true;
+}
+
+
+void SharedResource::Destroy(GLStateCache& a_rState)
+{
+	for (auto& copy : m_vCopies)
+	{
+		if (m_eTarget == GL_TEXTURE_2D)
+		{
+			a_rState.BindTexture(GL_TEXTURE_2D, 0);
+			glDeleteTextures(1, &copy.m_uiName);
+		}
+		else
+		{
+			a_rState.BindBuffer(GL_ARRAY_BUFFER, 0);
+			glDeleteBuffers(1, &copy.m_uiName);
+		}
+
+		if (copy.m_WriteFence != 0)
+			glDeleteSync(copy.m_WriteFence);
+		for (unsigned int i = 0; i < c_uiMaxContextSlots; ++i)
+		{
+			if (copy.m_aReadFences[i] != 0)
+				glDeleteSync(copy.m_aReadFences[i]);
+		}
+	}
+	m_vCopies.clear();
+	m_ullVersion = 0;
+}
+
+
+void SharedResource::Update(GLStateCache& a_rState, const void* a_pData)
+{
+	if (!IsCreated())
+		return;
+
+	unsigned int uiCount = (unsigned int)m_vCopies.size();
+	Copy* pCopy = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+
+		// the oldest copy no reader holds, never the latest unless it is the only one:
+		double dBlockStart = 0.0;
+		while (pCopy == nullptr)
+		{
+			for (unsigned int i = 1; i <= uiCount && pCopy == nullptr; ++i)
+			{
+				unsigned int uiCopy = (m_uiLatest + i) % uiCount;
+				if ((uiCopy != m_uiLatest || uiCount == 1) && m_vCopies[uiCopy].m_uiReaders == 0)
+					pCopy = &m_vCopies[uiCopy];
+			}
+
+			if (pCopy == nullptr)
+			{
+				if (dBlockStart == 0.0)
+				{
+					dBlockStart = glfwGetTime();
+					++m_Stats.m_ullWriterBlocks;
+				}
+				m_Changed.wait(lock);
+			}
+		}
+		if (dBlockStart != 0.0)
+			m_Stats.m_dWriterBlockSeconds += glfwGetTime() - dBlockStart;
+
+		// with one copy this keeps readers out until it is published again, otherwise no reader looks at it anyway:
+		pCopy->m_bWriting = true;
+	}
+
+	// nothing else touches the copy's fences while we are writing it. The GPU, not us, waits for the readers' draws:
+	for (unsigned int i = 0; i < c_uiMaxContextSlots; ++i)
+	{
+		if (pCopy->m_aReadFences[i] != 0)
+		{
+			glWaitSync(pCopy->m_aReadFences[i], 0, GL_TIMEOUT_IGNORED);
+			glDeleteSync(pCopy->m_aReadFences[i]);
+			pCopy->m_aReadFences[i] = 0;
+		}
+	}
+	Write(a_rState, *pCopy, a_pData);
+
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		pCopy->m_ullVersion = ++m_ullVersion;
+		pCopy->m_bWriting = false;
+		m_uiLatest = (unsigned int)(pCopy - &m_vCopies[0]);
+		++m_Stats.m_ullUpdates;
+	}
+	m_Changed.notify_all();
+}
+
+
+void SharedResource::Write(GLStateCache& a_rState, Copy& a_rCopy, const void* a_pData)
+{
+	if (m_eTarget == GL_TEXTURE_2D)
+	{
+		a_rState.BindTexture(GL_TEXTURE_2D, a_rCopy.m_uiName);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_iWidth, m_iHeight, m_eFormat, m_eType, a_pData);
+	}
+	else
+	{
+		a_rState.BindBuffer(GL_ARRAY_BUFFER, a_rCopy.m_uiName);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_iSize, a_pData);
+	}
+
+	// the flush makes sure the fence reaches the GPU, otherwise a reader's glWaitSync() could wait on it forever:
+	if (a_rCopy.m_WriteFence != 0)
+		glDeleteSync(a_rCopy.m_WriteFence);
+	a_rCopy.m_WriteFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+}
+
+
+SharedResourceView SharedResource::Acquire(unsigned int a_uiContextSlot)
+{
+	SharedResourceView view;
+	GLsync waitFence = 0;
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		if (m_vCopies[m_uiLatest].m_bWriting)
+		{
+			double dBlockStart = glfwGetTime();
+			++m_Stats.m_ullReaderBlocks;
+			m_Changed.wait(lock, [this] () { return !m_vCopies[m_uiLatest].m_bWriting; });
+			m_Stats.m_dReaderBlockSeconds += glfwGetTime() - dBlockStart;
+		}
+
+		Copy& copy = m_vCopies[m_uiLatest];
+		++copy.m_uiReaders;
+		++m_Stats.m_ullAcquires;
+
+		view.m_uiName = copy.m_uiName;
+		view.m_uiCopy = m_uiLatest;
+		view.m_ullVersion = copy.m_ullVersion;
+		view.m_bWaited = copy.m_aullWaited[a_uiContextSlot] != copy.m_ullVersion;
+		if (view.m_bWaited)
+		{
+			copy.m_aullWaited[a_uiContextSlot] = copy.m_ullVersion;
+			waitFence = copy.m_WriteFence;
+			++m_Stats.m_ullReaderWaits;
+		}
+	}
+
+	// the writer leaves a copy with readers alone, so its fence cannot be deleted under us:
+	if (waitFence != 0)
+		glWaitSync(waitFence, 0, GL_TIMEOUT_IGNORED);
+
+	return view;
+}
+
+
+void SharedResource::Release(const SharedResourceView& a_rView, unsigned int a_uiContextSlot)
+{
+	// a later fence from the same context covers everything the earlier one did:
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	GLsync oldFence = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		Copy& copy = m_vCopies[a_rView.m_uiCopy];
+		oldFence = copy.m_aReadFences[a_uiContextSlot];
+		copy.m_aReadFences[a_uiContextSlot] = fence;
+		--copy.m_uiReaders;
+	}
+	m_Changed.notify_all();
+
+	if (oldFence != 0)
+		glDeleteSync(oldFence);
+}
+
+
+void SharedResource::CloseContext(unsigned int a_uiContextSlot)
+{
+	if (a_uiContextSlot >= c_uiMaxContextSlots)
+		return;
+
+	std::vector<GLsync> vFences;
+	{
+		// Update() waits on the read fences of the copy it writes without holding the lock, so let it finish first:
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_Changed.wait(lock, [this] () { return std::none_of(m_vCopies.begin(), m_vCopies.end(), [] (const Copy& a_rCopy) { return a_rCopy.m_bWriting; }); });
+
+		for (auto& copy : m_vCopies)
+		{
+			if (copy.m_aReadFences[a_uiContextSlot] != 0)
+				vFences.push_back(copy.m_aReadFences[a_uiContextSlot]);
+			copy.m_aReadFences[a_uiContextSlot] = 0;
+			copy.m_aullWaited[a_uiContextSlot] = 0;	// so the slot's next context waits for the version it first draws with.
+		}
+	}
+
+	for (GLsync fence : vFences)
+		glDeleteSync(fence);
+}
+
+
+SharedResourceStats SharedResource::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Stats;
+}
+
+
+void SharedResource::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////
+/// @file		SharedResource.h
+/// @details	A buffer or texture that one thread keeps changing while other
+///				contexts draw from it. It is kept as N copies, each a GL object
+///				of its own. The writer fills the oldest copy no reader is using,
+///				fences it and publishes it as the latest version. A reader takes
+///				the latest version and, the first time its context uses that
+///				version, makes the GPU wait on the writer's fence with glWaitSync.
+///				So each context only waits for the updates it actually draws with,
+///				and never on another reader. When a reader is done issuing its
+///				draws it fences the copy, and the writer makes the GPU wait on
+///				those fences before writing over it again.
+///				With one copy the writer and the readers take turns, which is the
+///				same lock step as the threaded loop's two fences.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _SHAREDRESOURCE_H_
+#define _SHAREDRESOURCE_H_
+
+#include "ContextObjectRegistry.h"
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+class GLStateCache;
+
+const unsigned int c_uiDefaultSharedResourceCopies = 3;
+
+struct SharedResourceView
+{
+	GLuint				m_uiName;		// the buffer or texture to bind.
+	unsigned int		m_uiCopy;		// which copy it is, for Release().
+	unsigned long long	m_ullVersion;	// the update it holds, 1 is the data it was created with.
+	bool				m_bWaited;		// this context has not used this version before. It must be bound again, not just left bound.
+};
+
+struct SharedResourceStats
+{
+	unsigned long long	m_ullUpdates;
+	unsigned long long	m_ullWriterBlocks;		// updates that had to wait for readers to finish with every copy they could use.
+	double				m_dWriterBlockSeconds;
+	unsigned long long	m_ullAcquires;
+	unsigned long long	m_ullReaderWaits;		// glWaitSync() calls made by readers, one per context per version it drew with.
+	unsigned long long	m_ullReaderBlocks;		// Acquire() calls that found the latest copy being written, only with one copy.
+	double				m_dReaderBlockSeconds;
+};
+
+class SharedResource
+{
+public:
+	SharedResource();
+	~SharedResource();	// Destroy() must have been called with a context current.
+
+	/// Creates a_uiCopies buffers of a_iSize bytes and publishes a_pData as the first version. A context that shares with
+	/// every reader must be current, a_rState is its cache.
+	bool CreateBuffer(GLStateCache& a_rState, GLsizeiptr a_iSize, const void* a_pData, unsigned int a_uiCopies = c_uiDefaultSharedResourceCopies);
+
+	/// The same for a 2D texture without mipmaps, a_pData is a_iWidth * a_iHeight texels of a_eFormat/a_eType.
+	bool CreateTexture2D(GLStateCache& a_rState, GLsizei a_iWidth, GLsizei a_iHeight, GLint a_iInternalFormat, GLenum a_eFormat, GLenum a_eType,
+		const void* a_pData, unsigned int a_uiCopies = c_uiDefaultSharedResourceCopies);
+
+	/// No thread may be reading or writing it.
+	void Destroy(GLStateCache& a_rState);
+
+	/// Writes a whole new version and publishes it. One writer at a time, its context must share with the readers'.
+	/// Blocks only while readers are issuing draws from every copy it could write to.
+	void Update(GLStateCache& a_rState, const void* a_pData);
+
+	/// The latest version, a_uiContextSlot is the current context's slot in the ContextObjectRegistry. Bind the view's
+	/// object after this, and call Release() once the draws that use it have been issued. A context may only hold one
+	/// view of a resource at a time.
+	SharedResourceView Acquire(unsigned int a_uiContextSlot);
+	void Release(const SharedResourceView& a_rView, unsigned int a_uiContextSlot);
+
+	/// Forgets a context whose window is being destroyed, so the next context given its slot starts clean. The context
+	/// must hold no views, and a context that shares with the readers must be current to delete its fences.
+	void CloseContext(unsigned int a_uiContextSlot);
+
+	bool IsCreated() const						{ return !m_vCopies.empty(); }
+	unsigned int GetCopyCount() const			{ return (unsigned int)m_vCopies.size(); }
+	SharedResourceStats GetStats() const;
+	void ResetStats();
+
+private:
+	struct Copy
+	{
+		GLuint				m_uiName;
+		GLsync				m_WriteFence;							// after the writes of m_ullVersion.
+		unsigned long long	m_ullVersion;
+		unsigned int		m_uiReaders;							// views acquired and not yet released.
+		bool				m_bWriting;
+		GLsync				m_aReadFences[c_uiMaxContextSlots];		// after each context's last draws from it, 0 if none since it was written.
+		unsigned long long	m_aullWaited[c_uiMaxContextSlots];		// the version each context last waited for.
+	};
+
+	SharedResource(const SharedResource&);				// not copyable, we own GL objects.
+	SharedResource& operator=(const SharedResource&);
+
+	bool Create(GLStateCache& a_rState, GLenum a_eTarget, const void* a_pData, unsigned int a_uiCopies);
+	void Write(GLStateCache& a_rState, Copy& a_rCopy, const void* a_pData);
+
+	GLenum					m_eTarget;			// GL_ARRAY_BUFFER or GL_TEXTURE_2D.
+	GLsizeiptr				m_iSize;
+	GLsizei					m_iWidth;
+	GLsizei					m_iHeight;
+	GLint					m_iInternalFormat;
+	GLenum					m_eFormat;
+	GLenum					m_eType;
+
+	std::vector<Copy>		m_vCopies;
+	unsigned int			m_uiLatest;
+	unsigned long long		m_ullVersion;
+
+	mutable std::mutex		m_Lock;
+	std::condition_variable	m_Changed;			// a copy was released or published.
+	SharedResourceStats		m_Stats;
+};
+
+#endif // _SHAREDRESOURCE_H_
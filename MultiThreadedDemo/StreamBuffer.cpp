@@ -0,0 +1,192 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ContextRegistry.h"
+#include "StreamBuffer.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+
+
+StreamBuffer::StreamBuffer()
+	: m_uiBuffer(0)
+	, m_eTarget(GL_ARRAY_BUFFER)
+	, m_iRegionSize(0)
+	, m_uiRegionCount(0)
+	, m_bPersistent(false)
+	, m_pMapped(nullptr)
+	, m_uiRegion(0)
+	, m_iRegionUsed(0)
+	, m_bInFrame(false)
+	, m_ullFrames(0)
+	, m_ullStalls(0)
+	, m_dStallSeconds(0.0)
+{
+}
+
+
+StreamBuffer::~StreamBuffer()
+{
+	if (m_uiBuffer != 0)
+		printf("Warning: StreamBuffer %u was not destroyed!\n", m_uiBuffer);
+}
+
+
+bool StreamBuffer::Create(GLenum a_eTarget, GLsizeiptr a_iRegionSize, unsigned int a_uiRegionCount)
+{
+	if (m_uiBuffer != 0 || a_iRegionSize <= 0 || a_uiRegionCount == 0)
+		return false;
+
+	m_eTarget = a_eTarget;
+	m_iRegionSize = ((a_iRegionSize + 255) / 256) * 256;	// keep every region start aligned for any use.
+	m_uiRegionCount = a_uiRegionCount;
+	m_vFences.assign(a_uiRegionCount, (GLsync)0);
+	m_uiRegion = a_uiRegionCount - 1;	// so the first BeginFrame() starts at region 0.
+	m_iRegionUsed = 0;
+	m_bInFrame = false;
+
+	GLsizeiptr iTotalSize = m_iRegionSize * a_uiRegionCount;
+	glGenBuffers(1, &m_uiBuffer);
+	glBindBuffer(m_eTarget, m_uiBuffer);
+
+	m_bPersistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	if (m_bPersistent)
+	{
+		// map it once and keep it mapped, coherent so we never have to flush:
+		GLbitfield uiFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(m_eTarget, iTotalSize, nullptr, uiFlags);
+		m_pMapped = (unsigned char*)glMapBufferRange(m_eTarget, 0, iTotalSize, uiFlags);
+		if (m_pMapped == nullptr)
+		{
+			Log("Error: Could not persistently map a %i byte stream buffer!\n", (int)iTotalSize);
+			glBindBuffer(m_eTarget, 0);
+			glDeleteBuffers(1, &m_uiBuffer);
+			m_uiBuffer = 0;
+			return false;
+		}
+	}
+	else
+	{
+		glBufferData(m_eTarget, iTotalSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(m_eTarget, 0);
+	return true;
+}
+
+
+void StreamBuffer::Destroy()
+{
+	if (m_uiBuffer == 0)
+		return;
+
+	for (auto& fence : m_vFences)
+	{
+		if (fence != 0)
+			glDeleteSync(fence);
+		fence = 0;
+	}
+
+	if (m_pMapped != nullptr)
+	{
+		glBindBuffer(m_eTarget, m_uiBuffer);
+		glUnmapBuffer(m_eTarget);
+		glBindBuffer(m_eTarget, 0);
+		m_pMapped = nullptr;
+	}
+
+	glDeleteBuffers(1, &m_uiBuffer);
+	m_uiBuffer = 0;
+}
+
+
+double StreamBuffer::BeginFrame()
+{
+	if (m_uiBuffer == 0 || m_bInFrame)
+		return 0.0;
+
+	m_uiRegion = (m_uiRegion + 1) % m_uiRegionCount;
+	m_iRegionUsed = 0;
+	m_bInFrame = true;
+	++m_ullFrames;
+
+	double dStalled = 0.0;
+	GLsync& fence = m_vFences[m_uiRegion];
+	if (fence != 0)
+	{
+		// the cheap check first, if it has signalled there is nothing to wait for:
+		GLenum eResult = glClientWaitSync(fence, 0, 0);
+		if (eResult == GL_TIMEOUT_EXPIRED)
+		{
+			// the CPU is a whole ring ahead of the GPU, we have to wait:
+			double dStart = glfwGetTime();
+			do
+			{
+				eResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);	// 1ms at a time.
+			} while (eResult == GL_TIMEOUT_EXPIRED);
+			dStalled = glfwGetTime() - dStart;
+
+			++m_ullStalls;
+			m_dStallSeconds += dStalled;
+
+			// don't flood the console if it happens every frame:
+			if ((m_ullStalls & (m_ullStalls - 1)) == 0)
+				Log("Warning: StreamBuffer %u stalled %.3fms waiting on the GPU (%llu stalls in %llu frames)\n", m_uiBuffer, dStalled * 1000.0, m_ullStalls, m_ullFrames);
+		}
+
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	if (!m_bPersistent)
+	{
+		// the fence tells us the GPU is done with this region, so nothing is lost by not synchronising:
+		glBindBuffer(m_eTarget, m_uiBuffer);
+		m_pMapped = (unsigned char*)glMapBufferRange(m_eTarget, m_uiRegion * m_iRegionSize, m_iRegionSize,
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	}
+
+	return dStalled;
+}
+
+
+void* StreamBuffer::Allocate(GLsizeiptr a_iSize, GLintptr& a_riOffset, GLsizeiptr a_iAlignment)
+{
+	if (!m_bInFrame || m_pMapped == nullptr)
+		return nullptr;
+
+	GLsizeiptr iStart = ((m_iRegionUsed + a_iAlignment - 1) / a_iAlignment) * a_iAlignment;
+	if (iStart + a_iSize > m_iRegionSize)
+	{
+		LogRateLimited(LS_STREAM_BUFFER, m_uiBuffer, "Error: StreamBuffer %u region is full, could not allocate %i bytes!\n", m_uiBuffer, (int)a_iSize);
+		return nullptr;
+	}
+	m_iRegionUsed = iStart + a_iSize;
+
+	a_riOffset = m_uiRegion * m_iRegionSize + iStart;
+	return m_bPersistent ? m_pMapped + a_riOffset : m_pMapped + iStart;
+}
+
+
+void StreamBuffer::CommitWrites()
+{
+	// a persistent coherent mapping can be drawn from while mapped, anything else has to be unmapped first:
+	if (!m_bPersistent && m_pMapped != nullptr)
+	{
+		glBindBuffer(m_eTarget, m_uiBuffer);
+		glUnmapBuffer(m_eTarget);
+		m_pMapped = nullptr;
+	}
+}
+
+
+void StreamBuffer::EndFrame()
+{
+	if (!m_bInFrame)
+		return;
+
+	CommitWrites();
+	m_vFences[m_uiRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_bInFrame = false;
+}
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////
+/// @file		StreamBuffer.h
+/// @details	A ring of N frame sized regions in one persistently mapped buffer,
+///				for data that changes every frame. Each region is fenced when the
+///				frame that used it is submitted and only written again once the GPU
+///				has passed that fence, so writes never orphan the buffer or wait on
+///				the driver unless the CPU really has got N frames ahead.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _STREAMBUFFER_H_
+#define _STREAMBUFFER_H_
+
+#include <vector>
+
+const unsigned int c_uiStreamBufferRegions = 3;		// triple buffered by default.
+
+class StreamBuffer
+{
+public:
+	StreamBuffer();
+	~StreamBuffer();	// Destroy() must have been called with a context current.
+
+	/// Creates the buffer and maps it, a context must be current. Uses GL 4.4 buffer storage when it is available
+	/// and falls back to mapping each region unsynchronised as it is used when it is not.
+	bool Create(GLenum a_eTarget, GLsizeiptr a_iRegionSize, unsigned int a_uiRegionCount = c_uiStreamBufferRegions);
+	void Destroy();
+
+	/// Moves on to the next region, waiting for the GPU to finish reading it if it has not yet.
+	/// Returns the time spent waiting in seconds, anything above 0 is a stall.
+	double BeginFrame();
+
+	/// Reserves a_iSize bytes of the current region, a_riOffset is set to where they are in the buffer.
+	/// Returns nullptr if the region is full.
+	void* Allocate(GLsizeiptr a_iSize, GLintptr& a_riOffset, GLsizeiptr a_iAlignment = 16);
+
+	/// Call after writing and before drawing from this frames allocations. Only does anything without persistent mapping.
+	void CommitWrites();
+
+	/// Fences the current region, call once the draws that read from it have been issued.
+	void EndFrame();
+
+	GLuint GetBuffer() const					{ return m_uiBuffer; }
+	bool IsPersistent() const					{ return m_bPersistent; }
+	unsigned long long GetFrameCount() const	{ return m_ullFrames; }
+	unsigned long long GetStallCount() const	{ return m_ullStalls; }
+	double GetStallSeconds() const				{ return m_dStallSeconds; }
+
+private:
+	StreamBuffer(const StreamBuffer&);				// not copyable, we own GL objects.
+	StreamBuffer& operator=(const StreamBuffer&);
+
+	GLuint					m_uiBuffer;
+	GLenum					m_eTarget;
+	GLsizeiptr				m_iRegionSize;
+	unsigned int			m_uiRegionCount;
+	bool					m_bPersistent;
+	unsigned char*			m_pMapped;			// whole buffer when persistent, otherwise the current region.
+
+	std::vector<GLsync>		m_vFences;			// one per region, 0 once the GPU is known to be done with it.
+	unsigned int			m_uiRegion;
+	GLsizeiptr				m_iRegionUsed;
+	bool					m_bInFrame;
+
+	unsigned long long		m_ullFrames;
+	unsigned long long		m_ullStalls;
+	double					m_dStallSeconds;
+};
+
+#endif // _STREAMBUFFER_H_
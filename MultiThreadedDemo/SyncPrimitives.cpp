@@ -0,0 +1,239 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "SyncPrimitives.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <thread>
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// SSE2 is always there on x64 and is the default for x86 since VS2012:
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SYNC_CPU_PAUSE() _mm_pause()
+#else
+#define SYNC_CPU_PAUSE() std::this_thread::yield()
+#endif
+
+const unsigned int c_uiSpinsPerYield = 64;		// even a long spin gives the core away now and then, in case the signaller is waiting for it.
+
+const char* const c_aszSyncWaitPolicyNames[SWP_COUNT] =
+{
+	"spin then park",
+	"spin",
+	"park",
+};
+
+std::atomic<int> g_eSyncWaitPolicy(SWP_SPIN_THEN_PARK);
+
+// with one hardware thread the signaller cannot run while we spin, so spinning only ever yields:
+static const bool s_bOneHardwareThread = std::thread::hardware_concurrency() == 1;
+
+
+static void SpinOnce(unsigned int a_uiSpin)
+{
+	if (s_bOneHardwareThread || a_uiSpin % c_uiSpinsPerYield == c_uiSpinsPerYield - 1)
+		std::this_thread::yield();
+	else
+		SYNC_CPU_PAUSE();
+}
+
+
+void SetSyncWaitPolicy(SyncWaitPolicies a_ePolicy)
+{
+	g_eSyncWaitPolicy = a_ePolicy;
+}
+
+
+SyncWaitPolicies GetSyncWaitPolicy()
+{
+	return (SyncWaitPolicies)g_eSyncWaitPolicy.load();
+}
+
+
+const char* GetSyncWaitPolicyName(SyncWaitPolicies a_ePolicy)
+{
+	return a_ePolicy < SWP_COUNT ? c_aszSyncWaitPolicyNames[a_ePolicy] : "unknown";
+}
+
+
+void AddSyncStats(SyncStats& a_rTotal, const SyncStats& a_rStats)
+{
+	a_rTotal.m_ullWaits += a_rStats.m_ullWaits;
+	a_rTotal.m_ullSpins += a_rStats.m_ullSpins;
+	a_rTotal.m_ullSpinWakes += a_rStats.m_ullSpinWakes;
+	a_rTotal.m_ullParks += a_rStats.m_ullParks;
+	a_rTotal.m_dWakeSeconds += a_rStats.m_dWakeSeconds;
+	a_rTotal.m_dMaxWakeSeconds = std::max(a_rTotal.m_dMaxWakeSeconds, a_rStats.m_dMaxWakeSeconds);
+}
+
+
+void PrintSyncStats(const char* a_szName, const SyncStats& a_rStats)
+{
+	if (a_rStats.m_ullWaits == 0)
+		return;
+
+	printf("%s: %llu waits, %.1f spins each, %llu ended spinning and %llu parked, %.3fms mean and %.3fms max wake up\n", a_szName,
+		a_rStats.m_ullWaits, (double)a_rStats.m_ullSpins / a_rStats.m_ullWaits, a_rStats.m_ullSpinWakes, a_rStats.m_ullParks,
+		a_rStats.m_ullParks > 0 ? a_rStats.m_dWakeSeconds * 1000.0 / a_rStats.m_ullParks : 0.0, a_rStats.m_dMaxWakeSeconds * 1000.0);
+}
+
+
+double GetProcessCPUSeconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0.0;
+
+	// both are in 100ns ticks:
+	ULARGE_INTEGER kernelTicks, userTicks;
+	kernelTicks.LowPart = kernel.dwLowDateTime;
+	kernelTicks.HighPart = kernel.dwHighDateTime;
+	userTicks.LowPart = user.dwLowDateTime;
+	userTicks.HighPart = user.dwHighDateTime;
+	return (kernelTicks.QuadPart + userTicks.QuadPart) * 1.0e-7;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0.0;
+
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0e-6;
+#endif
+}
+
+
+SyncCounter::SyncCounter(unsigned long long a_ullValue)
+	: m_ullValue(a_ullValue)
+	, m_uiParked(0)
+	, m_uiSpinLimit(c_uiDefaultSyncSpins)
+	, m_ullWaits(0)
+	, m_ullSpins(0)
+	, m_ullSpinWakes(0)
+	, m_dSignalTime(0.0)
+	, m_ullParks(0)
+	, m_dWakeSeconds(0.0)
+	, m_dMaxWakeSeconds(0.0)
+{
+}
+
+
+void SyncCounter::Reset(unsigned long long a_ullValue)
+{
+	m_ullValue = a_ullValue;
+}
+
+
+unsigned long long SyncCounter::Add(unsigned long long a_ullCount)
+{
+	unsigned long long ullPrevious = m_ullValue.fetch_add(a_ullCount);
+
+	// a waiter counts itself as parked before it last looks at the value, so one of us always sees the other:
+	if (m_uiParked.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_dSignalTime = glfwGetTime();
+		}
+		m_Wake.notify_all();
+	}
+
+	return ullPrevious;
+}
+
+
+void SyncCounter::WaitFor(unsigned long long a_ullTarget)
+{
+	if (m_ullValue.load() >= a_ullTarget)
+		return;
+
+	++m_ullWaits;
+
+	SyncWaitPolicies ePolicy = GetSyncWaitPolicy();
+	unsigned int uiLimit = ePolicy == SWP_PARK ? 0 : m_uiSpinLimit.load();
+	unsigned int uiSpins = 0;
+	while (ePolicy == SWP_SPIN || uiSpins < uiLimit)
+	{
+		SpinOnce(uiSpins++);
+		if (m_ullValue.load() >= a_ullTarget)
+		{
+			m_ullSpins += uiSpins;
+			++m_ullSpinWakes;
+
+			// it paid off, next time it may be worth waiting a little longer:
+			if (ePolicy == SWP_SPIN_THEN_PARK)
+				m_uiSpinLimit = std::min(uiLimit * 2, c_uiMaxSyncSpins);
+			return;
+		}
+	}
+	m_ullSpins += uiSpins;
+
+	bool bSlept = false;
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		++m_uiParked;
+		while (m_ullValue.load() < a_ullTarget)
+		{
+			m_Wake.wait(lock);
+			bSlept = true;
+		}
+		--m_uiParked;
+
+		if (bSlept)
+		{
+			double dWake = glfwGetTime() - m_dSignalTime;
+			++m_ullParks;
+			m_dWakeSeconds += dWake;
+			m_dMaxWakeSeconds = std::max(m_dMaxWakeSeconds, dWake);
+		}
+	}
+
+	if (!bSlept)
+		++m_ullSpinWakes;	// it got there while we took the lock.
+	else if (ePolicy == SWP_SPIN_THEN_PARK)
+		m_uiSpinLimit = std::max(uiLimit / 2, c_uiMinSyncSpins);
+}
+
+
+SyncStats SyncCounter::GetStats() const
+{
+	SyncStats stats;
+	stats.m_ullWaits = m_ullWaits;
+	stats.m_ullSpins = m_ullSpins;
+	stats.m_ullSpinWakes = m_ullSpinWakes;
+
+	std::lock_guard<std::mutex> lock(m_Lock);
+	stats.m_ullParks = m_ullParks;
+	stats.m_dWakeSeconds = m_dWakeSeconds;
+	stats.m_dMaxWakeSeconds = m_dMaxWakeSeconds;
+	return stats;
+}
+
+
+void SyncCounter::ResetStats()
+{
+	m_ullWaits = 0;
+	m_ullSpins = 0;
+	m_ullSpinWakes = 0;
+
+	std::lock_guard<std::mutex> lock(m_Lock);
+	m_ullParks = 0;
+	m_dWakeSeconds = 0.0;
+	m_dMaxWakeSeconds = 0.0;
+}
+
+
+unsigned long long FrameBarrier::ArriveAndWait()
+{
+	unsigned long long ullGeneration = m_Counter.Add() / m_uiParties;
+	m_Counter.WaitFor((ullGeneration + 1) * m_uiParties);
+	return ullGeneration;
+}
@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////
+/// @file		SyncPrimitives.h
+/// @details	Thread synchronisation for the render loops: start latches,
+///				frame barriers and per window ready events. All of them are a
+///				counter that only goes up and a wait for it to reach a value.
+///				A waiter spins on the counter for a little while, in case the
+///				other thread is about to get there, then parks on a condition
+///				variable. How long it spins adapts: it doubles after a wait the
+///				spinning caught and halves after one that had to park anyway, so
+///				a thread that is always kept waiting (for vsync, say) costs
+///				next to nothing while a hand over that is quick stays quick.
+///				Signalling only takes the lock when someone is parked.
+///				Every primitive counts its waits, spin iterations, parks and
+///				how long a parked waiter took to run again after the signal.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _SYNCPRIMITIVES_H_
+#define _SYNCPRIMITIVES_H_
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+const unsigned int c_uiMinSyncSpins = 16;			// the adaptive spin never goes below this many iterations.
+const unsigned int c_uiMaxSyncSpins = 4096;			// or above this many.
+const unsigned int c_uiDefaultSyncSpins = 256;
+
+enum SyncWaitPolicies
+{
+	SWP_SPIN_THEN_PARK = 0,		// default, spin for the adaptive count then park.
+	SWP_SPIN,					// never park, the busy wait the threaded loop used to do.
+	SWP_PARK,					// park straight away, a plain condition variable.
+
+	SWP_COUNT,
+};
+
+struct SyncStats
+{
+	unsigned long long	m_ullWaits;			// waits that were not already satisfied.
+	unsigned long long	m_ullSpins;			// spin iterations over all of them.
+	unsigned long long	m_ullSpinWakes;		// waits that ended without parking.
+	unsigned long long	m_ullParks;
+	double				m_dWakeSeconds;		// from the last signal to a parked waiter running again, summed over m_ullParks.
+	double				m_dMaxWakeSeconds;
+};
+
+/// How every primitive waits from now on. Only change it while nothing is waiting.
+void SetSyncWaitPolicy(SyncWaitPolicies a_ePolicy);
+SyncWaitPolicies GetSyncWaitPolicy();
+const char* GetSyncWaitPolicyName(SyncWaitPolicies a_ePolicy);
+
+void AddSyncStats(SyncStats& a_rTotal, const SyncStats& a_rStats);
+void PrintSyncStats(const char* a_szName, const SyncStats& a_rStats);
+
+/// User plus kernel time of every thread in the process so far, to measure what waiting costs.
+double GetProcessCPUSeconds();
+
+class SyncCounter
+{
+public:
+	explicit SyncCounter(unsigned long long a_ullValue = 0);
+
+	/// Nothing may be waiting, the stats are kept.
+	void Reset(unsigned long long a_ullValue = 0);
+
+	/// Adds a_ullCount and wakes any parked waiters. Returns the value before the add.
+	unsigned long long Add(unsigned long long a_ullCount = 1);
+
+	/// Returns once the value is at least a_ullTarget.
+	void WaitFor(unsigned long long a_ullTarget);
+
+	unsigned long long Get() const				{ return m_ullValue.load(); }
+	SyncStats GetStats() const;
+	void ResetStats();
+
+private:
+	SyncCounter(const SyncCounter&);				// not copyable, waiters hold on to it.
+	SyncCounter& operator=(const SyncCounter&);
+
+	std::atomic<unsigned long long>	m_ullValue;
+	std::atomic<unsigned int>		m_uiParked;			// changed under m_Lock, read without it by Add().
+	std::atomic<unsigned int>		m_uiSpinLimit;		// SWP_SPIN_THEN_PARK's adaptive count.
+
+	std::atomic<unsigned long long>	m_ullWaits;
+	std::atomic<unsigned long long>	m_ullSpins;
+	std::atomic<unsigned long long>	m_ullSpinWakes;
+
+	mutable std::mutex				m_Lock;				// guards the four below.
+	std::condition_variable			m_Wake;
+	double							m_dSignalTime;		// when Add() last woke someone.
+	unsigned long long				m_ullParks;
+	double							m_dWakeSeconds;
+	double							m_dMaxWakeSeconds;
+};
+
+/// Opens once CountDown() has been called a_uiCount times, and stays open until Reset().
+class StartLatch
+{
+public:
+	explicit StartLatch(unsigned int a_uiCount = 1) : m_uiCount(a_uiCount)	{}
+
+	void Reset(unsigned int a_uiCount)			{ m_uiCount = a_uiCount; m_Counter.Reset(); }
+	void CountDown()							{ m_Counter.Add(); }
+	void Wait()									{ m_Counter.WaitFor(m_uiCount); }
+	bool IsOpen() const							{ return m_Counter.Get() >= m_uiCount; }
+
+	SyncStats GetStats() const					{ return m_Counter.GetStats(); }
+	void ResetStats()							{ m_Counter.ResetStats(); }
+
+private:
+	SyncCounter		m_Counter;
+	unsigned int	m_uiCount;
+};
+
+/// Holds every thread that arrives until a_uiParties have, then lets them all go and starts over.
+class FrameBarrier
+{
+public:
+	explicit FrameBarrier(unsigned int a_uiParties = 1) : m_uiParties(a_uiParties)	{}
+
+	/// Nothing may be waiting.
+	void Reset(unsigned int a_uiParties)		{ m_uiParties = a_uiParties; m_Counter.Reset(); }
+
+	/// Returns the generation that was let go, the first is 0.
+	unsigned long long ArriveAndWait();
+
+	unsigned int GetParties() const				{ return m_uiParties; }
+	SyncStats GetStats() const					{ return m_Counter.GetStats(); }
+	void ResetStats()							{ m_Counter.ResetStats(); }
+
+private:
+	SyncCounter		m_Counter;		// arrivals since Reset(), so generation N is over at (N + 1) * m_uiParties.
+	unsigned int	m_uiParties;
+};
+
+/// How many frames a window has finished, for a thread that must not start its own frame before another window's.
+class ReadyEvent
+{
+public:
+	void Reset()								{ m_Counter.Reset(); }
+	void Signal()								{ m_Counter.Add(); }
+
+	/// Returns once frame a_ullFrame has been signalled, the first is 1.
+	void WaitFor(unsigned long long a_ullFrame)	{ m_Counter.WaitFor(a_ullFrame); }
+
+	unsigned long long GetFrame() const			{ return m_Counter.Get(); }
+	SyncStats GetStats() const					{ return m_Counter.GetStats(); }
+	void ResetStats()							{ m_Counter.ResetStats(); }
+
+private:
+	SyncCounter		m_Counter;
+};
+
+#endif // _SYNCPRIMITIVES_H_
@@ -0,0 +1,233 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "TextureGen.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstring>
+#include <algorithm>
+
+// SSE2 is always there on x64 and is the default for x86 since VS2012:
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTUREGEN_SSE2
+#include <emmintrin.h>
+#endif
+
+static const TextureFormatInfo c_aFormatInfo[TF_COUNT] =
+{
+	{ "RGBA32F", GL_RGBA32F, GL_RGBA, GL_FLOAT, 16 },
+	{ "RGBA16F", GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8 },
+	{ "RGB10A2", GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4 },
+	{ "RGBA8", GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+};
+
+
+const TextureFormatInfo& GetTextureFormatInfo(TextureFormats a_eFormat)
+{
+	return c_aFormatInfo[a_eFormat < TF_COUNT ? a_eFormat : TF_RGBA8];
+}
+
+
+size_t GetTextureSize(const TextureDesc& a_rDesc)
+{
+	return (size_t)a_rDesc.m_uiWidth * a_rDesc.m_uiHeight * GetTextureFormatInfo(a_rDesc.m_eFormat).m_uiBytesPerTexel;
+}
+
+
+bool IsTextureGenSIMD()
+{
+#ifdef TEXTUREGEN_SSE2
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+static glm::vec4 PatternTexel(const TextureDesc& a_rDesc, unsigned int a_uiX, unsigned int a_uiY)
+{
+	if (a_rDesc.m_ePattern == TP_GRADIENT)
+		return glm::mix(a_rDesc.m_v4ColourA, a_rDesc.m_v4ColourB, (a_uiX + 0.5f) * (1.0f / a_rDesc.m_uiWidth));
+
+	return ((a_uiX / a_rDesc.m_uiCellWidth + a_uiY / a_rDesc.m_uiCellHeight) & 1) != 0 ? a_rDesc.m_v4ColourB : a_rDesc.m_v4ColourA;
+}
+
+
+static void StoreTexel(TextureFormats a_eFormat, const glm::vec4& a_rv4Colour, unsigned char* a_pDest)
+{
+	// the packed formats are written as 32 bit words, R in the low bits, which is also byte order R, G, B, A on a little endian CPU:
+	glm::vec4 v4Clamped = glm::clamp(a_rv4Colour, 0.0f, 1.0f);
+	unsigned int auiPacked[2];
+	switch (a_eFormat)
+	{
+	case TF_RGBA32F:
+		memcpy(a_pDest, &a_rv4Colour.x, sizeof(glm::vec4));
+		break;
+	case TF_RGBA16F:
+		auiPacked[0] = glm::packHalf2x16(glm::vec2(a_rv4Colour.x, a_rv4Colour.y));
+		auiPacked[1] = glm::packHalf2x16(glm::vec2(a_rv4Colour.z, a_rv4Colour.w));
+		memcpy(a_pDest, auiPacked, sizeof(unsigned int) * 2);
+		break;
+	case TF_RGB10A2:
+		auiPacked[0] = (unsigned int)(v4Clamped.x * 1023.0f + 0.5f) | (unsigned int)(v4Clamped.y * 1023.0f + 0.5f) << 10 |
+			(unsigned int)(v4Clamped.z * 1023.0f + 0.5f) << 20 | (unsigned int)(v4Clamped.w * 3.0f + 0.5f) << 30;
+		memcpy(a_pDest, auiPacked, sizeof(unsigned int));
+		break;
+	default:
+		auiPacked[0] = (unsigned int)(v4Clamped.x * 255.0f + 0.5f) | (unsigned int)(v4Clamped.y * 255.0f + 0.5f) << 8 |
+			(unsigned int)(v4Clamped.z * 255.0f + 0.5f) << 16 | (unsigned int)(v4Clamped.w * 255.0f + 0.5f) << 24;
+		memcpy(a_pDest, auiPacked, sizeof(unsigned int));
+		break;
+	}
+}
+
+
+#ifdef TEXTUREGEN_SSE2
+// a_av4Channels holds R, G, B and A of four texels, one texel per lane:
+static __m128i PackUnorm4(const __m128 a_av4Channels[4], float a_fColourMax, float a_fAlphaMax, int a_iBits)
+{
+	const __m128 v4Zero = _mm_setzero_ps();
+	const __m128 v4One = _mm_set1_ps(1.0f);
+	const __m128 v4Half = _mm_set1_ps(0.5f);
+
+	__m128i aiChannels[4];
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		__m128 v4Max = _mm_set1_ps(i == 3 ? a_fAlphaMax : a_fColourMax);
+		__m128 v4Clamped = _mm_min_ps(_mm_max_ps(a_av4Channels[i], v4Zero), v4One);
+		aiChannels[i] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v4Clamped, v4Max), v4Half));
+	}
+
+	__m128i iPacked = _mm_or_si128(aiChannels[0], _mm_slli_epi32(aiChannels[1], a_iBits));
+	iPacked = _mm_or_si128(iPacked, _mm_slli_epi32(aiChannels[2], a_iBits * 2));
+	return _mm_or_si128(iPacked, _mm_slli_epi32(aiChannels[3], a_iBits * 3));
+}
+
+
+static void StoreTexels4(TextureFormats a_eFormat, const __m128 a_av4Channels[4], unsigned char* a_pDest)
+{
+	switch (a_eFormat)
+	{
+	case TF_RGBA32F:
+	{
+		__m128 v4R = a_av4Channels[0], v4G = a_av4Channels[1], v4B = a_av4Channels[2], v4A = a_av4Channels[3];
+		_MM_TRANSPOSE4_PS(v4R, v4G, v4B, v4A);
+		_mm_storeu_ps((float*)a_pDest, v4R);
+		_mm_storeu_ps((float*)a_pDest + 4, v4G);
+		_mm_storeu_ps((float*)a_pDest + 8, v4B);
+		_mm_storeu_ps((float*)a_pDest + 12, v4A);
+		break;
+	}
+	case TF_RGBA16F:
+	{
+		// SSE2 has no half conversion, so the four texels go through glm one at a time:
+		float afChannels[4][4];
+		for (unsigned int i = 0; i < 4; ++i)
+			_mm_storeu_ps(afChannels[i], a_av4Channels[i]);
+		for (unsigned int i = 0; i < 4; ++i)
+			StoreTexel(a_eFormat, glm::vec4(afChannels[0][i], afChannels[1][i], afChannels[2][i], afChannels[3][i]), a_pDest + i * 8);
+		break;
+	}
+	case TF_RGB10A2:
+		// 2 alpha bits land at 30, which is where 3 * 10 puts them:
+		_mm_storeu_si128((__m128i*)a_pDest, PackUnorm4(a_av4Channels, 1023.0f, 3.0f, 10));
+		break;
+	default:
+		_mm_storeu_si128((__m128i*)a_pDest, PackUnorm4(a_av4Channels, 255.0f, 255.0f, 8));
+		break;
+	}
+}
+#endif
+
+
+static void FillRow(const TextureDesc& a_rDesc, unsigned int a_uiY, unsigned int a_uiBegin, unsigned int a_uiEnd, unsigned char* a_pRow)
+{
+	unsigned int uiBytesPerTexel = GetTextureFormatInfo(a_rDesc.m_eFormat).m_uiBytesPerTexel;
+	unsigned int uiX = a_uiBegin;
+
+#ifdef TEXTUREGEN_SSE2
+	// four texels a step, each channel in its own register:
+	__m128 av4ColourA[4], av4ColourB[4], av4Delta[4];
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		av4ColourA[i] = _mm_set1_ps(a_rDesc.m_v4ColourA[i]);
+		av4ColourB[i] = _mm_set1_ps(a_rDesc.m_v4ColourB[i]);
+		av4Delta[i] = _mm_sub_ps(av4ColourB[i], av4ColourA[i]);
+	}
+
+	// texel centres, so the truncation to a cell never lands on an edge:
+	const __m128 v4Offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	const __m128 v4InvWidth = _mm_set1_ps(1.0f / a_rDesc.m_uiWidth);
+	const __m128 v4InvCellWidth = _mm_set1_ps(1.0f / a_rDesc.m_uiCellWidth);
+	const __m128i iCellY = _mm_set1_epi32((int)(a_uiY / a_rDesc.m_uiCellHeight));
+	const __m128i iOne = _mm_set1_epi32(1);
+
+	__m128 av4Channels[4];
+	for (; uiX + 4 <= a_uiEnd; uiX += 4)
+	{
+		__m128 v4X = _mm_add_ps(_mm_set1_ps((float)uiX), v4Offsets);
+		if (a_rDesc.m_ePattern == TP_GRADIENT)
+		{
+			__m128 v4T = _mm_mul_ps(v4X, v4InvWidth);
+			for (unsigned int i = 0; i < 4; ++i)
+				av4Channels[i] = _mm_add_ps(av4ColourA[i], _mm_mul_ps(av4Delta[i], v4T));
+		}
+		else
+		{
+			__m128i iCellX = _mm_cvttps_epi32(_mm_mul_ps(v4X, v4InvCellWidth));
+			__m128i iOdd = _mm_and_si128(_mm_add_epi32(iCellX, iCellY), iOne);
+			__m128 v4UseB = _mm_castsi128_ps(_mm_cmpeq_epi32(iOdd, iOne));
+			for (unsigned int i = 0; i < 4; ++i)
+				av4Channels[i] = _mm_or_ps(_mm_and_ps(v4UseB, av4ColourB[i]), _mm_andnot_ps(v4UseB, av4ColourA[i]));
+		}
+
+		StoreTexels4(a_rDesc.m_eFormat, av4Channels, a_pRow + (uiX - a_uiBegin) * uiBytesPerTexel);
+	}
+#endif
+
+	for (; uiX < a_uiEnd; ++uiX)
+		StoreTexel(a_rDesc.m_eFormat, PatternTexel(a_rDesc, uiX, a_uiY), a_pRow + (uiX - a_uiBegin) * uiBytesPerTexel);
+}
+
+
+void GenerateTexture(const TextureDesc& a_rDesc, unsigned char* a_pTexels, JobSystem* a_pJobSystem)
+{
+	if (a_rDesc.m_uiWidth == 0 || a_rDesc.m_uiHeight == 0)
+		return;
+
+	TextureDesc desc = a_rDesc;
+	desc.m_uiCellWidth = std::max(desc.m_uiCellWidth, 1u);
+	desc.m_uiCellHeight = std::max(desc.m_uiCellHeight, 1u);
+
+	size_t uiBytesPerTexel = GetTextureFormatInfo(desc.m_eFormat).m_uiBytesPerTexel;
+	size_t uiRowBytes = desc.m_uiWidth * uiBytesPerTexel;
+	unsigned int uiTilesX = (desc.m_uiWidth + c_uiTextureTileSize - 1) / c_uiTextureTileSize;
+	unsigned int uiTilesY = (desc.m_uiHeight + c_uiTextureTileSize - 1) / c_uiTextureTileSize;
+
+	// tiles are numbered across then down, so neighbouring jobs write neighbouring memory:
+	auto fillTiles = [&desc, a_pTexels, uiRowBytes, uiBytesPerTexel, uiTilesX] (unsigned int a_uiBegin, unsigned int a_uiEnd)
+	{
+		for (unsigned int uiTile = a_uiBegin; uiTile < a_uiEnd; ++uiTile)
+		{
+			unsigned int uiX0 = (uiTile % uiTilesX) * c_uiTextureTileSize;
+			unsigned int uiY0 = (uiTile / uiTilesX) * c_uiTextureTileSize;
+			unsigned int uiX1 = std::min(uiX0 + c_uiTextureTileSize, desc.m_uiWidth);
+			unsigned int uiY1 = std::min(uiY0 + c_uiTextureTileSize, desc.m_uiHeight);
+
+			for (unsigned int uiY = uiY0; uiY < uiY1; ++uiY)
+				FillRow(desc, uiY, uiX0, uiX1, a_pTexels + uiY * uiRowBytes + uiX0 * uiBytesPerTexel);
+		}
+	};
+
+	unsigned int uiTiles = uiTilesX * uiTilesY;
+	if (a_pJobSystem == nullptr || uiTiles == 1)
+		fillTiles(0, uiTiles);
+	else
+		a_pJobSystem->ParallelFor(uiTiles, fillTiles, 1);
+}
+
+
+void GenerateTexture(const TextureDesc& a_rDesc, std::vector<unsigned char>& a_rvTexels, JobSystem* a_pJobSystem)
+{
+	a_rvTexels.resize(GetTextureSize(a_rDesc));
+	GenerateTexture(a_rDesc, a_rvTexels.data(), a_pJobSystem);
+}
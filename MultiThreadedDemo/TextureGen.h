@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////
+/// @file		TextureGen.h
+/// @details	Procedural textures, generated straight into the format they
+///				are uploaded in. The image is cut into square tiles that are
+///				filled in parallel on the job system, four texels at a time
+///				with SSE2 where the compiler has it. RGBA32F is only here to
+///				compare against, a two colour pattern loses nothing in RGBA8
+///				at a quarter of the memory. RGB10A2 and half float are there
+///				for patterns that need more than 8 bits, like gradients.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _TEXTUREGEN_H_
+#define _TEXTUREGEN_H_
+
+#include "glm/glm.hpp"
+#include "JobSystem.h"
+#include <vector>
+#include <cstddef>
+
+////////////////////////// Constants //////////////////////////////////
+const unsigned int c_uiTextureTileSize = 128;		// texels along each side of a tile, one job per tile.
+
+///////////////////// Custom Data Types ///////////////////////////////
+enum TextureFormats
+{
+	TF_RGBA32F = 0,		// 16 bytes a texel.
+	TF_RGBA16F,			// 8, packed with glm::packHalf2x16().
+	TF_RGB10A2,			// 4, 10 bits of colour and 2 of alpha.
+	TF_RGBA8,			// 4.
+
+	TF_COUNT,
+};
+
+enum TexturePatterns
+{
+	TP_CHECKER = 0,		// m_v4ColourA and m_v4ColourB in cells of m_uiCellWidth by m_uiCellHeight texels.
+	TP_GRADIENT,		// m_v4ColourA on the left to m_v4ColourB on the right.
+};
+
+struct TextureFormatInfo
+{
+	const char*		m_szName;
+	GLint			m_iInternalFormat;
+	GLenum			m_eFormat;
+	GLenum			m_eType;
+	unsigned int	m_uiBytesPerTexel;
+};
+
+struct TextureDesc
+{
+	unsigned int	m_uiWidth;
+	unsigned int	m_uiHeight;
+	TextureFormats	m_eFormat;
+	TexturePatterns	m_ePattern;
+	unsigned int	m_uiCellWidth;
+	unsigned int	m_uiCellHeight;
+	glm::vec4		m_v4ColourA;
+	glm::vec4		m_v4ColourB;
+};
+
+/////////////////////////// Functions /////////////////////////////////
+const TextureFormatInfo& GetTextureFormatInfo(TextureFormats a_eFormat);
+
+/// Bytes of texel data for a_rDesc, which is also what it takes on the GPU without mipmaps.
+size_t GetTextureSize(const TextureDesc& a_rDesc);
+
+/// Fills a_pTexels, GetTextureSize() bytes, with tightly packed rows. Rows are a multiple of 4 bytes in every format,
+/// so the default GL_UNPACK_ALIGNMENT is fine. Tiles run on a_pJobSystem, or all on this thread if it is null.
+void GenerateTexture(const TextureDesc& a_rDesc, unsigned char* a_pTexels, JobSystem* a_pJobSystem);
+void GenerateTexture(const TextureDesc& a_rDesc, std::vector<unsigned char>& a_rvTexels, JobSystem* a_pJobSystem);
+
+/// Whether GenerateTexture() was built with the SSE2 path, for the benchmark's output.
+bool IsTextureGenSIMD();
+
+#endif // _TEXTUREGEN_H_
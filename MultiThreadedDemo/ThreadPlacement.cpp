@@ -0,0 +1,514 @@
+// Note that the following includes must be defined in order:
+#include "ContextRegistry.h"
+#include "ThreadPlacement.h"
+#include "Logger.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+const char* const c_szSysfsRoot = "/sys/devices/system";
+const unsigned int c_uiMaxNUMANodes = 64;			// node directories looked for, they need not be numbered without gaps.
+
+const char* const c_aszThreadRoleNames[TR_COUNT] =
+{
+	"main",
+	"render",
+	"job",
+	"loader",
+};
+
+const char* const c_aszPlacementPolicyNames[PP_COUNT] =
+{
+	"none",
+	"compact",
+	"spread",
+};
+
+struct PlacedThread
+{
+	std::string			m_szName;
+	ThreadRoles			m_eRole;
+	int					m_iCPU;					// what it is pinned to, c_iNoCPU if its role's policy is none.
+
+	// only written by the thread itself:
+	int					m_iLastCPU;
+	unsigned long long	m_ullSamples;
+	unsigned long long	m_ullMigrations;
+	unsigned long long	m_ullNodeMigrations;
+};
+
+CPUTopology g_CPUTopology;
+PlacementPolicies g_aePlacementPolicies[TR_COUNT];
+std::vector<unsigned int> g_avPlacementOrders[PP_COUNT];	// indices into g_CPUTopology.m_vCPUs, in the order each policy hands them out.
+std::vector<int> g_viNodeByCPU;								// by the OS's CPU number, -1 for CPUs we may not run on.
+
+std::mutex g_PlacementLock;									// guards the list and every thread's m_iCPU.
+std::deque<PlacedThread> g_dPlacedThreads;					// a deque, so a thread's record never moves while it holds on to it.
+THREAD_LOCAL PlacedThread* t_pPlacedThread = nullptr;
+
+
+#if defined(__linux__)
+static bool ReadFileLine(const std::string& a_szPath, std::string& a_rszLine)
+{
+	FILE* pFile = fopen(a_szPath.c_str(), "r");
+	if (pFile == nullptr)
+		return false;
+
+	char szLine[1024];
+	bool bRead = fgets(szLine, sizeof(szLine), pFile) != nullptr;
+	fclose(pFile);
+
+	if (bRead)
+		a_rszLine = szLine;
+	return bRead;
+}
+
+
+// sysfs lists CPUs as ranges, "0-3,8-11":
+static std::vector<unsigned int> ParseCPUList(const std::string& a_szList)
+{
+	std::vector<unsigned int> vCPUs;
+	const char* szPos = a_szList.c_str();
+	while (*szPos != '\0' && *szPos != '\n')
+	{
+		char* szEnd = nullptr;
+		unsigned int uiFirst = (unsigned int)strtoul(szPos, &szEnd, 10);
+		if (szEnd == szPos)
+			break;
+
+		unsigned int uiLast = uiFirst;
+		if (*szEnd == '-')
+		{
+			szPos = szEnd + 1;
+			uiLast = (unsigned int)strtoul(szPos, &szEnd, 10);
+		}
+		for (unsigned int uiCPU = uiFirst; uiCPU <= uiLast; ++uiCPU)
+		{
+			vCPUs.push_back(uiCPU);
+		}
+
+		szPos = *szEnd == ',' ? szEnd + 1 : szEnd;
+	}
+	return vCPUs;
+}
+
+
+static bool ReadSysfsTopology(const std::string& a_szRoot, const std::vector<unsigned int>& a_vAllowed, CPUTopology& a_rTopology)
+{
+	std::string szLine;
+	if (!ReadFileLine(a_szRoot + "/cpu/online", szLine))
+		return false;
+
+	// cores are numbered by their package and core_id, which is only unique within the package:
+	std::vector<std::pair<unsigned int, unsigned int> > vCoreKeys;
+	for (unsigned int uiCPU : a_vAllowed)
+	{
+		std::string szTopology = a_szRoot + "/cpu/cpu" + std::to_string(uiCPU) + "/topology/";
+		LogicalCPU cpu;
+		cpu.m_uiCPU = uiCPU;
+		cpu.m_uiPackage = ReadFileLine(szTopology + "physical_package_id", szLine) ? (unsigned int)atoi(szLine.c_str()) : 0;
+		unsigned int uiCoreID = ReadFileLine(szTopology + "core_id", szLine) ? (unsigned int)atoi(szLine.c_str()) : uiCPU;
+		cpu.m_uiNode = 0;
+
+		std::pair<unsigned int, unsigned int> key(cpu.m_uiPackage, uiCoreID);
+		auto it = std::find(vCoreKeys.begin(), vCoreKeys.end(), key);
+		cpu.m_uiCore = (unsigned int)(it - vCoreKeys.begin());
+		if (it == vCoreKeys.end())
+			vCoreKeys.push_back(key);
+
+		// the CPUs are in order, so the siblings before this one already have their index:
+		cpu.m_uiSMTIndex = 0;
+		for (auto& other : a_rTopology.m_vCPUs)
+		{
+			if (other.m_uiCore == cpu.m_uiCore)
+				++cpu.m_uiSMTIndex;
+		}
+		a_rTopology.m_vCPUs.push_back(cpu);
+	}
+
+	// without the node directories (no NUMA in the kernel) everything is node 0:
+	for (unsigned int uiNode = 0; uiNode < c_uiMaxNUMANodes; ++uiNode)
+	{
+		if (!ReadFileLine(a_szRoot + "/node/node" + std::to_string(uiNode) + "/cpulist", szLine))
+			continue;
+
+		std::vector<unsigned int> vNodeCPUs = ParseCPUList(szLine);
+		for (auto& cpu : a_rTopology.m_vCPUs)
+		{
+			if (std::find(vNodeCPUs.begin(), vNodeCPUs.end(), cpu.m_uiCPU) != vNodeCPUs.end())
+				cpu.m_uiNode = uiNode;
+		}
+	}
+
+	a_rTopology.m_szSource = "sysfs";
+	return !a_rTopology.m_vCPUs.empty();
+}
+#endif
+
+
+static bool DiscoverTopology(CPUTopology& a_rTopology)
+{
+#ifdef _WIN32
+	DWORD uiBytes = 0;
+	GetLogicalProcessorInformation(nullptr, &uiBytes);
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> vInfo(uiBytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if (vInfo.empty() || !GetLogicalProcessorInformation(vInfo.data(), &uiBytes))
+		return false;
+
+	DWORD_PTR uiProcessMask = 0, uiSystemMask = 0;
+	GetProcessAffinityMask(GetCurrentProcess(), &uiProcessMask, &uiSystemMask);
+
+	// each core, node and package comes with a mask of its logical CPUs:
+	const unsigned int c_uiMaskBits = sizeof(ULONG_PTR) * 8;
+	std::vector<LogicalCPU> vAll(c_uiMaskBits);
+	std::vector<bool> vPresent(c_uiMaskBits, false);
+	unsigned int uiCore = 0, uiPackage = 0;
+	for (auto& info : vInfo)
+	{
+		unsigned int uiSMTIndex = 0;
+		for (unsigned int uiCPU = 0; uiCPU < c_uiMaskBits; ++uiCPU)
+		{
+			if ((info.ProcessorMask & ((ULONG_PTR)1 << uiCPU)) == 0)
+				continue;
+
+			LogicalCPU& cpu = vAll[uiCPU];
+			cpu.m_uiCPU = uiCPU;
+			if (info.Relationship == RelationProcessorCore)
+			{
+				cpu.m_uiCore = uiCore;
+				cpu.m_uiSMTIndex = uiSMTIndex++;
+				vPresent[uiCPU] = true;
+			}
+			else if (info.Relationship == RelationNumaNode)
+				cpu.m_uiNode = info.NumaNode.NodeNumber;
+			else if (info.Relationship == RelationProcessorPackage)
+				cpu.m_uiPackage = uiPackage;
+		}
+
+		if (info.Relationship == RelationProcessorCore)
+			++uiCore;
+		else if (info.Relationship == RelationProcessorPackage)
+			++uiPackage;
+	}
+
+	for (unsigned int uiCPU = 0; uiCPU < c_uiMaskBits; ++uiCPU)
+	{
+		if (vPresent[uiCPU] && (uiProcessMask & ((DWORD_PTR)1 << uiCPU)) != 0)
+			a_rTopology.m_vCPUs.push_back(vAll[uiCPU]);
+	}
+	a_rTopology.m_szSource = "GetLogicalProcessorInformation()";
+	return !a_rTopology.m_vCPUs.empty();
+#elif defined(__linux__)
+	// only the CPUs we are allowed on, a container or taskset may have taken some away:
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+		return false;
+
+	std::vector<unsigned int> vAllowed;
+	for (unsigned int uiCPU = 0; uiCPU < CPU_SETSIZE; ++uiCPU)
+	{
+		if (CPU_ISSET(uiCPU, &allowed))
+			vAllowed.push_back(uiCPU);
+	}
+	return ReadSysfsTopology(c_szSysfsRoot, vAllowed, a_rTopology);
+#else
+	return false;
+#endif
+}
+
+
+static bool PinCurrentThread(unsigned int a_uiCPU)
+{
+#ifdef _WIN32
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << a_uiCPU) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(a_uiCPU, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+
+static int GetCPUNode(int a_iCPU)
+{
+	return a_iCPU >= 0 && a_iCPU < (int)g_viNodeByCPU.size() ? g_viNodeByCPU[a_iCPU] : -1;
+}
+
+
+static bool ParsePlacementConfig(const std::string& a_szConfig, PlacementPolicies* a_aePolicies)
+{
+	size_t uiStart = 0;
+	while (uiStart < a_szConfig.size())
+	{
+		size_t uiEnd = a_szConfig.find(',', uiStart);
+		if (uiEnd == std::string::npos)
+			uiEnd = a_szConfig.size();
+		std::string szItem = a_szConfig.substr(uiStart, uiEnd - uiStart);
+		uiStart = uiEnd + 1;
+
+		size_t uiEquals = szItem.find('=');
+		std::string szRole = uiEquals != std::string::npos ? szItem.substr(0, uiEquals) : std::string();
+		std::string szPolicy = uiEquals != std::string::npos ? szItem.substr(uiEquals + 1) : szItem;
+
+		int iPolicy = 0;
+		while (iPolicy < PP_COUNT && szPolicy != c_aszPlacementPolicyNames[iPolicy])
+			++iPolicy;
+		if (iPolicy == PP_COUNT)
+			return false;
+
+		for (int iRole = 0; iRole < TR_COUNT; ++iRole)
+		{
+			if (szRole.empty() || szRole == c_aszThreadRoleNames[iRole])
+				a_aePolicies[iRole] = (PlacementPolicies)iPolicy;
+		}
+		if (!szRole.empty() && std::find_if(c_aszThreadRoleNames, c_aszThreadRoleNames + TR_COUNT,
+			[&szRole] (const char* a_szName) { return szRole == a_szName; }) == c_aszThreadRoleNames + TR_COUNT)
+			return false;
+	}
+	return true;
+}
+
+
+bool InitThreadPlacement(const std::string& a_szConfig)
+{
+	g_CPUTopology = CPUTopology();
+	if (!DiscoverTopology(g_CPUTopology))
+	{
+		// a flat machine, good enough to count migrations on but nothing is pinned:
+		g_CPUTopology.m_vCPUs.clear();
+		unsigned int uiCount = std::max(std::thread::hardware_concurrency(), 1u);
+		for (unsigned int uiCPU = 0; uiCPU < uiCount; ++uiCPU)
+		{
+			LogicalCPU cpu = { uiCPU, uiCPU, 0, 0, 0 };
+			g_CPUTopology.m_vCPUs.push_back(cpu);
+		}
+		g_CPUTopology.m_szSource = "hardware_concurrency()";
+	}
+
+	std::vector<unsigned int> vCores, vPackages, vNodes;
+	g_viNodeByCPU.clear();
+	for (auto& cpu : g_CPUTopology.m_vCPUs)
+	{
+		vCores.push_back(cpu.m_uiCore);
+		vPackages.push_back(cpu.m_uiPackage);
+		vNodes.push_back(cpu.m_uiNode);
+		if (cpu.m_uiCPU >= g_viNodeByCPU.size())
+			g_viNodeByCPU.resize(cpu.m_uiCPU + 1, -1);
+		g_viNodeByCPU[cpu.m_uiCPU] = (int)cpu.m_uiNode;
+	}
+	for (auto pvList : { &vCores, &vPackages, &vNodes })
+	{
+		std::sort(pvList->begin(), pvList->end());
+		pvList->erase(std::unique(pvList->begin(), pvList->end()), pvList->end());
+	}
+	g_CPUTopology.m_uiCores = (unsigned int)vCores.size();
+	g_CPUTopology.m_uiPackages = (unsigned int)vPackages.size();
+	g_CPUTopology.m_uiNodes = (unsigned int)vNodes.size();
+
+	// spread takes the nodes in turn, so it needs each core's place within its node:
+	const std::vector<LogicalCPU>& vCPUs = g_CPUTopology.m_vCPUs;
+	std::vector<unsigned int> vCoreRank(vCPUs.size(), 0);
+	for (size_t i = 0; i < vCPUs.size(); ++i)
+	{
+		std::vector<unsigned int> vNodeCores;
+		for (auto& cpu : vCPUs)
+		{
+			if (cpu.m_uiNode == vCPUs[i].m_uiNode && cpu.m_uiCore < vCPUs[i].m_uiCore &&
+				std::find(vNodeCores.begin(), vNodeCores.end(), cpu.m_uiCore) == vNodeCores.end())
+				vNodeCores.push_back(cpu.m_uiCore);
+		}
+		vCoreRank[i] = (unsigned int)vNodeCores.size();
+	}
+
+	for (int iPolicy = 0; iPolicy < PP_COUNT; ++iPolicy)
+	{
+		std::vector<unsigned int>& vOrder = g_avPlacementOrders[iPolicy];
+		vOrder.clear();
+		for (unsigned int i = 0; i < vCPUs.size(); ++i)
+		{
+			vOrder.push_back(i);
+		}
+	}
+	std::sort(g_avPlacementOrders[PP_COMPACT].begin(), g_avPlacementOrders[PP_COMPACT].end(), [&vCPUs] (unsigned int a_uiA, unsigned int a_uiB)
+	{
+		const LogicalCPU& a = vCPUs[a_uiA];
+		const LogicalCPU& b = vCPUs[a_uiB];
+		if (a.m_uiNode != b.m_uiNode)
+			return a.m_uiNode < b.m_uiNode;
+		if (a.m_uiPackage != b.m_uiPackage)
+			return a.m_uiPackage < b.m_uiPackage;
+		if (a.m_uiSMTIndex != b.m_uiSMTIndex)
+			return a.m_uiSMTIndex < b.m_uiSMTIndex;
+		return a.m_uiCore < b.m_uiCore;
+	});
+	std::sort(g_avPlacementOrders[PP_SPREAD].begin(), g_avPlacementOrders[PP_SPREAD].end(), [&vCPUs, &vCoreRank] (unsigned int a_uiA, unsigned int a_uiB)
+	{
+		const LogicalCPU& a = vCPUs[a_uiA];
+		const LogicalCPU& b = vCPUs[a_uiB];
+		if (a.m_uiSMTIndex != b.m_uiSMTIndex)
+			return a.m_uiSMTIndex < b.m_uiSMTIndex;
+		if (vCoreRank[a_uiA] != vCoreRank[a_uiB])
+			return vCoreRank[a_uiA] < vCoreRank[a_uiB];
+		return a.m_uiNode < b.m_uiNode;
+	});
+
+	Log("CPU topology from %s: %u logical CPUs, %u cores, %u packages, %u NUMA nodes\n", g_CPUTopology.m_szSource,
+		(unsigned int)vCPUs.size(), g_CPUTopology.m_uiCores, g_CPUTopology.m_uiPackages, g_CPUTopology.m_uiNodes);
+
+	PlacementPolicies aePolicies[TR_COUNT] = { PP_NONE, PP_NONE, PP_NONE, PP_NONE };
+	bool bParsed = ParsePlacementConfig(a_szConfig, aePolicies);
+	for (int iRole = 0; iRole < TR_COUNT; ++iRole)
+	{
+		g_aePlacementPolicies[iRole] = bParsed ? aePolicies[iRole] : PP_NONE;
+	}
+
+	if (!bParsed)
+		Log("Warning: Could not read thread placement \"%s\", expected role=policy,... with roles main, render, job, loader and policies none, compact, spread\n",
+			a_szConfig.c_str());
+	return bParsed;
+}
+
+
+void PlaceThread(ThreadRoles a_eRole, const char* a_szName)
+{
+	PlacedThread* pThread = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(g_PlacementLock);
+		for (auto& thread : g_dPlacedThreads)
+		{
+			if (thread.m_szName == a_szName)
+				pThread = &thread;
+		}
+
+		if (pThread == nullptr)
+		{
+			g_dPlacedThreads.push_back(PlacedThread());
+			pThread = &g_dPlacedThreads.back();
+			pThread->m_szName = a_szName;
+			pThread->m_iCPU = c_iNoCPU;
+			pThread->m_ullSamples = 0;
+			pThread->m_ullMigrations = 0;
+			pThread->m_ullNodeMigrations = 0;
+
+			// the least used CPU, the first in the policy's order if there are several:
+			PlacementPolicies ePolicy = g_aePlacementPolicies[a_eRole];
+			unsigned int uiBestThreads = 0xFFFFFFFF;
+			for (unsigned int uiIndex : g_avPlacementOrders[ePolicy])
+			{
+				if (ePolicy == PP_NONE)
+					break;
+
+				int iCPU = (int)g_CPUTopology.m_vCPUs[uiIndex].m_uiCPU;
+				unsigned int uiThreads = (unsigned int)std::count_if(g_dPlacedThreads.begin(), g_dPlacedThreads.end(),
+					[iCPU] (const PlacedThread& a_rThread) { return a_rThread.m_iCPU == iCPU; });
+				if (uiThreads < uiBestThreads)
+				{
+					uiBestThreads = uiThreads;
+					pThread->m_iCPU = iCPU;
+				}
+			}
+		}
+
+		pThread->m_eRole = a_eRole;
+		pThread->m_iLastCPU = c_iNoCPU;	// a restarted thread starts wherever the OS put it, that is not a migration.
+		if (pThread->m_iCPU != c_iNoCPU && !PinCurrentThread((unsigned int)pThread->m_iCPU))
+		{
+			Log("Warning: Could not pin thread %s to CPU %d\n", a_szName, pThread->m_iCPU);
+			pThread->m_iCPU = c_iNoCPU;
+		}
+	}
+
+	t_pPlacedThread = pThread;
+	if (pThread->m_iCPU != c_iNoCPU)
+		Log("Pinned %s thread %s to CPU %d on node %d\n", c_aszThreadRoleNames[a_eRole], a_szName, pThread->m_iCPU, GetCPUNode(pThread->m_iCPU));
+
+	SampleThreadPlacement();
+}
+
+
+void SampleThreadPlacement()
+{
+	PlacedThread* pThread = t_pPlacedThread;
+	if (pThread == nullptr)
+		return;
+
+	int iCPU = GetCurrentCPU();
+	if (iCPU == c_iNoCPU)
+		return;
+
+	++pThread->m_ullSamples;
+	if (pThread->m_iLastCPU != c_iNoCPU && iCPU != pThread->m_iLastCPU)
+	{
+		++pThread->m_ullMigrations;
+		if (GetCPUNode(iCPU) != GetCPUNode(pThread->m_iLastCPU))
+			++pThread->m_ullNodeMigrations;
+	}
+	pThread->m_iLastCPU = iCPU;
+}
+
+
+int GetCurrentCPU()
+{
+#ifdef _WIN32
+	return (int)GetCurrentProcessorNumber();
+#elif defined(__linux__)
+	return sched_getcpu();
+#else
+	return c_iNoCPU;
+#endif
+}
+
+
+const CPUTopology& GetCPUTopology()
+{
+	return g_CPUTopology;
+}
+
+
+const char* GetThreadRoleName(ThreadRoles a_eRole)
+{
+	return a_eRole < TR_COUNT ? c_aszThreadRoleNames[a_eRole] : "unknown";
+}
+
+
+const char* GetPlacementPolicyName(PlacementPolicies a_ePolicy)
+{
+	return a_ePolicy < PP_COUNT ? c_aszPlacementPolicyNames[a_ePolicy] : "unknown";
+}
+
+
+void PrintThreadPlacement()
+{
+	std::lock_guard<std::mutex> lock(g_PlacementLock);
+	if (g_dPlacedThreads.empty())
+		return;
+
+	printf("Thread placement, %u CPUs, %u cores, %u packages and %u NUMA nodes from %s:\n", (unsigned int)g_CPUTopology.m_vCPUs.size(),
+		g_CPUTopology.m_uiCores, g_CPUTopology.m_uiPackages, g_CPUTopology.m_uiNodes, g_CPUTopology.m_szSource);
+	printf("%20s %8s %8s %6s %6s %10s %12s %16s\n", "Thread", "Role", "Policy", "CPU", "Node", "Samples", "Migrations", "Node migrations");
+	for (auto& thread : g_dPlacedThreads)
+	{
+		std::string szCPU = thread.m_iCPU != c_iNoCPU ? std::to_string(thread.m_iCPU) : "-";
+		std::string szNode = thread.m_iCPU != c_iNoCPU ? std::to_string(GetCPUNode(thread.m_iCPU)) : "-";
+		printf("%20s %8s %8s %6s %6s %10llu %12llu %16llu\n", thread.m_szName.c_str(), c_aszThreadRoleNames[thread.m_eRole],
+			c_aszPlacementPolicyNames[g_aePlacementPolicies[thread.m_eRole]], szCPU.c_str(), szNode.c_str(), thread.m_ullSamples,
+			thread.m_ullMigrations, thread.m_ullNodeMigrations);
+	}
+}
@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////
+/// @file		ThreadPlacement.h
+/// @details	Pins the demo's threads to CPUs by role. The cores, their SMT
+///				siblings and NUMA nodes are read from sysfs on Linux and from
+///				GetLogicalProcessorInformation() on Windows. Each role (main,
+///				render, job and loader threads) has a policy:
+///				* none		the OS decides, the default.
+///				* compact	fills one node before the next, and every core of a
+///							node before any SMT sibling.
+///				* spread	one thread per core, taking the nodes in turn.
+///				A thread is given the least used CPU in its policy's order, so
+///				the roles share the machine instead of piling onto CPU 0.
+///				Every placed thread, pinned or not, counts how often it is
+///				found on a different CPU (and node) than last time it looked,
+///				so placements can be compared on the same machine.
+///				Windows with more than 64 logical CPUs only use the first
+///				processor group.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _THREADPLACEMENT_H_
+#define _THREADPLACEMENT_H_
+
+#include <string>
+#include <vector>
+
+const int c_iNoCPU = -1;	// a thread that is not pinned, or a platform that cannot say which CPU it is on.
+
+enum ThreadRoles
+{
+	TR_MAIN = 0,
+	TR_RENDER,			// render scheduler threads and the threaded loop's second thread.
+	TR_JOB,				// job system workers.
+	TR_LOADER,			// the resource loader's upload thread.
+
+	TR_COUNT,
+};
+
+enum PlacementPolicies
+{
+	PP_NONE = 0,
+	PP_COMPACT,
+	PP_SPREAD,
+
+	PP_COUNT,
+};
+
+struct LogicalCPU
+{
+	unsigned int	m_uiCPU;		// the OS's number for it, what affinity masks use.
+	unsigned int	m_uiCore;		// physical core, numbered across the whole machine.
+	unsigned int	m_uiPackage;	// socket.
+	unsigned int	m_uiNode;		// NUMA node.
+	unsigned int	m_uiSMTIndex;	// 0 for the first logical CPU of its core, 1 for its sibling and so on.
+};
+
+struct CPUTopology
+{
+	std::vector<LogicalCPU>	m_vCPUs;		// only the CPUs this process may run on, by m_uiCPU.
+	unsigned int			m_uiCores;
+	unsigned int			m_uiPackages;
+	unsigned int			m_uiNodes;
+	const char*				m_szSource;		// where it came from, for the log.
+};
+
+/// Finds the topology and reads a_szConfig, a comma separated list of role=policy (main, render, job, loader and
+/// none, compact, spread). A policy on its own applies to every role. Call on the main thread before any thread is
+/// placed. Returns false if the config could not be read, every role is left at none then.
+bool InitThreadPlacement(const std::string& a_szConfig);
+
+/// Pins the calling thread by its role's policy and starts counting its migrations. A thread placed under a name
+/// an earlier thread had (a render thread after the scheduler restarts, say) gets the same CPU and carries on its counts.
+void PlaceThread(ThreadRoles a_eRole, const char* a_szName);
+
+/// Counts a migration if the calling thread is on another CPU than when it last looked. Cheap enough for every frame,
+/// does nothing on a thread that was never placed.
+void SampleThreadPlacement();
+
+/// The CPU the calling thread is running on right now.
+int GetCurrentCPU();
+
+const CPUTopology& GetCPUTopology();
+const char* GetThreadRoleName(ThreadRoles a_eRole);
+const char* GetPlacementPolicyName(PlacementPolicies a_ePolicy);
+
+/// Every placed thread's CPU, node and migrations. Only once the threads it lists have stopped.
+void PrintThreadPlacement();
+
+#endif // _THREADPLACEMENT_H_
@@ -1,44 +1,136 @@
 // Note that the following includes must be defined in order:
-#include "GL\glew.h"
-#include "GLFW\glfw3.h"
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
 #include "ThreadingDemo.h"
+#include "RenderScheduler.h"
+#include "ContextRegistry.h"
+#include "ShaderReflection.h"
+#include "HeadlessGL.h"
+#include "FrameTiming.h"
+#include "StreamBuffer.h"
+#include "JobSystem.h"
+#include "SceneUpdate.h"
+#include "ResourceLoader.h"
+#include "ProgramCache.h"
+#include "GLStateCache.h"
+#include "RenderQueue.h"
+#include "ContextObjectRegistry.h"
+#include "WindowManager.h"
+#include "MultiViewTarget.h"
+#include "PresentQueue.h"
+#include "FrameSnapshot.h"
+#include "GPUTimer.h"
+#include "TextureGen.h"
+#include "Logger.h"
+#include "GLEWContextCache.h"
+#include "CommandList.h"
+#include "SharedResource.h"
+#include "SyncPrimitives.h"
+#include "ThreadPlacement.h"
 
 // Note the the following Includes do not need to be defined in order:
 #include <cstdio>
-#include <map>
-#include <list>
 #include <thread>
 #include <future>
 #include <atomic>
-#include "glm\glm.hpp"
-#include "glm\ext.hpp"
+#include <mutex>
+#include <condition_variable>
+#include "glm/glm.hpp"
+#include "glm/ext.hpp"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
 
 // info: http://www.baptiste-wicht.com/2012/04/c11-concurrency-tutorial-advanced-locking-and-condition-variables/
 //////////////////////// global Vars //////////////////////////////
 unsigned int	g_uiWindowCounter = 0;							// used to set window IDs
 
-std::list<WindowHandle>					g_lWindows;
-std::map<unsigned int, unsigned int>	g_mVAOs;
-std::map<std::thread::id, WindowHandle> g_mCurrentContextMap;	// store current contex per thread!
+WindowManager g_Windows;						// every window's data, in slots. The loader's window is not one of the open windows.
+std::vector<WindowHandle> g_vClosedWindows;		// closed this frame, see DestroyClosedWindows().
+
+ContextObjectRegistry g_ContextObjects;			// every context's VAOs, built the first time each window draws.
+ContextObjectID g_uiQuadVAO = c_uiInvalidContextObject;
+ContextObjectID g_uiInstancedQuadVAO = c_uiInvalidContextObject;	// the same quad plus one InstanceData per instance.
 
 WindowHandle g_hPrimaryWindow = nullptr;
 WindowHandle g_hSecondaryWindow = nullptr;
+WindowHandle g_hLoaderWindow = nullptr;			// hidden, its context belongs to the loader thread.
 
-unsigned int g_VBO = 0;
-unsigned int g_IBO = 0;
-unsigned int g_Texture = 0;
+ResourceLoader g_ResourceLoader;
+ResourceHandle g_hQuadVertices;					// the quad and its texture stream in on the loader thread,
+ResourceHandle g_hQuadIndices;					// nothing is drawn until they are ready.
+ResourceHandle g_hCheckerTexture;
 unsigned int g_Shader = 0;
-glm::mat4	g_ModelMatrix;
+unsigned int g_CameraUBO = 0;					// one CameraBlock per window, shared by all contexts.
+unsigned int g_uiCameraBlockStride = 0;			// sizeof(CameraBlock) rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+ProgramReflection g_ShaderReflection;
+GLint g_iModelUniform = -1;
+unsigned int g_InstancedShader = 0;
+unsigned int g_InstanceVBO = 0;
+GLint g_iInstancedModelUniform = -1;
+unsigned int g_uiInstanceCount = 0;				// -instances N, 0 draws the single quad without instancing.
+std::vector<InstanceData> g_vInstances;			// CPU copy, the per object benchmark draws from it.
+bool g_bStreamInstances = false;				// -stream, animate the instances every frame through each windows StreamBuffer.
+FrameSnapshotBuffer g_FrameSnapshots;			// the main thread simulates frame N+1 into one while the windows draw frame N.
 
 std::thread *g_tpWin2 = nullptr;
-std::mutex g_RenderLock;
 GLsync g_MainThreadFenceSync;
 GLsync g_SecondThreadFenceSync;
 std::atomic_bool g_bShouldClose;
 std::atomic_bool g_bDoWork;
 
-std::map<unsigned int, FPSData*> m_mFPSData;
+RenderScheduler g_RenderScheduler;
+unsigned int g_uiRequestedWindows = c_uiDefaultWindowCount;	// -windows N
+unsigned int g_uiRenderThreads = 0;							// -threads N, 0 = one per hardware thread.
+RunModes g_eRunMode = RM_POOLED;
+std::string g_szFrameTimingFile;							// -timings file, written at ShutDown().
+std::string g_szGPUTimelineFile;							// -timeline file, each window's pass timeline written at ShutDown().
+std::string g_szThreadPlacement = "none";					// -placement config, see ThreadPlacement.h.
+bool g_bGPUTimerQueries = true;								// -cputimers times the passes with CPU timestamps only.
+
+JobSystem g_JobSystem;
+SimulatedScene g_SimulatedScene;							// the game work, updated on g_JobSystem every frame.
+unsigned int g_uiJobThreads = 0;							// -jobthreads N including the thread that waits, 0 = one per hardware thread.
+unsigned int g_uiSceneObjects = c_uiDefaultSceneObjectCount;	// -objects N
+
+bool g_bGLStateCache = true;								// -nostatecache makes every redundant bind anyway, to compare.
+bool g_bPrintStats = false;									// -stats prints each window's counters on exit.
+
+ProgramCache g_ProgramCache;								// linked programs are kept on disk between runs, -nocache turns it off.
+GLEWContextCache g_GLEWContextCache;						// only the first context of each kind runs glewInit(), -noglewcache turns it off.
+
+bool g_bMultiView = false;									// -multiview, MainLoop() draws every window's view in one pass.
+MultiViewTarget g_MultiViewTarget;							// a layer per view, drawn on the primary context and blitted by each window.
+unsigned int g_MultiViewShader = 0;
+unsigned int g_MultiViewInstancedShader = 0;
+unsigned int g_MultiViewUBO = 0;							// one MultiViewCameraBlock, only the primary context writes it.
+GLint g_iMultiViewModelUniform = -1;
+GLint g_iMultiViewInstancedModelUniform = -1;
+ContextObjectID g_uiFrameQuery = c_uiInvalidContextObject;			// GL_TIME_ELAPSED queries for -multiviewbench,
+ContextObjectID g_uiMultiViewPassQuery = c_uiInvalidContextObject;	// queries are not shared either.
+
+bool g_bPresentThreads = false;								// -presentthreads, MainLoop() swaps each window on its own thread.
+PresentQueue g_PresentQueue;
+std::vector<int> g_viSwapIntervals;							// -swapinterval a,b,... by window ID, the last one repeats. Empty leaves the driver's.
+double g_dRefreshPeriod = 1.0 / c_dDefaultRefreshRate;		// of the primary monitor, to count missed vertical blanks.
+
+unsigned int g_uiTextureBenchmarkSize = c_uiDefaultTextureBenchmarkSize;	// -texturesize N
+
+unsigned int g_uiReplayList = 0;							// -loop deferred, which of each window's command lists the render threads replay.
+
+SharedResource g_SharedInstances;							// -sharedstress, rewritten every frame by the writer thread while every window draws them.
+SharedResource g_SharedTexture;
+ContextObjectID g_uiSharedQuadVAO = c_uiInvalidContextObject;	// the instanced quad, pointed at whichever copy of the instances is drawn.
+std::mutex g_SharedWriterLock;
+std::condition_variable g_SharedWriterWake;
+unsigned long long g_ullSharedWriterFrames = 0;				// frames the writer has been asked to update for, guarded by g_SharedWriterLock.
+bool g_bSharedWriterQuit = false;
+
+bool g_bAsyncLog = true;									// -synclog prints every message on the thread that logs it, to compare.
 
 //////////////////////// Function Declerations //////////////////////////////
 Quad CreateQuad();
@@ -47,31 +139,95 @@ int Init();
 int MainLoop();
 int MainLoopBAD();
 int MainLoopTHREADED();
+int MainLoopPOOLED();
+int MainLoopDEFERRED();
+int RunSchedulerBenchmark();
+int RunDispatchBenchmark();
+int RunInstanceBenchmark();
+int RunJobBenchmark();
+int RunRegistryBenchmark();
+int RunWindowStressTest();
+int RunMultiViewBenchmark();
+int RunPresentBenchmark();
+int RunTextureBenchmark();
+int RunStartupBenchmark();
+int RunSharedStressTest();
+int RunSyncBenchmark();
 void ChildLoop(WindowHandle a_toWindow);
 void Render(WindowHandle a_toWindow);
+void DrawScene(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame);
+void DrawScenePerObject(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame);
+void DrawSceneMultiView(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame);
+unsigned int RenderMultiView(const std::vector<WindowHandle>& a_vWindows, const FrameSnapshot& a_rFrame);
+void RenderWindowsSequential();
+JobHandle RecordCommandLists(const FrameSnapshot& a_rFrame);
+void RecordCommandList(WindowHandle a_hWindowHandle, CommandList& a_rList, const FrameSnapshot& a_rFrame);
+void ReplayCommandList(WindowHandle a_hWindowHandle);
+void StreamInstances(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame);
 int ShutDown();
 
 void GLFWErrorCallback(int a_iError, const char* a_szDiscription);
 void GLFWWindowSizeCallback(GLFWwindow* a_pWindow, int a_iWidth, int a_iHeight);
+void GLFWKeyCallback(GLFWwindow* a_pWindow, int a_iKey, int a_iScanCode, int a_iAction, int a_iMods);
 void APIENTRY GLErrorCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, void* userParam);
-GLEWContext* glewGetContext();   // This needs to be defined for GLEW MX to work, along with the GLEW_MX define in the perprocessor!
-void CalcFPS(WindowHandle a_hWindowHandle);
+GLEWContext* glewGetContext();   // This needs to be defined for GLEW MX to work, along with the GLEW_MX define in the perprocessor! (also declared in ContextRegistry.h)
+void SwapBuffers(WindowHandle a_hWindowHandle);
+void AcquireWindow(WindowHandle a_hWindowHandle);
+void PresentWindow(WindowHandle a_hWindowHandle);
+void SetSwapInterval(WindowHandle a_hWindowHandle, int a_iInterval);
+int GetRequestedSwapInterval(unsigned int a_uiWindowID);
+void WaitForRenderTurn(WindowHandle a_hWindowHandle, WindowHandle a_hOther, unsigned long long a_ullFrame);
+void ParseCommandLine(int argc, char* argv[]);
 
 WindowHandle  CreateWindow(int a_iWidth, int a_iHeight, const std::string& a_szTitle, GLFWmonitor* a_pMonitor, WindowHandle a_hShare);
+void SetupWindow(WindowHandle a_hWindowHandle);
+void DestroyWindow(WindowHandle a_hWindowHandle);
+void DestroyClosedWindows();
+void BuildQuadVertexArray(GLuint a_uiVertexArray, bool a_bInstanced);
+bool IsQuadReady();
+void LoadSceneResources();
+void WaitForSceneResources();
+GLuint CreateShaderProgram(const char* a_szVertexShader, const char* a_szPixelShader, const char* a_szGeometryShader = nullptr, const std::string& a_szDefines = "");
+void InitMultiView();
+void TimeMultiViewFrames(bool a_bMultiView, bool a_bGPUTimes, double& a_rdCPUSeconds, double& a_rdGPUSeconds);
+void TimePresentFrames(bool a_bPresentThreads, double& a_rdFPS, double& a_rdPresentP50, double& a_rdPresentP99, unsigned long long& a_rullMissed);
+double TimeTextureGeneration(const TextureDesc& a_rDesc, unsigned char* a_pTexels, JobSystem* a_pJobSystem);
+unsigned int TimeWindowStartup(unsigned int a_uiCount, bool a_bGLEWContextCache, double& a_rdOpenSeconds, double& a_rdGLEWSeconds);
+void TimeSharedStress(WindowHandle a_hWriterWindow, unsigned int a_uiCopies, double& a_rdFPS, double& a_rdUpdatesPerSecond,
+	SharedResourceStats& a_rInstanceStats, SharedResourceStats& a_rTextureStats);
+void SharedWriterLoop(WindowHandle a_hWriterWindow);
+void MakeSharedStressData(float a_fTime, std::vector<InstanceData>& a_rvInstances, std::vector<unsigned char>& a_rvTexels);
+void RenderSharedStress(WindowHandle a_hWindowHandle);
+void UploadInstances(unsigned int a_uiCount);
+void UpdateCameraBlock(WindowHandle a_hWindowHandle);
+bool ApplyPendingSize(WindowHandle a_hWindowHandle);
 void MakeContextCurrent(WindowHandle a_hWindowHandle);
+void StartRenderScheduler();
+void StopRenderScheduler();
+void SetSecondaryWindowDrawn(bool a_bDrawn);
+JobHandle StartFrameWork(SimulatedScene& a_rScene, float a_fTime);
+void BeginFrameSnapshot(float a_fTime);
+void PublishFrameSnapshot();
+void RecordFrameLatency(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame);
+void FinishFrameWork(const JobHandle& a_hWork);
 bool ShouldClose();
 
 
 //////////////////////// Function Definitions //////////////////////////////
-int main()
+int main(int argc, char* argv[])
 {
 	int iReturnCode =EC_NO_ERROR;
 
+	ParseCommandLine(argc, argv);
+
 	iReturnCode = Init();
 	if (iReturnCode != EC_NO_ERROR)
 		return iReturnCode;
 
-	// use this to simulate 3ms of work per window.
+	// the benchmarks print their tables straight to the console, start up's messages should come first:
+	FlushLog();
+
+	// update the simulated scene on the job system alongside rendering, see SceneUpdate.h.
 	g_bDoWork = true;
 
 	/* Use the following loop to have this demo run like the
@@ -87,7 +243,88 @@ int main()
 	/* This loop is a working/stable example of how to render from multipul threads. 
 	Notice that this does NOT render from both threads at the same time. 
 	*/
-	iReturnCode = MainLoopTHREADED();
+	//iReturnCode = MainLoopTHREADED();
+
+	/* This loop records each window's draws into a command list on the job system, with no context
+	current, while the render threads replay the lists recorded the frame before. Only the render
+	threads make GL calls, each on the contexts it owns, so no lock is needed.
+	Use -loop deferred to run it. */
+	//iReturnCode = MainLoopDEFERRED();
+
+	/* This loop hands every window to a pool of render threads, each window's context stays 
+	current on the thread that owns it and all windows render at the same time. 
+	Use -windows N to open more windows and -threads N to set the pool size.
+	Use -benchmark to measure aggregate FPS as the window count grows.
+	Use -instances N to draw N quads with one instanced draw call per window, and
+	-instancebench to compare that with one draw call per quad. 
+	Use -jobthreads N and -objects N to size the per frame scene update, and -jobbench to see how it scales.
+	Use -registrybench to compare the per context VAO lookup with the std::map it replaced.
+	Use -windowstress to open and close hundreds of windows through the window manager.
+	Use -multiview with the sequential loop to draw every window's view in one pass, and
+	-multiviewbench to compare that with drawing each window on its own.
+	Use -presentthreads with the sequential loop to swap each window on its own thread, so the windows
+	share a vertical blank instead of waiting for one each, and -presentbench to compare the two.
+	Use -texturebench to time generating and uploading a large procedural texture in each format, -texturesize N sets its size.
+	Use -startupbench to time opening windows with and without the GLEW context cache.
+	Use -sharedstress to rewrite a shared buffer and texture on another thread every frame while every window draws them.
+	Use -placement role=policy,... to pin the main, render, job and loader threads to CPUs (none, compact or spread).
+	Use -syncbench to compare the frame rate and CPU use of the pooled loop when its threads spin, park or spin then park.
+	Use -loop sequential|naive|threaded|pooled|deferred to pick one of the loops above at run time,
+	this is how the loops are compared with the headless backend (see HeadlessGL.h). */
+	switch (g_eRunMode)
+	{
+	case RM_SEQUENTIAL:
+		iReturnCode = MainLoop();
+		break;
+	case RM_NAIVE:
+		iReturnCode = MainLoopBAD();
+		break;
+	case RM_THREADED:
+		iReturnCode = MainLoopTHREADED();
+		break;
+	case RM_DEFERRED:
+		iReturnCode = MainLoopDEFERRED();
+		break;
+	case RM_SCHEDULER_BENCHMARK:
+		iReturnCode = RunSchedulerBenchmark();
+		break;
+	case RM_DISPATCH_BENCHMARK:
+		iReturnCode = RunDispatchBenchmark();
+		break;
+	case RM_INSTANCE_BENCHMARK:
+		iReturnCode = RunInstanceBenchmark();
+		break;
+	case RM_JOB_BENCHMARK:
+		iReturnCode = RunJobBenchmark();
+		break;
+	case RM_REGISTRY_BENCHMARK:
+		iReturnCode = RunRegistryBenchmark();
+		break;
+	case RM_WINDOW_STRESS:
+		iReturnCode = RunWindowStressTest();
+		break;
+	case RM_MULTIVIEW_BENCHMARK:
+		iReturnCode = RunMultiViewBenchmark();
+		break;
+	case RM_PRESENT_BENCHMARK:
+		iReturnCode = RunPresentBenchmark();
+		break;
+	case RM_TEXTURE_BENCHMARK:
+		iReturnCode = RunTextureBenchmark();
+		break;
+	case RM_STARTUP_BENCHMARK:
+		iReturnCode = RunStartupBenchmark();
+		break;
+	case RM_SHARED_STRESS:
+		iReturnCode = RunSharedStressTest();
+		break;
+	case RM_SYNC_BENCHMARK:
+		iReturnCode = RunSyncBenchmark();
+		break;
+	default:
+		iReturnCode = MainLoopPOOLED();
+		break;
+	}
 
 
 	if (iReturnCode != EC_NO_ERROR)
@@ -103,6 +340,15 @@ int main()
 
 int Init()
 {
+	// everything printed from here on is written by the logger's thread, unless -synclog was given:
+	if (g_bAsyncLog)
+		StartLogger();
+	g_ProgramCache.SetMessageFunc(&Log);	// it knows nothing of the logger, so it prints unless told otherwise.
+
+	// before any of our threads start, so each is pinned as it starts (see ThreadPlacement.h):
+	InitThreadPlacement(g_szThreadPlacement);
+	PlaceThread(TR_MAIN, "Main");
+
 	// Setup Our GLFW error callback, we do this before Init so we know what goes wrong with init if it fails:
 	glfwSetErrorCallback(GLFWErrorCallback);
 
@@ -110,6 +356,12 @@ int Init()
 	if (!glfwInit())
 		return EC_GLFW_INIT_FAIL;
 
+	// missed vertical blanks are counted against the primary monitor, some drivers report 0 Hz:
+	GLFWmonitor* pMonitor = glfwGetPrimaryMonitor();
+	const GLFWvidmode* pMode = pMonitor != nullptr ? glfwGetVideoMode(pMonitor) : nullptr;
+	if (pMode != nullptr && pMode->refreshRate > 0)
+		g_dRefreshPeriod = 1.0 / pMode->refreshRate;
+
 	// create our first window:
 	g_hPrimaryWindow = CreateWindow(c_iDefaultScreenWidth, c_iDefaultScreenHeight, c_szDefaultPrimaryWindowTitle, nullptr, nullptr);
 	
@@ -123,223 +375,430 @@ int Init()
 	int iOpenGLMajor = glfwGetWindowAttrib(g_hPrimaryWindow->m_pWindow, GLFW_CONTEXT_VERSION_MAJOR);
 	int iOpenGLMinor = glfwGetWindowAttrib(g_hPrimaryWindow->m_pWindow, GLFW_CONTEXT_VERSION_MINOR);
 	int iOpenGLRevision = glfwGetWindowAttrib(g_hPrimaryWindow->m_pWindow, GLFW_CONTEXT_REVISION);
-	printf("Status: Using GLFW Version %s\n", glfwGetVersionString());
-	printf("Status: Using OpenGL Version: %i.%i, Revision: %i\n", iOpenGLMajor, iOpenGLMinor, iOpenGLRevision);
-	printf("Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
+	Log("Status: Using GLFW Version %s\n", glfwGetVersionString());
+	Log("Status: Using OpenGL Version: %i.%i, Revision: %i\n", iOpenGLMajor, iOpenGLMinor, iOpenGLRevision);
+	Log("Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
 
 	// create our second window:
 	g_hSecondaryWindow = CreateWindow(c_iDefaultScreenWidth, c_iDefaultScreenHeight, c_szDefaultSecondaryWindowTitle, nullptr, g_hPrimaryWindow);
+
+	// and any extra windows asked for on the command line:
+	while (g_eRunMode != RM_SCHEDULER_BENCHMARK && g_Windows.GetOpenCount() < g_uiRequestedWindows)
+	{
+		std::string szTitle = std::string(c_szDefaultWindowTitle) + " " + std::to_string(g_uiWindowCounter);
+		if (CreateWindow(c_iDefaultScreenWidth, c_iDefaultScreenHeight, szTitle, nullptr, g_hPrimaryWindow) == nullptr)
+			break;
+	}
 	
+	// and a hidden one for the loader thread, it shares with the rest but is never drawn:
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	g_hLoaderWindow = CreateWindow(c_iDefaultScreenWidth / 4, c_iDefaultScreenHeight / 4, c_szLoaderWindowTitle, nullptr, g_hPrimaryWindow);
+	glfwDefaultWindowHints();
+	if (g_hLoaderWindow != nullptr)
+		g_Windows.Remove(g_hLoaderWindow);
+
+	// the job system generates the loader's data, so it has to be running first:
+	g_JobSystem.Start(g_uiJobThreads != 0 ? g_uiJobThreads - 1 : JobSystem::GetDefaultWorkerCount());
+	CreateSimulatedScene(g_SimulatedScene, g_uiSceneObjects);
+	Log("Status: Job system running %u workers, updating %u objects per frame\n", g_JobSystem.GetWorkerCount(), g_uiSceneObjects);
+
+	// start loading the quad and its texture, the windows will pick them up when they are ready:
+	if (!g_ResourceLoader.Start(g_hLoaderWindow, &g_JobSystem))
+		Log("Error: Could not start the resource loader, nothing will be drawn!\n");
+	LoadSceneResources();
+
 	MakeContextCurrent(g_hPrimaryWindow);
 
-	// start creating our quad data for later use:
-	std::future<Quad> fQuad = std::async(std::launch::async, CreateQuad);
-	glm::vec4 *ptexData = new glm::vec4[256 * 256];
-	std::future<glm::vec4*> ftexData = std::async(std::launch::async, [ptexData] () -> glm::vec4*
-	{
-		for (int i = 0; i < 256 * 256; i += 256)
-		{
-			for (int j = 0; j < 256; ++j)
-			{
-				if (j % 2 == 0)
-					ptexData[i + j] = glm::vec4(0, 0, 0, 1);
-				else
-					ptexData[i + j] = glm::vec4(1, 1, 1, 1);
-			}
-		}
+	// create shaders:
+	g_Shader = CreateShaderProgram(c_szVertexShader, c_szPixelShader);
+	g_InstancedShader = CreateShaderProgram(c_szInstancedVertexShader, c_szPixelShader);
+	if (g_bMultiView || g_eRunMode == RM_MULTIVIEW_BENCHMARK)
+		InitMultiView();
+	g_ProgramCache.PrintReport();
+	g_GLEWContextCache.PrintReport();
+
+	// look up all the uniform/attribute locations now so the render loop never has to:
+	ReflectProgram(g_Shader, g_ShaderReflection);
+	PrintProgramReflection(g_ShaderReflection);
+	g_iModelUniform = g_ShaderReflection.GetUniformLocation("Model");
+	glUniformBlockBinding(g_Shader, g_ShaderReflection.GetUniformBlockIndex("Camera"), c_uiCameraBlockBinding);
+
+	ProgramReflection instancedReflection;
+	ReflectProgram(g_InstancedShader, instancedReflection);
+	g_iInstancedModelUniform = instancedReflection.GetUniformLocation("Model");
+	glUniformBlockBinding(g_InstancedShader, instancedReflection.GetUniformBlockIndex("Camera"), c_uiCameraBlockBinding);
+	g_hPrimaryWindow->m_pGLState->UseProgram(g_InstancedShader);
+	glUniform1i(instancedReflection.GetUniformLocation("diffuseTexture"), 0);
+
+	g_hPrimaryWindow->m_pGLState->UseProgram(g_Shader);
+
+	// create the camera uniform buffer, each window gets its own aligned CameraBlock in it:
+	GLint iUBOAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &iUBOAlignment);
+	if (iUBOAlignment <= 0)
+		iUBOAlignment = 256;
+	g_uiCameraBlockStride = ((sizeof(CameraBlock) + iUBOAlignment - 1) / iUBOAlignment) * iUBOAlignment;
+
+	glGenBuffers(1, &g_CameraUBO);
+	g_hPrimaryWindow->m_pGLState->BindBuffer(GL_UNIFORM_BUFFER, g_CameraUBO);
+	glBufferData(GL_UNIFORM_BUFFER, g_uiCameraBlockStride * c_uiMaxWindowCount, nullptr, GL_DYNAMIC_DRAW);
+
+	// set the texture to use slot 0 in the shader
+	glUniform1i(g_ShaderReflection.GetUniformLocation("diffuseTexture"), 0);
 
-		return ptexData;
-	} );
+	// the per instance buffer for the quad, it is filled by UploadInstances():
+	glGenBuffers(1, &g_InstanceVBO);
+	if (g_uiInstanceCount > 0)
+		UploadInstances(g_uiInstanceCount);
 
-	// create shader:
-	GLint iSuccess = 0;
-	GLchar acLog[256];
-	GLuint vsHandle = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fsHandle = glCreateShader(GL_FRAGMENT_SHADER);
+	// VAOs are not shared, each window builds its own from these the first time it draws the quad:
+	g_uiQuadVAO = g_ContextObjects.Register(COT_VERTEX_ARRAY, [] (GLuint a_uiVertexArray) { BuildQuadVertexArray(a_uiVertexArray, false); });
+	g_uiInstancedQuadVAO = g_ContextObjects.Register(COT_VERTEX_ARRAY, [] (GLuint a_uiVertexArray) { BuildQuadVertexArray(a_uiVertexArray, true); });
 
-	glShaderSource(vsHandle, 1, (const char**)&c_szVertexShader, 0);
-	glCompileShader(vsHandle);
-	glGetShaderiv(vsHandle, GL_COMPILE_STATUS, &iSuccess);
-	glGetShaderInfoLog(vsHandle, sizeof(acLog), 0, acLog);
-	if (iSuccess == GL_FALSE)
+	// Now do window specific stuff for each window:
+	for (auto window : g_Windows.GetOpenWindows())
 	{
-		printf("Error: Failed to compile vertex shader!\n");
-		printf(acLog);
-		printf("\n");
+		SetupWindow(window);
 	}
 
-	glShaderSource(fsHandle, 1, (const char**)&c_szPixelShader, 0);
-	glCompileShader(fsHandle);
-	glGetShaderiv(fsHandle, GL_COMPILE_STATUS, &iSuccess);
-	glGetShaderInfoLog(fsHandle, sizeof(acLog), 0, acLog);
-	if (iSuccess == GL_FALSE)
+	Log("Init completed on thread ID: %s\n", GetLogThreadID());
+
+	return EC_NO_ERROR;
+}
+
+
+GLuint CreateShaderProgram(const char* a_szVertexShader, const char* a_szPixelShader, const char* a_szGeometryShader, const std::string& a_szDefines)
+{
+	return g_ProgramCache.CreateProgram(a_szVertexShader, a_szGeometryShader, a_szPixelShader, a_szDefines, [](GLuint a_uiProgram)
+	{
+		// specify Vertex Attribs:
+		glBindAttribLocation(a_uiProgram, 0, "Position");
+		glBindAttribLocation(a_uiProgram, 1, "UV");
+		glBindAttribLocation(a_uiProgram, 2, "Colour");
+		glBindAttribLocation(a_uiProgram, c_uiInstanceAttribLocation, "InstancePositionScale");	// only used by the instanced shader.
+		glBindFragDataLocation(a_uiProgram, 0, "outColour");
+	});
+}
+
+
+void InitMultiView()
+{
+	// the primary context must be current. The geometry shader's array sizes have to be literals, so they are defined here:
+	std::string szDefines = "#define MAX_VIEWS " + std::to_string(c_uiMaxMultiViews) + "\n"
+		"#define MAX_VIEW_VERTICES " + std::to_string(c_uiMaxMultiViews * 3) + "\n";
+	g_MultiViewShader = CreateShaderProgram(c_szMultiViewVertexShader, c_szPixelShader, c_szMultiViewGeometryShader, szDefines);
+	g_MultiViewInstancedShader = CreateShaderProgram(c_szMultiViewInstancedVertexShader, c_szPixelShader, c_szMultiViewGeometryShader, szDefines);
+
+	GLStateCache* pState = g_hPrimaryWindow->m_pGLState;
+	ProgramReflection reflection;
+	ReflectProgram(g_MultiViewShader, reflection);
+	g_iMultiViewModelUniform = reflection.GetUniformLocation("Model");
+	glUniformBlockBinding(g_MultiViewShader, reflection.GetUniformBlockIndex("MultiViewCamera"), c_uiMultiViewCameraBlockBinding);
+	pState->UseProgram(g_MultiViewShader);
+	glUniform1i(reflection.GetUniformLocation("diffuseTexture"), 0);
+
+	ProgramReflection instancedReflection;
+	ReflectProgram(g_MultiViewInstancedShader, instancedReflection);
+	g_iMultiViewInstancedModelUniform = instancedReflection.GetUniformLocation("Model");
+	glUniformBlockBinding(g_MultiViewInstancedShader, instancedReflection.GetUniformBlockIndex("MultiViewCamera"), c_uiMultiViewCameraBlockBinding);
+	pState->UseProgram(g_MultiViewInstancedShader);
+	glUniform1i(instancedReflection.GetUniformLocation("diffuseTexture"), 0);
+
+	glGenBuffers(1, &g_MultiViewUBO);
+	pState->BindBuffer(GL_UNIFORM_BUFFER, g_MultiViewUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(MultiViewCameraBlock), nullptr, GL_DYNAMIC_DRAW);
+
+	// the texture arrays are made on the first pass, once we know how many views there are:
+	g_MultiViewTarget.RegisterFramebuffers(g_ContextObjects);
+	g_uiFrameQuery = g_ContextObjects.Register(COT_QUERY, ContextObjectRegistry::BuildFunc());
+	g_uiMultiViewPassQuery = g_ContextObjects.Register(COT_QUERY, ContextObjectRegistry::BuildFunc());
+}
+
+
+void UploadInstances(unsigned int a_uiCount)
+{
+	// the current context must share with the primary window.
+	if (a_uiCount > c_uiMaxInstanceCount)
+		a_uiCount = c_uiMaxInstanceCount;
+
+	// lay the instances out on a grid that fills the same space no matter how many there are:
+	unsigned int uiSide = 1;
+	while (uiSide * uiSide * uiSide < a_uiCount)
+		++uiSide;
+	float fSpacing = c_fInstanceSceneSize / uiSide;
+	float fScale = fSpacing * 0.2f;		// the quad is 4 units across, this leaves a gap between neighbours.
+	float fOrigin = -c_fInstanceSceneSize * 0.5f + fSpacing * 0.5f;
+
+	g_vInstances.resize(a_uiCount);
+	for (unsigned int i = 0; i < a_uiCount; ++i)
 	{
-		printf("Error: Failed to compile fragment shader!\n");
-		printf(acLog);
-		printf("\n");
+		unsigned int x = i % uiSide;
+		unsigned int y = (i / uiSide) % uiSide;
+		unsigned int z = i / (uiSide * uiSide);
+		g_vInstances[i].m_v4PositionScale = glm::vec4(fOrigin + x * fSpacing, fOrigin + y * fSpacing, fOrigin + z * fSpacing, fScale);
 	}
 
-	g_Shader = glCreateProgram();
-	glAttachShader(g_Shader, vsHandle);
-	glAttachShader(g_Shader, fsHandle);
-	glDeleteShader(vsHandle);
-	glDeleteShader(fsHandle);
+	GLStateCache* pState = GetCurrentContext()->m_pGLState;
+	pState->BindBuffer(GL_ARRAY_BUFFER, g_InstanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, a_uiCount * sizeof(InstanceData), g_vInstances.data(), GL_STATIC_DRAW);
+	pState->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+	g_uiInstanceCount = a_uiCount;
+}
 
-	// specify Vertex Attribs:
-	glBindAttribLocation(g_Shader, 0, "Position");
-	glBindAttribLocation(g_Shader, 1, "UV");
-	glBindAttribLocation(g_Shader, 2, "Colour");
-	glBindFragDataLocation(g_Shader, 0, "outColour");
 
-	glLinkProgram(g_Shader);
-	glGetProgramiv(g_Shader, GL_LINK_STATUS, &iSuccess);
-	glGetProgramInfoLog(g_Shader, sizeof(acLog), 0, acLog);
-	if (iSuccess == GL_FALSE)
+void SetupWindow(WindowHandle a_hWindowHandle)
+{
+	// Window specific stuff, including:
+	// --> Setting Up Projection and View Matricies!
+	// --> Specifing OpenGL Options for the window!
+	// The shared instance buffer/Shader must have been created before this is called.
+	// The VAOs are not made here, g_ContextObjects builds them when the window first draws the quad.
+	WindowHandle hPreviousContext = GetCurrentContext();
+	MakeContextCurrent(a_hWindowHandle);
+	GLStateCache* pState = a_hWindowHandle->m_pGLState;
+
+	// animated instances are written to a ring of frame regions instead, see StreamInstances():
+	if (g_bStreamInstances && g_uiInstanceCount > 0 && a_hWindowHandle->m_pInstanceStream == nullptr)
 	{
-		printf("Error: failed to link Shader Program!\n");
-		printf(acLog);
-		printf("\n");
+		a_hWindowHandle->m_pInstanceStream = new StreamBuffer();
+		if (!a_hWindowHandle->m_pInstanceStream->Create(GL_ARRAY_BUFFER, g_uiInstanceCount * sizeof(InstanceData)))
+		{
+			delete a_hWindowHandle->m_pInstanceStream;
+			a_hWindowHandle->m_pInstanceStream = nullptr;
+		}
+		pState->InvalidateBuffer(GL_ARRAY_BUFFER);	// the stream bound its own.
 	}
 
-	glUseProgram(g_Shader);
+	// Setup Matrix:
+	a_hWindowHandle->m_m4Projection = glm::perspective(45.0f, float(a_hWindowHandle->m_uiWidth)/float(a_hWindowHandle->m_uiHeight), c_fCameraNear, c_fCameraFar);
+	a_hWindowHandle->m_m4ViewMatrix = glm::lookAt(glm::vec3(a_hWindowHandle->m_uiID * 8,8,8), glm::vec3(0,0,0), glm::vec3(0,1,0));
 
-	auto* texData = ftexData.get();
+	// and upload them to this windows slot in the camera UBO, there is one block per window slot so they are never shared:
+	a_hWindowHandle->m_uiCameraOffset = a_hWindowHandle->m_uiSlot * g_uiCameraBlockStride;
+	UpdateCameraBlock(a_hWindowHandle);
 
-	glGenTextures( 1, &g_Texture );
-	glBindTexture( GL_TEXTURE_2D, g_Texture );
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 256, 256, 0, GL_RGBA, GL_FLOAT, texData);
+	// set OpenGL Options:
+	pState->Viewport(0, 0, a_hWindowHandle->m_uiWidth, a_hWindowHandle->m_uiHeight);
+	pState->ClearColour(0.25f,0.25f,0.25f,1);
+	pState->Enable(GL_DEPTH_TEST);
+	pState->Enable(GL_CULL_FACE);
 
-	delete ptexData;
+	// setup frame timing:
+	if (a_hWindowHandle->m_pFrameTiming == nullptr)
+		a_hWindowHandle->m_pFrameTiming = CreateFrameTiming(a_hWindowHandle->m_uiID);
 
-	// specify default filtering and wrapping
-	glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-	glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	MakeContextCurrent(hPreviousContext);
+}
 
-	// set the texture to use slot 0 in the shader
-	GLuint texUniformID = glGetUniformLocation(g_Shader,"diffuseTexture");
-	glUniform1i(texUniformID,0);
 
-	// Create VBO/IBO
-	glGenBuffers(1, &g_VBO);
-	glGenBuffers(1, &g_IBO);
-	glBindBuffer(GL_ARRAY_BUFFER, g_VBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_IBO);
+void BuildQuadVertexArray(GLuint a_uiVertexArray, bool a_bInstanced)
+{
+	// called by g_ContextObjects with the windows context current, and only once the quad is ready. Binding the
+	// buffers here, after the loader's fence has passed, is what makes their contents visible to this context.
+	GLStateCache* pState = GetCurrentContext()->m_pGLState;
+	pState->BindVertexArray(a_uiVertexArray);
+	pState->BindBuffer(GL_ARRAY_BUFFER, g_hQuadVertices->m_uiName);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_hQuadIndices->m_uiName);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), ((char*)0) + 16);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), ((char*)0) + 24);
+
+	if (a_bInstanced)
+	{
+		pState->BindBuffer(GL_ARRAY_BUFFER, g_InstanceVBO);
+		glEnableVertexAttribArray(c_uiInstanceAttribLocation);
+		glVertexAttribPointer(c_uiInstanceAttribLocation, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), 0);
+		glVertexAttribDivisor(c_uiInstanceAttribLocation, 1);
+	}
+
+	pState->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-	// get the quad from the future:
-	Quad temp = fQuad.get();
 
-	glBufferData(GL_ARRAY_BUFFER, temp.c_uiNoOfVerticies * sizeof(Vertex), temp.m_Verticies, GL_STATIC_DRAW);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, temp.c_uiNoOfIndicies * sizeof(unsigned int), temp.m_uiIndicies, GL_STATIC_DRAW);
+bool IsQuadReady()
+{
+	// cheap once it has loaded, before that it polls the loader's fences without waiting:
+	return ResourceLoader::IsReady(g_hQuadVertices) && ResourceLoader::IsReady(g_hQuadIndices);
+}
 
-	// Now do window specific stuff, including:
-	// --> Creating a VAO with the VBO/IBO created above!
-	// --> Setting Up Projection and View Matricies!
-	// --> Specifing OpenGL Options for the window!
-	for (auto window : g_lWindows)
+
+void LoadSceneResources()
+{
+	g_hQuadVertices = g_ResourceLoader.LoadBuffer("quad vertices", [] (std::vector<unsigned char>& a_rvData)
 	{
-		MakeContextCurrent(window);
-		
-		// Setup VAO:
-		g_mVAOs[window->m_uiID] = 0;
-		glGenVertexArrays(1, &(g_mVAOs[window->m_uiID]));
-		glBindVertexArray(g_mVAOs[window->m_uiID]);
-		glBindBuffer(GL_ARRAY_BUFFER, g_VBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_IBO);
-
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), ((char*)0) + 16);
-		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), ((char*)0) + 24);
-
-		// Setup Matrix:
-		window->m_m4Projection = glm::perspective(45.0f, float(window->m_uiWidth)/float(window->m_uiHeight), 0.1f, 1000.0f);
-		window->m_m4ViewMatrix = glm::lookAt(glm::vec3(window->m_uiID * 8,8,8), glm::vec3(0,0,0), glm::vec3(0,1,0));
-
-		// set OpenGL Options:
-		glViewport(0, 0, window->m_uiWidth, window->m_uiHeight);
-		glClearColor(0.25f,0.25f,0.25f,1);
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
-
-		// setup FPS Data
-		FPSData* fpsData = new FPSData();
-		fpsData->m_fFPS = 0;
-		fpsData->m_fTimeBetweenChecks = 3.0f;	// calc fps every 3 seconds!!
-		fpsData->m_fFrameCount = 0;
-		fpsData->m_fTimeElapsed = 0.0f;
-		fpsData->m_fCurrnetRunTime = (float)glfwGetTime();
-		m_mFPSData[window->m_uiID] = fpsData;
-	}
-
-	std::cout << "Init completed on thread ID: " << std::this_thread::get_id() << std::endl;
+		Quad quad = CreateQuad();
+		a_rvData.assign((unsigned char*)quad.m_Verticies, (unsigned char*)(quad.m_Verticies + Quad::c_uiNoOfVerticies));
+	});
 
-	return EC_NO_ERROR;
+	g_hQuadIndices = g_ResourceLoader.LoadBuffer("quad indices", [] (std::vector<unsigned char>& a_rvData)
+	{
+		Quad quad = CreateQuad();
+		a_rvData.assign((unsigned char*)quad.m_uiIndicies, (unsigned char*)(quad.m_uiIndicies + Quad::c_uiNoOfIndicies));
+	});
+
+	// black and white columns one texel wide, two colours need nothing more than RGBA8:
+	TextureDesc checker;
+	checker.m_uiWidth = 256;
+	checker.m_uiHeight = 256;
+	checker.m_eFormat = TF_RGBA8;
+	checker.m_ePattern = TP_CHECKER;
+	checker.m_uiCellWidth = 1;
+	checker.m_uiCellHeight = 256;
+	checker.m_v4ColourA = glm::vec4(0, 0, 0, 1);
+	checker.m_v4ColourB = glm::vec4(1, 1, 1, 1);
+
+	const TextureFormatInfo& format = GetTextureFormatInfo(checker.m_eFormat);
+	g_hCheckerTexture = g_ResourceLoader.LoadTexture2D("checkerboard texture", checker.m_uiWidth, checker.m_uiHeight, format.m_iInternalFormat,
+		format.m_eFormat, format.m_eType, [checker] (std::vector<unsigned char>& a_rvData)
+	{
+		GenerateTexture(checker, a_rvData, &g_JobSystem);
+	});
+}
+
+
+void WaitForSceneResources()
+{
+	// only the benchmarks do this, they should not time a half loaded scene. The current context must share with the loader's.
+	g_ResourceLoader.WaitUntilReady(g_hQuadVertices);
+	g_ResourceLoader.WaitUntilReady(g_hQuadIndices);
+	g_ResourceLoader.WaitUntilReady(g_hCheckerTexture);
+}
+
+
+void UpdateCameraBlock(WindowHandle a_hWindowHandle)
+{
+	// the windows context must be current.
+	CameraBlock block;
+	block.m_m4Projection = a_hWindowHandle->m_m4Projection;
+	block.m_m4View = a_hWindowHandle->m_m4ViewMatrix;
+
+	a_hWindowHandle->m_pGLState->BindBuffer(GL_UNIFORM_BUFFER, g_CameraUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, a_hWindowHandle->m_uiCameraOffset, sizeof(CameraBlock), &block);
+}
+
+
+bool ApplyPendingSize(WindowHandle a_hWindowHandle)
+{
+	// only on the thread drawing the window, the acquire pairs with the release in GLFWWindowSizeCallback():
+	if (!a_hWindowHandle->m_bViewportDirty.exchange(false, std::memory_order_acquire))
+		return false;
+
+	// the size and projection always come from the same callback, however late it ran:
+	std::lock_guard<std::mutex> lock(a_hWindowHandle->m_SizeLock);
+	a_hWindowHandle->m_uiWidth = a_hWindowHandle->m_PendingSize.m_uiWidth;
+	a_hWindowHandle->m_uiHeight = a_hWindowHandle->m_PendingSize.m_uiHeight;
+	a_hWindowHandle->m_m4Projection = a_hWindowHandle->m_PendingSize.m_m4Projection;
+	return true;
 }
 
 
 int MainLoop()
 {
-	std::cout << "Entering main loop on thread ID: " << std::this_thread::get_id() << std::endl;
+	Log("Entering main loop on thread ID: %s\n", GetLogThreadID());
+
+	// the main thread draws every window, -presentthreads moves their swaps off it:
+	if (g_bPresentThreads)
+	{
+		glfwMakeContextCurrent(nullptr);
+		SetCurrentContext(nullptr, nullptr);
+		g_PresentQueue.Start(g_Windows.GetOpenWindows(), g_dRefreshPeriod);
+	}
 
 	while (!ShouldClose())
 	{
 		float fTime = (float)glfwGetTime();   // get time for this iteration
 
-		glm::mat4 identity;
-		g_ModelMatrix = glm::rotate(identity, fTime * 10.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+		// simulate the next frame on the workers while we draw the last one, it is published once both are done:
+		BeginFrameSnapshot(fTime);
+		JobHandle hWork = StartFrameWork(g_SimulatedScene, fTime);
 
-		// simulate work:
-		if (g_bDoWork)
-		{
-			std::chrono::milliseconds dura( 6 );
-			std::this_thread::sleep_for( dura );
-		}
+		RenderWindowsSequential();
 
-		// draw each window in sequence:
-		for (const auto& window : g_lWindows)
-		{
-			MakeContextCurrent(window);
-		
-			// clear the backbuffer to our clear colour and clear the depth buffer
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		FinishFrameWork(hWork);
+		PublishFrameSnapshot();
 
-			glUseProgram(g_Shader);
+		SampleThreadPlacement();
+		glfwPollEvents(); // process events!
+		DestroyClosedWindows();
+	}
 
-			GLuint ProjectionID = glGetUniformLocation(g_Shader,"Projection");
-			GLuint ViewID = glGetUniformLocation(g_Shader,"View");
-			GLuint ModelID = glGetUniformLocation(g_Shader,"Model");
+	// the present threads hand back every context once their last swaps are done:
+	if (g_PresentQueue.IsRunning())
+	{
+		g_PresentQueue.Stop();
+		MakeContextCurrent(g_hPrimaryWindow);
+	}
 
-			glUniformMatrix4fv(ProjectionID, 1, false, glm::value_ptr(window->m_m4Projection));
-			glUniformMatrix4fv(ViewID, 1, false, glm::value_ptr(window->m_m4ViewMatrix));
-			glUniformMatrix4fv(ModelID, 1, false, glm::value_ptr(g_ModelMatrix));
+	Log("Exiting main loop on thread ID: %s\n", GetLogThreadID());
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture( GL_TEXTURE_2D, g_Texture );
-			glBindVertexArray(g_mVAOs[window->m_uiID]);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	return EC_NO_ERROR;
+}
 
-			glfwSwapBuffers(window->m_pWindow);  // make this loop through all current windows??
 
-			// calc FPS:
-			CalcFPS(window);
-		}
+void RenderWindowsSequential()
+{
+	// every window draws the same frame, even if the next one is published part way through:
+	ScopedFrameSnapshot frame(g_FrameSnapshots);
 
-		glfwPollEvents(); // process events!
+	// with -multiview the primary context draws every window's view in one pass, the windows just blit theirs:
+	unsigned int uiViews = 0;
+	double dPassSeconds = 0.0;
+	if (g_bMultiView)
+	{
+		AcquireWindow(g_hPrimaryWindow);
+		double dPassStart = glfwGetTime();
+		uiViews = RenderMultiView(g_Windows.GetOpenWindows(), frame.Get());
+		dPassSeconds = glfwGetTime() - dPassStart;
 	}
 
-	std::cout << "Exiting main loop on thread ID: " << std::this_thread::get_id() << std::endl;
+	// draw each window in sequence:
+	unsigned int uiWindow = 0;
+	for (const auto& window : g_Windows.GetOpenWindows())
+	{
+		AcquireWindow(window);
+		double dCPUStart = glfwGetTime();
 
-	return EC_NO_ERROR;
+		if (ApplyPendingSize(window))
+		{
+			window->m_pGLState->Viewport(0, 0, window->m_uiWidth, window->m_uiHeight);
+			UpdateCameraBlock(window);
+		}
+
+		if (uiWindow < uiViews)
+		{
+			g_MultiViewTarget.Present(window->m_uiContextSlot, uiWindow, window->m_uiWidth, window->m_uiHeight);
+		}
+		else
+		{
+			// clear the backbuffer to our clear colour and clear the depth buffer
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			DrawScene(window, frame.Get());
+		}
+		++uiWindow;
+
+		// the pass is counted against the primary window, it did the drawing:
+		double dCPUSeconds = glfwGetTime() - dCPUStart;
+		if (window == g_hPrimaryWindow)
+			dCPUSeconds += dPassSeconds;
+		RecordFrameTime(window, FT_CPU, dCPUSeconds);
+		RecordFrameLatency(window, frame.Get());
+
+		PresentWindow(window);  // queued on the window's present thread with -presentthreads.
+
+		EndFrameTiming(window);
+	}
 }
 
 
 int MainLoopBAD()
 {
-	std::cout << "Entering main loop on thread ID: " << std::this_thread::get_id() << std::endl;
+	Log("Entering main loop on thread ID: %s\n", GetLogThreadID());
 
 	MakeContextCurrent(g_hPrimaryWindow);
 
@@ -349,24 +808,26 @@ int MainLoopBAD()
 		// get delta time for this iteration:
 		float fDeltaTime = (float)glfwGetTime();
 
-		glm::mat4 identity;
-		g_ModelMatrix = glm::rotate(identity, fDeltaTime * 10.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+		// both windows draw the last frame while we fill in this one:
+		BeginFrameSnapshot(fDeltaTime);
 
 		// render threaded.
 		std::thread renderWindow2(&Render, g_hSecondaryWindow);
 		Render(g_hPrimaryWindow);
 
-		// calc FPS:
-		CalcFPS(g_hSecondaryWindow);
-		CalcFPS(g_hPrimaryWindow);
-
 		// join second render thread
 		renderWindow2.join();
+		PublishFrameSnapshot();
 
+		// frame timings:
+		EndFrameTiming(g_hSecondaryWindow);
+		EndFrameTiming(g_hPrimaryWindow);
+
+		SampleThreadPlacement();
 		glfwPollEvents(); // process events!
 	}
 
-	std::cout << "Exiting main loop on thread ID: " << std::this_thread::get_id() << std::endl;
+	Log("Exiting main loop on thread ID: %s\n", GetLogThreadID());
 
 	return EC_NO_ERROR;
 }
@@ -374,7 +835,7 @@ int MainLoopBAD()
 
 int MainLoopTHREADED()
 {
-	std::cout << "Entering main loop on thread ID: " << std::this_thread::get_id() << std::endl;
+	Log("Entering main loop on thread ID: %s\n", GetLogThreadID());
 
 	// init the sync fece to something so the initial render pass for the main thread wuill work:
 	g_SecondThreadFenceSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
@@ -386,26 +847,30 @@ int MainLoopTHREADED()
 		// get delta time for this iteration:
 		float fDeltaTime = (float)glfwGetTime();
 
-		glm::mat4 identity;
-		g_ModelMatrix = glm::rotate(identity, fDeltaTime * 10.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+		// simulate the next frame on the workers while we draw the last one. The second thread draws whichever
+		// frame is the latest when it starts, it never sees one half written:
+		BeginFrameSnapshot(fDeltaTime);
+		JobHandle hWork = StartFrameWork(g_SimulatedScene, fDeltaTime);
 
-		// simulate work:
-		if (g_bDoWork)
+		// the windows take turns, our frame N goes after the second window's frame N - 1. Its fence is set by then:
+		WaitForRenderTurn(g_hPrimaryWindow, g_hSecondaryWindow, g_hPrimaryWindow->m_pFrameReady->GetFrame());
+		if (g_SecondThreadFenceSync != 0)	// 0 if the second thread has not rendered since we last waited on it.
 		{
-			std::chrono::milliseconds dura( 3 );
-			std::this_thread::sleep_for( dura );
+			glWaitSync(g_SecondThreadFenceSync, 0, GL_TIMEOUT_IGNORED);				// tell the GPU to make sure that the second threads calls are in the pipline before adding ours!
+			glDeleteSync(g_SecondThreadFenceSync);
+			g_SecondThreadFenceSync = 0;
 		}
-
-		g_RenderLock.lock();
-		glWaitSync(g_SecondThreadFenceSync, 0, GL_TIMEOUT_IGNORED);				// tell the GPU to make sure that the second threads calls are in the pipline before adding ours!
-		glDeleteSync(g_SecondThreadFenceSync);
 		Render(g_hPrimaryWindow);
 		g_MainThreadFenceSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);	// setup our fence sync for the other thread to wait on it.
-		g_RenderLock.unlock();
+		g_hPrimaryWindow->m_pFrameReady->Signal();
 
-		// calc FPS:
-		CalcFPS(g_hPrimaryWindow);
+		FinishFrameWork(hWork);
+		PublishFrameSnapshot();
 
+		// frame timings:
+		EndFrameTiming(g_hPrimaryWindow);
+
+		SampleThreadPlacement();
 		glfwPollEvents(); // process events!
 		g_bShouldClose = ShouldClose();  // check if we should close:
 
@@ -416,250 +881,2046 @@ int MainLoopTHREADED()
 		}
 	}
 
-	std::cout << "Exiting main loop on thread ID: " << std::this_thread::get_id() << std::endl;
+	// the second thread may be waiting for a frame we are not going to draw, it sees g_bShouldClose once it is let go:
+	g_hPrimaryWindow->m_pFrameReady->Signal();
+
+	Log("Exiting main loop on thread ID: %s\n", GetLogThreadID());
 
 	return EC_NO_ERROR;
 }
 
 
-void ChildLoop(WindowHandle a_toWindow)
+int MainLoopPOOLED()
 {
-	std::cout << "Starting Secondary Render Thread: " << std::this_thread::get_id() << std::endl;
-	MakeContextCurrent(g_hSecondaryWindow);
+	Log("Entering pooled main loop on thread ID: %s\n", GetLogThreadID());
 
-	while(!g_bShouldClose)
+	StartRenderScheduler();
+
+	while (!ShouldClose())
 	{
-		if (g_MainThreadFenceSync == 0)
-		{
-			continue; // dont start rendering until the main thread has started rendering for the first time.
-		}
+		// get time for this iteration:
+		float fTime = (float)glfwGetTime();
 
-		// simulate work:
-		if (g_bDoWork)
-		{
-			std::chrono::milliseconds dura( 3 );
-			std::this_thread::sleep_for( dura );
-		}
+		// simulate the next frame on the workers while the render threads draw the last one:
+		BeginFrameSnapshot(fTime);
+		JobHandle hWork = StartFrameWork(g_SimulatedScene, fTime);
 
-		g_RenderLock.lock();
-		glWaitSync(g_MainThreadFenceSync, 0, GL_TIMEOUT_IGNORED);		// tell the GPU to make sure that the second threads calls are in the pipline before adding ours!
-		glDeleteSync(g_MainThreadFenceSync);
-		Render(a_toWindow);
-		g_SecondThreadFenceSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);	// setup our fence sync for the other thread to wait on it.
-		g_RenderLock.unlock();
+		// render all windows on the render threads, returns once every window has been drawn:
+		g_RenderScheduler.RenderFrame();
 
-		// calc FPS:
-		CalcFPS(g_hSecondaryWindow);
-	}
-}
+		FinishFrameWork(hWork);
+		PublishFrameSnapshot();
 
+		SampleThreadPlacement();
+		glfwPollEvents(); // process events!
+		DestroyClosedWindows();
+	}
 
-void Render(WindowHandle a_toWindow)
-{
-	MakeContextCurrent(a_toWindow);
-		
-	// clear the backbuffer to our clear colour and clear the depth buffer
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	StopRenderScheduler();
 
-	glUseProgram(g_Shader);
+	Log("Exiting pooled main loop on thread ID: %s\n", GetLogThreadID());
 
-	GLuint ProjectionID = glGetUniformLocation(g_Shader,"Projection");
-	GLuint ViewID = glGetUniformLocation(g_Shader,"View");
-	GLuint ModelID = glGetUniformLocation(g_Shader,"Model");
+	return EC_NO_ERROR;
+}
 
-	glUniformMatrix4fv(ProjectionID, 1, false, glm::value_ptr(a_toWindow->m_m4Projection));
-	glUniformMatrix4fv(ViewID, 1, false, glm::value_ptr(a_toWindow->m_m4ViewMatrix));
-	glUniformMatrix4fv(ModelID, 1, false, glm::value_ptr(g_ModelMatrix));
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture( GL_TEXTURE_2D, g_Texture );
-	glBindVertexArray(g_mVAOs[a_toWindow->m_uiID]);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+int MainLoopDEFERRED()
+{
+	Log("Entering deferred main loop on thread ID: %s\n", GetLogThreadID());
 
-	glfwSwapBuffers(a_toWindow->m_pWindow);  // make this loop through all current windows??
+	// the render threads only replay, see ReplayCommandList():
+	StartRenderScheduler();
 
-	//CheckForGLErrors("Render Error");
-}
+	while (!ShouldClose())
+	{
+		float fTime = (float)glfwGetTime();
 
+		BeginFrameSnapshot(fTime);
+		JobHandle hWork = StartFrameWork(g_SimulatedScene, fTime);
 
-int ShutDown()
-{
-	// join the window2 thread and delete it:
-	if (g_tpWin2 != nullptr)
-	{
-		g_tpWin2->join();
-		delete g_tpWin2;
-	}
-	
-	// delete the FPS data:
-	for (auto itr : m_mFPSData)
-	{
-		delete itr.second;
-	}
+		// record the latest published frame on the workers while the render threads replay what was recorded last frame:
+		JobHandle hRecord;
+		{
+			ScopedFrameSnapshot frame(g_FrameSnapshots);
+			hRecord = RecordCommandLists(frame.Get());
+			g_RenderScheduler.RenderFrame();
+			g_JobSystem.Wait(hRecord);
+		}
+		g_uiReplayList ^= 1;
 
-	// cleanup any remaining windows:
-	for (auto& window :g_lWindows)
-	{
-		delete window->m_pGLEWContext;
-		glfwDestroyWindow(window->m_pWindow);
+		FinishFrameWork(hWork);
+		PublishFrameSnapshot();
 
-		delete window;
+		SampleThreadPlacement();
+		glfwPollEvents(); // process events!
+		DestroyClosedWindows();
 	}
 
-	// terminate GLFW:
-	glfwTerminate();
+	StopRenderScheduler();
+
+	Log("Exiting deferred main loop on thread ID: %s\n", GetLogThreadID());
 
 	return EC_NO_ERROR;
 }
 
 
-GLEWContext* glewGetContext()
+JobHandle RecordCommandLists(const FrameSnapshot& a_rFrame)
 {
-	//return g_hCurrentContext->m_pGLEWContext;
-	std::thread::id thread = std::this_thread::get_id();
-
-	return g_mCurrentContextMap[thread]->m_pGLEWContext;
+	// one job per window, each records into the list the render threads are not replaying:
+	const std::vector<WindowHandle>& vWindows = g_Windows.GetOpenWindows();
+	unsigned int uiRecordList = g_uiReplayList ^ 1;
+	return g_JobSystem.ParallelForAsync((unsigned int)vWindows.size(), [&vWindows, &a_rFrame, uiRecordList] (unsigned int a_uiBegin, unsigned int a_uiEnd)
+	{
+		for (unsigned int i = a_uiBegin; i < a_uiEnd; ++i)
+			RecordCommandList(vWindows[i], *vWindows[i]->m_apCommandLists[uiRecordList], a_rFrame);
+	}, 1);
 }
 
 
-void MakeContextCurrent(WindowHandle a_hWindowHandle)
+void RecordCommandList(WindowHandle a_hWindowHandle, CommandList& a_rList, const FrameSnapshot& a_rFrame)
 {
-	if (a_hWindowHandle != nullptr)
+	// runs on any thread with no context current, so nothing in here may call GL. The same frame as DrawScene() draws:
+	a_rList.Begin(a_rFrame.m_ullFrame, a_rFrame.m_dSampleTime);
+
+	if (ApplyPendingSize(a_hWindowHandle))
 	{
-		std::thread::id thread = std::this_thread::get_id();
+		a_rList.Viewport(0, 0, a_hWindowHandle->m_uiWidth, a_hWindowHandle->m_uiHeight);
 
-		glfwMakeContextCurrent(a_hWindowHandle->m_pWindow);
-		g_mCurrentContextMap[thread] = a_hWindowHandle;
+		CameraBlock block;
+		block.m_m4Projection = a_hWindowHandle->m_m4Projection;
+		block.m_m4View = a_hWindowHandle->m_m4ViewMatrix;
+		a_rList.BufferSubData(GL_UNIFORM_BUFFER, g_CameraUBO, a_hWindowHandle->m_uiCameraOffset, sizeof(CameraBlock), &block);
 	}
-}
 
+	a_rList.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-WindowHandle CreateWindow(int a_iWidth, int a_iHeight, const std::string& a_szTitle, GLFWmonitor* a_pMonitor, WindowHandle a_hShare)
-{
-	// save current active context info so we can restore it later!
-	std::thread::id thread = std::this_thread::get_id();
-	WindowHandle hPreviousContext = g_mCurrentContextMap[thread];
+	// the loader's fences can only be polled with a context, ReplayCommandList() does that and we see the result a frame later:
+	if (ResourceLoader::IsKnownReady(g_hQuadVertices) && ResourceLoader::IsKnownReady(g_hQuadIndices))
+	{
+		a_rList.BindBufferRange(GL_UNIFORM_BUFFER, c_uiCameraBlockBinding, g_CameraUBO, a_hWindowHandle->m_uiCameraOffset, sizeof(CameraBlock));
 
-	// create new window data:
-	WindowHandle newWindow = new Window();
-	if (newWindow == nullptr)
-		return nullptr;
+		DrawPacket packet;
+		packet.m_uiVertexArray = 0;
+		packet.m_uiTexture = ResourceLoader::IsKnownReady(g_hCheckerTexture) ? g_hCheckerTexture->m_uiName : 0;
+		packet.m_iIndexCount = Quad::c_uiNoOfIndicies;
+		packet.m_uiFirstInstance = 0;
 
-	newWindow->m_pGLEWContext = nullptr;
-	newWindow->m_pWindow = nullptr;
-	newWindow->m_uiID = g_uiWindowCounter++;		// set ID and Increment Counter!
-	newWindow->m_uiWidth = a_iWidth;
-	newWindow->m_uiHeight = a_iHeight;
+		if (g_uiInstanceCount > 0)
+		{
+			packet.m_uiProgram = g_InstancedShader;
+			packet.m_iModelUniform = g_iInstancedModelUniform;
+			packet.m_iInstanceCount = g_uiInstanceCount;
+			a_rList.Draw(g_uiInstancedQuadVAO, packet, a_rFrame.m_m4Model, 0, 0.0f);
+		}
+		else
+		{
+			packet.m_uiProgram = g_Shader;
+			packet.m_iModelUniform = g_iModelUniform;
+			packet.m_iInstanceCount = 0;
+			a_rList.Draw(g_uiQuadVAO, packet, a_rFrame.m_m4Model, 0, 0.0f);
+		}
+	}
 
-	// if compiling in debug ask for debug context:
-#ifdef _DEBUG
-	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLU_TRUE);
-#endif
+	a_rList.End();
+}
 
-	std::cout << "Creating window called " << a_szTitle.c_str() << " with ID " << newWindow->m_uiID << std::endl;
 
-	// Create Window:
-	if (a_hShare != nullptr) // Check that the Window Handle passed in is valid.
-	{
-		newWindow->m_pWindow = glfwCreateWindow(a_iWidth, a_iHeight, a_szTitle.c_str(), a_pMonitor, a_hShare->m_pWindow);  // Window handle is valid, Share its GL Context Data!
-	}
-	else
-	{
-		newWindow->m_pWindow = glfwCreateWindow(a_iWidth, a_iHeight, a_szTitle.c_str(), a_pMonitor, nullptr); // Window handle is invlad, do not share!
-	}
-	
-	// Confirm window was created successfully:
-	if (newWindow->m_pWindow == nullptr)
-	{
-		printf("Error: Could not Create GLFW Window!\n");
-		delete newWindow;
-		return nullptr;
-	}
+void ReplayCommandList(WindowHandle a_hWindowHandle)
+{
+	// called on the render thread that owns the window, with its context current:
+	MakeContextCurrent(a_hWindowHandle);
+	double dCPUStart = glfwGetTime();
 
-	// create GLEW Context:
-	newWindow->m_pGLEWContext = new GLEWContext();
-	if (newWindow->m_pGLEWContext == nullptr)
+	// poll the loader's fences for the threads recording, they have no context to do it with:
+	IsQuadReady();
+	ResourceLoader::IsReady(g_hCheckerTexture);
+
+	CommandList* pList = a_hWindowHandle->m_apCommandLists[g_uiReplayList];
+	GPUTimer* pTimer = a_hWindowHandle->m_pGPUTimer;
+	pTimer->BeginFrame();
+
+	// the clear is one of the commands, so the whole list counts as the draw pass:
 	{
-		printf("Error: Could not create GLEW Context!\n");
-		delete newWindow;
-		return nullptr;
+		ScopedGPUTimer scope(*pTimer, GTS_DRAW);
+		pList->Execute(*a_hWindowHandle->m_pGLState, *a_hWindowHandle->m_pRenderQueue, g_ContextObjects, a_hWindowHandle->m_uiContextSlot);
 	}
+	RecordFrameTime(a_hWindowHandle, FT_CPU, glfwGetTime() - dCPUStart);
+	if (pList->GetFrame() > 0)
+		RecordFrameTime(a_hWindowHandle, FT_LATENCY, glfwGetTime() - pList->GetSampleTime());
 
-	glfwMakeContextCurrent(newWindow->m_pWindow);   // Must be done before init of GLEW for this new windows Context!
-	MakeContextCurrent(newWindow);					// and must be made current too :)
-	
-	// Init GLEW for this context:
-	GLenum err = glewInit();
-	if (err != GLEW_OK)
 	{
-		// a problem occured when trying to init glew, report it:
-		printf("GLEW Error occured, Description: %s\n", glewGetErrorString(err));
-		glfwDestroyWindow(newWindow->m_pWindow);
-		delete newWindow;
-		return nullptr;
+		ScopedGPUTimer scope(*pTimer, GTS_SWAP);
+		SwapBuffers(a_hWindowHandle);
 	}
-	
-	// setup callbacks:
-	// setup callback for window size changes:
-	glfwSetWindowSizeCallback(newWindow->m_pWindow, GLFWWindowSizeCallback);
-
-	 // setup openGL Error callback:
-    if (GLEW_ARB_debug_output) // test to make sure we can use the new callbacks, they wer added as an extgension in 4.1 and as a core feture in 4.3
-    {
-            #ifdef _DEBUG
-            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);                        // this allows us to set a break point in the callback function, no point to it if in release mode.
-            #endif
-            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);        // tell openGl what errors we want (all).
-            glDebugMessageCallback(GLErrorCallback, NULL);                        // define the callback function.
-    }
+	pTimer->EndFrame();
+}
 
-	// add new window to the map and increment handle counter:
-	g_lWindows.push_back(newWindow);
 
-	// now restore previous context:
-	MakeContextCurrent(hPreviousContext);
+int RunSchedulerBenchmark()
+{
+	std::cout << "Running render scheduler benchmark, " << c_fBenchmarkRunTime << " seconds per window count" << std::endl;
 
-	return newWindow;
-}
+	// the benchmark wants to measure rendering, not our fake work or the first few frames without the quad:
+	g_bDoWork = false;
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
 
+	printf("\n%8s %8s %12s %12s\n", "Windows", "Threads", "Frames", "Frames/sec");
 
-void CalcFPS(WindowHandle a_hWindowHandle)
-{
-	FPSData* data = m_mFPSData[a_hWindowHandle->m_uiID];
-	if (data != nullptr)
+	for (unsigned int uiWindowCount : c_auiBenchmarkWindowCounts)
 	{
-		data->m_fFrameCount++;
-		data->m_fPreviousRunTime = data->m_fCurrnetRunTime;
-		data->m_fCurrnetRunTime = (float)glfwGetTime();
-		data->m_fTimeElapsed += data->m_fCurrnetRunTime - data->m_fPreviousRunTime;
-		if (data->m_fTimeElapsed >= data->m_fTimeBetweenChecks)
+		if (uiWindowCount > c_uiMaxWindowCount)
+			break;
+
+		// Init() always opens the primary and secondary windows, the secondary one sits out a run with one window:
+		SetSecondaryWindowDrawn(uiWindowCount > 1);
+		if (uiWindowCount < g_Windows.GetOpenCount())
+			continue;	// windows opened for a larger count stay open.
+
+		// windows can only be created on the main thread, so open any new ones we need before starting the pool:
+		bool bCreatedAll = true;
+		while (g_Windows.GetOpenCount() < uiWindowCount)
 		{
-			data->m_fFPS = data->m_fFrameCount / data->m_fTimeElapsed;
-			data->m_fTimeElapsed = 0.0f;
-			data->m_fFrameCount = 0;
-			std::cout << "Thread id: " << std::this_thread::get_id() << "  Window: " <<  a_hWindowHandle->m_uiID << " FPS = " << (int)data->m_fFPS << std::endl;
+			std::string szTitle = std::string(c_szDefaultWindowTitle) + " " + std::to_string(g_uiWindowCounter);
+			WindowHandle hWindow = CreateWindow(c_iDefaultScreenWidth / 4, c_iDefaultScreenHeight / 4, szTitle, nullptr, g_hPrimaryWindow);
+			if (hWindow == nullptr)
+			{
+				bCreatedAll = false;
+				break;
+			}
+			SetupWindow(hWindow);
 		}
-	}
-}
 
+		if (!bCreatedAll)
+			break;
 
-bool ShouldClose()
-{
-	for (const auto& window : g_lWindows)
-	{
-		if (glfwWindowShouldClose(window->m_pWindow))
+		StartRenderScheduler();
+
+		// one frame to warm up, so thread start up and the first fence waits are not counted:
+		g_RenderScheduler.RenderFrame();
+		unsigned long long ullStartFrames = g_RenderScheduler.GetFramesRendered();
+		double dStartTime = glfwGetTime();
+		double dElapsed = 0.0;
+
+		while (dElapsed < c_fBenchmarkRunTime && !ShouldClose())
 		{
-			return true;
+			BeginFrameSnapshot((float)glfwGetTime());
+			PublishFrameSnapshot();
+
+			g_RenderScheduler.RenderFrame();
+			glfwPollEvents();
+
+			dElapsed = glfwGetTime() - dStartTime;
 		}
-	}
 
-	return false;
-}
+		unsigned long long ullFrames = g_RenderScheduler.GetFramesRendered() - ullStartFrames;
+		unsigned int uiThreads = g_RenderScheduler.GetThreadCount();
 
+		StopRenderScheduler();
 
-Quad CreateQuad()
-{
-	Quad geom;
+		FlushLog();
+		printf("%8u %8u %12llu %12.1f\n", g_Windows.GetOpenCount(), uiThreads, ullFrames, ullFrames / dElapsed);
+
+		if (ShouldClose())
+			break;
+	}
+	SetSecondaryWindowDrawn(true);
+
+	printf("\n");
+
+	return EC_NO_ERROR;
+}
+
+
+int RunDispatchBenchmark()
+{
+	std::cout << "Running GL dispatch benchmark" << std::endl;
+
+	// count how many times GLEW looks up the current context for one frame, once the quad is loaded and bound:
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
+	Render(g_hPrimaryWindow);
+	unsigned int uiLookupsBefore = t_uiGLEWContextLookups;
+	Render(g_hPrimaryWindow);
+	unsigned int uiLookupsPerFrame = t_uiGLEWContextLookups - uiLookupsBefore;
+
+	// then time the old and new lookups with as many threads as a pooled loop would use:
+	unsigned int uiThreads = g_uiRenderThreads != 0 ? g_uiRenderThreads : std::thread::hardware_concurrency();
+	if (uiThreads == 0)
+		uiThreads = 1;
+	ContextLookupTimings timings = BenchmarkContextLookup(uiThreads, c_uiDispatchBenchmarkLookups);
+
+	printf("\nglewGetContext() calls per window per frame: %u\n", uiLookupsPerFrame);
+	printf("Lookup cost with %u threads:\n", timings.m_uiThreads);
+	printf("%24s %12s %18s\n", "", "ns/lookup", "ns/window frame");
+	printf("%24s %12.2f %18.1f\n", "std::map (before)", timings.m_dMapLookupNS, timings.m_dMapLookupNS * uiLookupsPerFrame);
+	printf("%24s %12.2f %18.1f\n", "thread local (after)", timings.m_dThreadLocalLookupNS, timings.m_dThreadLocalLookupNS * uiLookupsPerFrame);
+	printf("\n");
+
+	return EC_NO_ERROR;
+}
+
+
+int RunInstanceBenchmark()
+{
+	std::cout << "Running instancing benchmark, " << c_uiInstanceBenchmarkFrames << " frames per object count" << std::endl;
+
+	// we only want to time submitting the draw calls, so don't wait for vsync:
+	MakeContextCurrent(g_hPrimaryWindow);
+	SetSwapInterval(g_hPrimaryWindow, 0);
+	WaitForSceneResources();
+
+	printf("\n%10s %12s %22s %22s %10s\n", "Objects", "Upload ms", "Instanced submit ms", "Per object submit ms", "Speedup");
+
+	for (unsigned int uiCount : c_auiInstanceBenchmarkCounts)
+	{
+		if (ShouldClose())
+			break;
+
+		double dStart = glfwGetTime();
+		UploadInstances(uiCount);
+		glFinish();
+		double dUpload = glfwGetTime() - dStart;
+
+		// time the CPU side of each way of drawing the scene, the swap is left out:
+		double dInstanced = 0.0;
+		double dPerObject = 0.0;
+		bool bPerObject = uiCount <= c_uiMaxPerObjectBenchmarkCount;
+		for (unsigned int uiFrame = 0; uiFrame < c_uiInstanceBenchmarkFrames; ++uiFrame)
+		{
+			BeginFrameSnapshot((float)glfwGetTime());
+			PublishFrameSnapshot();
+			ScopedFrameSnapshot frame(g_FrameSnapshots);
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			dStart = glfwGetTime();
+			DrawScene(g_hPrimaryWindow, frame.Get());
+			dInstanced += glfwGetTime() - dStart;
+			SwapBuffers(g_hPrimaryWindow);
+
+			if (bPerObject)
+			{
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				dStart = glfwGetTime();
+				DrawScenePerObject(g_hPrimaryWindow, frame.Get());
+				dPerObject += glfwGetTime() - dStart;
+				SwapBuffers(g_hPrimaryWindow);
+			}
+
+			glfwPollEvents();
+		}
+
+		double dInstancedMS = dInstanced * 1000.0 / c_uiInstanceBenchmarkFrames;
+		if (bPerObject)
+		{
+			double dPerObjectMS = dPerObject * 1000.0 / c_uiInstanceBenchmarkFrames;
+			printf("%10u %12.3f %22.4f %22.4f %9.1fx\n", uiCount, dUpload * 1000.0, dInstancedMS, dPerObjectMS, dInstancedMS > 0.0 ? dPerObjectMS / dInstancedMS : 0.0);
+		}
+		else
+		{
+			printf("%10u %12.3f %22.4f %22s %10s\n", uiCount, dUpload * 1000.0, dInstancedMS, "skipped", "");
+		}
+	}
+
+	printf("\n");
+
+	SetSwapInterval(g_hPrimaryWindow, GetRequestedSwapInterval(g_hPrimaryWindow->m_uiID));
+
+	return EC_NO_ERROR;
+}
+
+
+int RunJobBenchmark()
+{
+	std::cout << "Running job system benchmark, " << c_uiJobBenchmarkFrames << " updates of " << g_uiSceneObjects << " objects per thread count" << std::endl;
+
+	unsigned int uiMaxThreads = std::thread::hardware_concurrency();
+	if (uiMaxThreads == 0)
+		uiMaxThreads = 1;
+
+	printf("\n%8s %14s %10s %12s %12s\n", "Threads", "Update ms", "Speedup", "Efficiency", "Stolen/frame");
+
+	double dSingleThreadMS = 0.0;
+	for (unsigned int uiThreads = 1; uiThreads <= uiMaxThreads && !ShouldClose(); ++uiThreads)
+	{
+		// the thread waiting makes up the last one:
+		g_JobSystem.Start(uiThreads - 1);
+
+		// warm up, so thread start up is not counted:
+		FinishFrameWork(StartSceneUpdate(g_JobSystem, g_SimulatedScene, 0.0f));
+
+		unsigned long long ullStolenBefore = g_JobSystem.GetJobsStolen();
+		double dStart = glfwGetTime();
+		for (unsigned int uiFrame = 0; uiFrame < c_uiJobBenchmarkFrames; ++uiFrame)
+			FinishFrameWork(StartSceneUpdate(g_JobSystem, g_SimulatedScene, uiFrame / 60.0f));
+		double dUpdateMS = (glfwGetTime() - dStart) * 1000.0 / c_uiJobBenchmarkFrames;
+		unsigned long long ullStolen = g_JobSystem.GetJobsStolen() - ullStolenBefore;
+
+		if (uiThreads == 1)
+			dSingleThreadMS = dUpdateMS;
+		double dSpeedup = dUpdateMS > 0.0 ? dSingleThreadMS / dUpdateMS : 0.0;
+		printf("%8u %14.3f %9.2fx %11.0f%% %12.1f\n", uiThreads, dUpdateMS, dSpeedup, dSpeedup * 100.0 / uiThreads, (double)ullStolen / c_uiJobBenchmarkFrames);
+
+		glfwPollEvents();
+	}
+
+	printf("\n");
+
+	return EC_NO_ERROR;
+}
+
+
+int RunRegistryBenchmark()
+{
+	std::cout << "Running context object registry benchmark, " << c_uiRegistryBenchmarkLookups << " VAO lookups per context count" << std::endl;
+
+	// the lookups are all made on one thread, which is what one render thread cycling through its windows does:
+	MakeContextCurrent(g_hPrimaryWindow);
+
+	printf("\n%10s %16s %16s %10s\n", "Contexts", "std::map ns", "Registry ns", "Speedup");
+	for (unsigned int uiContexts : c_auiRegistryBenchmarkContexts)
+	{
+		if (ShouldClose())
+			break;
+
+		ContextObjectLookupTimings timings = BenchmarkContextObjectLookup(uiContexts, c_uiRegistryBenchmarkLookups);
+		printf("%10u %16.2f %16.2f %9.1fx\n", timings.m_uiContexts, timings.m_dMapLookupNS, timings.m_dRegistryLookupNS,
+			timings.m_dRegistryLookupNS > 0.0 ? timings.m_dMapLookupNS / timings.m_dRegistryLookupNS : 0.0);
+
+		glfwPollEvents();
+	}
+
+	printf("\n");
+
+	return EC_NO_ERROR;
+}
+
+
+int RunWindowStressTest()
+{
+	std::cout << "Running window stress test, " << c_uiWindowStressRounds << " rounds of " << c_uiWindowStressOpenWindows << " windows" << std::endl;
+
+	// time opening, drawing and closing windows, not our fake work or a half loaded scene:
+	g_bDoWork = false;
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
+	srand(1);
+
+	unsigned int uiOpened = 0;
+	unsigned int uiClosed = 0;
+	unsigned int uiMisrouted = 0;		// size callbacks that changed the wrong window.
+	unsigned int uiHighestSlot = 0;
+	double dOpenSeconds = 0.0;
+	double dCloseSeconds = 0.0;
+
+	printf("\n%6s %8s %8s %8s %16s %12s %16s\n", "Round", "Windows", "Opened", "Closed", "Open ms/window", "Frame ms", "Close ms/window");
+
+	for (unsigned int uiRound = 0; uiRound < c_uiWindowStressRounds && !ShouldClose(); ++uiRound)
+	{
+		// top the open windows back up, they take the slots the last round freed:
+		unsigned int uiOpenedThisRound = 0;
+		double dStart = glfwGetTime();
+		while (g_Windows.GetOpenCount() < c_uiWindowStressOpenWindows)
+		{
+			std::string szTitle = std::string(c_szDefaultWindowTitle) + " " + std::to_string(g_uiWindowCounter);
+			WindowHandle hWindow = CreateWindow(c_iDefaultScreenWidth / 8, c_iDefaultScreenHeight / 8, szTitle, nullptr, g_hPrimaryWindow);
+			if (hWindow == nullptr)
+				break;
+			SetupWindow(hWindow);
+
+			// we are timing the windows, not the display:
+			MakeContextCurrent(hWindow);
+			SetSwapInterval(hWindow, 0);
+			MakeContextCurrent(g_hPrimaryWindow);
+
+			if (hWindow->m_uiSlot > uiHighestSlot)
+				uiHighestSlot = hWindow->m_uiSlot;
+			++uiOpenedThisRound;
+		}
+		double dOpen = glfwGetTime() - dStart;
+
+		// resize every window, each size callback has to find its window through the GLFW user pointer:
+		for (auto window : g_Windows.GetOpenWindows())
+			glfwSetWindowSize(window->m_pWindow, c_iDefaultScreenWidth / 8 + window->m_uiSlot, c_iDefaultScreenHeight / 8 + uiRound);
+		glfwPollEvents();
+		for (auto window : g_Windows.GetOpenWindows())
+		{
+			// the render threads are stopped, so the sizes are still waiting for the next frame to take them:
+			std::lock_guard<std::mutex> lock(window->m_SizeLock);
+			if (window->m_PendingSize.m_uiWidth != c_iDefaultScreenWidth / 8 + window->m_uiSlot || window->m_PendingSize.m_uiHeight != c_iDefaultScreenHeight / 8 + uiRound)
+				++uiMisrouted;
+		}
+
+		// draw them all on the render threads:
+		StartRenderScheduler();
+		dStart = glfwGetTime();
+		for (unsigned int uiFrame = 0; uiFrame < c_uiWindowStressFrames; ++uiFrame)
+		{
+			BeginFrameSnapshot((float)glfwGetTime());
+			PublishFrameSnapshot();
+			g_RenderScheduler.RenderFrame();
+			glfwPollEvents();
+		}
+		double dFrame = (glfwGetTime() - dStart) / c_uiWindowStressFrames;
+
+		// then close a random half of them, other than the two every loop needs. They are destroyed together
+		// at the end of the frame, exactly as the main loops do it:
+		for (auto window : g_Windows.GetOpenWindows())
+		{
+			if (window != g_hPrimaryWindow && window != g_hSecondaryWindow && rand() % 2 == 0)
+				glfwSetWindowShouldClose(window->m_pWindow, GL_TRUE);
+		}
+
+		unsigned int uiOpenBefore = g_Windows.GetOpenCount();
+		dStart = glfwGetTime();
+		DestroyClosedWindows();
+		double dClose = glfwGetTime() - dStart;
+		unsigned int uiClosedThisRound = uiOpenBefore - g_Windows.GetOpenCount();
+
+		// new windows can only be made on the main thread once the render threads have given back the primary context:
+		StopRenderScheduler();
+
+		FlushLog();
+		printf("%6u %8u %8u %8u %16.3f %12.3f %16.3f\n", uiRound, uiOpenBefore, uiOpenedThisRound, uiClosedThisRound,
+			uiOpenedThisRound > 0 ? dOpen * 1000.0 / uiOpenedThisRound : 0.0, dFrame * 1000.0, uiClosedThisRound > 0 ? dClose * 1000.0 / uiClosedThisRound : 0.0);
+
+		uiOpened += uiOpenedThisRound;
+		uiClosed += uiClosedThisRound;
+		dOpenSeconds += dOpen;
+		dCloseSeconds += dClose;
+	}
+
+	printf("\nOpened %u windows and closed %u, highest slot used %u of %u, %u size callbacks reached the wrong window\n",
+		uiOpened, uiClosed, uiHighestSlot, g_Windows.GetSlotCount(), uiMisrouted);
+	printf("Average %.3fms to open a window and %.3fms to close one\n\n",
+		uiOpened > 0 ? dOpenSeconds * 1000.0 / uiOpened : 0.0, uiClosed > 0 ? dCloseSeconds * 1000.0 / uiClosed : 0.0);
+
+	return EC_NO_ERROR;
+}
+
+
+int RunMultiViewBenchmark()
+{
+	std::cout << "Running multi-view benchmark, " << c_uiMultiViewBenchmarkFrames << " frames each way per window count" << std::endl;
+
+	// time drawing the windows, not our fake work, a half loaded scene or vsync:
+	g_bDoWork = false;
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
+	for (auto window : g_Windows.GetOpenWindows())
+	{
+		MakeContextCurrent(window);
+		SetSwapInterval(window, 0);
+	}
+	MakeContextCurrent(g_hPrimaryWindow);
+
+	// timer queries are core from 3.3:
+	bool bGPUTimes = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+	if (!bGPUTimes)
+		printf("Warning: Timer queries are not supported, GPU times will not be measured\n");
+
+	printf("\n%8s %18s %18s %10s %18s %18s %10s\n", "Windows", "Per window CPU ms", "Multi-view CPU ms", "CPU saved", "Per window GPU ms", "Multi-view GPU ms", "GPU saved");
+
+	for (unsigned int uiWindowCount : c_auiMultiViewBenchmarkWindowCounts)
+	{
+		if (uiWindowCount > c_uiMaxMultiViews || ShouldClose())
+			break;
+
+		// Init() always opens the primary and secondary windows, the secondary one sits out a run with one window:
+		SetSecondaryWindowDrawn(uiWindowCount > 1);
+		if (uiWindowCount < g_Windows.GetOpenCount())
+			continue;	// windows opened for a larger count stay open.
+
+		// full size, so each window's layer has as many pixels as the window itself:
+		bool bCreatedAll = true;
+		while (g_Windows.GetOpenCount() < uiWindowCount)
+		{
+			std::string szTitle = std::string(c_szDefaultWindowTitle) + " " + std::to_string(g_uiWindowCounter);
+			WindowHandle hWindow = CreateWindow(c_iDefaultScreenWidth, c_iDefaultScreenHeight, szTitle, nullptr, g_hPrimaryWindow);
+			if (hWindow == nullptr)
+			{
+				bCreatedAll = false;
+				break;
+			}
+			SetupWindow(hWindow);
+
+			MakeContextCurrent(hWindow);
+			SetSwapInterval(hWindow, 0);
+			MakeContextCurrent(g_hPrimaryWindow);
+		}
+
+		if (!bCreatedAll)
+			break;
+
+		double dPerWindowCPU = 0.0;
+		double dPerWindowGPU = 0.0;
+		double dMultiViewCPU = 0.0;
+		double dMultiViewGPU = 0.0;
+		TimeMultiViewFrames(false, bGPUTimes, dPerWindowCPU, dPerWindowGPU);
+		TimeMultiViewFrames(true, bGPUTimes, dMultiViewCPU, dMultiViewGPU);
+
+		double dPerWindowCPUMS = dPerWindowCPU * 1000.0 / c_uiMultiViewBenchmarkFrames;
+		double dMultiViewCPUMS = dMultiViewCPU * 1000.0 / c_uiMultiViewBenchmarkFrames;
+		FlushLog();
+		printf("%8u %18.4f %18.4f %9.0f%%", g_Windows.GetOpenCount(), dPerWindowCPUMS, dMultiViewCPUMS,
+			dPerWindowCPUMS > 0.0 ? (1.0 - dMultiViewCPUMS / dPerWindowCPUMS) * 100.0 : 0.0);
+
+		if (bGPUTimes)
+		{
+			double dPerWindowGPUMS = dPerWindowGPU * 1000.0 / c_uiMultiViewBenchmarkFrames;
+			double dMultiViewGPUMS = dMultiViewGPU * 1000.0 / c_uiMultiViewBenchmarkFrames;
+			printf(" %18.4f %18.4f %9.0f%%\n", dPerWindowGPUMS, dMultiViewGPUMS,
+				dPerWindowGPUMS > 0.0 ? (1.0 - dMultiViewGPUMS / dPerWindowGPUMS) * 100.0 : 0.0);
+		}
+		else
+		{
+			printf(" %18s %18s %10s\n", "n/a", "n/a", "");
+		}
+	}
+	SetSecondaryWindowDrawn(true);
+
+	printf("\n");
+
+	for (auto window : g_Windows.GetOpenWindows())
+	{
+		MakeContextCurrent(window);
+		SetSwapInterval(window, GetRequestedSwapInterval(window->m_uiID));
+	}
+	MakeContextCurrent(g_hPrimaryWindow);
+
+	return EC_NO_ERROR;
+}
+
+
+void TimeMultiViewFrames(bool a_bMultiView, bool a_bGPUTimes, double& a_rdCPUSeconds, double& a_rdGPUSeconds)
+{
+	// draws every open window either on its own or from one multi-view pass. Only submitting is timed on the CPU, the
+	// swaps and reading back the timer queries are left out. The first frame builds the framebuffers and is not counted:
+	const std::vector<WindowHandle>& vWindows = g_Windows.GetOpenWindows();
+	a_rdCPUSeconds = 0.0;
+	a_rdGPUSeconds = 0.0;
+
+	for (unsigned int uiFrame = 0; uiFrame <= c_uiMultiViewBenchmarkFrames; ++uiFrame)
+	{
+		BeginFrameSnapshot((float)glfwGetTime());
+		PublishFrameSnapshot();
+		ScopedFrameSnapshot frame(g_FrameSnapshots);
+
+		double dCPUSeconds = 0.0;
+		unsigned int uiViews = 0;
+		if (a_bMultiView)
+		{
+			MakeContextCurrent(g_hPrimaryWindow);
+			double dStart = glfwGetTime();
+			if (a_bGPUTimes)
+				glBeginQuery(GL_TIME_ELAPSED, g_ContextObjects.Get(g_uiMultiViewPassQuery, g_hPrimaryWindow->m_uiContextSlot));
+			uiViews = RenderMultiView(vWindows, frame.Get());
+			if (a_bGPUTimes)
+				glEndQuery(GL_TIME_ELAPSED);
+			dCPUSeconds += glfwGetTime() - dStart;
+		}
+
+		for (unsigned int i = 0; i < vWindows.size(); ++i)
+		{
+			WindowHandle window = vWindows[i];
+			MakeContextCurrent(window);
+			double dStart = glfwGetTime();
+			if (a_bGPUTimes)
+				glBeginQuery(GL_TIME_ELAPSED, g_ContextObjects.Get(g_uiFrameQuery, window->m_uiContextSlot));
+
+			if (i < uiViews)
+			{
+				g_MultiViewTarget.Present(window->m_uiContextSlot, i, window->m_uiWidth, window->m_uiHeight);
+			}
+			else
+			{
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				DrawScene(window, frame.Get());
+			}
+
+			if (a_bGPUTimes)
+				glEndQuery(GL_TIME_ELAPSED);
+			dCPUSeconds += glfwGetTime() - dStart;
+
+			SwapBuffers(window);
+		}
+
+		// waits for the GPU to finish the frame, which is why it is not part of the CPU time:
+		GLuint64 ullGPUNS = 0;
+		if (a_bGPUTimes)
+		{
+			for (auto window : vWindows)
+			{
+				MakeContextCurrent(window);
+				GLuint64 ullNS = 0;
+				glGetQueryObjectui64v(g_ContextObjects.Get(g_uiFrameQuery, window->m_uiContextSlot), GL_QUERY_RESULT, &ullNS);
+				ullGPUNS += ullNS;
+			}
+
+			if (a_bMultiView)
+			{
+				MakeContextCurrent(g_hPrimaryWindow);
+				GLuint64 ullNS = 0;
+				glGetQueryObjectui64v(g_ContextObjects.Get(g_uiMultiViewPassQuery, g_hPrimaryWindow->m_uiContextSlot), GL_QUERY_RESULT, &ullNS);
+				ullGPUNS += ullNS;
+			}
+		}
+
+		if (uiFrame > 0)
+		{
+			a_rdCPUSeconds += dCPUSeconds;
+			a_rdGPUSeconds += ullGPUNS * 1e-9;
+		}
+
+		glfwPollEvents();
+	}
+
+	MakeContextCurrent(g_hPrimaryWindow);
+}
+
+
+int RunPresentBenchmark()
+{
+	std::cout << "Running present benchmark, " << c_fPresentBenchmarkRunTime << " seconds each way per window count" << std::endl;
+
+	// time the swaps, not our fake work or a half loaded scene. Vsync stays as asked for, it is what is being measured:
+	g_bDoWork = false;
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
+
+	// the table is printed as each window count finishes, the runs print their own status lines in between:
+	printf("\n%8s | %-45s | %-45s\n", "", "Swapped in turn", "On present threads");
+	printf("%8s | %10s %12s %12s %8s | %10s %12s %12s %8s\n", "Windows", "FPS", "Present p50", "Present p99", "Missed",
+		"FPS", "Present p50", "Present p99", "Missed");
+
+	for (unsigned int uiWindowCount : c_auiPresentBenchmarkWindowCounts)
+	{
+		if (ShouldClose())
+			break;
+
+		// Init() always opens the primary and secondary windows, the secondary one sits out a run with one window:
+		SetSecondaryWindowDrawn(uiWindowCount > 1);
+		if (uiWindowCount < g_Windows.GetOpenCount())
+			continue;	// windows opened for a larger count stay open.
+
+		bool bCreatedAll = true;
+		while (g_Windows.GetOpenCount() < uiWindowCount)
+		{
+			std::string szTitle = std::string(c_szDefaultWindowTitle) + " " + std::to_string(g_uiWindowCounter);
+			WindowHandle hWindow = CreateWindow(c_iDefaultScreenWidth, c_iDefaultScreenHeight, szTitle, nullptr, g_hPrimaryWindow);
+			if (hWindow == nullptr)
+			{
+				bCreatedAll = false;
+				break;
+			}
+			SetupWindow(hWindow);
+		}
+
+		if (!bCreatedAll)
+			break;
+
+		double adFPS[2], adP50[2], adP99[2];
+		unsigned long long aullMissed[2];
+		for (unsigned int i = 0; i < 2; ++i)
+			TimePresentFrames(i == 1, adFPS[i], adP50[i], adP99[i], aullMissed[i]);
+
+		FlushLog();
+		printf("%8u | %10.1f %10.2fms %10.2fms %8llu | %10.1f %10.2fms %10.2fms %8llu\n", g_Windows.GetOpenCount(),
+			adFPS[0], adP50[0] * 1000.0, adP99[0] * 1000.0, aullMissed[0], adFPS[1], adP50[1] * 1000.0, adP99[1] * 1000.0, aullMissed[1]);
+	}
+	SetSecondaryWindowDrawn(true);
+
+	printf("\n");
+
+	return EC_NO_ERROR;
+}
+
+
+void TimePresentFrames(bool a_bPresentThreads, double& a_rdFPS, double& a_rdPresentP50, double& a_rdPresentP99, unsigned long long& a_rullMissed)
+{
+	// draws every open window in turn for c_fPresentBenchmarkRunTime, swapping each one after it is drawn or on its present thread.
+	// Every window starts with fresh timings so the presents and missed blanks are only this run's:
+	const std::vector<WindowHandle>& vWindows = g_Windows.GetOpenWindows();
+	for (auto window : vWindows)
+	{
+		delete window->m_pFrameTiming;
+		window->m_pFrameTiming = CreateFrameTiming(window->m_uiID);
+	}
+
+	if (a_bPresentThreads)
+	{
+		glfwMakeContextCurrent(nullptr);
+		SetCurrentContext(nullptr, nullptr);
+		g_PresentQueue.Start(vWindows, g_dRefreshPeriod);
+	}
+
+	unsigned int uiFrames = 0;
+	double dStart = glfwGetTime();
+	while (glfwGetTime() - dStart < c_fPresentBenchmarkRunTime && !ShouldClose())
+	{
+		BeginFrameSnapshot((float)glfwGetTime());
+		PublishFrameSnapshot();
+
+		RenderWindowsSequential();
+		glfwPollEvents();
+		++uiFrames;
+	}
+
+	if (a_bPresentThreads)
+		g_PresentQueue.Stop();
+	double dSeconds = glfwGetTime() - dStart;
+	MakeContextCurrent(g_hPrimaryWindow);
+
+	// the median window's median, and the worst window's p99:
+	a_rdFPS = dSeconds > 0.0 ? uiFrames / dSeconds : 0.0;
+	a_rdPresentP50 = 0.0;
+	a_rdPresentP99 = 0.0;
+	a_rullMissed = 0;
+	std::vector<double> vP50;
+	for (auto window : vWindows)
+	{
+		const FrameHistogram& present = window->m_pFrameTiming->m_aTotal[FT_PRESENT];
+		vP50.push_back(present.GetPercentile(50));
+		a_rdPresentP99 = std::max(a_rdPresentP99, present.GetPercentile(99));
+		a_rullMissed += window->m_pFrameTiming->m_ullMissedIntervals;
+	}
+	if (!vP50.empty())
+	{
+		std::sort(vP50.begin(), vP50.end());
+		a_rdPresentP50 = vP50[vP50.size() / 2];
+	}
+}
+
+
+int RunTextureBenchmark()
+{
+	unsigned int uiSize = std::max(g_uiTextureBenchmarkSize, 1u);
+
+	// nothing else should be using the CPU or the driver while it is timed:
+	g_bDoWork = false;
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
+	GLStateCache* pState = g_hPrimaryWindow->m_pGLState;
+
+	GLint iMaxSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &iMaxSize);
+	if (iMaxSize > 0 && uiSize > (unsigned int)iMaxSize)
+	{
+		printf("Warning: %u is bigger than GL_MAX_TEXTURE_SIZE, using %d\n", uiSize, iMaxSize);
+		uiSize = (unsigned int)iMaxSize;
+	}
+
+	std::cout << "Running texture benchmark, a " << uiSize << "x" << uiSize << " checkerboard in each format, " << (IsTextureGenSIMD() ? "SSE2" : "scalar")
+		<< " rows, " << g_JobSystem.GetWorkerCount() + 1 << " threads for the tiled runs" << std::endl;
+
+	TextureDesc desc;
+	desc.m_uiWidth = uiSize;
+	desc.m_uiHeight = uiSize;
+	desc.m_ePattern = TP_CHECKER;
+	desc.m_uiCellWidth = 64;
+	desc.m_uiCellHeight = 64;
+	desc.m_v4ColourA = glm::vec4(0.1f, 0.2f, 0.3f, 1.0f);
+	desc.m_v4ColourB = glm::vec4(0.9f, 0.8f, 0.7f, 1.0f);
+
+	printf("\n%8s %8s %10s %12s %12s %9s %11s\n", "Format", "Bytes", "GPU MiB", "1 thread ms", "Tiled ms", "Speedup", "Upload ms");
+
+	std::vector<unsigned char> vTexels;
+	for (unsigned int i = 0; i < TF_COUNT && !ShouldClose(); ++i)
+	{
+		desc.m_eFormat = (TextureFormats)i;
+		const TextureFormatInfo& format = GetTextureFormatInfo(desc.m_eFormat);
+		size_t uiBytes = GetTextureSize(desc);
+
+		// written once before timing, so the first run does not pay for the pages being mapped in:
+		vTexels.assign(uiBytes, 0);
+		double dSerialMS = TimeTextureGeneration(desc, vTexels.data(), nullptr);
+		double dTiledMS = TimeTextureGeneration(desc, vTexels.data(), &g_JobSystem);
+
+		// straight from client memory and waited on with glFinish(), so the driver's copy is counted too:
+		GLuint uiTexture = 0;
+		glGenTextures(1, &uiTexture);
+		pState->BindTexture(GL_TEXTURE_2D, uiTexture);
+		double dStart = glfwGetTime();
+		glTexImage2D(GL_TEXTURE_2D, 0, format.m_iInternalFormat, uiSize, uiSize, 0, format.m_eFormat, format.m_eType, vTexels.data());
+		glFinish();
+		double dUploadMS = (glfwGetTime() - dStart) * 1000.0;
+		bool bOutOfMemory = glGetError() == GL_OUT_OF_MEMORY;
+		pState->BindTexture(GL_TEXTURE_2D, 0);
+		glDeleteTextures(1, &uiTexture);
+
+		printf("%8s %8u %10.1f %12.2f %12.2f %8.2fx", format.m_szName, format.m_uiBytesPerTexel, uiBytes / (1024.0 * 1024.0),
+			dSerialMS, dTiledMS, dTiledMS > 0.0 ? dSerialMS / dTiledMS : 0.0);
+		if (bOutOfMemory)
+			printf(" %11s\n", "no memory");
+		else
+			printf(" %11.2f\n", dUploadMS);
+
+		std::vector<unsigned char>().swap(vTexels);
+		glfwPollEvents();
+	}
+
+	printf("\n");
+
+	return EC_NO_ERROR;
+}
+
+
+double TimeTextureGeneration(const TextureDesc& a_rDesc, unsigned char* a_pTexels, JobSystem* a_pJobSystem)
+{
+	// the fastest run, in milliseconds:
+	double dBestMS = 0.0;
+	for (unsigned int uiRun = 0; uiRun < c_uiTextureBenchmarkRuns; ++uiRun)
+	{
+		double dStart = glfwGetTime();
+		GenerateTexture(a_rDesc, a_pTexels, a_pJobSystem);
+		double dMS = (glfwGetTime() - dStart) * 1000.0;
+		if (uiRun == 0 || dMS < dBestMS)
+			dBestMS = dMS;
+	}
+	return dBestMS;
+}
+
+
+int RunStartupBenchmark()
+{
+	std::cout << "Running start up benchmark, opening windows with glewInit() for each and with the GLEW context cache" << std::endl;
+
+	// only the window creation is timed, nothing is drawn:
+	g_bDoWork = false;
+	bool bWasEnabled = g_GLEWContextCache.IsEnabled();
+
+	printf("\n%8s %14s %14s %18s %18s %10s\n", "Windows", "GLEW ms", "Open ms", "Cached GLEW ms", "Cached open ms", "Saved");
+	for (unsigned int uiCount : c_auiStartupBenchmarkWindowCounts)
+	{
+		if (ShouldClose())
+			break;
+
+		double dOpen = 0.0;
+		double dGLEW = 0.0;
+		double dCachedOpen = 0.0;
+		double dCachedGLEW = 0.0;
+		unsigned int uiOpened = TimeWindowStartup(uiCount, false, dOpen, dGLEW);
+		unsigned int uiCachedOpened = TimeWindowStartup(uiCount, true, dCachedOpen, dCachedGLEW);
+		if (uiOpened == 0 || uiCachedOpened == 0)
+		{
+			printf("%8u %14s\n", uiCount, "no windows");
+			continue;
+		}
+
+		// per window, the saving is in the whole time to open one:
+		dOpen *= 1000.0 / uiOpened;
+		dGLEW *= 1000.0 / uiOpened;
+		dCachedOpen *= 1000.0 / uiCachedOpened;
+		dCachedGLEW *= 1000.0 / uiCachedOpened;
+		FlushLog();
+		printf("%8u %14.3f %14.3f %18.3f %18.3f %9.0f%%\n", uiCount, dGLEW, dOpen, dCachedGLEW, dCachedOpen,
+			dOpen > 0.0 ? (dOpen - dCachedOpen) * 100.0 / dOpen : 0.0);
+	}
+	printf("\n");
+
+	g_GLEWContextCache.SetEnabled(bWasEnabled);
+	MakeContextCurrent(g_hPrimaryWindow);
+
+	return EC_NO_ERROR;
+}
+
+
+unsigned int TimeWindowStartup(unsigned int a_uiCount, bool a_bGLEWContextCache, double& a_rdOpenSeconds, double& a_rdGLEWSeconds)
+{
+	// every run starts cold like the demo does, so with the cache the first window still runs glewInit():
+	g_GLEWContextCache.Clear();
+	g_GLEWContextCache.SetEnabled(a_bGLEWContextCache);
+	GLEWContextCacheStats before = g_GLEWContextCache.GetStats();
+
+	std::vector<WindowHandle> vWindows;
+	double dStart = glfwGetTime();
+	for (unsigned int i = 0; i < a_uiCount; ++i)
+	{
+		std::string szTitle = std::string(c_szDefaultWindowTitle) + " " + std::to_string(g_uiWindowCounter);
+		WindowHandle hWindow = CreateWindow(c_iDefaultScreenWidth / 8, c_iDefaultScreenHeight / 8, szTitle, nullptr, g_hPrimaryWindow);
+		if (hWindow == nullptr)
+			break;
+		vWindows.push_back(hWindow);
+	}
+	a_rdOpenSeconds = glfwGetTime() - dStart;
+
+	GLEWContextCacheStats after = g_GLEWContextCache.GetStats();
+	a_rdGLEWSeconds = (after.m_dInitSeconds + after.m_dCopySeconds) - (before.m_dInitSeconds + before.m_dCopySeconds);
+
+	// closed together at the end of the frame, as the main loops do it:
+	for (auto window : vWindows)
+		glfwSetWindowShouldClose(window->m_pWindow, GL_TRUE);
+	DestroyClosedWindows();
+
+	return (unsigned int)vWindows.size();
+}
+
+
+int RunSharedStressTest()
+{
+	std::cout << "Running shared resource stress test, " << c_fSharedStressRunTime << " seconds for each window count and number of copies" << std::endl;
+
+	// time the sharing, not our fake work or a half loaded scene:
+	g_bDoWork = false;
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
+
+	// the instances keep their grid from UploadInstances() and are bobbed by the writer, -instances N sets how many:
+	if (g_uiInstanceCount == 0)
+		UploadInstances(c_uiSharedStressInstances);
+	g_uiSharedQuadVAO = g_ContextObjects.Register(COT_VERTEX_ARRAY, [] (GLuint a_uiVertexArray) { BuildQuadVertexArray(a_uiVertexArray, true); });
+
+	// the writer's hidden window shares with the rest like the loader's, its context belongs to the writer thread:
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	WindowHandle hWriterWindow = CreateWindow(c_iDefaultScreenWidth / 4, c_iDefaultScreenHeight / 4, c_szSharedWriterWindowTitle, nullptr, g_hPrimaryWindow);
+	glfwDefaultWindowHints();
+	if (hWriterWindow == nullptr)
+	{
+		Log("Error: Could not create the shared writer's window!\n");
+		return EC_NO_ERROR;
+	}
+	g_Windows.Remove(hWriterWindow);
+	MakeContextCurrent(g_hPrimaryWindow);
+
+	FlushLog();
+	printf("\n%8s %8s %12s %12s %16s %16s %12s\n", "Windows", "Copies", "Frames/sec", "Updates/sec", "Writer blocked", "Reader blocked", "Waits/frame");
+
+	for (unsigned int uiWindowCount : c_auiSharedStressWindowCounts)
+	{
+		if (ShouldClose())
+			break;
+
+		// Init() always opens the primary and secondary windows, the secondary one sits out a run with one window:
+		SetSecondaryWindowDrawn(uiWindowCount > 1);
+		if (uiWindowCount < g_Windows.GetOpenCount())
+			continue;	// windows opened for a larger count stay open.
+
+		bool bCreatedAll = true;
+		while (g_Windows.GetOpenCount() < uiWindowCount)
+		{
+			std::string szTitle = std::string(c_szDefaultWindowTitle) + " " + std::to_string(g_uiWindowCounter);
+			WindowHandle hWindow = CreateWindow(c_iDefaultScreenWidth / 4, c_iDefaultScreenHeight / 4, szTitle, nullptr, g_hPrimaryWindow);
+			if (hWindow == nullptr)
+			{
+				bCreatedAll = false;
+				break;
+			}
+			SetupWindow(hWindow);
+		}
+
+		if (!bCreatedAll)
+			break;
+
+		for (unsigned int uiCopies : c_auiSharedStressCopies)
+		{
+			double dFPS = 0.0, dUpdatesPerSecond = 0.0;
+			SharedResourceStats instances, texture;
+			TimeSharedStress(hWriterWindow, uiCopies, dFPS, dUpdatesPerSecond, instances, texture);
+
+			// blocked times are in total over the run, the waits are glWaitSync() calls per window per frame:
+			unsigned long long ullDraws = instances.m_ullAcquires;
+			FlushLog();
+			printf("%8u %8u %12.1f %12.1f %14.2fms %14.2fms %12.2f\n", g_Windows.GetOpenCount(), uiCopies, dFPS, dUpdatesPerSecond,
+				(instances.m_dWriterBlockSeconds + texture.m_dWriterBlockSeconds) * 1000.0,
+				(instances.m_dReaderBlockSeconds + texture.m_dReaderBlockSeconds) * 1000.0,
+				ullDraws > 0 ? (double)(instances.m_ullReaderWaits + texture.m_ullReaderWaits) / ullDraws : 0.0);
+
+			if (ShouldClose())
+				break;
+		}
+	}
+	SetSecondaryWindowDrawn(true);
+
+	printf("\n");
+
+	DestroyWindow(hWriterWindow);
+	MakeContextCurrent(g_hPrimaryWindow);
+
+	return EC_NO_ERROR;
+}
+
+
+void TimeSharedStress(WindowHandle a_hWriterWindow, unsigned int a_uiCopies, double& a_rdFPS, double& a_rdUpdatesPerSecond,
+	SharedResourceStats& a_rInstanceStats, SharedResourceStats& a_rTextureStats)
+{
+	// the primary context must be current, the resources are made on it and published before any window draws them:
+	GLStateCache* pState = g_hPrimaryWindow->m_pGLState;
+	std::vector<InstanceData> vInstances;
+	std::vector<unsigned char> vTexels;
+	MakeSharedStressData((float)glfwGetTime(), vInstances, vTexels);
+	const TextureFormatInfo& format = GetTextureFormatInfo(TF_RGBA8);
+	g_SharedInstances.CreateBuffer(*pState, vInstances.size() * sizeof(InstanceData), vInstances.data(), a_uiCopies);
+	g_SharedTexture.CreateTexture2D(*pState, c_uiSharedStressTextureSize, c_uiSharedStressTextureSize, format.m_iInternalFormat, format.m_eFormat,
+		format.m_eType, vTexels.data(), a_uiCopies);
+
+	StartRenderScheduler();
+	{
+		std::lock_guard<std::mutex> lock(g_SharedWriterLock);
+		g_ullSharedWriterFrames = 0;
+		g_bSharedWriterQuit = false;
+	}
+	std::thread writer(&SharedWriterLoop, a_hWriterWindow);
+
+	// one frame to warm up, so thread start up and building the VAOs are not counted:
+	g_RenderScheduler.RenderFrame();
+	g_SharedInstances.ResetStats();
+	g_SharedTexture.ResetStats();
+	unsigned long long ullStartFrames = g_RenderScheduler.GetFramesRendered();
+	double dStart = glfwGetTime();
+	double dElapsed = 0.0;
+
+	while (dElapsed < c_fSharedStressRunTime && !ShouldClose())
+	{
+		BeginFrameSnapshot((float)glfwGetTime());
+		PublishFrameSnapshot();
+
+		// one update a frame, written while the windows draw:
+		{
+			std::lock_guard<std::mutex> lock(g_SharedWriterLock);
+			++g_ullSharedWriterFrames;
+		}
+		g_SharedWriterWake.notify_one();
+
+		g_RenderScheduler.RenderFrame();
+		glfwPollEvents();
+
+		dElapsed = glfwGetTime() - dStart;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(g_SharedWriterLock);
+		g_bSharedWriterQuit = true;
+	}
+	g_SharedWriterWake.notify_one();
+	writer.join();
+
+	unsigned long long ullFrames = g_RenderScheduler.GetFramesRendered() - ullStartFrames;
+	StopRenderScheduler();
+
+	a_rInstanceStats = g_SharedInstances.GetStats();
+	a_rTextureStats = g_SharedTexture.GetStats();
+	a_rdFPS = dElapsed > 0.0 ? ullFrames / dElapsed : 0.0;
+	a_rdUpdatesPerSecond = dElapsed > 0.0 ? a_rTextureStats.m_ullUpdates / dElapsed : 0.0;
+
+	// the next run's copies may reuse these names, each window binds them again the first time it draws them (m_bWaited):
+	g_SharedInstances.Destroy(*pState);
+	g_SharedTexture.Destroy(*pState);
+}
+
+
+void SharedWriterLoop(WindowHandle a_hWriterWindow)
+{
+	Log("Starting Shared Writer Thread: %s\n", GetLogThreadID());
+	MakeContextCurrent(a_hWriterWindow);
+
+	std::vector<InstanceData> vInstances;
+	std::vector<unsigned char> vTexels;
+	unsigned long long ullFrame = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(g_SharedWriterLock);
+			g_SharedWriterWake.wait(lock, [&ullFrame] () { return g_bSharedWriterQuit || g_ullSharedWriterFrames != ullFrame; });
+			if (g_bSharedWriterQuit)
+				break;
+			ullFrame = g_ullSharedWriterFrames;		// frames we fell behind on are skipped, only the latest is worth writing.
+		}
+
+		MakeSharedStressData((float)glfwGetTime(), vInstances, vTexels);
+		g_SharedInstances.Update(*a_hWriterWindow->m_pGLState, vInstances.data());
+		g_SharedTexture.Update(*a_hWriterWindow->m_pGLState, vTexels.data());
+	}
+
+	glfwMakeContextCurrent(nullptr);
+	SetCurrentContext(nullptr, nullptr);
+
+	Log("Exiting Shared Writer Thread: %s\n", GetLogThreadID());
+}
+
+
+void MakeSharedStressData(float a_fTime, std::vector<InstanceData>& a_rvInstances, std::vector<unsigned char>& a_rvTexels)
+{
+	// the instances bob like StreamInstances() and the checkerboard changes colour, so every version looks different:
+	a_rvInstances.resize(g_vInstances.size());
+	float fTime = a_fTime * 2.0f;
+	for (size_t i = 0; i < g_vInstances.size(); ++i)
+	{
+		glm::vec4 v4PositionScale = g_vInstances[i].m_v4PositionScale;
+		v4PositionScale.y += sinf(fTime + i * 0.37f) * v4PositionScale.w;
+		a_rvInstances[i].m_v4PositionScale = v4PositionScale;
+	}
+
+	TextureDesc checker;
+	checker.m_uiWidth = c_uiSharedStressTextureSize;
+	checker.m_uiHeight = c_uiSharedStressTextureSize;
+	checker.m_eFormat = TF_RGBA8;
+	checker.m_ePattern = TP_CHECKER;
+	checker.m_uiCellWidth = 32;
+	checker.m_uiCellHeight = 32;
+	checker.m_v4ColourA = glm::vec4(0.5f + 0.5f * sinf(a_fTime), 0, 0, 1);
+	checker.m_v4ColourB = glm::vec4(0, 0, 0.5f + 0.5f * cosf(a_fTime), 1);
+	GenerateTexture(checker, a_rvTexels, nullptr);
+}
+
+
+void RenderSharedStress(WindowHandle a_hWindowHandle)
+{
+	// called on the render thread that owns the window, draws whichever versions the writer published last:
+	MakeContextCurrent(a_hWindowHandle);
+	double dCPUStart = glfwGetTime();
+	GLStateCache* pState = a_hWindowHandle->m_pGLState;
+	unsigned int uiSlot = a_hWindowHandle->m_uiContextSlot;
+
+	if (ApplyPendingSize(a_hWindowHandle))
+	{
+		pState->Viewport(0, 0, a_hWindowHandle->m_uiWidth, a_hWindowHandle->m_uiHeight);
+		UpdateCameraBlock(a_hWindowHandle);
+	}
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	SharedResourceView instances = g_SharedInstances.Acquire(uiSlot);
+	SharedResourceView texture = g_SharedTexture.Acquire(uiSlot);
+
+	pState->BindBufferRange(GL_UNIFORM_BUFFER, c_uiCameraBlockBinding, g_CameraUBO, a_hWindowHandle->m_uiCameraOffset, sizeof(CameraBlock));
+
+	DrawPacket packet;
+	packet.m_uiProgram = g_InstancedShader;
+	packet.m_uiVertexArray = g_ContextObjects.Get(g_uiSharedQuadVAO, uiSlot);
+	packet.m_uiTexture = texture.m_uiName;
+	packet.m_iModelUniform = g_iInstancedModelUniform;
+	packet.m_iIndexCount = Quad::c_uiNoOfIndicies;
+	packet.m_iInstanceCount = (GLsizei)g_vInstances.size();
+	packet.m_uiFirstInstance = 0;
+
+	// a version this context has not drawn before must be bound again for its contents to be visible here, even if the
+	// name is the one the cache thinks is bound. A version it has drawn is already what the VAO points at:
+	if (instances.m_bWaited)
+	{
+		pState->BindVertexArray(packet.m_uiVertexArray);
+		pState->InvalidateBuffer(GL_ARRAY_BUFFER);
+		pState->BindBuffer(GL_ARRAY_BUFFER, instances.m_uiName);
+		glVertexAttribPointer(c_uiInstanceAttribLocation, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), 0);
+	}
+	if (texture.m_bWaited)
+		pState->InvalidateTexture(GL_TEXTURE_2D);
+
+	RenderQueue* pQueue = a_hWindowHandle->m_pRenderQueue;
+	pQueue->Begin();
+	pQueue->Submit(RenderQueue::MakeSortKey(0, packet.m_uiProgram, packet.m_uiVertexArray, packet.m_uiTexture, 0.0f), packet, glm::mat4(1));
+	pQueue->Execute(*pState);
+
+	// the draws are issued, the writer may have these copies back once the GPU has finished them:
+	g_SharedTexture.Release(texture, uiSlot);
+	g_SharedInstances.Release(instances, uiSlot);
+	RecordFrameTime(a_hWindowHandle, FT_CPU, glfwGetTime() - dCPUStart);
+
+	SwapBuffers(a_hWindowHandle);
+}
+
+
+int RunSyncBenchmark()
+{
+	std::cout << "Running sync benchmark, the pooled loop with " << g_Windows.GetOpenCount() << " windows for " << c_fSyncBenchmarkRunTime
+		<< " seconds waiting each way" << std::endl;
+
+	// time the waiting, not our fake work or a half loaded scene:
+	g_bDoWork = false;
+	MakeContextCurrent(g_hPrimaryWindow);
+	WaitForSceneResources();
+
+	FlushLog();
+	printf("\n%16s %8s %12s %10s %10s %12s %10s %12s %12s\n", "Waiting", "Threads", "Frames/sec", "CPU %", "Waits", "Spin wakes", "Parks",
+		"Wake ms", "Max wake ms");
+
+	for (int iPolicy = 0; iPolicy < SWP_COUNT; ++iPolicy)
+	{
+		SetSyncWaitPolicy((SyncWaitPolicies)iPolicy);
+		StartRenderScheduler();
+
+		// one frame to warm up, so thread start up and the first fence waits are not counted:
+		g_RenderScheduler.RenderFrame();
+		g_RenderScheduler.ResetSyncStats();
+		unsigned long long ullStartFrames = g_RenderScheduler.GetFramesRendered();
+		double dStartCPU = GetProcessCPUSeconds();
+		double dStartTime = glfwGetTime();
+		double dElapsed = 0.0;
+
+		while (dElapsed < c_fSyncBenchmarkRunTime && !ShouldClose())
+		{
+			BeginFrameSnapshot((float)glfwGetTime());
+			PublishFrameSnapshot();
+
+			g_RenderScheduler.RenderFrame();
+			glfwPollEvents();
+
+			dElapsed = glfwGetTime() - dStartTime;
+		}
+
+		// the CPU time of every thread, as a percentage of one core. A thread that only waits should cost next to nothing:
+		double dCPU = GetProcessCPUSeconds() - dStartCPU;
+		unsigned long long ullFrames = g_RenderScheduler.GetFramesRendered() - ullStartFrames;
+		unsigned int uiThreads = g_RenderScheduler.GetThreadCount();
+		SyncStats stats = g_RenderScheduler.GetSyncStats();
+
+		StopRenderScheduler();
+
+		FlushLog();
+		printf("%16s %8u %12.1f %10.1f %10llu %12llu %10llu %12.3f %12.3f\n", GetSyncWaitPolicyName((SyncWaitPolicies)iPolicy), uiThreads,
+			ullFrames / dElapsed, dCPU * 100.0 / dElapsed, stats.m_ullWaits, stats.m_ullSpinWakes, stats.m_ullParks,
+			stats.m_ullParks > 0 ? stats.m_dWakeSeconds * 1000.0 / stats.m_ullParks : 0.0, stats.m_dMaxWakeSeconds * 1000.0);
+
+		if (ShouldClose())
+			break;
+	}
+
+	SetSyncWaitPolicy(SWP_SPIN_THEN_PARK);
+	printf("\n");
+
+	return EC_NO_ERROR;
+}
+
+
+void StartRenderScheduler()
+{
+	// the fence lets the render threads wait for the shared resources the main thread created:
+	MakeContextCurrent(g_hPrimaryWindow);
+	GLsync initFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	// the deferred loop records the draws elsewhere, its render threads only replay them:
+	bool bReplay = g_eRunMode == RM_DEFERRED;
+	bool bSharedStress = g_eRunMode == RM_SHARED_STRESS;
+	g_RenderScheduler.Start(g_Windows.GetOpenWindows(), g_uiRenderThreads, [bReplay, bSharedStress] (WindowHandle a_hWindow)
+	{
+		if (bReplay)
+			ReplayCommandList(a_hWindow);
+		else if (bSharedStress)
+			RenderSharedStress(a_hWindow);
+		else
+			Render(a_hWindow);
+		EndFrameTiming(a_hWindow);
+	}, initFence);
+}
+
+
+void StopRenderScheduler()
+{
+	GLsync initFence = g_RenderScheduler.GetInitFence();
+	g_RenderScheduler.Stop();
+
+	// the render threads have given up their contexts, take the primary one back so we can clean up:
+	MakeContextCurrent(g_hPrimaryWindow);
+	glDeleteSync(initFence);
+}
+
+
+JobHandle StartFrameWork(SimulatedScene& a_rScene, float a_fTime)
+{
+	if (!g_bDoWork)
+		return JobHandle();
+
+	return StartSceneUpdate(g_JobSystem, a_rScene, a_fTime);
+}
+
+
+void FinishFrameWork(const JobHandle& a_hWork)
+{
+	// helps with whatever is left rather than just blocking:
+	if (a_hWork)
+		g_JobSystem.Wait(a_hWork);
+}
+
+
+void BeginFrameSnapshot(float a_fTime)
+{
+	// main thread only. Fills in the next frame, the windows keep drawing the last one until PublishFrameSnapshot():
+	FrameSnapshot& frame = g_FrameSnapshots.BeginWrite();
+	frame.m_dSampleTime = glfwGetTime();
+	frame.m_fTime = a_fTime;
+
+	glm::mat4 identity;
+	frame.m_m4Model = glm::rotate(identity, a_fTime * 10.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+
+void PublishFrameSnapshot()
+{
+	// the scene update for this frame has finished by now, or was not run:
+	FrameSnapshot& frame = g_FrameSnapshots.GetWriting();
+	frame.m_v3BoundsMin = g_SimulatedScene.m_v3BoundsMin;
+	frame.m_v3BoundsMax = g_SimulatedScene.m_v3BoundsMax;
+	g_FrameSnapshots.Publish();
+}
+
+
+void RecordFrameLatency(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame)
+{
+	// from the simulation sampling the frame to it being handed to the swap, nothing is drawn before the first one:
+	if (a_rFrame.m_ullFrame > 0)
+		RecordFrameTime(a_hWindowHandle, FT_LATENCY, glfwGetTime() - a_rFrame.m_dSampleTime);
+}
+
+
+void ChildLoop(WindowHandle a_toWindow)
+{
+	Log("Starting Secondary Render Thread: %s\n", GetLogThreadID());
+	PlaceThread(TR_RENDER, "Secondary render");
+	MakeContextCurrent(g_hSecondaryWindow);
+
+	// this thread has its own game work, the main thread is busy updating g_SimulatedScene:
+	SimulatedScene childScene;
+	CreateSimulatedScene(childScene, g_uiSceneObjects);
+
+	while(!g_bShouldClose)
+	{
+		JobHandle hWork = StartFrameWork(childScene, (float)glfwGetTime());
+
+		// our frame N goes after the main thread's frame N, so we never start before it has rendered once. Parked, not spinning:
+		WaitForRenderTurn(a_toWindow, g_hPrimaryWindow, a_toWindow->m_pFrameReady->GetFrame() + 1);
+		if (!g_bShouldClose)	// otherwise the main thread let us go without drawing a frame.
+		{
+			if (g_MainThreadFenceSync != 0)		// 0 if the main thread has not rendered since we last waited on it.
+			{
+				glWaitSync(g_MainThreadFenceSync, 0, GL_TIMEOUT_IGNORED);		// tell the GPU to make sure that the second threads calls are in the pipline before adding ours!
+				glDeleteSync(g_MainThreadFenceSync);
+				g_MainThreadFenceSync = 0;
+			}
+			Render(a_toWindow);
+			g_SecondThreadFenceSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);	// setup our fence sync for the other thread to wait on it.
+			a_toWindow->m_pFrameReady->Signal();
+		}
+
+		FinishFrameWork(hWork);
+		SampleThreadPlacement();
+
+		// frame timings:
+		EndFrameTiming(a_toWindow);
+	}
+
+	// give the context back so ShutDown() can clean up its VAOs on the main thread:
+	glfwMakeContextCurrent(nullptr);
+}
+
+
+void Render(WindowHandle a_toWindow)
+{
+	MakeContextCurrent(a_toWindow);
+	double dCPUStart = glfwGetTime();
+
+	// the latest published frame, it cannot change under us while we draw it:
+	ScopedFrameSnapshot frame(g_FrameSnapshots);
+
+	if (ApplyPendingSize(a_toWindow))
+	{
+		a_toWindow->m_pGLState->Viewport(0, 0, a_toWindow->m_uiWidth, a_toWindow->m_uiHeight);
+		UpdateCameraBlock(a_toWindow);
+	}
+		
+	// each pass is timed on the CPU and, where there are timer queries, on the GPU. See GPUTimer.h:
+	GPUTimer* pTimer = a_toWindow->m_pGPUTimer;
+	pTimer->BeginFrame();
+
+	// clear the backbuffer to our clear colour and clear the depth buffer
+	{
+		ScopedGPUTimer scope(*pTimer, GTS_CLEAR);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	{
+		ScopedGPUTimer scope(*pTimer, GTS_DRAW);
+		DrawScene(a_toWindow, frame.Get());
+	}
+	RecordFrameTime(a_toWindow, FT_CPU, glfwGetTime() - dCPUStart);
+	RecordFrameLatency(a_toWindow, frame.Get());
+
+	{
+		ScopedGPUTimer scope(*pTimer, GTS_SWAP);
+		SwapBuffers(a_toWindow);  // make this loop through all current windows??
+	}
+	pTimer->EndFrame();
+
+	//CheckForGLErrors("Render Error");
+}
+
+
+void DrawScene(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame)
+{
+	// the windows context must be current.
+	// until the quad has loaded there is nothing to draw, this never waits for it:
+	if (!IsQuadReady())
+		return;
+
+	// the camera is per window, not per draw, so it is bound here rather than in the packets:
+	GLStateCache* pState = a_hWindowHandle->m_pGLState;
+	pState->BindBufferRange(GL_UNIFORM_BUFFER, c_uiCameraBlockBinding, g_CameraUBO, a_hWindowHandle->m_uiCameraOffset, sizeof(CameraBlock));
+
+	// it is drawn untextured until the texture has loaded:
+	DrawPacket packet;
+	packet.m_uiTexture = ResourceLoader::IsReady(g_hCheckerTexture) ? g_hCheckerTexture->m_uiName : 0;
+	packet.m_iIndexCount = Quad::c_uiNoOfIndicies;
+	packet.m_uiFirstInstance = 0;
+
+	bool bInstanced = g_uiInstanceCount > 0;
+	if (bInstanced)
+	{
+		// every object in one draw call:
+		packet.m_uiProgram = g_InstancedShader;
+		packet.m_uiVertexArray = g_ContextObjects.Get(g_uiInstancedQuadVAO, a_hWindowHandle->m_uiContextSlot);
+		packet.m_iModelUniform = g_iInstancedModelUniform;
+		packet.m_iInstanceCount = g_uiInstanceCount;
+
+		// the streamed instances are written now, the instanced VAO has to be bound to point it at them:
+		if (a_hWindowHandle->m_pInstanceStream != nullptr)
+		{
+			pState->BindVertexArray(packet.m_uiVertexArray);
+			StreamInstances(a_hWindowHandle, a_rFrame);
+		}
+	}
+	else
+	{
+		packet.m_uiProgram = g_Shader;
+		packet.m_uiVertexArray = g_ContextObjects.Get(g_uiQuadVAO, a_hWindowHandle->m_uiContextSlot);
+		packet.m_iModelUniform = g_iModelUniform;
+		packet.m_iInstanceCount = 0;
+	}
+
+	RenderQueue* pQueue = a_hWindowHandle->m_pRenderQueue;
+	pQueue->Begin();
+	pQueue->Submit(RenderQueue::MakeSortKey(0, packet.m_uiProgram, packet.m_uiVertexArray, packet.m_uiTexture, 0.0f), packet, a_rFrame.m_m4Model);
+	pQueue->Execute(*pState);
+
+	if (bInstanced && a_hWindowHandle->m_pInstanceStream != nullptr)
+		a_hWindowHandle->m_pInstanceStream->EndFrame();
+}
+
+
+void StreamInstances(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame)
+{
+	// the instanced VAO must be bound, points its instance attribute at this frames copy of the instances.
+	StreamBuffer* pStream = a_hWindowHandle->m_pInstanceStream;
+	GLStateCache* pState = a_hWindowHandle->m_pGLState;
+	double dStalled = pStream->BeginFrame();
+	RecordFrameTime(a_hWindowHandle, FT_FENCE, dStalled);
+
+	GLintptr iOffset = 0;
+	InstanceData* pInstances = (InstanceData*)pStream->Allocate(g_uiInstanceCount * sizeof(InstanceData), iOffset);
+	if (pInstances == nullptr)
+	{
+		// the instance count has grown past what the stream was created for, draw them standing still:
+		pStream->CommitWrites();
+		pState->InvalidateBuffer(GL_ARRAY_BUFFER);	// the stream may have bound its own.
+		pState->BindBuffer(GL_ARRAY_BUFFER, g_InstanceVBO);
+		glVertexAttribPointer(c_uiInstanceAttribLocation, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), 0);
+		return;
+	}
+
+	// bob every instance up and down, written straight into mapped memory, no glBufferSubData and no orphaning:
+	float fTime = a_rFrame.m_fTime * 2.0f;
+	for (unsigned int i = 0; i < g_uiInstanceCount; ++i)
+	{
+		glm::vec4 v4PositionScale = g_vInstances[i].m_v4PositionScale;
+		v4PositionScale.y += sinf(fTime + i * 0.37f) * v4PositionScale.w;
+		pInstances[i].m_v4PositionScale = v4PositionScale;
+	}
+	pStream->CommitWrites();
+	pState->InvalidateBuffer(GL_ARRAY_BUFFER);
+
+	pState->BindBuffer(GL_ARRAY_BUFFER, pStream->GetBuffer());
+	glVertexAttribPointer(c_uiInstanceAttribLocation, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), ((char*)0) + iOffset);
+}
+
+
+void DrawScenePerObject(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame)
+{
+	// the same scene as the instanced path, but the way we would draw it without instancing, one draw call per object:
+	if (!IsQuadReady())
+		return;
+
+	GLStateCache* pState = a_hWindowHandle->m_pGLState;
+	pState->BindBufferRange(GL_UNIFORM_BUFFER, c_uiCameraBlockBinding, g_CameraUBO, a_hWindowHandle->m_uiCameraOffset, sizeof(CameraBlock));
+
+	DrawPacket packet;
+	packet.m_uiProgram = g_Shader;
+	packet.m_uiVertexArray = g_ContextObjects.Get(g_uiQuadVAO, a_hWindowHandle->m_uiContextSlot);
+	packet.m_uiTexture = ResourceLoader::IsReady(g_hCheckerTexture) ? g_hCheckerTexture->m_uiName : 0;
+	packet.m_iModelUniform = g_iModelUniform;
+	packet.m_iIndexCount = Quad::c_uiNoOfIndicies;
+	packet.m_uiFirstInstance = 0;
+	packet.m_iInstanceCount = 0;
+
+	// every object shares its state, so the key only differs by depth and they are drawn front to back:
+	RenderQueue* pQueue = a_hWindowHandle->m_pRenderQueue;
+	pQueue->Begin();
+	glm::mat4 identity;
+	for (unsigned int i = 0; i < g_uiInstanceCount; ++i)
+	{
+		const glm::vec4& v4PositionScale = g_vInstances[i].m_v4PositionScale;
+		glm::mat4 m4Model = glm::translate(identity, glm::vec3(v4PositionScale)) * a_rFrame.m_m4Model * glm::scale(identity, glm::vec3(v4PositionScale.w));
+		float fDepth = -(a_hWindowHandle->m_m4ViewMatrix * glm::vec4(glm::vec3(v4PositionScale), 1.0f)).z / c_fCameraFar;
+		pQueue->Submit(RenderQueue::MakeSortKey(0, packet.m_uiProgram, packet.m_uiVertexArray, packet.m_uiTexture, fDepth), packet, m4Model);
+	}
+	pQueue->Execute(*pState);
+}
+
+
+unsigned int RenderMultiView(const std::vector<WindowHandle>& a_vWindows, const FrameSnapshot& a_rFrame)
+{
+	// the primary window's context must be current. Draws the views of the first c_uiMaxMultiViews windows, one per layer
+	// in the same order, and returns how many it drew. The rest have to draw themselves.
+	unsigned int uiViews = (unsigned int)a_vWindows.size();
+	if (uiViews > c_uiMaxMultiViews)
+		uiViews = c_uiMaxMultiViews;
+	if (uiViews == 0)
+		return 0;
+
+	// windows have opened or closed since the last pass, there has to be exactly one layer per view:
+	GLStateCache* pState = g_hPrimaryWindow->m_pGLState;
+	if (g_MultiViewTarget.GetViewCount() != uiViews)
+	{
+		g_MultiViewTarget.Destroy(*pState);
+		if (!g_MultiViewTarget.Create(*pState, c_iMultiViewLayerWidth, c_iMultiViewLayerHeight, uiViews))
+		{
+			Log("Error: Could not create the multi-view target, windows will draw themselves!\n");
+			return 0;
+		}
+	}
+
+	MultiViewCameraBlock block;
+	for (unsigned int i = 0; i < uiViews; ++i)
+		block.m_am4ViewProjection[i] = a_vWindows[i]->m_m4Projection * a_vWindows[i]->m_m4ViewMatrix;
+	block.m_uiViewCount = uiViews;
+	pState->BindBuffer(GL_UNIFORM_BUFFER, g_MultiViewUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MultiViewCameraBlock), &block);
+
+	g_MultiViewTarget.BeginPass(*pState, g_hPrimaryWindow->m_uiContextSlot);
+	DrawSceneMultiView(g_hPrimaryWindow, a_rFrame);
+	g_MultiViewTarget.EndPass();
+
+	pState->Viewport(0, 0, g_hPrimaryWindow->m_uiWidth, g_hPrimaryWindow->m_uiHeight);
+	return uiViews;
+}
+
+
+void DrawSceneMultiView(WindowHandle a_hWindowHandle, const FrameSnapshot& a_rFrame)
+{
+	// the same scene as DrawScene(), drawn once for every view by the multi-view geometry shader. The target must be bound.
+	if (!IsQuadReady())
+		return;
+
+	GLStateCache* pState = a_hWindowHandle->m_pGLState;
+	pState->BindBufferRange(GL_UNIFORM_BUFFER, c_uiMultiViewCameraBlockBinding, g_MultiViewUBO, 0, sizeof(MultiViewCameraBlock));
+
+	DrawPacket packet;
+	packet.m_uiTexture = ResourceLoader::IsReady(g_hCheckerTexture) ? g_hCheckerTexture->m_uiName : 0;
+	packet.m_iIndexCount = Quad::c_uiNoOfIndicies;
+	packet.m_uiFirstInstance = 0;
+
+	if (g_uiInstanceCount > 0)
+	{
+		packet.m_uiProgram = g_MultiViewInstancedShader;
+		packet.m_uiVertexArray = g_ContextObjects.Get(g_uiInstancedQuadVAO, a_hWindowHandle->m_uiContextSlot);
+		packet.m_iModelUniform = g_iMultiViewInstancedModelUniform;
+		packet.m_iInstanceCount = g_uiInstanceCount;
+	}
+	else
+	{
+		packet.m_uiProgram = g_MultiViewShader;
+		packet.m_uiVertexArray = g_ContextObjects.Get(g_uiQuadVAO, a_hWindowHandle->m_uiContextSlot);
+		packet.m_iModelUniform = g_iMultiViewModelUniform;
+		packet.m_iInstanceCount = 0;
+	}
+
+	RenderQueue* pQueue = a_hWindowHandle->m_pRenderQueue;
+	pQueue->Begin();
+	pQueue->Submit(RenderQueue::MakeSortKey(0, packet.m_uiProgram, packet.m_uiVertexArray, packet.m_uiTexture, 0.0f), packet, a_rFrame.m_m4Model);
+	pQueue->Execute(*pState);
+}
+
+
+int ShutDown()
+{
+	// join the window2 thread and delete it:
+	if (g_tpWin2 != nullptr)
+	{
+		g_tpWin2->join();
+		delete g_tpWin2;
+	}
+	
+	// the loader may be helping with jobs, so it goes first. Nothing can be waiting on a job after that:
+	g_ResourceLoader.Stop();
+	g_JobSystem.Stop();
+
+	// every thread that logs has stopped, the reports below are printed straight away:
+	StopLogger();
+
+	// the multi-view layers were made on the primary context, any context that shares with it will do:
+	if (g_MultiViewTarget.IsCreated())
+	{
+		MakeContextCurrent(g_hPrimaryWindow);
+		g_MultiViewTarget.Destroy(*g_hPrimaryWindow->m_pGLState);
+	}
+
+	// report the frame timings, the latency row is what drawing one frame behind the simulation costs:
+	PrintFrameTimings(g_Windows.GetOpenWindows());
+	printf("Frame snapshots: %llu published, the simulation waited for a free one %llu times\n\n",
+		g_FrameSnapshots.GetPublishedCount(), g_FrameSnapshots.GetWriterWaits());
+	PrintThreadPlacement();
+	PrintSyncStats("Render scheduler barriers", g_RenderScheduler.GetSyncStats());
+	if (!g_szFrameTimingFile.empty())
+		DumpFrameTimings(g_Windows.GetOpenWindows(), g_szFrameTimingFile);
+	PrintGPUTimers(g_Windows.GetOpenWindows());
+	if (!g_szGPUTimelineFile.empty())
+		DumpGPUTimeline(g_Windows.GetOpenWindows(), g_szGPUTimelineFile);
+
+	// cleanup any remaining windows:
+	std::vector<WindowHandle> vWindows = g_Windows.GetOpenWindows();
+	for (auto& window : vWindows)
+	{
+		if (g_bPrintStats)
+		{
+			window->m_pRenderQueue->PrintStats(window->m_uiID);
+			window->m_apCommandLists[0]->PrintStats(window->m_uiID);	// both are recorded and replayed every other frame, one is enough.
+			window->m_pGLState->PrintCounters(window->m_uiID);
+			PrintSyncStats(("Window " + std::to_string(window->m_uiID) + " ready event").c_str(), window->m_pFrameReady->GetStats());
+
+			if (window->m_pInstanceStream != nullptr)
+			{
+				StreamBuffer* pStream = window->m_pInstanceStream;
+				printf("Window %u stream buffer (%s): %llu frames, %llu stalls, %.3fms stalled\n", window->m_uiID,
+					pStream->IsPersistent() ? "persistent" : "mapped per frame", pStream->GetFrameCount(), pStream->GetStallCount(), pStream->GetStallSeconds() * 1000.0);
+			}
+		}
+
+		g_Windows.Remove(window);
+		DestroyWindow(window);
+	}
+
+	// and the loader's window, its thread has given up the context by now:
+	if (g_hLoaderWindow != nullptr)
+	{
+		DestroyWindow(g_hLoaderWindow);
+		g_hLoaderWindow = nullptr;
+	}
+
+	// terminate GLFW:
+	glfwTerminate();
+
+	return EC_NO_ERROR;
+}
+
+
+GLEWContext* glewGetContext()
+{
+	// each thread keeps its own current context, see ContextRegistry.h:
+	++t_uiGLEWContextLookups;
+	return t_pCurrentGLEWContext;
+}
+
+
+void MakeContextCurrent(WindowHandle a_hWindowHandle)
+{
+	if (a_hWindowHandle != nullptr)
+	{
+		glfwMakeContextCurrent(a_hWindowHandle->m_pWindow);
+		SetCurrentContext(a_hWindowHandle, a_hWindowHandle->m_pGLEWContext);
+	}
+}
+
+
+WindowHandle CreateWindow(int a_iWidth, int a_iHeight, const std::string& a_szTitle, GLFWmonitor* a_pMonitor, WindowHandle a_hShare)
+{
+	// save current active context info so we can restore it later!
+	WindowHandle hPreviousContext = GetCurrentContext();
+
+	// take a slot for the new window data:
+	WindowHandle newWindow = g_Windows.Allocate();
+	if (newWindow == nullptr)
+	{
+		Log("Error: No window slots left, only %u windows are supported!\n", g_Windows.GetSlotCount());
+		return nullptr;
+	}
+
+	newWindow->m_pGLEWContext = nullptr;
+	newWindow->m_pWindow = nullptr;
+	newWindow->m_uiID = g_uiWindowCounter++;		// set ID and Increment Counter!
+	newWindow->m_uiWidth = a_iWidth;
+	newWindow->m_uiHeight = a_iHeight;
+	newWindow->m_FrameFence = 0;
+	newWindow->m_uiCameraOffset = 0;
+	newWindow->m_bViewportDirty = false;
+	newWindow->m_PendingSize.m_uiWidth = a_iWidth;
+	newWindow->m_PendingSize.m_uiHeight = a_iHeight;
+	newWindow->m_pFrameTiming = nullptr;
+	newWindow->m_pInstanceStream = nullptr;
+	newWindow->m_uiContextSlot = c_uiInvalidContextSlot;
+	newWindow->m_pGLState = nullptr;
+	newWindow->m_pRenderQueue = nullptr;
+	newWindow->m_iSwapInterval = GetRequestedSwapInterval(newWindow->m_uiID);
+	newWindow->m_pGPUTimer = nullptr;
+	newWindow->m_apCommandLists[0] = nullptr;
+	newWindow->m_apCommandLists[1] = nullptr;
+	newWindow->m_pFrameReady = nullptr;
+
+	// if compiling in debug ask for debug context:
+#ifdef _DEBUG
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLU_TRUE);
+#endif
+
+	Log("Creating window called %s with ID %u\n", a_szTitle.c_str(), newWindow->m_uiID);
+
+	// Create Window:
+	if (a_hShare != nullptr) // Check that the Window Handle passed in is valid.
+	{
+		newWindow->m_pWindow = glfwCreateWindow(a_iWidth, a_iHeight, a_szTitle.c_str(), a_pMonitor, a_hShare->m_pWindow);  // Window handle is valid, Share its GL Context Data!
+	}
+	else
+	{
+		newWindow->m_pWindow = glfwCreateWindow(a_iWidth, a_iHeight, a_szTitle.c_str(), a_pMonitor, nullptr); // Window handle is invlad, do not share!
+	}
+	
+	// Confirm window was created successfully:
+	if (newWindow->m_pWindow == nullptr)
+	{
+		Log("Error: Could not Create GLFW Window!\n");
+		g_Windows.Free(newWindow);
+		return nullptr;
+	}
+
+	// create GLEW Context:
+	newWindow->m_pGLEWContext = new GLEWContext();
+	if (newWindow->m_pGLEWContext == nullptr)
+	{
+		Log("Error: Could not create GLEW Context!\n");
+		g_Windows.Free(newWindow);
+		return nullptr;
+	}
+
+	glfwMakeContextCurrent(newWindow->m_pWindow);   // Must be done before init of GLEW for this new windows Context!
+	MakeContextCurrent(newWindow);					// and must be made current too :)
+	
+	// Init GLEW for this context, a copy of an earlier one if a context like it has been seen before:
+	GLenum err = g_GLEWContextCache.InitContext(newWindow->m_pGLEWContext, newWindow->m_pWindow);
+	if (err != GLEW_OK)
+	{
+		// a problem occured when trying to init glew, report it:
+		Log("GLEW Error occured, Description: %s\n", glewGetErrorString(err));
+		if (hPreviousContext != nullptr)
+			MakeContextCurrent(hPreviousContext);
+		else
+		{
+			glfwMakeContextCurrent(nullptr);	// nothing was current before, so neither is the failed window's context.
+			SetCurrentContext(nullptr, nullptr);
+		}
+		glfwDestroyWindow(newWindow->m_pWindow);
+		delete newWindow->m_pGLEWContext;
+		g_Windows.Free(newWindow);
+		return nullptr;
+	}
+
+	// a slot for its VAOs and the like:
+	newWindow->m_uiContextSlot = g_ContextObjects.OpenContext();
+	if (newWindow->m_uiContextSlot == c_uiInvalidContextSlot)
+	{
+		Log("Error: No context slots left, only %u contexts are supported!\n", c_uiMaxContextSlots);
+		if (hPreviousContext != nullptr)
+			MakeContextCurrent(hPreviousContext);
+		else
+		{
+			glfwMakeContextCurrent(nullptr);	// nothing was current before, so neither is the failed window's context.
+			SetCurrentContext(nullptr, nullptr);
+		}
+		glfwDestroyWindow(newWindow->m_pWindow);
+		delete newWindow->m_pGLEWContext;
+		g_Windows.Free(newWindow);
+		return nullptr;
+	}
+
+	// a new context starts with nothing we know of bound:
+	newWindow->m_pGLState = new GLStateCache(g_bGLStateCache);
+	newWindow->m_pRenderQueue = new RenderQueue();
+	newWindow->m_pGPUTimer = new GPUTimer(g_bGPUTimerQueries);
+	newWindow->m_apCommandLists[0] = new CommandList();
+	newWindow->m_apCommandLists[1] = new CommandList();
+	newWindow->m_pFrameReady = new ReadyEvent();
+
+	// otherwise the driver's default is left alone, which is almost always 1:
+	if (!g_viSwapIntervals.empty())
+		glfwSwapInterval(newWindow->m_iSwapInterval);
+	
+	// setup callbacks:
+	// setup callback for window size changes:
+	glfwSetWindowSizeCallback(newWindow->m_pWindow, GLFWWindowSizeCallback);
+	glfwSetKeyCallback(newWindow->m_pWindow, GLFWKeyCallback);
+
+	 // setup openGL Error callback:
+    if (GLEW_ARB_debug_output) // test to make sure we can use the new callbacks, they wer added as an extgension in 4.1 and as a core feture in 4.3
+    {
+            #ifdef _DEBUG
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);                        // this allows us to set a break point in the callback function, no point to it if in release mode. The callback only queues the message, so it costs little.
+            #endif
+            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);        // tell openGl what errors we want (all).
+            glDebugMessageCallback(GLErrorCallback, NULL);                        // define the callback function.
+    }
+
+	// add new window to the open windows, this also lets the callbacks find it:
+	g_Windows.Add(newWindow);
+
+	// now restore previous context:
+	MakeContextCurrent(hPreviousContext);
+
+	return newWindow;
+}
+
+
+void DestroyWindow(WindowHandle a_hWindowHandle)
+{
+	// the window must not be one of g_Windows' open windows any more, and its context must not be current on any other thread.
+	MakeContextCurrent(a_hWindowHandle);
+	g_ContextObjects.CloseContext(a_hWindowHandle->m_uiContextSlot);
+	g_SharedInstances.CloseContext(a_hWindowHandle->m_uiContextSlot);	// a later window given the same slot must wait for the versions it draws.
+	g_SharedTexture.CloseContext(a_hWindowHandle->m_uiContextSlot);
+
+	if (a_hWindowHandle->m_pInstanceStream != nullptr)
+	{
+		a_hWindowHandle->m_pInstanceStream->Destroy();
+		delete a_hWindowHandle->m_pInstanceStream;
+	}
+	a_hWindowHandle->m_pGPUTimer->Destroy();
+	delete a_hWindowHandle->m_pGPUTimer;
+	delete a_hWindowHandle->m_pFrameTiming;
+	delete a_hWindowHandle->m_pRenderQueue;
+	delete a_hWindowHandle->m_apCommandLists[0];
+	delete a_hWindowHandle->m_apCommandLists[1];
+	delete a_hWindowHandle->m_pFrameReady;
+	delete a_hWindowHandle->m_pGLState;
+	delete a_hWindowHandle->m_pGLEWContext;
+	glfwDestroyWindow(a_hWindowHandle->m_pWindow);
+
+	// GLFW has released the context, forget it here too so nothing calls GL through the deleted GLEW context:
+	SetCurrentContext(nullptr, nullptr);
+
+	g_Windows.Free(a_hWindowHandle);
+}
+
+
+void DestroyClosedWindows()
+{
+	// called once a frame on the main thread. Closing the primary or secondary window ends the demo (see ShouldClose()),
+	// any other window is destroyed on its own, with everything else that was closed in the same frame:
+	if (ShouldClose() || g_Windows.CollectClosed(g_vClosedWindows) == 0)
+		return;
+
+	// the render threads own the contexts of the windows they draw, so they have to hand them back first:
+	bool bRestartScheduler = g_RenderScheduler.IsRunning();
+	if (bRestartScheduler)
+		StopRenderScheduler();
+
+	// and the present threads may still be swapping them:
+	bool bRestartPresentQueue = g_PresentQueue.IsRunning();
+	if (bRestartPresentQueue)
+		g_PresentQueue.Stop();
+
+	for (auto window : g_vClosedWindows)
+		DestroyWindow(window);
+	g_vClosedWindows.clear();
+
+	if (bRestartScheduler)
+		StartRenderScheduler();
+	else if (bRestartPresentQueue)
+		g_PresentQueue.Start(g_Windows.GetOpenWindows(), g_dRefreshPeriod);	// DestroyWindow() left no context current.
+	else
+		MakeContextCurrent(g_hPrimaryWindow);
+}
+
+
+void SwapBuffers(WindowHandle a_hWindowHandle)
+{
+	double dStart = glfwGetTime();
+	glfwSwapBuffers(a_hWindowHandle->m_pWindow);
+	RecordPresent(a_hWindowHandle, dStart, dStart, glfwGetTime(), g_dRefreshPeriod);
+}
+
+
+void AcquireWindow(WindowHandle a_hWindowHandle)
+{
+	// with the present threads running the window's context may still be swapping on its present thread:
+	if (g_PresentQueue.IsRunning())
+		g_PresentQueue.Acquire(a_hWindowHandle);
+	else
+		MakeContextCurrent(a_hWindowHandle);
+}
+
+
+void PresentWindow(WindowHandle a_hWindowHandle)
+{
+	if (g_PresentQueue.IsRunning())
+		g_PresentQueue.Present(a_hWindowHandle);
+	else
+		SwapBuffers(a_hWindowHandle);
+}
+
+
+void SetSwapInterval(WindowHandle a_hWindowHandle, int a_iInterval)
+{
+	// the windows context must be current.
+	a_hWindowHandle->m_iSwapInterval = a_iInterval;
+	glfwSwapInterval(a_iInterval);
+}
+
+
+int GetRequestedSwapInterval(unsigned int a_uiWindowID)
+{
+	if (g_viSwapIntervals.empty())
+		return c_iDefaultSwapInterval;
+	return g_viSwapIntervals[std::min<size_t>(a_uiWindowID, g_viSwapIntervals.size() - 1)];
+}
+
+
+void WaitForRenderTurn(WindowHandle a_hWindowHandle, WindowHandle a_hOther, unsigned long long a_ullFrame)
+{
+	double dStart = glfwGetTime();
+	a_hOther->m_pFrameReady->WaitFor(a_ullFrame);
+	RecordFrameTime(a_hWindowHandle, FT_LOCK, glfwGetTime() - dStart);
+}
+
+
+void SetSecondaryWindowDrawn(bool a_bDrawn)
+{
+	// only between runs, the render threads draw whatever is in the open windows:
+	if (g_hSecondaryWindow == nullptr)
+		return;
+
+	const std::vector<WindowHandle>& vOpen = g_Windows.GetOpenWindows();
+	bool bDrawn = std::find(vOpen.begin(), vOpen.end(), g_hSecondaryWindow) != vOpen.end();
+	if (bDrawn == a_bDrawn)
+		return;
+
+	if (a_bDrawn)
+	{
+		g_Windows.Add(g_hSecondaryWindow);
+		glfwShowWindow(g_hSecondaryWindow->m_pWindow);
+	}
+	else
+	{
+		g_Windows.Remove(g_hSecondaryWindow);
+		glfwHideWindow(g_hSecondaryWindow->m_pWindow);
+	}
+}
+
+
+bool ShouldClose()
+{
+	// every loop draws the primary and secondary windows, closing any other window only closes that one, see DestroyClosedWindows():
+	if (glfwWindowShouldClose(g_hPrimaryWindow->m_pWindow))
+		return true;
+
+	return g_hSecondaryWindow != nullptr && glfwWindowShouldClose(g_hSecondaryWindow->m_pWindow);
+}
+
+
+Quad CreateQuad()
+{
+	Quad geom;
 
 	geom.m_Verticies[0].m_v4Position = glm::vec4(-2,0,-2,1);
 	geom.m_Verticies[0].m_v2UV = glm::vec2(0,0);
@@ -681,81 +2942,273 @@ Quad CreateQuad()
 	geom.m_uiIndicies[4] = 2;
 	geom.m_uiIndicies[5] = 1;
 
-	printf("Created quad on thread ID: %i\n", std::this_thread::get_id());
-
 	return geom;
 }
 
 
+void ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-benchmark") == 0)
+		{
+			g_eRunMode = RM_SCHEDULER_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-dispatchbench") == 0)
+		{
+			g_eRunMode = RM_DISPATCH_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-loop") == 0 && i + 1 < argc)
+		{
+			const char* szLoop = argv[++i];
+			if (strcmp(szLoop, "sequential") == 0)
+				g_eRunMode = RM_SEQUENTIAL;
+			else if (strcmp(szLoop, "naive") == 0)
+				g_eRunMode = RM_NAIVE;
+			else if (strcmp(szLoop, "threaded") == 0)
+				g_eRunMode = RM_THREADED;
+			else if (strcmp(szLoop, "pooled") == 0)
+				g_eRunMode = RM_POOLED;
+			else if (strcmp(szLoop, "deferred") == 0)
+				g_eRunMode = RM_DEFERRED;
+			else
+				printf("Warning: Unknown loop %s, expected sequential, naive, threaded, pooled or deferred\n", szLoop);
+		}
+		else if (strcmp(argv[i], "-instancebench") == 0)
+		{
+			g_eRunMode = RM_INSTANCE_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-instances") == 0 && i + 1 < argc)
+		{
+			g_uiInstanceCount = (unsigned int)atoi(argv[++i]);
+			if (g_uiInstanceCount > c_uiMaxInstanceCount)
+				g_uiInstanceCount = c_uiMaxInstanceCount;
+		}
+		else if (strcmp(argv[i], "-stream") == 0)
+		{
+			g_bStreamInstances = true;
+		}
+		else if (strcmp(argv[i], "-timings") == 0 && i + 1 < argc)
+		{
+			g_szFrameTimingFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "-timeline") == 0 && i + 1 < argc)
+		{
+			g_szGPUTimelineFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "-placement") == 0 && i + 1 < argc)
+		{
+			g_szThreadPlacement = argv[++i];
+		}
+		else if (strcmp(argv[i], "-cputimers") == 0)
+		{
+			g_bGPUTimerQueries = false;
+		}
+		else if (strcmp(argv[i], "-windows") == 0 && i + 1 < argc)
+		{
+			g_uiRequestedWindows = (unsigned int)atoi(argv[++i]);
+			if (g_uiRequestedWindows > c_uiMaxWindowCount - 1)
+				g_uiRequestedWindows = c_uiMaxWindowCount - 1;	// the loader's window needs a slot too.
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			g_uiRenderThreads = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-jobbench") == 0)
+		{
+			g_eRunMode = RM_JOB_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-registrybench") == 0)
+		{
+			g_eRunMode = RM_REGISTRY_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-windowstress") == 0)
+		{
+			g_eRunMode = RM_WINDOW_STRESS;
+		}
+		else if (strcmp(argv[i], "-multiview") == 0)
+		{
+			g_bMultiView = true;
+		}
+		else if (strcmp(argv[i], "-multiviewbench") == 0)
+		{
+			g_eRunMode = RM_MULTIVIEW_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-presentthreads") == 0)
+		{
+			g_bPresentThreads = true;
+		}
+		else if (strcmp(argv[i], "-presentbench") == 0)
+		{
+			g_eRunMode = RM_PRESENT_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-texturebench") == 0)
+		{
+			g_eRunMode = RM_TEXTURE_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-startupbench") == 0)
+		{
+			g_eRunMode = RM_STARTUP_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-sharedstress") == 0)
+		{
+			g_eRunMode = RM_SHARED_STRESS;
+		}
+		else if (strcmp(argv[i], "-syncbench") == 0)
+		{
+			g_eRunMode = RM_SYNC_BENCHMARK;
+		}
+		else if (strcmp(argv[i], "-texturesize") == 0 && i + 1 < argc)
+		{
+			g_uiTextureBenchmarkSize = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-swapinterval") == 0 && i + 1 < argc)
+		{
+			// one per window by ID, a,b,c:
+			g_viSwapIntervals.clear();
+			for (const char* szInterval = argv[++i]; *szInterval != '\0'; )
+			{
+				g_viSwapIntervals.push_back(std::max(0, atoi(szInterval)));
+				const char* szComma = strchr(szInterval, ',');
+				if (szComma == nullptr)
+					break;
+				szInterval = szComma + 1;
+			}
+		}
+		else if (strcmp(argv[i], "-jobthreads") == 0 && i + 1 < argc)
+		{
+			g_uiJobThreads = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-objects") == 0 && i + 1 < argc)
+		{
+			g_uiSceneObjects = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-nocache") == 0)
+		{
+			g_ProgramCache.SetEnabled(false);
+		}
+		else if (strcmp(argv[i], "-noglewcache") == 0)
+		{
+			g_GLEWContextCache.SetEnabled(false);
+		}
+		else if (strcmp(argv[i], "-nostatecache") == 0)
+		{
+			g_bGLStateCache = false;
+		}
+		else if (strcmp(argv[i], "-stats") == 0)
+		{
+			g_bPrintStats = true;
+		}
+		else if (strcmp(argv[i], "-synclog") == 0)
+		{
+			g_bAsyncLog = false;
+		}
+		else
+		{
+			printf("Warning: Unknown command line option %s\n", argv[i]);
+		}
+	}
+
+	// one context draws every view, so multi-view only works where every window is drawn on the main thread:
+	if (g_bMultiView && g_eRunMode != RM_SEQUENTIAL)
+	{
+		if (g_eRunMode == RM_POOLED || g_eRunMode == RM_NAIVE || g_eRunMode == RM_THREADED || g_eRunMode == RM_DEFERRED)
+		{
+			printf("Status: -multiview draws every window on the main thread, using the sequential loop\n");
+			g_eRunMode = RM_SEQUENTIAL;
+		}
+		else
+		{
+			g_bMultiView = false;	// the other benchmarks draw the windows their own way.
+		}
+	}
+
+	// the present threads take the swaps off the loop that draws every window on the main thread:
+	if (g_bPresentThreads && g_eRunMode != RM_SEQUENTIAL)
+	{
+		if (g_eRunMode == RM_POOLED || g_eRunMode == RM_NAIVE || g_eRunMode == RM_THREADED || g_eRunMode == RM_DEFERRED)
+		{
+			printf("Status: -presentthreads presents the windows of the sequential loop, using the sequential loop\n");
+			g_eRunMode = RM_SEQUENTIAL;
+		}
+		else
+		{
+			g_bPresentThreads = false;	// the benchmarks swap their own way, -presentbench starts them itself.
+		}
+	}
+
+	// streaming writes the instances into a buffer mapped by the window's context, the threads recording the deferred loop have none:
+	if (g_eRunMode == RM_DEFERRED && g_bStreamInstances)
+	{
+		printf("Warning: -stream is not supported with the deferred loop, the instances will not move\n");
+		g_bStreamInstances = false;
+	}
+
+	// the multi-view pass draws the instances standing still, there is one copy of them rather than one per window:
+	if ((g_bMultiView || g_eRunMode == RM_MULTIVIEW_BENCHMARK) && g_bStreamInstances)
+	{
+		printf("Warning: -stream is not supported with multi-view, the instances will not move\n");
+		g_bStreamInstances = false;
+	}
+}
+
+
 void GLFWErrorCallback(int a_iError, const char* a_szDiscription)
 {
-	printf("GLFW Error occured, Error ID: %i, Description: %s\n", a_iError, a_szDiscription);
+	LogRateLimited(LS_GLFW, (unsigned int)a_iError, "GLFW Error occured, Error ID: %i, Description: %s\n", a_iError, a_szDiscription);
 }
 
 
 void APIENTRY GLErrorCallback(GLenum /* source */, GLenum type, GLuint id, GLenum severity, GLsizei /* length */, const GLchar* message, void* /* userParam */)
 {
-	std::cout << "---------------------opengl-callback-start------------" << std::endl;
-	std::cout << "Message: " << message << std::endl;
-	std::cout << "Type: "; 
-    switch (type) 
-        {
-    case GL_DEBUG_TYPE_ERROR:
-		std::cout << "ERROR" << std::endl; 
-        break;
-    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-		std::cout << "DEPRECATED_BEHAVIOR" << std::endl; 
-        break;
-    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-		std::cout << "UNDEFINED_BEHAVIOR" << std::endl; 
-        break;
-    case GL_DEBUG_TYPE_PORTABILITY:
-		std::cout << "PORTABILITY" << std::endl; 
-        break;
-    case GL_DEBUG_TYPE_PERFORMANCE:
-		std::cout << "PERFORMANCE" << std::endl; 
-        break;
-    case GL_DEBUG_TYPE_OTHER:
-		std::cout << "OTHER" << std::endl; 
-        break;
-    }
+	// this runs on whichever thread made the call, so it only queues the message. A burst of one ID is cut off at c_uiLogRateLimit a second:
+	const char* szType = "OTHER";
+	switch (type)
+	{
+	case GL_DEBUG_TYPE_ERROR:				szType = "ERROR"; break;
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:	szType = "DEPRECATED_BEHAVIOR"; break;
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:	szType = "UNDEFINED_BEHAVIOR"; break;
+	case GL_DEBUG_TYPE_PORTABILITY:			szType = "PORTABILITY"; break;
+	case GL_DEBUG_TYPE_PERFORMANCE:			szType = "PERFORMANCE"; break;
+	}
 
-	std::cout << "ID: " << id << ", Severity: ";
-    switch (severity)
-        {
-    case GL_DEBUG_SEVERITY_LOW:
-		std::cout << "LOW" << std::endl; 
-        break;
-    case GL_DEBUG_SEVERITY_MEDIUM:
-		std::cout << "MEDIUM" << std::endl; 
-        break;
-    case GL_DEBUG_SEVERITY_HIGH:
-		std::cout << "HIGH" << std::endl; 
-        break;
-    }
+	const char* szSeverity = "NOTIFICATION";
+	switch (severity)
+	{
+	case GL_DEBUG_SEVERITY_LOW:		szSeverity = "LOW"; break;
+	case GL_DEBUG_SEVERITY_MEDIUM:	szSeverity = "MEDIUM"; break;
+	case GL_DEBUG_SEVERITY_HIGH:	szSeverity = "HIGH"; break;
+	}
 
-	std::cout << "---------------------opengl-callback-end--------------" << std::endl;
+	LogRateLimited(LS_GL_DEBUG, id, "---------------------opengl-callback-start------------\nMessage: %s\nType: %s\nID: %u, Severity: %s\n"
+		"---------------------opengl-callback-end--------------\n", message, szType, id, szSeverity);
 }
 
 
-void GLFWWindowSizeCallback(GLFWwindow* a_pWindow, int a_iWidth, int a_iHeight)
+void GLFWKeyCallback(GLFWwindow* /* a_pWindow */, int a_iKey, int /* a_iScanCode */, int a_iAction, int /* a_iMods */)
 {
-	// find the window data corrosponding to a_pWindow;
-	WindowHandle window = nullptr;
-	for (auto& itr : g_lWindows)
+	// T dumps the frame timings so far, the histograms can be read while the render threads are still writing to them:
+	if (a_iKey == GLFW_KEY_T && a_iAction == GLFW_PRESS)
 	{
-		if (itr->m_pWindow == a_pWindow)
-		{
-			window = itr;
-			window->m_uiWidth = a_iWidth;
-			window->m_uiHeight = a_iHeight;
-			window->m_m4Projection = glm::perspective(45.0f, float(a_iWidth)/float(a_iHeight), 0.1f, 1000.0f);
-		}
+		PrintFrameTimings(g_Windows.GetOpenWindows());
+		DumpFrameTimings(g_Windows.GetOpenWindows(), g_szFrameTimingFile.empty() ? c_szDefaultFrameTimingFile : g_szFrameTimingFile);
 	}
+}
+
+
+void GLFWWindowSizeCallback(GLFWwindow* a_pWindow, int a_iWidth, int a_iHeight)
+{
+	// the window data corrosponding to a_pWindow was stored with it when it was added to g_Windows:
+	WindowHandle window = WindowManager::FromGLFWWindow(a_pWindow);
+	if (window == nullptr)
+		return;
 
-	std::thread::id thread = std::this_thread::get_id();
-	WindowHandle previousContext = g_mCurrentContextMap[thread];
-	MakeContextCurrent(window);
-	glViewport(0, 0, a_iWidth, a_iHeight);
-	MakeContextCurrent(previousContext);
+	// a render thread may be drawing the window, so the new size goes to one side for it to pick up all at once:
+	{
+		std::lock_guard<std::mutex> lock(window->m_SizeLock);
+		window->m_PendingSize.m_uiWidth = a_iWidth;
+		window->m_PendingSize.m_uiHeight = a_iHeight;
+		window->m_PendingSize.m_m4Projection = glm::perspective(45.0f, float(a_iWidth)/float(a_iHeight), c_fCameraNear, c_fCameraFar);
+	}
+	window->m_bViewportDirty.store(true, std::memory_order_release);
 }
@@ -9,14 +9,86 @@
 #ifndef _THREADINGDEMO_H_
 #define _THREADINGDEMO_H_
 
-#include "glm\glm.hpp"
+#include "glm/glm.hpp"
+#include <atomic>
+#include <mutex>
 
 ////////////////////////// Constants //////////////////////////////////
 const int c_iDefaultScreenWidth = 1280;
 const int c_iDefaultScreenHeight = 720;
 
-const char *c_szDefaultPrimaryWindowTitle = "Threading Demo - Primary Window";
-const char *c_szDefaultSecondaryWindowTitle = "Threading Demo - Secondary Window";
+const char * const c_szDefaultPrimaryWindowTitle = "Threading Demo - Primary Window";
+const char * const c_szDefaultSecondaryWindowTitle = "Threading Demo - Secondary Window";
+const char * const c_szDefaultWindowTitle = "Threading Demo - Window";
+
+const float c_fCameraNear = 0.1f;
+const float c_fCameraFar = 1000.0f;
+
+const unsigned int c_uiDefaultWindowCount = 2;
+const unsigned int c_uiMaxWindowCount = 128;		// window slots, see WindowManager.h. The loader's hidden window takes one.
+
+// Benchmark mode (-benchmark), runs the pooled render loop for each window count and reports aggregate FPS:
+const float c_fBenchmarkRunTime = 5.0f;		// seconds per window count.
+const unsigned int c_auiBenchmarkWindowCounts[] = { 1, 2, 4, 8, 16 };
+
+// Dispatch benchmark (-dispatchbench):
+const unsigned int c_uiDispatchBenchmarkLookups = 10000000;	// glewGetContext() lookups per thread.
+
+// Instanced scene (-instances N) and its benchmark (-instancebench):
+const unsigned int c_uiMaxInstanceCount = 1000000;
+const unsigned int c_auiInstanceBenchmarkCounts[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+const unsigned int c_uiInstanceBenchmarkFrames = 60;			// frames timed for each count.
+const unsigned int c_uiMaxPerObjectBenchmarkCount = 100000;		// one draw per object is too slow to be worth timing past this.
+const float c_fInstanceSceneSize = 10.0f;						// the instances fill a cube this big around the origin.
+
+// Job system scaling benchmark (-jobbench), times the scene update with 1 to all hardware threads:
+const unsigned int c_uiJobBenchmarkFrames = 100;				// updates timed for each thread count.
+
+// Context object registry benchmark (-registrybench), VAO lookup cost with this many contexts:
+const unsigned int c_auiRegistryBenchmarkContexts[] = { 1, 2, 16, 64, 128 };
+const unsigned int c_uiRegistryBenchmarkLookups = 10000000;
+
+// Window stress test (-windowstress), each round tops the open windows back up, draws them and closes a random half:
+const unsigned int c_uiWindowStressRounds = 16;
+const unsigned int c_uiWindowStressOpenWindows = 96;			// open windows at the start of each round, including the primary and secondary.
+const unsigned int c_uiWindowStressFrames = 2;					// frames drawn on every window each round.
+
+// Multi-view rendering (-multiview), every window's view drawn in one pass into a layer of a texture array:
+const unsigned int c_uiMaxMultiViews = 16;						// layers, windows past this draw themselves as usual.
+const int c_iMultiViewLayerWidth = c_iDefaultScreenWidth;		// every layer is this size and scaled to fit its window.
+const int c_iMultiViewLayerHeight = c_iDefaultScreenHeight;
+
+// and its benchmark (-multiviewbench), per window drawing against one multi-view pass:
+const unsigned int c_auiMultiViewBenchmarkWindowCounts[] = { 1, 2, 4, 8, 16 };
+const unsigned int c_uiMultiViewBenchmarkFrames = 60;			// frames timed each way for each window count.
+
+// Present threads (-presentthreads), each window swaps on its own thread, and their benchmark (-presentbench):
+const int c_iDefaultSwapInterval = 1;							// vertical blanks per swap, see -swapinterval.
+const double c_dDefaultRefreshRate = 60.0;						// Hz, when the monitor does not say.
+const float c_fPresentBenchmarkRunTime = 3.0f;					// seconds each way for each window count.
+const unsigned int c_auiPresentBenchmarkWindowCounts[] = { 1, 2, 4, 8 };
+
+// Procedural texture benchmark (-texturebench), generates and uploads a texture this big in every format (see TextureGen.h):
+const unsigned int c_uiDefaultTextureBenchmarkSize = 8192;		// texels along each side, -texturesize N.
+const unsigned int c_uiTextureBenchmarkRuns = 3;				// the fastest of this many runs is reported.
+
+// Start up benchmark (-startupbench), opens this many windows with glewInit() for each and with the GLEW context cache:
+const unsigned int c_auiStartupBenchmarkWindowCounts[] = { 1, 8, 64 };
+
+// Shared resource stress test (-sharedstress), a writer thread rewrites a shared instance buffer and texture every frame
+// while every window draws them, with each number of copies (see SharedResource.h). One copy is lock step:
+const float c_fSharedStressRunTime = 2.0f;						// seconds for each window count and number of copies.
+const unsigned int c_auiSharedStressWindowCounts[] = { 1, 2, 4, 8 };
+const unsigned int c_auiSharedStressCopies[] = { 1, 2, 3 };
+const unsigned int c_uiSharedStressInstances = 1024;			// unless -instances N says otherwise.
+const unsigned int c_uiSharedStressTextureSize = 256;
+const char * const c_szSharedWriterWindowTitle = "Threading Demo - Shared Writer";
+
+// Sync benchmark (-syncbench), runs the pooled loop over the open windows waiting each way (see SyncPrimitives.h):
+const float c_fSyncBenchmarkRunTime = 3.0f;						// seconds for each way of waiting.
+
+// where pressing T writes the frame timings if -timings was not given:
+const char * const c_szDefaultFrameTimingFile = "FrameTimings.csv";
 
 
 ///////////////////// Custom Data Types ///////////////////////////////
@@ -27,6 +99,43 @@ enum ExitCodes
 	EC_GLFW_FIRST_WINDOW_CREATION_FAIL = 2,
 };
 
+enum RunModes
+{
+	RM_POOLED = 0,				// default, MainLoopPOOLED().
+	RM_SCHEDULER_BENCHMARK,		// -benchmark, aggregate FPS as the window count grows.
+	RM_DISPATCH_BENCHMARK,		// -dispatchbench, glewGetContext() overhead per frame.
+	RM_SEQUENTIAL,				// -loop sequential, MainLoop().
+	RM_NAIVE,					// -loop naive, MainLoopBAD().
+	RM_THREADED,				// -loop threaded, MainLoopTHREADED().
+	RM_INSTANCE_BENCHMARK,		// -instancebench, CPU submit time of instanced vs one draw per object.
+	RM_JOB_BENCHMARK,			// -jobbench, scene update time as job threads are added.
+	RM_REGISTRY_BENCHMARK,		// -registrybench, per context VAO lookup cost as the context count grows.
+	RM_WINDOW_STRESS,			// -windowstress, opens and closes hundreds of windows.
+	RM_MULTIVIEW_BENCHMARK,		// -multiviewbench, per window drawing vs one multi-view pass.
+	RM_PRESENT_BENCHMARK,		// -presentbench, swapping every window in turn vs on present threads.
+	RM_TEXTURE_BENCHMARK,		// -texturebench, procedural texture generation time and size per format.
+	RM_STARTUP_BENCHMARK,		// -startupbench, window creation time with and without the GLEW context cache.
+	RM_DEFERRED,				// -loop deferred, MainLoopDEFERRED().
+	RM_SHARED_STRESS,			// -sharedstress, a writer thread updates shared resources every frame while every window reads them.
+	RM_SYNC_BENCHMARK,			// -syncbench, frame rate and CPU use of the pooled loop spinning, parking and spinning then parking.
+};
+
+struct FrameTimingData;
+class StreamBuffer;
+class GLStateCache;
+class RenderQueue;
+class GPUTimer;
+class CommandList;
+class ReadyEvent;
+
+// A windows size and the projection that goes with it, the size callback publishes them together.
+struct WindowSize
+{
+	unsigned int	m_uiWidth;
+	unsigned int	m_uiHeight;
+	glm::mat4		m_m4Projection;
+};
+
 struct Window
 {
 	GLFWwindow*		m_pWindow;
@@ -35,20 +144,39 @@ struct Window
 	unsigned int	m_uiHeight;
 	glm::mat4		m_m4Projection;
 	glm::mat4		m_m4ViewMatrix;
+	GLsync			m_FrameFence;		// fence after this windows last frame, see RenderScheduler.
+	unsigned int	m_uiCameraOffset;	// where this windows CameraBlock lives in g_CameraUBO, one per slot.
+	std::atomic_bool m_bViewportDirty;	// set by the size callback, the thread that draws the window takes m_PendingSize and updates the viewport.
+	std::mutex		m_SizeLock;			// guards m_PendingSize, the three above it are only touched by the thread drawing the window.
+	WindowSize		m_PendingSize;		// the last size the callback saw, see ApplyPendingSize().
+	FrameTimingData* m_pFrameTiming;	// see FrameTiming.h.
+	StreamBuffer*	m_pInstanceStream;	// per frame instance data when streaming (-stream), otherwise nullptr.
+	unsigned int	m_uiContextSlot;	// where this windows VAOs live in g_ContextObjects, see ContextObjectRegistry.h.
+	GLStateCache*	m_pGLState;			// what this windows context has bound, all binds on it go through this. See GLStateCache.h.
+	RenderQueue*	m_pRenderQueue;		// this windows draws, sorted by state then depth when it is rendered. See RenderQueue.h.
+	int				m_iSwapInterval;	// vertical blanks per swap, set with SetSwapInterval().
+	GPUTimer*		m_pGPUTimer;		// CPU and GPU time of each pass of Render(), see GPUTimer.h.
+	CommandList*	m_apCommandLists[2];	// -loop deferred, one is recorded on the job system while the other is replayed. See CommandList.h.
+	ReadyEvent*		m_pFrameReady;		// frames this window has finished in the threaded loop, the other thread waits on it. See SyncPrimitives.h.
 
 	unsigned int	m_uiID;
+	unsigned int	m_uiSlot;			// where this window lives in g_Windows, reused once it is closed. See WindowManager.h.
 };
 typedef Window* WindowHandle;
 
-struct FPSData
+// Per window camera data, matches the std140 layout of the Camera block in c_szVertexShader.
+struct CameraBlock
+{
+	glm::mat4 m_m4Projection;
+	glm::mat4 m_m4View;
+};
+
+// Every view of a multi-view pass, matches the std140 layout of the MultiViewCamera block in c_szMultiViewGeometryShader.
+struct MultiViewCameraBlock
 {
-	float			m_fFPS;
-	float			m_fFrameCount;
-	float			m_fTimeBetweenChecks;
-	float			m_fTimeElapsed;
-	// temp vars for calcing delta time:
-	float			m_fCurrnetRunTime;
-	float			m_fPreviousRunTime;
+	glm::mat4		m_am4ViewProjection[c_uiMaxMultiViews];
+	unsigned int	m_uiViewCount;
+	unsigned int	m_auiPadding[3];
 };
 
 struct Vertex
@@ -58,6 +186,12 @@ struct Vertex
 	glm::vec4 m_v4Colour;
 };
 
+// packed per instance data for the instanced scene, xyz = position and w = uniform scale:
+struct InstanceData
+{
+	glm::vec4 m_v4PositionScale;
+};
+
 struct Quad
 {
 	static const unsigned int	c_uiNoOfIndicies = 6;
@@ -68,14 +202,19 @@ struct Quad
 
 
 /////////////////////////// Shaders ///////////////////////////////////
-const char *c_szVertexShader = "#version 330\n"
+const unsigned int c_uiCameraBlockBinding = 0;		// uniform buffer binding point for the Camera block.
+
+const char * const c_szVertexShader = "#version 330\n"
 	"in vec4 Position;\n"
 	"in vec2 UV;\n"
 	"in vec4 Colour;\n"
 	"out vec2 vUV;\n"
 	"out vec4 vColour;\n"
-	"uniform mat4 Projection;\n"
-	"uniform mat4 View;\n"
+	"layout(std140) uniform Camera\n"
+	"{\n"
+		"mat4 Projection;\n"
+		"mat4 View;\n"
+	"};\n"
 	"uniform mat4 Model;\n"
 	"void main()\n"
 	"{\n" 
@@ -85,7 +224,97 @@ const char *c_szVertexShader = "#version 330\n"
 	"}\n"
 	"\n";
 
-const char *c_szPixelShader = "#version 330\n"
+// same as above but each instance is scaled then moved by its InstanceData, Model only rotates:
+const unsigned int c_uiInstanceAttribLocation = 3;
+
+const char * const c_szInstancedVertexShader = "#version 330\n"
+	"in vec4 Position;\n"
+	"in vec2 UV;\n"
+	"in vec4 Colour;\n"
+	"in vec4 InstancePositionScale;\n"
+	"out vec2 vUV;\n"
+	"out vec4 vColour;\n"
+	"layout(std140) uniform Camera\n"
+	"{\n"
+		"mat4 Projection;\n"
+		"mat4 View;\n"
+	"};\n"
+	"uniform mat4 Model;\n"
+	"void main()\n"
+	"{\n" 
+		"vUV = UV;\n"
+		"vColour = Colour;"
+		"vec4 local = Model * vec4(Position.xyz * InstancePositionScale.w, 1.0);\n"
+		"gl_Position = Projection * View * vec4(local.xyz + InstancePositionScale.xyz, 1.0);\n"
+	"}\n"
+	"\n";
+
+// Multi-view versions of the two vertex shaders above, they leave the vertex in world space for the geometry shader:
+const unsigned int c_uiMultiViewCameraBlockBinding = 1;
+
+const char * const c_szMultiViewVertexShader = "#version 330\n"
+	"in vec4 Position;\n"
+	"in vec2 UV;\n"
+	"in vec4 Colour;\n"
+	"out vec2 wUV;\n"
+	"out vec4 wColour;\n"
+	"uniform mat4 Model;\n"
+	"void main()\n"
+	"{\n" 
+		"wUV = UV;\n"
+		"wColour = Colour;"
+		"gl_Position = Model * Position;\n"
+	"}\n"
+	"\n";
+
+const char * const c_szMultiViewInstancedVertexShader = "#version 330\n"
+	"in vec4 Position;\n"
+	"in vec2 UV;\n"
+	"in vec4 Colour;\n"
+	"in vec4 InstancePositionScale;\n"
+	"out vec2 wUV;\n"
+	"out vec4 wColour;\n"
+	"uniform mat4 Model;\n"
+	"void main()\n"
+	"{\n" 
+		"wUV = UV;\n"
+		"wColour = Colour;"
+		"vec4 local = Model * vec4(Position.xyz * InstancePositionScale.w, 1.0);\n"
+		"gl_Position = vec4(local.xyz + InstancePositionScale.xyz, 1.0);\n"
+	"}\n"
+	"\n";
+
+// emits every triangle once per view, into that view's layer. MAX_VIEWS and MAX_VIEW_VERTICES are defined when it is built:
+const char * const c_szMultiViewGeometryShader = "#version 330\n"
+	"layout(triangles) in;\n"
+	"layout(triangle_strip, max_vertices = MAX_VIEW_VERTICES) out;\n"
+	"in vec2 wUV[];\n"
+	"in vec4 wColour[];\n"
+	"out vec2 vUV;\n"
+	"out vec4 vColour;\n"
+	"layout(std140) uniform MultiViewCamera\n"
+	"{\n"
+		"mat4 ViewProjection[MAX_VIEWS];\n"
+		"int ViewCount;\n"
+	"};\n"
+	"void main()\n"
+	"{\n"
+		"for (int view = 0; view < ViewCount; ++view)\n"
+		"{\n"
+			"for (int i = 0; i < 3; ++i)\n"
+			"{\n"
+				"gl_Layer = view;\n"
+				"vUV = wUV[i];\n"
+				"vColour = wColour[i];\n"
+				"gl_Position = ViewProjection[view] * gl_in[i].gl_Position;\n"
+				"EmitVertex();\n"
+			"}\n"
+			"EndPrimitive();\n"
+		"}\n"
+	"}\n"
+	"\n";
+
+const char * const c_szPixelShader = "#version 330\n"
 	"in vec2 vUV;\n"
 	"in vec4 vColour;\n"
 	"out vec4 outColour;\n"
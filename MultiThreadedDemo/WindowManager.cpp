@@ -0,0 +1,80 @@
+// Note that the following includes must be defined in order:
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "ThreadingDemo.h"
+#include "WindowManager.h"
+
+// Note the the following Includes do not need to be defined in order:
+#include <algorithm>
+
+
+WindowManager::WindowManager()
+	: m_pSlots(new Window[c_uiMaxWindowCount])
+	, m_uiSlotCount(c_uiMaxWindowCount)
+{
+	// hand out the low slots first:
+	m_vFreeSlots.reserve(m_uiSlotCount);
+	for (unsigned int i = 0; i < m_uiSlotCount; ++i)
+	{
+		m_vFreeSlots.push_back(m_uiSlotCount - 1 - i);
+		m_pSlots[i].m_uiSlot = i;
+	}
+	m_vOpen.reserve(m_uiSlotCount);
+}
+
+
+WindowManager::~WindowManager()
+{
+	delete[] m_pSlots;
+}
+
+
+WindowHandle WindowManager::Allocate()
+{
+	if (m_vFreeSlots.empty())
+		return nullptr;
+
+	unsigned int uiSlot = m_vFreeSlots.back();
+	m_vFreeSlots.pop_back();
+	return &m_pSlots[uiSlot];
+}
+
+
+void WindowManager::Free(WindowHandle a_hWindow)
+{
+	if (a_hWindow == nullptr)
+		return;
+
+	m_vFreeSlots.push_back(a_hWindow->m_uiSlot);
+}
+
+
+void WindowManager::Add(WindowHandle a_hWindow)
+{
+	glfwSetWindowUserPointer(a_hWindow->m_pWindow, a_hWindow);
+	m_vOpen.push_back(a_hWindow);
+}
+
+
+void WindowManager::Remove(WindowHandle a_hWindow)
+{
+	m_vOpen.erase(std::remove(m_vOpen.begin(), m_vOpen.end(), a_hWindow), m_vOpen.end());
+}
+
+
+unsigned int WindowManager::CollectClosed(std::vector<WindowHandle>& a_rvClosed)
+{
+	// one pass over the open windows however many closed, rather than a search and erase for each:
+	size_t uiBefore = a_rvClosed.size();
+	auto itrKeep = m_vOpen.begin();
+	for (auto itr = m_vOpen.begin(); itr != m_vOpen.end(); ++itr)
+	{
+		if (glfwWindowShouldClose((*itr)->m_pWindow))
+			a_rvClosed.push_back(*itr);
+		else
+			*itrKeep++ = *itr;
+	}
+	m_vOpen.erase(itrKeep, m_vOpen.end());
+
+	return (unsigned int)(a_rvClosed.size() - uiBefore);
+}
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////
+/// @file		WindowManager.h
+/// @details	Owns the Window data of every open window in a fixed array of
+///				slots, so a WindowHandle never moves while its window is open
+///				and a closed window's slot is reused by the next one opened.
+///				GLFW callbacks find their window through the GLFW user pointer
+///				rather than searching, the open windows are kept packed in one
+///				array for the per frame loops, and closed windows are collected
+///				in one pass so they can be destroyed together at a point where
+///				no render thread is drawing them.
+///				Windows can only be created and destroyed on the main thread,
+///				so none of this is locked.
+/// @author		Greg Nott
+/// @version	1.0 - Initial Version
+/// @date		16/10/26
+////////////////////////////////////////////////////////////
+
+#ifndef _WINDOWMANAGER_H_
+#define _WINDOWMANAGER_H_
+
+#include <vector>
+
+struct Window;
+typedef Window* WindowHandle;
+
+class WindowManager
+{
+public:
+	WindowManager();
+	~WindowManager();
+
+	/// Takes a free slot, nullptr if they are all in use. Only m_uiSlot is set, the rest is whatever the slot's last window left.
+	WindowHandle Allocate();
+
+	/// Gives the slot back, the window must have been removed and its GLFW window destroyed.
+	void Free(WindowHandle a_hWindow);
+
+	/// Adds the window to the open windows and points its GLFW window's user pointer at it.
+	void Add(WindowHandle a_hWindow);
+
+	/// Takes the window out of the open windows without freeing its slot, for windows that are never drawn.
+	void Remove(WindowHandle a_hWindow);
+
+	/// Removes every open window GLFW has been asked to close and appends them to a_rvClosed, keeping the
+	/// rest in order. Returns how many were closed. The caller destroys them and then frees their slots.
+	unsigned int CollectClosed(std::vector<WindowHandle>& a_rvClosed);
+
+	/// The window a GLFW callback was called for, or nullptr if it is not one of ours.
+	static WindowHandle FromGLFWWindow(GLFWwindow* a_pWindow)	{ return (WindowHandle)glfwGetWindowUserPointer(a_pWindow); }
+
+	const std::vector<WindowHandle>& GetOpenWindows() const		{ return m_vOpen; }
+	unsigned int GetOpenCount() const							{ return (unsigned int)m_vOpen.size(); }
+	unsigned int GetFreeSlotCount() const						{ return (unsigned int)m_vFreeSlots.size(); }
+	unsigned int GetSlotCount() const							{ return m_uiSlotCount; }
+
+private:
+	WindowManager(const WindowManager&);
+	WindowManager& operator=(const WindowManager&);
+
+	Window*						m_pSlots;			// c_uiMaxWindowCount windows, allocated once.
+	unsigned int				m_uiSlotCount;
+	std::vector<unsigned int>	m_vFreeSlots;		// lowest slot at the back.
+	std::vector<WindowHandle>	m_vOpen;			// in the order they were added.
+};
+
+#endif // _WINDOWMANAGER_H_